@@ -12,16 +12,24 @@
 #include "i18n.h"  // NLS support.
 #include "image.hpp"
 #include "iptc.hpp"
+#include "photoshop.hpp"
 #include "preview.hpp"
 #include "safe_op.hpp"
 #include "xmp_exiv2.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <mutex>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 // + standard includes
 #include <sys/stat.h>  // for stat()
@@ -90,14 +98,61 @@ std::string time2Str(time_t time);
 int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType targetType, bool preserve);
 
 /*!
-  @brief Rename a file according to a timestamp value.
+  @brief Write the Exif data of a JPEG image in place, by patching the bytes that changed
+         in the Exif APP1 segment of the file. This is only possible if no value changes
+         its size and no tag is added or removed. Other images update their TIFF structure
+         in place in this case already.
+
+  @param path  Path of the image file
+  @param image The image, with its metadata read and the Exif data modified
+  @return true if the file was patched, false if the metadata must be written with
+         Image::writeMetadata(), in which case the file is unchanged.
+*/
+bool patchExif(const std::string& path, Exiv2::Image& image);
+
+//! Kinds of JPEG segments which hold the metadata copied by metacopy()
+enum class SegmentKind { other, exif, xmp, photoshop, comment };
+
+//! A JPEG segment before the image data, the marker and the contents including the length field
+struct JpegSegment {
+  int marker;
+  Exiv2::DataBuf data;
+};
+
+/*!
+  @brief Read the segments of a JPEG or EXV file, which is positioned after its header, up to
+         the start of the image data or the end of the image.
+
+  @return The marker which ends the segments, SOS or EOI, or -1 if the file is corrupt
+*/
+int readSegments(Exiv2::BasicIo& io, std::vector<JpegSegment>& segments);
+
+//! Return the kind of metadata held by a JPEG segment
+SegmentKind segmentKind(const JpegSegment& segment);
+
+/*!
+  @brief Build the APP13 segment with the IPTC data of the Photoshop segments in \em segments, as
+         the library writes it: a single IPTC IRB, without the other Photoshop resources.
+
+  @return false if the Photoshop data is corrupt or the IPTC data too large for a segment.
+         \em segment is empty if there is no IPTC data.
+*/
+bool iptcSegment(const std::vector<JpegSegment>& segments, JpegSegment& segment);
 
-  @param path The original file path. Contains the new path on exit.
-  @param tm   Pointer to a buffer with the broken-down time to rename
-              the file to.
-  @return 0 if successful, -1 if the file was skipped, 1 on error.
+/*!
+  @brief Copy the Exif, XMP, IPTC (Photoshop) and comment segments selected by \em targets
+         byte for byte from a JPEG or EXV file to a JPEG file, without decoding the metadata.
+         Of the Photoshop segments, only the IPTC IRBs are copied, see iptcSegment().
+         This is only done if the target has none of the selected kinds of segments, such that
+         nothing needs to be merged.
+
+  @return true if the metadata was copied, false if it must be copied with the metadata
+         classes, in which case the target is unchanged.
 */
-int renameFile(std::string& path, const tm* tm);
+bool transplantSegments(const std::string& source, const std::string& target, Params::CommonTarget targets);
+
+//! Replace all occurrences of \em searchText in \em text with \em replaceText
+void replace(std::string& text, const std::string& searchText, const std::string& replaceText);
 
 /*!
   @brief Make a file path from the current file path, destination
@@ -133,6 +188,32 @@ int printStructure(std::ostream& out, Exiv2::PrintStructureOption option, const
 // *****************************************************************************
 // class member definitions
 namespace Action {
+namespace {
+//! Output streams of the current thread, replaced while an OutputBuffer exists
+thread_local std::ostream* threadOut = &std::cout;
+thread_local std::ostream* threadErr = &std::cerr;
+}  // namespace
+
+std::ostream& out() {
+  return *threadOut;
+}
+
+std::ostream& err() {
+  return *threadErr;
+}
+
+OutputBuffer::OutputBuffer() : prevOut_(std::exchange(threadOut, &out_)), prevErr_(std::exchange(threadErr, &err_)) {
+}
+
+OutputBuffer::~OutputBuffer() {
+  threadOut = prevOut_;
+  threadErr = prevErr_;
+}
+
+bool OutputBuffer::active() {
+  return threadOut != &std::cout;
+}
+
 TaskFactory& TaskFactory::instance() {
   static TaskFactory instance_;
   return instance_;
@@ -152,6 +233,7 @@ TaskFactory::TaskFactory() {
   registry_.emplace(modify, std::make_unique<Modify>());
   registry_.emplace(fixiso, std::make_unique<FixIso>());
   registry_.emplace(fixcom, std::make_unique<FixCom>());
+  registry_.emplace(diff, std::make_unique<Diff>());
 }
 
 Task::UniquePtr TaskFactory::create(TaskType type) {
@@ -179,13 +261,13 @@ static int setModeAndPrintStructure(Exiv2::PrintStructureOption option, const st
         size_t length = code.size();
         for (size_t start = 0; start < length; start += chunk) {
           auto count = std::min<size_t>(chunk, length - start);
-          std::cout << code.substr(start, count) << '\n';
+          out() << code.substr(start, count) << '\n';
         }
       }
     }
   } else {
     _setmode(fileno(stdout), O_BINARY);
-    result = printStructure(std::cout, option, path);
+    result = printStructure(out(), option, path);
   }
 
   return result;
@@ -204,9 +286,9 @@ int Print::run(const std::string& path) {
       case Params::pmPreview:
         return printPreviewList();
       case Params::pmStructure:
-        return printStructure(std::cout, Exiv2::kpsBasic, path_);
+        return printStructure(out(), Exiv2::kpsBasic, path_);
       case Params::pmRecursive:
-        return printStructure(std::cout, Exiv2::kpsRecursive, path_);
+        return printStructure(out(), Exiv2::kpsRecursive, path_);
       case Params::pmXMP:
         return setModeAndPrintStructure(Exiv2::kpsXMP, path_, binary());
       case Params::pmIccProfile:
@@ -214,17 +296,17 @@ int Print::run(const std::string& path) {
     }
     return 0;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in print action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in print action for file " << path << ":\n" << e << "\n";
     return 1;
   } catch (const std::overflow_error& e) {
-    std::cerr << "std::overflow_error exception in print action for file " << path << ":\n" << e.what() << "\n";
+    err() << "std::overflow_error exception in print action for file " << path << ":\n" << e.what() << "\n";
     return 1;
   }
 }
 
 int Print::printSummary() {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
@@ -235,22 +317,22 @@ int Print::printSummary() {
 
   // Filename
   printLabel(_("File name"));
-  std::cout << path_ << '\n';
+  out() << path_ << '\n';
 
   // Filesize
   printLabel(_("File size"));
-  std::cout << fs::file_size(path_) << " " << _("Bytes") << '\n';
+  out() << fs::file_size(path_) << " " << _("Bytes") << '\n';
 
   // MIME type
   printLabel(_("MIME type"));
-  std::cout << image->mimeType() << '\n';
+  out() << image->mimeType() << '\n';
 
   // Image size
   printLabel(_("Image size"));
-  std::cout << image->pixelWidth() << " x " << image->pixelHeight() << '\n';
+  out() << image->pixelWidth() << " x " << image->pixelHeight() << '\n';
 
   if (exifData.empty()) {
-    std::cerr << path_ << ": " << _("No Exif data found in the file") << "\n";
+    err() << path_ << ": " << _("No Exif data found in the file") << "\n";
     return -3;
   }
 
@@ -259,16 +341,16 @@ int Print::printSummary() {
   Exiv2::ExifThumbC exifThumb(exifData);
   std::string thumbExt = exifThumb.extension();
   if (thumbExt.empty()) {
-    std::cout << _("None");
+    out() << _("None");
   } else {
     auto dataBuf = exifThumb.copy();
     if (dataBuf.empty()) {
-      std::cout << _("None");
+      out() << _("None");
     } else {
-      std::cout << exifThumb.mimeType() << ", " << dataBuf.size() << " " << _("Bytes");
+      out() << exifThumb.mimeType() << ", " << dataBuf.size() << " " << _("Bytes");
     }
   }
-  std::cout << '\n';
+  out() << '\n';
 
   printTag(exifData, Exiv2::make, _("Camera make"));
   printTag(exifData, Exiv2::model, _("Camera model"));
@@ -290,17 +372,17 @@ int Print::printSummary() {
   printTag(exifData, "Exif.Image.Copyright", _("Copyright"));
   printTag(exifData, "Exif.Photo.UserComment", _("Exif comment"));
 
-  std::cout << '\n';
+  out() << '\n';
 
   return 0;
 }  // Print::printSummary
 
 void Print::printLabel(const std::string& label) const {
-  std::cout << std::setfill(' ') << std::left;
-  if (Params::instance().files_.size() > 1) {
-    std::cout << std::setw(20) << path_ << " ";
+  out() << std::setfill(' ') << std::left;
+  if (Params::instance().manyFiles()) {
+    out() << std::setw(20) << path_ << " ";
   }
-  std::cout << std::pair(label, align_) << ": ";
+  out() << std::pair(label, align_) << ": ";
 }
 
 int Print::printTag(const Exiv2::ExifData& exifData, const std::string& key, const std::string& label) const {
@@ -311,11 +393,11 @@ int Print::printTag(const Exiv2::ExifData& exifData, const std::string& key, con
   Exiv2::ExifKey ek(key);
   auto md = exifData.findKey(ek);
   if (md != exifData.end()) {
-    md->write(std::cout, &exifData);
+    md->write(out(), &exifData);
     rc = 1;
   }
   if (!label.empty())
-    std::cout << '\n';
+    out() << '\n';
   return rc;
 }  // Print::printTag
 
@@ -327,45 +409,45 @@ int Print::printTag(const Exiv2::ExifData& exifData, EasyAccessFct easyAccessFct
   }
   auto md = easyAccessFct(exifData);
   if (md != exifData.end()) {
-    md->write(std::cout, &exifData);
+    md->write(out(), &exifData);
     rc = 1;
   } else if (easyAccessFctFallback) {
     md = easyAccessFctFallback(exifData);
     if (md != exifData.end()) {
-      md->write(std::cout, &exifData);
+      md->write(out(), &exifData);
       rc = 1;
     }
   }
   if (!label.empty())
-    std::cout << '\n';
+    out() << '\n';
   return rc;
 }  // Print::printTag
 
 int Print::printList() {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
   auto image = Exiv2::ImageFactory::open(path_);
   image->readMetadata();
-  // Set defaults for metadata types and data columns
-  if (Params::instance().printTags_ == MetadataId::invalid) {
-    Params::instance().printTags_ = MetadataId::exif | MetadataId::iptc | MetadataId::xmp;
-  }
-  if (Params::instance().printItems_ == 0) {
-    Params::instance().printItems_ = Params::prKey | Params::prType | Params::prCount | Params::prTrans;
-  }
   return printMetadata(image.get());
 }  // Print::printList
 
 int Print::printMetadata(const Exiv2::Image* image) {
+  const bool asRecord = Params::instance().outputFormat_ != Params::ofText;
+  auto print = [&](const Exiv2::Metadatum& md) {
+    return asRecord ? addToRecord(md, image) : printMetadatum(md, image);
+  };
+  record_.clear();
+  recordIndex_.clear();
+
   bool ret = false;
   bool noExif = false;
   if ((Params::instance().printTags_ & MetadataId::exif) == MetadataId::exif) {
     const Exiv2::ExifData& exifData = image->exifData();
     for (auto&& md : exifData) {
-      ret |= printMetadatum(md, image);
+      ret |= print(md);
     }
     if (exifData.empty())
       noExif = true;
@@ -375,7 +457,7 @@ int Print::printMetadata(const Exiv2::Image* image) {
   if ((Params::instance().printTags_ & MetadataId::iptc) == MetadataId::iptc) {
     const Exiv2::IptcData& iptcData = image->iptcData();
     for (auto&& md : iptcData) {
-      ret |= printMetadatum(md, image);
+      ret |= print(md);
     }
     if (iptcData.empty())
       noIptc = true;
@@ -385,20 +467,24 @@ int Print::printMetadata(const Exiv2::Image* image) {
   if ((Params::instance().printTags_ & MetadataId::xmp) == MetadataId::xmp) {
     const Exiv2::XmpData& xmpData = image->xmpData();
     for (auto&& md : xmpData) {
-      ret |= printMetadatum(md, image);
+      ret |= print(md);
     }
     if (xmpData.empty())
       noXmp = true;
   }
 
+  // Files without matching metadata get a record too, so that there is one for each file
+  if (asRecord)
+    printRecord();
+
   // With -v, inform about the absence of any (requested) type of metadata
   if (Params::instance().verbose_) {
     if (noExif)
-      std::cerr << path_ << ": " << _("No Exif data found in the file") << "\n";
+      err() << path_ << ": " << _("No Exif data found in the file") << "\n";
     if (noIptc)
-      std::cerr << path_ << ": " << _("No IPTC data found in the file") << "\n";
+      err() << path_ << ": " << _("No IPTC data found in the file") << "\n";
     if (noXmp)
-      std::cerr << path_ << ": " << _("No XMP data found in the file") << "\n";
+      err() << path_ << ": " << _("No XMP data found in the file") << "\n";
   }
 
   // With -g or -K, return -3 if no matching tags were found
@@ -409,116 +495,194 @@ int Print::printMetadata(const Exiv2::Image* image) {
   return rc;
 }  // Print::printMetadata
 
-bool Print::grepTag(const std::string& key) {
-  bool result = Params::instance().greps_.empty();
-  for (auto const& g : Params::instance().greps_) {
-    result = std::regex_search(key, g);
-    if (result) {
-      break;
+//! Return true if a -g literal is found in the key, a '.' in the literal matches any character
+static bool findLiteral(const std::string& key, const Params::GrepLiteral& literal) {
+  const auto& text = literal.text_;
+  for (size_t pos = 0; pos + text.size() <= key.size(); ++pos) {
+    size_t i = 0;
+    for (; i < text.size(); ++i) {
+      auto c = static_cast<unsigned char>(key[pos + i]);
+      if (text[i] != '.' && text[i] != (literal.ignoreCase_ ? std::tolower(c) : c))
+        break;
     }
+    if (i == text.size())
+      return true;
   }
-  return result;
+  return false;
+}
+
+bool Print::grepTag(const std::string& key) {
+  const auto& params = Params::instance();
+  if (params.greps_.empty())
+    return true;
+  return std::any_of(params.grepLiterals_.begin(), params.grepLiterals_.end(),
+                     [&key](const auto& literal) { return findLiteral(key, literal); }) ||
+         std::any_of(params.grepRegexes_.begin(), params.grepRegexes_.end(),
+                     [&key](const auto& regex) { return std::regex_search(key, regex); });
 }
 
 bool Print::keyTag(const std::string& key) {
-  bool result = Params::instance().keys_.empty();
-  for (const auto& k : Params::instance().keys_) {
-    if (result)
-      break;
-    result = key == k;
+  return Params::instance().keys_.empty() || Params::instance().keySet_.contains(key);
+}
+
+bool Print::addToRecord(const Exiv2::Metadatum& md, const Exiv2::Image* image) {
+  auto key = md.key();
+  if (!grepTag(key) || !keyTag(key))
+    return false;
+  if (Params::instance().unknown_ && md.tagName().starts_with("0x"))
+    return false;
+
+  const auto items = Params::instance().printItems_;
+  auto value = items & Params::prValue && !(items & Params::prTrans) ? md.toString() : md.print(&image->exifData());
+  auto [pos, added] = recordIndex_.try_emplace(key, record_.size());
+  if (added) {
+    record_.emplace_back(std::move(key), std::vector<std::string>());
   }
-  return result;
+  record_[pos->second].second.push_back(std::move(value));
+  return true;
+}
+
+void Print::printCsvHeader() {
+  std::string line = "file";
+  for (const auto& key : Params::instance().keys_) {
+    line += ',';
+    Util::appendCsvField(line, key);
+  }
+  line += '\n';
+  out().write(line.data(), line.size());
+}
+
+void Print::printRecord() {
+  line_.clear();
+  if (Params::instance().outputFormat_ == Params::ofJson) {
+    line_ += "{\"file\":";
+    Util::appendJsonString(line_, path_);
+    for (const auto& [key, values] : record_) {
+      line_ += ',';
+      Util::appendJsonString(line_, key);
+      line_ += ':';
+      // Repeated keys, like IPTC keywords, have an array of values
+      if (values.size() > 1)
+        line_ += '[';
+      for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0)
+          line_ += ',';
+        Util::appendJsonString(line_, values[i]);
+      }
+      if (values.size() > 1)
+        line_ += ']';
+    }
+    line_ += '}';
+  } else {
+    Util::appendCsvField(line_, path_);
+    for (const auto& key : Params::instance().keys_) {
+      line_ += ',';
+      auto pos = recordIndex_.find(key);
+      if (pos == recordIndex_.end())
+        continue;
+      // The values of repeated keys are listed like those of XMP arrays
+      const auto& values = record_[pos->second].second;
+      if (values.size() == 1) {
+        Util::appendCsvField(line_, values.front());
+      } else {
+        std::string joined;
+        for (size_t i = 0; i < values.size(); ++i)
+          joined.append(i > 0 ? ", " : "").append(values[i]);
+        Util::appendCsvField(line_, joined);
+      }
+    }
+  }
+  line_ += '\n';
+  out().write(line_.data(), line_.size());
 }
 
 static void binaryOutput(const std::ostringstream& os) {
-  std::cout << os.str();
+  out() << os.str();
 }
 
 bool Print::printMetadatum(const Exiv2::Metadatum& md, const Exiv2::Image* pImage) {
-  if (!grepTag(md.key()))
-    return false;
-  if (!keyTag(md.key()))
+  if (const auto key = md.key(); !grepTag(key) || !keyTag(key))
     return false;
 
   if (Params::instance().unknown_ && md.tagName().starts_with("0x")) {
     return false;
   }
 
-  bool const manyFiles = Params::instance().files_.size() > 1;
+  bool const manyFiles = Params::instance().manyFiles();
   if (manyFiles) {
-    std::cout << std::setfill(' ') << std::left << std::setw(20) << path_ << "  ";
+    out() << std::setfill(' ') << std::left << std::setw(20) << path_ << "  ";
   }
 
   bool first = true;
   if (Params::instance().printItems_ & Params::prTag) {
     first = false;
-    std::cout << "0x" << std::setw(4) << std::setfill('0') << std::right << std::hex << md.tag();
+    out() << "0x" << std::setw(4) << std::setfill('0') << std::right << std::hex << md.tag();
   }
   if (Params::instance().printItems_ & Params::prSet) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << "set";
+    out() << "set";
   }
   if (Params::instance().printItems_ & Params::prGroup) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setw(12) << std::setfill(' ') << std::left << md.groupName();
+    out() << std::setw(12) << std::setfill(' ') << std::left << md.groupName();
   }
   if (Params::instance().printItems_ & Params::prKey) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setfill(' ') << std::left << std::setw(44) << md.key();
+    out() << std::setfill(' ') << std::left << std::setw(44) << md.key();
   }
   if (Params::instance().printItems_ & Params::prName) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setw(27) << std::setfill(' ') << std::left << md.tagName();
+    out() << std::setw(27) << std::setfill(' ') << std::left << md.tagName();
   }
   if (Params::instance().printItems_ & Params::prLabel) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setw(30) << std::setfill(' ') << std::left << md.tagLabel();
+    out() << std::setw(30) << std::setfill(' ') << std::left << md.tagLabel();
   }
   if (Params::instance().printItems_ & Params::prDesc) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setw(30) << std::setfill(' ') << std::left << md.tagDesc();
+    out() << std::setw(30) << std::setfill(' ') << std::left << md.tagDesc();
   }
   if (Params::instance().printItems_ & Params::prType) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::setw(9) << std::setfill(' ') << std::left;
+    out() << std::setw(9) << std::setfill(' ') << std::left;
     const char* tn = md.typeName();
     if (tn) {
-      std::cout << tn;
+      out() << tn;
     } else {
       std::ostringstream os;
       os << "0x" << std::setw(4) << std::setfill('0') << std::hex << md.typeId();
-      std::cout << os.str();
+      out() << os.str();
     }
   }
   if (Params::instance().printItems_ & Params::prCount) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::dec << std::setw(3) << std::setfill(' ') << std::right << md.count();
+    out() << std::dec << std::setw(3) << std::setfill(' ') << std::right << md.count();
   }
   if (Params::instance().printItems_ & Params::prSize) {
     if (!first)
-      std::cout << " ";
+      out() << " ";
     first = false;
-    std::cout << std::dec << std::setw(3) << std::setfill(' ') << std::right << md.size();
+    out() << std::dec << std::setw(3) << std::setfill(' ') << std::right << md.size();
   }
   if (Params::instance().printItems_ & Params::prValue && md.size() > 0) {
     if (!first)
-      std::cout << "  ";
+      out() << "  ";
     first = false;
     std::ostringstream os;
     // #1114 - show negative values for SByte
@@ -534,7 +698,7 @@ bool Print::printMetadatum(const Exiv2::Metadatum& md, const Exiv2::Image* pImag
   }
   if (Params::instance().printItems_ & Params::prTrans) {
     if (!first)
-      std::cout << "  ";
+      out() << "  ";
     first = false;
     std::ostringstream os;
     os << std::dec << md.print(&pImage->exifData());
@@ -542,53 +706,53 @@ bool Print::printMetadatum(const Exiv2::Metadatum& md, const Exiv2::Image* pImag
   }
   if (Params::instance().printItems_ & Params::prHex) {
     if (!first)
-      std::cout << '\n';
+      out() << '\n';
     if (md.size() > 0) {
       Exiv2::DataBuf buf(md.size());
       md.copy(buf.data(), pImage->byteOrder());
-      Exiv2::hexdump(std::cout, buf.c_data(), buf.size());
+      Exiv2::hexdump(out(), buf.c_data(), buf.size());
     }
   }
-  std::cout << '\n';
+  out() << '\n';
   return true;
 }  // Print::printMetadatum
 
 int Print::printComment() {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
   auto image = Exiv2::ImageFactory::open(path_);
   image->readMetadata();
   if (Params::instance().verbose_) {
-    std::cout << _("JPEG comment") << ": ";
+    out() << _("JPEG comment") << ": ";
   }
-  std::cout << image->comment() << '\n';
+  out() << image->comment() << '\n';
   return 0;
 }  // Print::printComment
 
 int Print::printPreviewList() {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
   auto image = Exiv2::ImageFactory::open(path_);
   image->readMetadata();
-  bool const manyFiles = Params::instance().files_.size() > 1;
+  bool const manyFiles = Params::instance().manyFiles();
   int cnt = 0;
   Exiv2::PreviewManager pm(*image);
   Exiv2::PreviewPropertiesList list = pm.getPreviewProperties();
   for (const auto& pos : list) {
     if (manyFiles) {
-      std::cout << std::setfill(' ') << std::left << std::setw(20) << path_ << "  ";
+      out() << std::setfill(' ') << std::left << std::setw(20) << path_ << "  ";
     }
-    std::cout << _("Preview") << " " << ++cnt << ": " << pos.mimeType_ << ", ";
+    out() << _("Preview") << " " << ++cnt << ": " << pos.mimeType_ << ", ";
     if (pos.width_ != 0 && pos.height_ != 0) {
-      std::cout << pos.width_ << "x" << pos.height_ << " " << _("pixels") << ", ";
+      out() << pos.width_ << "x" << pos.height_ << " " << _("pixels") << ", ";
     }
-    std::cout << pos.size_ << " " << _("bytes") << "\n";
+    out() << pos.size_ << " " << _("bytes") << "\n";
   }
   return 0;
 }  // Print::printPreviewList
@@ -598,63 +762,215 @@ Task::UniquePtr Print::clone() const {
 }
 
 int Rename::run(const std::string& path) {
+  if (plan_)
+    return probe(path, *plan_);
+
+  std::vector<Plan> plans(1);
+  if (int rc = probe(path, plans.front()))
+    return rc;
+  // Files renamed in parallel must not take the same name
+  auto guard = std::scoped_lock(cs);
+  resolve(plans, !OutputBuffer::active());
+  err() << plans.front().err;
+  return execute(plans.front());
+}
+
+int Rename::probe(const std::string& path, Plan& plan) {
+  plan.path = path;
+  plan.ret = 1;
   try {
     if (!Exiv2::fileExists(path)) {
-      std::cerr << path << ": " << _("Failed to open the file") << "\n";
-      return -1;
+      err() << path << ": " << _("Failed to open the file") << "\n";
+      return plan.ret = -1;
     }
-    Timestamp ts;
-    if (Params::instance().preserve_)
-      ts.read(path);
-
     auto image = Exiv2::ImageFactory::open(path);
     image->readMetadata();
     Exiv2::ExifData& exifData = image->exifData();
     if (exifData.empty()) {
-      std::cerr << path << ": " << _("No Exif data found in the file") << "\n";
-      return -3;
+      err() << path << ": " << _("No Exif data found in the file") << "\n";
+      return plan.ret = -3;
     }
     auto md = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
     if (md == exifData.end())
       md = exifData.findKey(Exiv2::ExifKey("Exif.Image.DateTime"));
     if (md == exifData.end()) {
-      std::cerr << _("Neither tag") << " `Exif.Photo.DateTimeOriginal' " << _("nor") << " `Exif.Image.DateTime' "
-                << _("found in the file") << " " << path << "\n";
-      return 1;
+      err() << _("Neither tag") << " `Exif.Photo.DateTimeOriginal' " << _("nor") << " `Exif.Image.DateTime' "
+            << _("found in the file") << " " << path << "\n";
+      return plan.ret;
     }
-    std::string v = md->toString();
-    if (v.empty() || v.front() == ' ') {
-      std::cerr << _("Image file creation timestamp not set in the file") << " " << path << "\n";
-      return 1;
+    plan.value = md->toString();
+    if (plan.value.empty() || plan.value.front() == ' ') {
+      err() << _("Image file creation timestamp not set in the file") << " " << path << "\n";
+      return plan.ret;
     }
-    std::tm tm;
-    if (str2Tm(v, &tm) != 0) {
-      std::cerr << _("Failed to parse timestamp") << " `" << v << "' " << _("in the file") << " " << path << "\n";
-      return 1;
+    if (str2Tm(plan.value, &plan.tm) != 0) {
+      err() << _("Failed to parse timestamp") << " `" << plan.value << "' " << _("in the file") << " " << path
+            << "\n";
+      return plan.ret;
     }
-    if (Params::instance().timestamp_ || Params::instance().timestampOnly_) {
-      ts.read(&tm);
+  } catch (const Exiv2::Error& e) {
+    err() << "Exiv2 exception in rename action for file " << path << ":\n" << e << "\n";
+    return plan.ret;
+  }
+
+  plan.ret = 0;
+  plan.newPath = path;
+  if (Params::instance().timestampOnly_)
+    return plan.ret;
+
+  auto p = fs::path(path);
+  std::string format = Params::instance().format_;
+  std::string filename = p.stem().string();
+  std::string basesuffix;
+  int pos = filename.find('.');
+  if (pos > 0)
+    basesuffix = filename.substr(filename.find('.'));
+  replace(format, ":basename:", p.stem().string());
+  replace(format, ":basesuffix:", basesuffix);
+  replace(format, ":dirname:", p.parent_path().filename().string());
+  replace(format, ":parentname:", p.parent_path().parent_path().filename().string());
+
+  const size_t max = 1024;
+  char basename[max] = {};
+  if (strftime(basename, max, format.c_str(), &plan.tm) == 0) {
+    err() << _("Filename format yields empty filename for the file") << " " << path << "\n";
+    return plan.ret = 1;
+  }
+  plan.stem = basename;
+  auto newPath = p.parent_path() / (plan.stem + p.extension().string());
+  plan.newPath = newPath.string();
+  if (newPath.parent_path() == p.parent_path() && newPath.filename() == p.filename()) {
+    if (Params::instance().verbose_) {
+      out() << _("This file already has the correct name") << '\n';
     }
-    int rc = 0;
-    std::string newPath = path;
-    if (Params::instance().timestampOnly_) {
-      if (Params::instance().verbose_) {
-        std::cout << _("Updating timestamp to") << " " << v << '\n';
+    plan.skip = true;
+    return plan.ret;
+  }
+  plan.rename = true;
+  return plan.ret;
+}
+
+void Rename::resolve(std::vector<Plan>& plans, bool prompt) {
+  // Whether a path exists after the plans so far are executed, for the paths they rename
+  std::unordered_map<std::string, bool> renamed;
+  auto key = [](const std::string& path) { return fs::path(path).lexically_normal().string(); };
+  auto exists = [&](const std::string& path) {
+    auto it = renamed.find(key(path));
+    return it == renamed.end() ? Exiv2::fileExists(path) : it->second;
+  };
+
+  for (auto& plan : plans) {
+    if (plan.ret != 0 || plan.skip)
+      continue;
+    // The file was renamed or replaced by an earlier plan for the same file
+    if (auto it = renamed.find(key(plan.path)); it != renamed.end()) {
+      plan.err += plan.path + ": " + _("The file was renamed or replaced by an earlier file, skipped") + "\n";
+      plan.ret = -1;
+      continue;
+    }
+    if (!plan.rename)
+      continue;
+
+    auto p = fs::path(plan.newPath);
+    auto newPath = [&](int seq) {
+      return (p.parent_path() / (plan.stem + "_" + Exiv2::toString(seq) + p.extension().string())).string();
+    };
+    int seq = 1;
+    std::string s;
+    Params::FileExistsPolicy fileExistsPolicy = Params::instance().fileExistsPolicy_;
+    while (!plan.overwrite && exists(plan.newPath)) {
+      switch (fileExistsPolicy) {
+        case Params::overwritePolicy:
+          plan.overwrite = true;
+          break;
+        case Params::renamePolicy:
+          plan.newPath = newPath(seq++);
+          break;
+        case Params::askPolicy:
+          if (!prompt) {
+            plan.err += Params::instance().progname() + ": " + _("File") + " `" + plan.newPath + "' " +
+                        _("exists, skipped. Use -f to overwrite or -F to rename it") + "\n";
+            plan.skip = true;
+            break;
+          }
+          out() << Params::instance().progname() << ": " << _("File") << " `" << plan.newPath << "' "
+                << _("exists. [O]verwrite, [r]ename or [s]kip?") << " ";
+          std::cin >> s;
+          switch (s.front()) {
+            case 'o':
+            case 'O':
+              plan.overwrite = true;
+              break;
+            case 'r':
+            case 'R':
+              fileExistsPolicy = Params::renamePolicy;
+              plan.newPath = newPath(seq++);
+              break;
+            default:
+              plan.skip = true;
+          }
       }
+      if (plan.skip)
+        break;
+    }
+    if (!plan.skip) {
+      renamed[key(plan.path)] = false;
+      renamed[key(plan.newPath)] = true;
+    }
+  }
+}
+
+int Rename::execute(const Plan& plan) {
+  const auto& params = Params::instance();
+  if (plan.ret != 0 || plan.skip)
+    return plan.ret;
+
+  if (params.dryRun_) {
+    if (plan.rename) {
+      out() << plan.path << " -> " << plan.newPath;
+      if (plan.overwrite)
+        out() << " (" << _("overwrites the existing file") << ")";
     } else {
-      rc = renameFile(newPath, &tm);
-      if (rc == -1)
-        return 0;  // skip
+      out() << plan.path << ": " << _("timestamp") << " " << plan.value;
+    }
+    out() << '\n';
+    return 0;
+  }
+
+  Timestamp ts;
+  if (params.preserve_)
+    ts.read(plan.path);
+  if (params.timestamp_ || params.timestampOnly_) {
+    std::tm tm = plan.tm;
+    ts.read(&tm);
+  }
+  if (plan.rename) {
+    // The file names were resolved in memory, an existing file is never replaced unless planned
+    if (!plan.overwrite && Exiv2::fileExists(plan.newPath)) {
+      err() << params.progname() << ": " << _("File") << " `" << plan.newPath << "' "
+            << _("exists, skipped. Use -f to overwrite or -F to rename it") << "\n";
+      return 0;
     }
-    if (0 == rc &&
-        (Params::instance().preserve_ || Params::instance().timestamp_ || Params::instance().timestampOnly_)) {
-      ts.touch(newPath);
+    if (params.verbose_) {
+      out() << _("Renaming file to") << " " << plan.newPath;
+      if (params.timestamp_) {
+        out() << ", " << _("updating timestamp");
+      }
+      out() << '\n';
     }
-    return rc;
-  } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in rename action for file " << path << ":\n" << e << "\n";
-    return 1;
+    std::error_code ec;
+    fs::rename(plan.path, plan.newPath, ec);
+    if (ec) {
+      err() << plan.path << ": " << _("Failed to rename the file") << ": " << ec.message() << "\n";
+      return 1;
+    }
+  } else if (params.verbose_) {
+    out() << _("Updating timestamp to") << " " << plan.value << '\n';
+  }
+  if (params.preserve_ || params.timestamp_ || params.timestampOnly_) {
+    ts.touch(plan.newPath);
   }
+  return 0;
 }
 
 Task::UniquePtr Rename::clone() const {
@@ -666,7 +982,7 @@ int Erase::run(const std::string& path) {
     path_ = path;
 
     if (!Exiv2::fileExists(path_)) {
-      std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+      err() << path_ << ": " << _("Failed to open the file") << "\n";
       return -1;
     }
     Timestamp ts;
@@ -696,7 +1012,7 @@ int Erase::run(const std::string& path) {
       rc = eraseIccProfile(image.get());
     }
     if (0 == rc && Params::instance().target_ & Params::ctIptcRaw) {
-      rc = printStructure(std::cout, Exiv2::kpsIptcErase, path_);
+      rc = printStructure(out(), Exiv2::kpsIptcErase, path_);
     }
 
     if (0 == rc) {
@@ -707,7 +1023,7 @@ int Erase::run(const std::string& path) {
 
     return rc;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in erase action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in erase action for file " << path << ":\n" << e << "\n";
     return 1;
   }
 }
@@ -720,14 +1036,14 @@ int Erase::eraseThumbnail(Exiv2::Image* image) {
   }
   exifThumb.erase();
   if (Params::instance().verbose_) {
-    std::cout << _("Erasing thumbnail data") << '\n';
+    out() << _("Erasing thumbnail data") << '\n';
   }
   return 0;
 }
 
 int Erase::eraseExifData(Exiv2::Image* image) {
   if (Params::instance().verbose_ && !image->exifData().empty()) {
-    std::cout << _("Erasing Exif data from the file") << '\n';
+    out() << _("Erasing Exif data from the file") << '\n';
   }
   image->clearExifData();
   return 0;
@@ -735,7 +1051,7 @@ int Erase::eraseExifData(Exiv2::Image* image) {
 
 int Erase::eraseIptcData(Exiv2::Image* image) {
   if (Params::instance().verbose_ && !image->iptcData().empty()) {
-    std::cout << _("Erasing IPTC data from the file") << '\n';
+    out() << _("Erasing IPTC data from the file") << '\n';
   }
   image->clearIptcData();
   return 0;
@@ -743,7 +1059,7 @@ int Erase::eraseIptcData(Exiv2::Image* image) {
 
 int Erase::eraseComment(Exiv2::Image* image) {
   if (Params::instance().verbose_ && !image->comment().empty()) {
-    std::cout << _("Erasing JPEG comment from the file") << '\n';
+    out() << _("Erasing JPEG comment from the file") << '\n';
   }
   image->clearComment();
   return 0;
@@ -751,7 +1067,7 @@ int Erase::eraseComment(Exiv2::Image* image) {
 
 int Erase::eraseXmpData(Exiv2::Image* image) {
   if (Params::instance().verbose_ && !image->xmpData().empty()) {
-    std::cout << _("Erasing XMP data from the file") << '\n';
+    out() << _("Erasing XMP data from the file") << '\n';
   }
   image->clearXmpData();  // Quick fix for bug #612
   image->clearXmpPacket();
@@ -759,7 +1075,7 @@ int Erase::eraseXmpData(Exiv2::Image* image) {
 }
 int Erase::eraseIccProfile(Exiv2::Image* image) {
   if (Params::instance().verbose_ && image->iccProfileDefined()) {
-    std::cout << _("Erasing ICC Profile data from the file") << '\n';
+    out() << _("Erasing ICC Profile data from the file") << '\n';
   }
   image->clearIccProfile();
   return 0;
@@ -805,32 +1121,32 @@ int Extract::run(const std::string& path) {
     }
     return rc;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in extract action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in extract action for file " << path << ":\n" << e << "\n";
     return 1;
   }
 }
 
 int Extract::writeThumbnail() const {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
   auto image = Exiv2::ImageFactory::open(path_);
   image->readMetadata();
   Exiv2::ExifData& exifData = image->exifData();
   if (exifData.empty()) {
-    std::cerr << path_ << ": " << _("No Exif data found in the file") << "\n";
+    err() << path_ << ": " << _("No Exif data found in the file") << "\n";
     return -3;
   }
   int rc = 0;
   Exiv2::ExifThumb exifThumb(exifData);
   std::string thumbExt = exifThumb.extension();
   if (thumbExt.empty()) {
-    std::cerr << path_ << ": " << _("Image does not contain an Exif thumbnail") << "\n";
+    err() << path_ << ": " << _("Image does not contain an Exif thumbnail") << "\n";
   } else {
     if ((Params::instance().target_ & Params::ctStdInOut) != 0) {
       Exiv2::DataBuf buf = exifThumb.copy();
-      std::cout.write(buf.c_str(), buf.size());
+      out().write(buf.c_str(), buf.size());
       return 0;
     }
 
@@ -841,13 +1157,13 @@ int Extract::writeThumbnail() const {
     if (Params::instance().verbose_) {
       Exiv2::DataBuf buf = exifThumb.copy();
       if (!buf.empty()) {
-        std::cout << _("Writing thumbnail") << " (" << exifThumb.mimeType() << ", " << buf.size() << " " << _("Bytes")
+        out() << _("Writing thumbnail") << " (" << exifThumb.mimeType() << ", " << buf.size() << " " << _("Bytes")
                   << ") " << _("to file") << " " << thumbPath << '\n';
       }
     }
     rc = static_cast<int>(exifThumb.writeFile(thumb));
     if (rc == 0) {
-      std::cerr << path_ << ": " << _("Exif data doesn't contain a thumbnail") << "\n";
+      err() << path_ << ": " << _("Exif data doesn't contain a thumbnail") << "\n";
     }
   }
   return rc;
@@ -855,7 +1171,7 @@ int Extract::writeThumbnail() const {
 
 int Extract::writePreviews() const {
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
@@ -877,7 +1193,7 @@ int Extract::writePreviews() const {
     }
     num--;
     if (num >= pvList.size()) {
-      std::cerr << path_ << ": " << _("Image does not have preview") << " " << num + 1 << "\n";
+      err() << path_ << ": " << _("Image does not have preview") << " " << num + 1 << "\n";
       continue;
     }
     writePreviewFile(pvMgr.getPreviewImage(pvList[num]), num + 1);
@@ -888,7 +1204,7 @@ int Extract::writePreviews() const {
 int Extract::writeIccProfile(const std::string& target) const {
   int rc = 0;
   if (!Exiv2::fileExists(path_)) {
-    std::cerr << path_ << ": " << _("Failed to open the file") << "\n";
+    err() << path_ << ": " << _("Failed to open the file") << "\n";
     rc = -1;
   }
 
@@ -898,14 +1214,14 @@ int Extract::writeIccProfile(const std::string& target) const {
     auto image = Exiv2::ImageFactory::open(path_);
     image->readMetadata();
     if (!image->iccProfileDefined()) {
-      std::cerr << _("No embedded iccProfile: ") << path_ << '\n';
+      err() << _("No embedded iccProfile: ") << path_ << '\n';
       rc = -2;
     } else {
       if (bStdout) {  // -eC-
-        std::cout.write(image->iccProfile().c_str(), image->iccProfile().size());
+        out().write(image->iccProfile().c_str(), image->iccProfile().size());
       } else {
         if (Params::instance().verbose_) {
-          std::cout << _("Writing iccProfile: ") << target << '\n';
+          out() << _("Writing iccProfile: ") << target << '\n';
         }
         Exiv2::FileIo iccFile(target);
         iccFile.open("wb");
@@ -923,15 +1239,15 @@ void Extract::writePreviewFile(const Exiv2::PreviewImage& pvImg, size_t num) con
   if (dontOverwrite(pvPath))
     return;
   if (Params::instance().verbose_) {
-    std::cout << _("Writing preview") << " " << num << " (" << pvImg.mimeType() << ", ";
+    out() << _("Writing preview") << " " << num << " (" << pvImg.mimeType() << ", ";
     if (pvImg.width() != 0 && pvImg.height() != 0) {
-      std::cout << pvImg.width() << "x" << pvImg.height() << " " << _("pixels") << ", ";
+      out() << pvImg.width() << "x" << pvImg.height() << " " << _("pixels") << ", ";
     }
-    std::cout << pvImg.size() << " " << _("bytes") << ") " << _("to file") << " " << pvPath << '\n';
+    out() << pvImg.size() << " " << _("bytes") << ") " << _("to file") << " " << pvPath << '\n';
   }
   auto rc = pvImg.writeFile(pvFile);
   if (rc == 0) {
-    std::cerr << path_ << ": " << _("Image does not have preview") << " " << num << "\n";
+    err() << path_ << ": " << _("Image does not have preview") << " " << num << "\n";
   }
 }
 
@@ -944,7 +1260,7 @@ int Insert::run(const std::string& path) try {
   bool bStdin = (Params::instance().target_ & Params::ctStdInOut) != 0;
 
   if (!Exiv2::fileExists(path)) {
-    std::cerr << path << ": " << _("Failed to open the file") << "\n";
+    err() << path << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
 
@@ -983,7 +1299,7 @@ int Insert::run(const std::string& path) try {
     ts.touch(path);
   return rc;
 } catch (const Exiv2::Error& e) {
-  std::cerr << "Exiv2 exception in insert action for file " << path << ":\n" << e << "\n";
+  err() << "Exiv2 exception in insert action for file " << path << ":\n" << e << "\n";
   return 1;
 }  // Insert::run
 
@@ -996,11 +1312,11 @@ int Insert::insertXmpPacket(const std::string& path, const std::string& xmpPath)
     rc = insertXmpPacket(path, xmpBlob, true);
   } else {
     if (!Exiv2::fileExists(xmpPath)) {
-      std::cerr << xmpPath << ": " << _("Failed to open the file") << "\n";
+      err() << xmpPath << ": " << _("Failed to open the file") << "\n";
       rc = -1;
     }
     if (rc == 0 && !Exiv2::fileExists(path)) {
-      std::cerr << path << ": " << _("Failed to open the file") << "\n";
+      err() << path << ": " << _("Failed to open the file") << "\n";
       rc = -1;
     }
     if (rc == 0) {
@@ -1037,7 +1353,7 @@ int Insert::insertIccProfile(const std::string& path, const std::string& iccPath
     rc = insertIccProfile(path, std::move(iccProfile));
   } else {
     if (!Exiv2::fileExists(iccProfilePath)) {
-      std::cerr << iccProfilePath << ": " << _("Failed to open the file") << "\n";
+      err() << iccProfilePath << ": " << _("Failed to open the file") << "\n";
       rc = -1;
     } else {
       Exiv2::DataBuf iccProfile = Exiv2::readFile(iccPath);
@@ -1051,7 +1367,7 @@ int Insert::insertIccProfile(const std::string& path, Exiv2::DataBuf&& iccProfil
   int rc = 0;
   // test path exists
   if (!Exiv2::fileExists(path)) {
-    std::cerr << path << ": " << _("Failed to open the file") << "\n";
+    err() << path << ": " << _("Failed to open the file") << "\n";
     rc = -1;
   }
 
@@ -1073,11 +1389,11 @@ int Insert::insertIccProfile(const std::string& path, Exiv2::DataBuf&& iccProfil
 int Insert::insertThumbnail(const std::string& path) {
   std::string thumbPath = newFilePath(path, "-thumb.jpg");
   if (!Exiv2::fileExists(thumbPath)) {
-    std::cerr << thumbPath << ": " << _("Failed to open the file") << "\n";
+    err() << thumbPath << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
   if (!Exiv2::fileExists(path)) {
-    std::cerr << path << ": " << _("Failed to open the file") << "\n";
+    err() << path << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
   auto image = Exiv2::ImageFactory::open(path);
@@ -1096,7 +1412,7 @@ Task::UniquePtr Insert::clone() const {
 int Modify::run(const std::string& path) {
   try {
     if (!Exiv2::fileExists(path)) {
-      std::cerr << path << ": " << _("Failed to open the file") << "\n";
+      err() << path << ": " << _("Failed to open the file") << "\n";
       return -1;
     }
     Timestamp ts;
@@ -1116,7 +1432,7 @@ int Modify::run(const std::string& path) {
 
     return rc;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in modify action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in modify action for file " << path << ":\n" << e << "\n";
     return 1;
   }
 }  // Modify::run
@@ -1126,100 +1442,228 @@ int Modify::applyCommands(Exiv2::Image* pImage) {
     // If modify is used when extracting to stdout then ignore verbose
     if (Params::instance().verbose_ &&
         !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut)) {
-      std::cout << _("Setting JPEG comment") << " '" << Params::instance().jpegComment_ << "'" << '\n';
+      out() << _("Setting JPEG comment") << " '" << Params::instance().jpegComment_ << "'" << '\n';
     }
     pImage->setComment(Params::instance().jpegComment_);
   }
 
-  // loop through command table and apply each command
-  const ModifyCmds& modifyCmds = Params::instance().modifyCmds_;
-  int rc = 0;
-  int ret = 0;
-  for (const auto& cmd : modifyCmds) {
-    switch (cmd.cmdId_) {
-      case CmdId::add:
-        ret = addMetadatum(pImage, cmd);
-        if (rc == 0)
-          rc = ret;
-        break;
-      case CmdId::set:
-        ret = setMetadatum(pImage, cmd);
-        if (rc == 0)
-          rc = ret;
-        break;
-      case CmdId::del:
-        delMetadatum(pImage, cmd);
-        break;
-      case CmdId::reg:
-        regNamespace(cmd);
-        break;
-      case CmdId::invalid:
-        break;
+  return ModifyProgram::instance().apply(*pImage);
+}  // Modify::applyCommands
+
+Task::UniquePtr Modify::clone() const {
+  return std::make_unique<Modify>(*this);
+}
+
+struct ModifyProgram::Instruction {
+  ModifyCmd cmd;                  //!< The command as parsed
+  Exiv2::Key::UniquePtr key;      //!< Key of add, set and del commands
+  std::string name;               //!< Index id of Exif and XMP keys
+  uint32_t dataSet{0};            //!< Index id of IPTC keys
+  Exiv2::Value::UniquePtr value;  //!< Value of add and set commands, empty if it cannot be read
+};
+
+namespace {
+// Ids of the metadata in a KeyIndex. Those of IPTC metadata compare like IptcData::findKey() does.
+std::string indexId(const Exiv2::Exifdatum& md) {
+  return md.key();
+}
+
+std::string indexId(const Exiv2::ExifKey& key) {
+  return key.key();
+}
+
+uint32_t indexId(const Exiv2::Iptcdatum& md) {
+  return static_cast<uint32_t>(md.record()) << 16 | md.tag();
+}
+
+uint32_t indexId(const Exiv2::IptcKey& key) {
+  return static_cast<uint32_t>(key.record()) << 16 | key.tag();
+}
+
+std::string indexId(const Exiv2::Xmpdatum& md) {
+  return md.key();
+}
+
+std::string indexId(const Exiv2::XmpKey& key) {
+  return key.key();
+}
+
+/*!
+  @brief Index of the first metadatum with each key in the Exif, IPTC or XMP
+         data of an image. It is built when it is first used and kept up to
+         date when metadata are added or erased through it.
+ */
+template <typename Data, typename Id>
+class KeyIndex {
+ public:
+  explicit KeyIndex(Data& data) : data_(data) {
+  }
+
+  [[nodiscard]] Data& data() const {
+    return data_;
+  }
+  [[nodiscard]] typename Data::iterator end() const {
+    return data_.end();
+  }
+
+  //! Return the first metadatum with \em id, or end()
+  typename Data::iterator find(const Id& id) {
+    if (!valid_) {
+      index_.clear();
+      for (auto it = data_.begin(); it != data_.end(); ++it)
+        index_.try_emplace(indexId(*it), it);
+      valid_ = true;
     }
+    auto pos = index_.find(id);
+    return pos == index_.end() ? data_.end() : pos->second;
+  }
+
+  //! Call \em addFct, which appends at most one metadatum to the data, and index the new metadatum
+  template <typename AddFct>
+  void add(AddFct addFct) {
+    const auto count = data_.count();
+    const auto* first = data_.empty() ? nullptr : &*data_.begin();
+    addFct(data_);
+    if (!valid_ || data_.count() == count)
+      return;
+    // Iterators into a vector are invalidated when its storage is reallocated
+    if (&*data_.begin() != first) {
+      valid_ = false;
+      return;
+    }
+    auto last = std::prev(data_.end());
+    index_.try_emplace(indexId(*last), last);
   }
-  return rc;
-}  // Modify::applyCommands
 
-int Modify::addMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd) {
+  //! Erase all metadata with \em id
+  void erase(const Id& id) {
+    auto pos = find(id);
+    while (pos != data_.end()) {
+      if (indexId(*pos) == id) {
+        pos = data_.erase(pos);
+      } else {
+        ++pos;
+      }
+    }
+    // Erasing from a vector moves the metadata which follow
+    if constexpr (std::is_same_v<typename std::iterator_traits<typename Data::iterator>::iterator_category,
+                                 std::random_access_iterator_tag>) {
+      valid_ = false;
+    } else {
+      index_.erase(id);
+    }
+  }
+
+  //! Rebuild the index when it is used next, after the data was changed otherwise
+  void invalidate() {
+    valid_ = false;
+  }
+
+ private:
+  Data& data_;
+  std::unordered_map<Id, typename Data::iterator> index_;
+  bool valid_{false};
+};
+
+//! The key indexes of the metadata of the image to which a ModifyProgram is applied
+struct MetadataIndex {
+  explicit MetadataIndex(Exiv2::Image& image) : exif(image.exifData()), iptc(image.iptcData()), xmp(image.xmpData()) {
+  }
+
+  //! Return the first metadatum with the key of \em ins, or nullptr
+  Exiv2::Metadatum* find(const ModifyProgram::Instruction& ins) {
+    if (ins.cmd.metadataId_ == MetadataId::exif) {
+      if (auto pos = exif.find(ins.name); pos != exif.end())
+        return &*pos;
+    }
+    if (ins.cmd.metadataId_ == MetadataId::iptc) {
+      if (auto pos = iptc.find(ins.dataSet); pos != iptc.end())
+        return &*pos;
+    }
+    if (ins.cmd.metadataId_ == MetadataId::xmp) {
+      if (auto pos = xmp.find(ins.name); pos != xmp.end())
+        return &*pos;
+    }
+    return nullptr;
+  }
+
+  //! Add a metadatum with the key of \em ins and \em value
+  void add(const ModifyProgram::Instruction& ins, const Exiv2::Value* value) {
+    if (ins.cmd.metadataId_ == MetadataId::exif) {
+      exif.add([&](auto& data) { data.add(static_cast<const Exiv2::ExifKey&>(*ins.key), value); });
+    }
+    if (ins.cmd.metadataId_ == MetadataId::iptc) {
+      iptc.add([&](auto& data) { data.add(static_cast<const Exiv2::IptcKey&>(*ins.key), value); });
+    }
+    if (ins.cmd.metadataId_ == MetadataId::xmp) {
+      xmp.add([&](auto& data) { data.add(static_cast<const Exiv2::XmpKey&>(*ins.key), value); });
+    }
+  }
+
+  KeyIndex<Exiv2::ExifData, std::string> exif;
+  KeyIndex<Exiv2::IptcData, uint32_t> iptc;
+  KeyIndex<Exiv2::XmpData, std::string> xmp;
+};
+
+//! Return true if the verbose output of the modify commands is printed
+bool modifyVerbose() {
   // If modify is used when extracting to stdout then ignore verbose
-  if (Params::instance().verbose_ &&
-      !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut)) {
-    std::cout << _("Add") << " " << modifyCmd.key_ << " \"" << modifyCmd.value_ << "\" ("
-              << Exiv2::TypeInfo::typeName(modifyCmd.typeId_) << ")" << '\n';
-  }
-  Exiv2::ExifData& exifData = pImage->exifData();
-  Exiv2::IptcData& iptcData = pImage->iptcData();
-  Exiv2::XmpData& xmpData = pImage->xmpData();
+  return Params::instance().verbose_ &&
+         !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut);
+}
+
+//! Return true if reading a string into a value of type \em typeId replaces all of its previous content
+bool readReplacesValue(Exiv2::TypeId typeId) {
+  switch (typeId) {
+    case Exiv2::time:     // keeps the time zone if none is read
+    case Exiv2::comment:  // keeps the byte order
+    case Exiv2::xmpText:  // keeps the XMP array type if none is read
+    case Exiv2::xmpAlt:   // appends an item
+    case Exiv2::xmpBag:
+    case Exiv2::xmpSeq:
+    case Exiv2::langAlt:  // adds a language
+      return false;
+    default:
+      return true;
+  }
+}
+
+void printReadWarning(const ModifyCmd& modifyCmd, Exiv2::TypeId typeId) {
+  err() << _("Warning") << ": " << modifyCmd.key_ << ": " << _("Failed to read") << " "
+        << Exiv2::TypeInfo::typeName(typeId) << " " << _("value") << " \"" << modifyCmd.value_ << "\"\n";
+}
+
+//! Add a metadatum according to \em ins
+int addMetadatum(MetadataIndex& index, const ModifyProgram::Instruction& ins) {
+  const ModifyCmd& modifyCmd = ins.cmd;
+  if (modifyVerbose()) {
+    out() << _("Add") << " " << modifyCmd.key_ << " \"" << modifyCmd.value_ << "\" ("
+          << Exiv2::TypeInfo::typeName(modifyCmd.typeId_) << ")" << '\n';
+  }
+  if (ins.value) {
+    index.add(ins, ins.value.get());
+    return 0;
+  }
+  // Read the value again, to report the failure for this file
   auto value = Exiv2::Value::create(modifyCmd.typeId_);
   int rc = value->read(modifyCmd.value_);
   if (0 == rc) {
-    if (modifyCmd.metadataId_ == MetadataId::exif) {
-      exifData.add(Exiv2::ExifKey(modifyCmd.key_), value.get());
-    }
-    if (modifyCmd.metadataId_ == MetadataId::iptc) {
-      iptcData.add(Exiv2::IptcKey(modifyCmd.key_), value.get());
-    }
-    if (modifyCmd.metadataId_ == MetadataId::xmp) {
-      xmpData.add(Exiv2::XmpKey(modifyCmd.key_), value.get());
-    }
+    index.add(ins, value.get());
   } else {
-    std::cerr << _("Warning") << ": " << modifyCmd.key_ << ": " << _("Failed to read") << " "
-              << Exiv2::TypeInfo::typeName(value->typeId()) << " " << _("value") << " \"" << modifyCmd.value_ << "\"\n";
+    printReadWarning(modifyCmd, value->typeId());
   }
   return rc;
 }
 
 // This function looks rather complex because we try to avoid adding an
 // empty metadatum if reading the value fails
-int Modify::setMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd) {
-  // If modify is used when extracting to stdout then ignore verbose
-  if (Params::instance().verbose_ &&
-      !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut)) {
-    std::cout << _("Set") << " " << modifyCmd.key_ << " \"" << modifyCmd.value_ << "\" ("
-              << Exiv2::TypeInfo::typeName(modifyCmd.typeId_) << ")" << '\n';
-  }
-  Exiv2::ExifData& exifData = pImage->exifData();
-  Exiv2::IptcData& iptcData = pImage->iptcData();
-  Exiv2::XmpData& xmpData = pImage->xmpData();
-  Exiv2::Metadatum* metadatum = nullptr;
-  if (modifyCmd.metadataId_ == MetadataId::exif) {
-    auto pos = exifData.findKey(Exiv2::ExifKey(modifyCmd.key_));
-    if (pos != exifData.end()) {
-      metadatum = &(*pos);
-    }
-  }
-  if (modifyCmd.metadataId_ == MetadataId::iptc) {
-    auto pos = iptcData.findKey(Exiv2::IptcKey(modifyCmd.key_));
-    if (pos != iptcData.end()) {
-      metadatum = &(*pos);
-    }
-  }
-  if (modifyCmd.metadataId_ == MetadataId::xmp) {
-    auto pos = xmpData.findKey(Exiv2::XmpKey(modifyCmd.key_));
-    if (pos != xmpData.end()) {
-      metadatum = &(*pos);
-    }
+int setMetadatum(MetadataIndex& index, const ModifyProgram::Instruction& ins) {
+  const ModifyCmd& modifyCmd = ins.cmd;
+  if (modifyVerbose()) {
+    out() << _("Set") << " " << modifyCmd.key_ << " \"" << modifyCmd.value_ << "\" ("
+          << Exiv2::TypeInfo::typeName(modifyCmd.typeId_) << ")" << '\n';
   }
+  Exiv2::Metadatum* metadatum = index.find(ins);
   // If a type was explicitly requested, use it; else
   // use the current type of the metadatum, if any;
   // or the default type
@@ -1227,76 +1671,131 @@ int Modify::setMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd) {
   if (metadatum) {
     value = metadatum->getValue();
   }
-  if (!value || (modifyCmd.explicitType_ && modifyCmd.typeId_ != value->typeId())) {
-    value = Exiv2::Value::create(modifyCmd.typeId_);
+  if (value && modifyCmd.explicitType_ && modifyCmd.typeId_ != value->typeId()) {
+    value.reset();
+  }
+  // The value read when the program was compiled can be used, unless it
+  // has to be merged into the current value
+  const Exiv2::Value* newValue = nullptr;
+  if (ins.value && (!value || (value->typeId() == ins.value->typeId() && readReplacesValue(value->typeId()) &&
+                               value->sizeDataArea() == 0))) {
+    newValue = ins.value.get();
+  }
+  int rc = 0;
+  if (!newValue) {
+    if (!value) {
+      value = Exiv2::Value::create(modifyCmd.typeId_);
+    }
+    rc = value->read(modifyCmd.value_);
+    newValue = value.get();
   }
-  int rc = value->read(modifyCmd.value_);
   if (0 == rc) {
     if (metadatum) {
-      metadatum->setValue(value.get());
+      metadatum->setValue(newValue);
     } else {
-      if (modifyCmd.metadataId_ == MetadataId::exif) {
-        exifData.add(Exiv2::ExifKey(modifyCmd.key_), value.get());
-      }
-      if (modifyCmd.metadataId_ == MetadataId::iptc) {
-        iptcData.add(Exiv2::IptcKey(modifyCmd.key_), value.get());
-      }
-      if (modifyCmd.metadataId_ == MetadataId::xmp) {
-        xmpData.add(Exiv2::XmpKey(modifyCmd.key_), value.get());
-      }
+      index.add(ins, newValue);
     }
   } else {
-    std::cerr << _("Warning") << ": " << modifyCmd.key_ << ": " << _("Failed to read") << " "
-              << Exiv2::TypeInfo::typeName(value->typeId()) << " " << _("value") << " \"" << modifyCmd.value_ << "\"\n";
+    printReadWarning(modifyCmd, value->typeId());
   }
   return rc;
 }
 
-void Modify::delMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd) {
-  // If modify is used when extracting to stdout then ignore verbose
-  if (Params::instance().verbose_ &&
-      !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut)) {
-    std::cout << _("Del") << " " << modifyCmd.key_ << '\n';
+//! Delete the metadata with the key of \em ins
+void delMetadatum(MetadataIndex& index, const ModifyProgram::Instruction& ins) {
+  const ModifyCmd& modifyCmd = ins.cmd;
+  if (modifyVerbose()) {
+    out() << _("Del") << " " << modifyCmd.key_ << '\n';
   }
-
-  Exiv2::ExifData& exifData = pImage->exifData();
-  Exiv2::IptcData& iptcData = pImage->iptcData();
-  Exiv2::XmpData& xmpData = pImage->xmpData();
   if (modifyCmd.metadataId_ == MetadataId::exif) {
-    Exiv2::ExifData::iterator pos;
-    const Exiv2::ExifKey exifKey(modifyCmd.key_);
-    while ((pos = exifData.findKey(exifKey)) != exifData.end()) {
-      exifData.erase(pos);
-    }
+    index.exif.erase(ins.name);
   }
   if (modifyCmd.metadataId_ == MetadataId::iptc) {
-    Exiv2::IptcData::iterator pos;
-    const Exiv2::IptcKey iptcKey(modifyCmd.key_);
-    while ((pos = iptcData.findKey(iptcKey)) != iptcData.end()) {
-      iptcData.erase(pos);
-    }
+    index.iptc.erase(ins.dataSet);
   }
   if (modifyCmd.metadataId_ == MetadataId::xmp) {
-    const Exiv2::XmpKey xmpKey(modifyCmd.key_);
-    auto pos = xmpData.findKey(xmpKey);
-    if (pos != xmpData.end()) {
-      xmpData.eraseFamily(pos);
+    auto pos = index.xmp.find(ins.name);
+    if (pos != index.xmp.end()) {
+      index.xmp.data().eraseFamily(pos);
+      index.xmp.invalidate();
     }
   }
 }
 
-void Modify::regNamespace(const ModifyCmd& modifyCmd) {
-  // If modify is used when extracting to stdout then ignore verbose
-  if (Params::instance().verbose_ &&
-      !(Params::instance().action_ & Action::extract && Params::instance().target_ & Params::ctStdInOut)) {
-    std::cout << _("Reg ") << modifyCmd.key_ << "=\"" << modifyCmd.value_ << "\"" << '\n';
+//! Register an XMP namespace according to \em modifyCmd
+void regNamespace(const ModifyCmd& modifyCmd) {
+  if (modifyVerbose()) {
+    out() << _("Reg ") << modifyCmd.key_ << "=\"" << modifyCmd.value_ << "\"" << '\n';
   }
   Exiv2::XmpProperties::registerNs(modifyCmd.value_, modifyCmd.key_);
 }
 
-Task::UniquePtr Modify::clone() const {
-  return std::make_unique<Modify>(*this);
+//! Resolve the key of an add, set or del command and store its index id in \em id
+template <typename KeyType, typename Id>
+void resolveKey(ModifyProgram::Instruction& ins, Id& id) {
+  auto key = std::make_unique<KeyType>(ins.cmd.key_);
+  id = indexId(*key);
+  ins.key = std::move(key);
 }
+}  // namespace
+
+ModifyProgram::ModifyProgram(const ModifyCmds& modifyCmds) {
+  // Values which cannot be read are read again for each file, to report the failure there. Until then, keep quiet.
+  OutputBuffer quiet;
+  for (const auto& cmd : modifyCmds) {
+    Instruction ins;
+    ins.cmd = cmd;
+    if (cmd.cmdId_ == CmdId::add || cmd.cmdId_ == CmdId::set || cmd.cmdId_ == CmdId::del) {
+      if (cmd.metadataId_ == MetadataId::exif)
+        resolveKey<Exiv2::ExifKey>(ins, ins.name);
+      if (cmd.metadataId_ == MetadataId::iptc)
+        resolveKey<Exiv2::IptcKey>(ins, ins.dataSet);
+      if (cmd.metadataId_ == MetadataId::xmp)
+        resolveKey<Exiv2::XmpKey>(ins, ins.name);
+    }
+    if (cmd.cmdId_ == CmdId::add || cmd.cmdId_ == CmdId::set) {
+      auto value = Exiv2::Value::create(cmd.typeId_);
+      if (value->read(cmd.value_) == 0)
+        ins.value = std::move(value);
+    }
+    instructions_.push_back(std::move(ins));
+  }
+}
+
+ModifyProgram::~ModifyProgram() = default;
+
+const ModifyProgram& ModifyProgram::instance() {
+  return *Params::instance().modifyProgram_;
+}
+
+int ModifyProgram::apply(Exiv2::Image& image) const {
+  MetadataIndex index(image);
+  int rc = 0;
+  int ret = 0;
+  for (const auto& ins : instructions_) {
+    switch (ins.cmd.cmdId_) {
+      case CmdId::add:
+        ret = addMetadatum(index, ins);
+        if (rc == 0)
+          rc = ret;
+        break;
+      case CmdId::set:
+        ret = setMetadatum(index, ins);
+        if (rc == 0)
+          rc = ret;
+        break;
+      case CmdId::del:
+        delMetadatum(index, ins);
+        break;
+      case CmdId::reg:
+        regNamespace(ins.cmd);
+        break;
+      case CmdId::invalid:
+        break;
+    }
+  }
+  return rc;
+}  // ModifyProgram::apply
 
 int Adjust::run(const std::string& path) try {
   adjustment_ = Params::instance().adjustment_;
@@ -1305,7 +1804,7 @@ int Adjust::run(const std::string& path) try {
   dayAdjustment_ = Params::instance().yodAdjust_[Params::yodDay].adjustment_;
 
   if (!Exiv2::fileExists(path)) {
-    std::cerr << path << ": " << _("Failed to open the file") << "\n";
+    err() << path << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
   Timestamp ts;
@@ -1316,7 +1815,7 @@ int Adjust::run(const std::string& path) try {
   image->readMetadata();
   Exiv2::ExifData& exifData = image->exifData();
   if (exifData.empty()) {
-    std::cerr << path << ": " << _("No Exif data found in the file") << "\n";
+    err() << path << ": " << _("No Exif data found in the file") << "\n";
     return -3;
   }
   int rc = adjustDateTime(exifData, "Exif.Image.DateTime", path);
@@ -1325,13 +1824,14 @@ int Adjust::run(const std::string& path) try {
   rc += adjustDateTime(exifData, "Exif.Photo.DateTimeDigitized", path);
 
   if (rc == 0) {
-    image->writeMetadata();
+    if (!patchExif(path, *image))
+      image->writeMetadata();
     if (Params::instance().preserve_)
       ts.touch(path);
   }
   return rc ? 1 : 0;
 } catch (const Exiv2::Error& e) {
-  std::cerr << "Exiv2 exception in adjust action for file " << path << ":\n" << e << "\n";
+  err() << "Exiv2 exception in adjust action for file " << path << ":\n" << e << "\n";
   return 1;
 }  // Adjust::run
 
@@ -1348,54 +1848,54 @@ int Adjust::adjustDateTime(Exiv2::ExifData& exifData, const std::string& key, co
   }
   std::string timeStr = md->toString();
   if (timeStr.empty() || timeStr[0] == ' ') {
-    std::cerr << path << ": " << _("Timestamp of metadatum with key") << " `" << ek << "' " << _("not set") << "\n";
+    err() << path << ": " << _("Timestamp of metadatum with key") << " `" << ek << "' " << _("not set") << "\n";
     return 1;
   }
   if (Params::instance().verbose_) {
     bool comma = false;
-    std::cout << _("Adjusting") << " `" << ek << "' " << _("by");
+    out() << _("Adjusting") << " `" << ek << "' " << _("by");
     if (yearAdjustment_ != 0) {
-      std::cout << (yearAdjustment_ < 0 ? " " : " +") << yearAdjustment_ << " ";
+      out() << (yearAdjustment_ < 0 ? " " : " +") << yearAdjustment_ << " ";
       if (yearAdjustment_ < -1 || yearAdjustment_ > 1) {
-        std::cout << _("years");
+        out() << _("years");
       } else {
-        std::cout << _("year");
+        out() << _("year");
       }
       comma = true;
     }
     if (monthAdjustment_ != 0) {
       if (comma)
-        std::cout << ",";
-      std::cout << (monthAdjustment_ < 0 ? " " : " +") << monthAdjustment_ << " ";
+        out() << ",";
+      out() << (monthAdjustment_ < 0 ? " " : " +") << monthAdjustment_ << " ";
       if (monthAdjustment_ < -1 || monthAdjustment_ > 1) {
-        std::cout << _("months");
+        out() << _("months");
       } else {
-        std::cout << _("month");
+        out() << _("month");
       }
       comma = true;
     }
     if (dayAdjustment_ != 0) {
       if (comma)
-        std::cout << ",";
-      std::cout << (dayAdjustment_ < 0 ? " " : " +") << dayAdjustment_ << " ";
+        out() << ",";
+      out() << (dayAdjustment_ < 0 ? " " : " +") << dayAdjustment_ << " ";
       if (dayAdjustment_ < -1 || dayAdjustment_ > 1) {
-        std::cout << _("days");
+        out() << _("days");
       } else {
-        std::cout << _("day");
+        out() << _("day");
       }
       comma = true;
     }
     if (adjustment_ != 0) {
       if (comma)
-        std::cout << ",";
-      std::cout << " " << adjustment_ << _("s");
+        out() << ",";
+      out() << " " << adjustment_ << _("s");
     }
   }
   std::tm tm;
   if (str2Tm(timeStr, &tm) != 0) {
     if (Params::instance().verbose_)
-      std::cout << '\n';
-    std::cerr << path << ": " << _("Failed to parse timestamp") << " `" << timeStr << "'\n";
+      out() << '\n';
+    err() << path << ": " << _("Failed to parse timestamp") << " `" << timeStr << "'\n";
     return 1;
   }
 
@@ -1434,8 +1934,8 @@ int Adjust::adjustDateTime(Exiv2::ExifData& exifData, const std::string& key, co
   // Let's not create files with non-4-digit years, we can't read them.
   if (tm.tm_year > 9999 - 1900 || tm.tm_year < 1000 - 1900) {
     if (Params::instance().verbose_)
-      std::cout << '\n';
-    std::cerr << path << ": " << _("Can't adjust timestamp by") << " " << yearAdjustment + monOverflow << " "
+      out() << '\n';
+    err() << path << ": " << _("Can't adjust timestamp by") << " " << yearAdjustment + monOverflow << " "
               << _("years") << "\n";
     return 1;
   }
@@ -1443,7 +1943,7 @@ int Adjust::adjustDateTime(Exiv2::ExifData& exifData, const std::string& key, co
   time = Safe::add(time, Safe::add(adjustment, dayAdjustment * secondsInDay));
   timeStr = time2Str(time);
   if (Params::instance().verbose_) {
-    std::cout << " " << _("to") << " " << timeStr << '\n';
+    out() << " " << _("to") << " " << timeStr << '\n';
   }
   md->setValue(timeStr);
   return 0;
@@ -1452,7 +1952,7 @@ int Adjust::adjustDateTime(Exiv2::ExifData& exifData, const std::string& key, co
 int FixIso::run(const std::string& path) {
   try {
     if (!Exiv2::fileExists(path)) {
-      std::cerr << path << ": " << _("Failed to open the file") << "\n";
+      err() << path << ": " << _("Failed to open the file") << "\n";
       return -1;
     }
     Timestamp ts;
@@ -1463,14 +1963,14 @@ int FixIso::run(const std::string& path) {
     image->readMetadata();
     Exiv2::ExifData& exifData = image->exifData();
     if (exifData.empty()) {
-      std::cerr << path << ": " << _("No Exif data found in the file") << "\n";
+      err() << path << ": " << _("No Exif data found in the file") << "\n";
       return -3;
     }
     auto md = Exiv2::isoSpeed(exifData);
     if (md != exifData.end()) {
       if (md->key() == "Exif.Photo.ISOSpeedRatings") {
         if (Params::instance().verbose_) {
-          std::cout << _("Standard Exif ISO tag exists; not modified") << "\n";
+          out() << _("Standard Exif ISO tag exists; not modified") << "\n";
         }
         return 0;
       }
@@ -1478,17 +1978,18 @@ int FixIso::run(const std::string& path) {
       std::ostringstream os;
       md->write(os, &exifData);
       if (Params::instance().verbose_) {
-        std::cout << _("Setting Exif ISO value to") << " " << os.str() << "\n";
+        out() << _("Setting Exif ISO value to") << " " << os.str() << "\n";
       }
       exifData["Exif.Photo.ISOSpeedRatings"] = os.str();
     }
-    image->writeMetadata();
+    if (!patchExif(path, *image))
+      image->writeMetadata();
     if (Params::instance().preserve_)
       ts.touch(path);
 
     return 0;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in fixiso action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in fixiso action for file " << path << ":\n" << e << "\n";
     return 1;
   }
 }  // FixIso::run
@@ -1500,7 +2001,7 @@ Task::UniquePtr FixIso::clone() const {
 int FixCom::run(const std::string& path) {
   try {
     if (!Exiv2::fileExists(path)) {
-      std::cerr << path << ": " << _("Failed to open the file") << "\n";
+      err() << path << ": " << _("Failed to open the file") << "\n";
       return -1;
     }
     Timestamp ts;
@@ -1511,13 +2012,13 @@ int FixCom::run(const std::string& path) {
     image->readMetadata();
     Exiv2::ExifData& exifData = image->exifData();
     if (exifData.empty()) {
-      std::cerr << path << ": " << _("No Exif data found in the file") << "\n";
+      err() << path << ": " << _("No Exif data found in the file") << "\n";
       return -3;
     }
     auto pos = exifData.findKey(Exiv2::ExifKey("Exif.Photo.UserComment"));
     if (pos == exifData.end()) {
       if (Params::instance().verbose_) {
-        std::cout << _("No Exif user comment found") << "\n";
+        out() << _("No Exif user comment found") << "\n";
       }
       return 0;
     }
@@ -1525,31 +2026,32 @@ int FixCom::run(const std::string& path) {
     const auto pcv = dynamic_cast<const Exiv2::CommentValue*>(v.get());
     if (!pcv) {
       if (Params::instance().verbose_) {
-        std::cout << _("Found Exif user comment with unexpected value type") << "\n";
+        out() << _("Found Exif user comment with unexpected value type") << "\n";
       }
       return 0;
     }
     Exiv2::CommentValue::CharsetId csId = pcv->charsetId();
     if (csId != Exiv2::CommentValue::unicode) {
       if (Params::instance().verbose_) {
-        std::cout << _("No Exif UNICODE user comment found") << "\n";
+        out() << _("No Exif UNICODE user comment found") << "\n";
       }
       return 0;
     }
     std::string comment = pcv->comment(Params::instance().charset_.c_str());
     if (Params::instance().verbose_) {
-      std::cout << _("Setting Exif UNICODE user comment to") << " \"" << comment << "\"\n";
+      out() << _("Setting Exif UNICODE user comment to") << " \"" << comment << "\"\n";
     }
     comment = std::string("charset=\"") + Exiv2::CommentValue::CharsetInfo::name(csId) + "\" " + comment;
     // Remove BOM and convert value from source charset to UCS-2, but keep byte order
     pos->setValue(comment);
-    image->writeMetadata();
+    if (!patchExif(path, *image))
+      image->writeMetadata();
     if (Params::instance().preserve_)
       ts.touch(path);
 
     return 0;
   } catch (const Exiv2::Error& e) {
-    std::cerr << "Exiv2 exception in fixcom action for file " << path << ":\n" << e << "\n";
+    err() << "Exiv2 exception in fixcom action for file " << path << ":\n" << e << "\n";
     return 1;
   }
 }  // FixCom::run
@@ -1558,11 +2060,91 @@ Task::UniquePtr FixCom::clone() const {
   return std::make_unique<FixCom>(*this);
 }
 
+int Diff::run(const std::string& path) try {
+  const auto& params = Params::instance();
+  const auto& first = params.files_.front();
+  const auto& second = params.files_.back();
+  std::string path1 = path;
+  std::string path2 = second;
+  if (params.recursive_) {
+    // The file is in one of the two directories, the file with the same relative path in the other is its counterpart
+    auto relative = fs::path(path).lexically_relative(first);
+    if (!relative.empty() && *relative.begin() != "..") {
+      path2 = (fs::path(second) / relative).string();
+    } else {
+      path1 = (fs::path(first) / fs::path(path).lexically_relative(second)).string();
+      path2 = path;
+    }
+    for (const auto& p : {path1, path2}) {
+      if (!Exiv2::fileExists(p)) {
+        const auto& other = fs::path(p == path1 ? path2 : path1);
+        out() << _("Only in") << " " << other.parent_path().string() << ": " << other.filename().string() << "\n";
+        return 1;
+      }
+    }
+  }
+  for (const auto& p : {path1, path2}) {
+    if (!Exiv2::fileExists(p)) {
+      err() << p << ": " << _("Failed to open the file") << "\n";
+      return -1;
+    }
+  }
+
+  auto image1 = Exiv2::ImageFactory::open(path1);
+  image1->readMetadata();
+  auto image2 = Exiv2::ImageFactory::open(path2);
+  image2->readMetadata();
+
+  bool same = true;
+  auto compare = [&](const Exiv2::CanonicalMetadata& metadata1, const Exiv2::CanonicalMetadata& metadata2) {
+    if (Exiv2::digest(metadata1) == Exiv2::digest(metadata2))
+      return;
+    if (same) {
+      out() << "--- " << path1 << "\n" << "+++ " << path2 << "\n";
+      same = false;
+    }
+    auto print = [](char sign, const std::pair<std::string, std::string>& md) {
+      out() << sign << " " << std::setw(44) << std::left << md.first << " " << md.second << "\n";
+    };
+    // Both are ordered by key, repeated keys are compared in their order
+    auto it1 = metadata1.begin();
+    auto it2 = metadata2.begin();
+    while (it1 != metadata1.end() || it2 != metadata2.end()) {
+      if (it2 == metadata2.end() || (it1 != metadata1.end() && it1->first < it2->first)) {
+        print('-', *it1++);
+      } else if (it1 == metadata1.end() || it2->first < it1->first) {
+        print('+', *it2++);
+      } else {
+        if (it1->second != it2->second) {
+          print('-', *it1);
+          print('+', *it2);
+        }
+        ++it1;
+        ++it2;
+      }
+    }
+  };
+  compare(Exiv2::canonicalMetadata(image1->exifData()), Exiv2::canonicalMetadata(image2->exifData()));
+  compare(Exiv2::canonicalMetadata(image1->iptcData()), Exiv2::canonicalMetadata(image2->iptcData()));
+  compare(Exiv2::canonicalMetadata(image1->xmpData()), Exiv2::canonicalMetadata(image2->xmpData()));
+  return same ? 0 : 1;
+} catch (const Exiv2::Error& e) {
+  err() << "Exiv2 exception in diff action for file " << path << ":\n" << e << "\n";
+  return 1;
+}  // Diff::run
+
+Task::UniquePtr Diff::clone() const {
+  return std::make_unique<Diff>(*this);
+}
+
 }  // namespace Action
 
 // *****************************************************************************
 // local definitions
 namespace {
+using Action::err;
+using Action::out;
+
 //! @cond IGNORE
 int Timestamp::read(const std::string& path) {
   struct stat buf;
@@ -1667,7 +2249,7 @@ std::string temporaryPath() {
   pid_t pid = ::getpid();
 #endif
   /// \todo check if we can use std::tmpnam
-  auto p = fs::temp_directory_path() / (Exiv2::toString(pid) + "_" + std::to_string(count));
+  auto p = fs::temp_directory_path() / (Exiv2::toString(pid) + "_" + std::to_string(count++));
   if (fs::exists(p)) {
     fs::remove(p);
   }
@@ -1675,22 +2257,291 @@ std::string temporaryPath() {
   return p.string();
 }
 
+bool patchExif(const std::string& path, Exiv2::Image& image) {
+  if (image.imageType() != Exiv2::ImageType::jpeg || image.byteOrder() == Exiv2::invalidByteOrder)
+    return false;
+  Exiv2::FileIo io(path);
+  if (io.open("r+b") != 0)
+    return false;
+  Exiv2::IoCloser closer(io);
+
+  // Find the first Exif APP1 segment, which is the one read and written by the library
+  static constexpr std::array<Exiv2::byte, 6> exifId{'E', 'x', 'i', 'f', '\0', '\0'};
+  std::array<Exiv2::byte, 6> buf;
+  if (io.read(buf.data(), 2) != 2 || buf[0] != 0xff || buf[1] != 0xd8)
+    return false;
+  size_t size = 0;
+  while (size == 0) {
+    int marker = io.getb();
+    if (marker != 0xff)
+      return false;
+    // Markers may be preceded by fill bytes
+    while (marker == 0xff)
+      marker = io.getb();
+    // There is no Exif data before the image data or the end of the image
+    if (marker == EOF || marker == 0xd9 || marker == 0xda)
+      return false;
+    // Standalone markers have no segment
+    if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7))
+      continue;
+    if (io.read(buf.data(), 2) != 2)
+      return false;
+    const size_t length = Exiv2::getUShort(buf.data(), Exiv2::bigEndian);
+    if (length < 2)
+      return false;
+    if (marker == 0xe1 && length > 8) {
+      if (io.read(buf.data(), 6) != 6)
+        return false;
+      if (buf == exifId) {
+        size = length - 8;
+      } else if (io.seek(length - 8, Exiv2::BasicIo::cur) != 0) {
+        return false;
+      }
+    } else if (io.seek(length - 2, Exiv2::BasicIo::cur) != 0) {
+      return false;
+    }
+  }
+  const size_t offset = io.tell();
+  Exiv2::DataBuf exif(size);
+  if (io.read(exif.data(), size) != size)
+    return false;
+
+  // The Exif data is updated in a copy, if no value changes its size
+  Exiv2::DataBuf patched(exif.c_data(), exif.size());
+  Exiv2::Blob blob;
+  if (Exiv2::ExifParser::encode(blob, patched.c_data(), patched.size(), image.byteOrder(), image.exifData()) !=
+          Exiv2::wmNonIntrusive ||
+      !blob.empty())
+    return false;
+
+  // Only the range of bytes that changed is written
+  auto first = std::mismatch(exif.begin(), exif.end(), patched.begin()).first;
+  if (first == exif.end())
+    return true;
+  auto last = std::mismatch(std::make_reverse_iterator(exif.end()), std::make_reverse_iterator(first),
+                            std::make_reverse_iterator(patched.end()))
+                  .first.base();
+  const auto start = static_cast<size_t>(first - exif.begin());
+  const auto count = static_cast<size_t>(last - first);
+  if (io.seek(offset + start, Exiv2::BasicIo::beg) != 0 || io.write(patched.c_data(start), count) != count)
+    throw Exiv2::Error(Exiv2::ErrorCode::kerImageWriteFailed);
+  return true;
+}  // patchExif
+
+int readSegments(Exiv2::BasicIo& io, std::vector<JpegSegment>& segments) {
+  std::array<Exiv2::byte, 2> buf;
+  while (true) {
+    int marker = io.getb();
+    if (marker != 0xff)
+      return -1;
+    // Markers may be preceded by fill bytes
+    while (marker == 0xff)
+      marker = io.getb();
+    if (marker == EOF)
+      return -1;
+    if (marker == 0xd9 || marker == 0xda)
+      return marker;
+    // Standalone markers have no contents
+    if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+      segments.push_back({marker, Exiv2::DataBuf()});
+      continue;
+    }
+    if (io.read(buf.data(), 2) != 2)
+      return -1;
+    const size_t length = Exiv2::getUShort(buf.data(), Exiv2::bigEndian);
+    if (length < 2 || length - 2 > io.size() - io.tell())
+      return -1;
+    Exiv2::DataBuf data(length);
+    std::copy(buf.begin(), buf.end(), data.begin());
+    if (io.read(data.data(2), length - 2) != length - 2)
+      return -1;
+    segments.push_back({marker, std::move(data)});
+  }
+}
+
+SegmentKind segmentKind(const JpegSegment& segment) {
+  static constexpr std::string_view exifId{"Exif\0\0", 6};
+  static constexpr std::string_view xmpId{"http://ns.adobe.com/xap/1.0/\0", 29};
+  static constexpr std::string_view ps3Id{Exiv2::Photoshop::ps3Id_, 14};
+  auto hasId = [&segment](std::string_view id) {
+    return segment.data.size() >= 2 + id.size() && segment.data.cmpBytes(2, id.data(), id.size()) == 0;
+  };
+  if (segment.marker == 0xe1 && hasId(exifId))
+    return SegmentKind::exif;
+  if (segment.marker == 0xe1 && hasId(xmpId))
+    return SegmentKind::xmp;
+  if (segment.marker == 0xed && hasId(ps3Id))
+    return SegmentKind::photoshop;
+  if (segment.marker == 0xfe)
+    return SegmentKind::comment;
+  return SegmentKind::other;
+}
+
+bool iptcSegment(const std::vector<JpegSegment>& segments, JpegSegment& segment) {
+  static constexpr size_t ps3IdSize = 14;
+  Exiv2::Blob psBlob;
+  for (const auto& s : segments) {
+    if (segmentKind(s) == SegmentKind::photoshop)
+      psBlob.insert(psBlob.end(), s.data.cbegin() + 2 + ps3IdSize, s.data.cend());
+  }
+
+  // Like the library, the data of all IPTC IRBs is joined
+  Exiv2::Blob iptc;
+  const Exiv2::byte* record = nullptr;
+  uint32_t sizeHdr = 0;
+  uint32_t sizeData = 0;
+  const Exiv2::byte* pCur = psBlob.data();
+  const Exiv2::byte* pEnd = pCur + psBlob.size();
+  int rc = 0;
+  while (pCur < pEnd && (rc = Exiv2::Photoshop::locateIptcIrb(pCur, pEnd - pCur, &record, sizeHdr, sizeData)) == 0) {
+    iptc.insert(iptc.end(), record + sizeHdr, record + sizeHdr + sizeData);
+    pCur = record + sizeHdr + sizeData + (sizeData & 1);
+  }
+  segment = {0xed, Exiv2::DataBuf()};
+  if (rc < 0)
+    return false;
+  if (iptc.empty())
+    return true;
+
+  // Length, Photoshop id and the IRB: its marker, resource id, empty name, data size and padded data
+  const size_t size = 2 + ps3IdSize + 12 + iptc.size() + (iptc.size() & 1);
+  if (size > 0xffff)
+    return false;
+  segment.data = Exiv2::DataBuf(size);
+  Exiv2::us2Data(segment.data.data(), static_cast<uint16_t>(size), Exiv2::bigEndian);
+  std::copy_n(Exiv2::Photoshop::ps3Id_, ps3IdSize, segment.data.begin() + 2);
+  std::copy_n(Exiv2::Photoshop::irbId_.front(), 4, segment.data.begin() + 2 + ps3IdSize);
+  Exiv2::us2Data(segment.data.data(6 + ps3IdSize), Exiv2::Photoshop::iptc_, Exiv2::bigEndian);
+  Exiv2::ul2Data(segment.data.data(10 + ps3IdSize), static_cast<uint32_t>(iptc.size()), Exiv2::bigEndian);
+  std::copy(iptc.begin(), iptc.end(), segment.data.begin() + 14 + ps3IdSize);
+  return true;
+}
+
+bool transplantSegments(const std::string& source, const std::string& target, Params::CommonTarget targets) {
+  static constexpr std::array<Exiv2::byte, 2> jpegId{0xff, 0xd8};
+  static constexpr std::array<Exiv2::byte, 7> exvId{0xff, 0x01, 'E', 'x', 'i', 'v', '2'};
+  if (!Exiv2::fileExists(target))
+    return false;
+  Exiv2::FileIo sourceIo(source);
+  Exiv2::FileIo targetIo(target);
+  if (sourceIo.open() != 0 || targetIo.open() != 0)
+    return false;
+  Exiv2::IoCloser sourceCloser(sourceIo);
+  Exiv2::IoCloser targetCloser(targetIo);
+
+  // The source can be a JPEG or an EXV file, both are a sequence of JPEG segments after their header
+  std::array<Exiv2::byte, 7> header;
+  if (sourceIo.read(header.data(), 2) != 2)
+    return false;
+  if (!std::equal(jpegId.begin(), jpegId.end(), header.begin()) &&
+      (sourceIo.read(header.data() + 2, 5) != 5 || header != exvId))
+    return false;
+  if (targetIo.read(header.data(), 2) != 2 || !std::equal(header.begin(), header.begin() + 2, jpegId.begin()))
+    return false;
+
+  std::vector<JpegSegment> sourceSegments;
+  std::vector<JpegSegment> targetSegments;
+  if (readSegments(sourceIo, sourceSegments) < 0)
+    return false;
+  const int last = readSegments(targetIo, targetSegments);
+  if (last < 0)
+    return false;
+
+  // The kinds of segments to copy, in the order in which the library writes them
+  std::vector<std::pair<SegmentKind, const char*>> kinds;
+  if (targets & Params::ctExif)
+    kinds.emplace_back(SegmentKind::exif, N_("Writing Exif data from"));
+  if (targets & Params::ctXmp)
+    kinds.emplace_back(SegmentKind::xmp, N_("Writing XMP data from"));
+  if (targets & Params::ctIptc)
+    kinds.emplace_back(SegmentKind::photoshop, N_("Writing IPTC data from"));
+  if (targets & Params::ctComment)
+    kinds.emplace_back(SegmentKind::comment, N_("Writing JPEG comment from"));
+  for (const auto& segment : targetSegments) {
+    const auto kind = segmentKind(segment);
+    if (std::any_of(kinds.begin(), kinds.end(), [kind](const auto& k) { return k.first == kind; }))
+      return false;
+  }
+
+  // Like the library, the first Exif, XMP and comment segments are read. Of the Photoshop segments,
+  // only the IPTC data is written.
+  JpegSegment iptc{0xed, Exiv2::DataBuf()};
+  std::vector<const JpegSegment*> copies;
+  for (const auto& [kind, message] : kinds) {
+    const size_t count = copies.size();
+    if (kind == SegmentKind::photoshop) {
+      if (!iptcSegment(sourceSegments, iptc))
+        return false;
+      if (!iptc.data.empty())
+        copies.push_back(&iptc);
+    } else {
+      auto segment = std::find_if(sourceSegments.begin(), sourceSegments.end(),
+                                  [kind = kind](const JpegSegment& s) { return segmentKind(s) == kind; });
+      if (segment != sourceSegments.end())
+        copies.push_back(&*segment);
+    }
+    if (copies.size() > count && Params::instance().verbose_)
+      out() << _(message) << " " << source << " " << _("to") << " " << target << '\n';
+  }
+  if (copies.empty())
+    return true;
+
+  // The new segments are inserted after the APP0 segments of the target, where the library inserts them
+  size_t insertPos = 0;
+  for (size_t i = 0; i < targetSegments.size(); ++i) {
+    if (targetSegments[i].marker == 0xe0)
+      insertPos = i + 1;
+  }
+  Exiv2::MemIo tempIo;
+  auto write = [&tempIo](const JpegSegment& segment) {
+    const std::array<Exiv2::byte, 2> marker{0xff, static_cast<Exiv2::byte>(segment.marker)};
+    if (tempIo.write(marker.data(), 2) != 2 ||
+        tempIo.write(segment.data.c_data(), segment.data.size()) != segment.data.size())
+      throw Exiv2::Error(Exiv2::ErrorCode::kerImageWriteFailed);
+  };
+  if (tempIo.write(jpegId.data(), 2) != 2)
+    throw Exiv2::Error(Exiv2::ErrorCode::kerImageWriteFailed);
+  for (size_t i = 0; i <= targetSegments.size(); ++i) {
+    if (i == insertPos) {
+      for (auto segment : copies)
+        write(*segment);
+    }
+    if (i < targetSegments.size())
+      write(targetSegments[i]);
+  }
+
+  // The image data is copied as it is
+  const std::array<Exiv2::byte, 2> marker{0xff, static_cast<Exiv2::byte>(last)};
+  const size_t rest = targetIo.size() - targetIo.tell();
+  if (tempIo.write(marker.data(), 2) != 2 || tempIo.write(targetIo) != rest)
+    throw Exiv2::Error(Exiv2::ErrorCode::kerImageWriteFailed);
+  targetIo.close();
+  targetIo.transfer(tempIo);
+  return true;
+}  // transplantSegments
+
 int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType targetType, bool preserve) {
 #ifdef EXIV2_DEBUG_MESSAGES
-  std::cerr << "actions.cpp::metacopy"
+  err() << "actions.cpp::metacopy"
             << " source = " << source << " target = " << tgt << '\n';
 #endif
 
   // read the source metadata
   int rc = -1;
   if (!Exiv2::fileExists(source)) {
-    std::cerr << source << ": " << _("Failed to open the file") << "\n";
+    err() << source << ": " << _("Failed to open the file") << "\n";
     return rc;
   }
 
   bool bStdin = source == "-";
   bool bStdout = tgt == "-";
 
+  // JPEG segments are copied as they are if the metadata doesn't need to be modified or merged
+  if (!bStdin && !bStdout && Params::instance().modifyCmds_.empty() &&
+      transplantSegments(source, tgt, Params::instance().target_)) {
+    return 0;
+  }
+
   Exiv2::DataBuf stdIn;
   Exiv2::Image::UniquePtr sourceImage;
   if (bStdin) {
@@ -1720,7 +2571,7 @@ int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType
   // Copy each type of metadata
   if (Params::instance().target_ & Params::ctExif && !sourceImage->exifData().empty()) {
     if (Params::instance().verbose_ && !bStdout) {
-      std::cout << _("Writing Exif data from") << " " << source << " " << _("to") << " " << target << '\n';
+      out() << _("Writing Exif data from") << " " << source << " " << _("to") << " " << target << '\n';
     }
     if (preserve) {
       for (const auto& exif : sourceImage->exifData()) {
@@ -1732,7 +2583,7 @@ int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType
   }
   if (Params::instance().target_ & Params::ctIptc && !sourceImage->iptcData().empty()) {
     if (Params::instance().verbose_ && !bStdout) {
-      std::cout << _("Writing IPTC data from") << " " << source << " " << _("to") << " " << target << '\n';
+      out() << _("Writing IPTC data from") << " " << source << " " << _("to") << " " << target << '\n';
     }
     if (preserve) {
       for (const auto& iptc : sourceImage->iptcData()) {
@@ -1744,7 +2595,7 @@ int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType
   }
   if (Params::instance().target_ & (Params::ctXmp | Params::ctXmpRaw) && !sourceImage->xmpData().empty()) {
     if (Params::instance().verbose_ && !bStdout) {
-      std::cout << _("Writing XMP data from") << " " << source << " " << _("to") << " " << target << '\n';
+      out() << _("Writing XMP data from") << " " << source << " " << _("to") << " " << target << '\n';
     }
 
     // #1148 use Raw XMP packet if there are no XMP modification commands
@@ -1768,7 +2619,7 @@ int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType
   }
   if (Params::instance().target_ & Params::ctComment && !sourceImage->comment().empty()) {
     if (Params::instance().verbose_ && !bStdout) {
-      std::cout << _("Writing JPEG comment from") << " " << source << " " << _("to") << " " << tgt << '\n';
+      out() << _("Writing JPEG comment from") << " " << source << " " << _("to") << " " << tgt << '\n';
     }
     targetImage->setComment(sourceImage->comment());
   }
@@ -1777,7 +2628,7 @@ int metacopy(const std::string& source, const std::string& tgt, Exiv2::ImageType
       targetImage->writeMetadata();
       rc = 0;
     } catch (const Exiv2::Error& e) {
-      std::cerr << tgt << ": " << _("Could not write metadata to file") << ": " << e << "\n";
+      err() << tgt << ": " << _("Could not write metadata to file") << ": " << e << "\n";
       rc = 1;
     }
 
@@ -1808,89 +2659,6 @@ void replace(std::string& text, const std::string& searchText, const std::string
   }
 }
 
-int renameFile(std::string& newPath, const tm* tm) {
-  auto p = fs::path(newPath);
-  std::string path = newPath;
-  auto oldFsPath = fs::path(path);
-  std::string format = Params::instance().format_;
-  std::string filename = p.stem().string();
-  std::string basesuffix;
-  int pos = filename.find('.');
-  if (pos > 0)
-    basesuffix = filename.substr(filename.find('.'));
-  replace(format, ":basename:", p.stem().string());
-  replace(format, ":basesuffix:", basesuffix);
-  replace(format, ":dirname:", p.parent_path().filename().string());
-  replace(format, ":parentname:", p.parent_path().parent_path().filename().string());
-
-  const size_t max = 1024;
-  char basename[max] = {};
-  if (strftime(basename, max, format.c_str(), tm) == 0) {
-    std::cerr << _("Filename format yields empty filename for the file") << " " << path << "\n";
-    return 1;
-  }
-
-  newPath = (p.parent_path() / (basename + p.extension().string())).string();
-  p = fs::path(newPath);
-
-  if (p.parent_path() == oldFsPath.parent_path() && p.filename() == oldFsPath.filename()) {
-    if (Params::instance().verbose_) {
-      std::cout << _("This file already has the correct name") << '\n';
-    }
-    return -1;
-  }
-
-  bool go = true;
-  int seq = 1;
-  std::string s;
-  Params::FileExistsPolicy fileExistsPolicy = Params::instance().fileExistsPolicy_;
-  while (go) {
-    if (Exiv2::fileExists(newPath)) {
-      switch (fileExistsPolicy) {
-        case Params::overwritePolicy:
-          go = false;
-          break;
-        case Params::renamePolicy:
-          newPath = (p.parent_path() / (std::string(basename) + "_" + Exiv2::toString(seq++) + p.extension().string()))
-                        .string();
-          break;
-        case Params::askPolicy:
-          std::cout << Params::instance().progname() << ": " << _("File") << " `" << newPath << "' "
-                    << _("exists. [O]verwrite, [r]ename or [s]kip?") << " ";
-          std::cin >> s;
-          switch (s.front()) {
-            case 'o':
-            case 'O':
-              go = false;
-              break;
-            case 'r':
-            case 'R':
-              fileExistsPolicy = Params::renamePolicy;
-              newPath =
-                  (p.parent_path() / (std::string(basename) + "_" + Exiv2::toString(seq++) + p.extension().string()))
-                      .string();
-              break;
-            default:  // skip
-              return -1;
-          }
-      }
-    } else {
-      go = false;
-    }
-  }
-
-  if (Params::instance().verbose_) {
-    std::cout << _("Renaming file to") << " " << newPath;
-    if (Params::instance().timestamp_) {
-      std::cout << ", " << _("updating timestamp");
-    }
-    std::cout << '\n';
-  }
-
-  fs::rename(path, newPath);
-  return 0;
-}
-
 std::string newFilePath(const std::string& path, const std::string& ext) {
   auto p = fs::path(path);
   auto directory = fs::path(Params::instance().directory_);
@@ -1906,7 +2674,12 @@ int dontOverwrite(const std::string& path) {
     return 0;
 
   if (!Params::instance().force_ && Exiv2::fileExists(path)) {
-    std::cout << Params::instance().progname() << ": " << _("Overwrite") << " `" << path << "'? ";
+    if (Action::OutputBuffer::active()) {
+      err() << Params::instance().progname() << ": " << _("File") << " `" << path << "' "
+            << _("exists, skipped. Use -f to overwrite it") << "\n";
+      return 1;
+    }
+    out() << Params::instance().progname() << ": " << _("Overwrite") << " `" << path << "'? ";
     std::string s;
     std::cin >> s;
     if (s.front() != 'y' && s.front() != 'Y')
@@ -1927,7 +2700,7 @@ std::ostream& operator<<(std::ostream& os, const std::pair<std::string, int>& st
 
 int printStructure(std::ostream& out, Exiv2::PrintStructureOption option, const std::string& path) {
   if (!Exiv2::fileExists(path)) {
-    std::cerr << path << ": " << _("Failed to open the file") << "\n";
+    err() << path << ": " << _("Failed to open the file") << "\n";
     return -1;
   }
   Exiv2::Image::UniquePtr image = Exiv2::ImageFactory::open(path);
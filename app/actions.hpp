@@ -14,6 +14,8 @@
 // *****************************************************************************
 #include "exiv2app.hpp"
 
+#include <ctime>
+#include <sstream>
 #include <unordered_map>
 
 // *****************************************************************************
@@ -42,11 +44,48 @@ enum TaskType {
   modify,
   fixiso,
   fixcom,
+  diff,
 };
 
+//! Standard output of the actions running on the current thread: std::cout, unless an OutputBuffer is active
+std::ostream& out();
+//! Error output of the actions running on the current thread: std::cerr, unless an OutputBuffer is active
+std::ostream& err();
+
 // *****************************************************************************
 // class definitions
 
+/*!
+  @brief Collects the standard and error output of the actions running on
+         the current thread, from construction to destruction, so that the
+         output for a file can be written in one piece when several files
+         are processed in parallel.
+ */
+class OutputBuffer {
+ public:
+  OutputBuffer();
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  //! The standard output collected so far
+  [[nodiscard]] std::string out() const {
+    return out_.str();
+  }
+  //! The error output collected so far
+  [[nodiscard]] std::string err() const {
+    return err_.str();
+  }
+  //! Return true if the output of the current thread is buffered. The user cannot be prompted then.
+  static bool active();
+
+ private:
+  std::ostringstream out_;
+  std::ostringstream err_;
+  std::ostream* prevOut_;
+  std::ostream* prevErr_;
+};  // class OutputBuffer
+
 /*!
   @brief Abstract base class for all concrete actions.
 
@@ -169,17 +208,75 @@ class Print : public Task {
    */
   int printTag(const Exiv2::ExifData& exifData, EasyAccessFct easyAccessFct, const std::string& label = "",
                EasyAccessFct easyAccessFctFallback = nullptr) const;
+  //! Print the header line of the CSV output, with the -K keys as columns
+  static void printCsvHeader();
 
  private:
+  //! Add a metadatum to the record of the file for the JSON Lines or CSV output, return true if it was added
+  bool addToRecord(const Exiv2::Metadatum& md, const Exiv2::Image* image);
+  //! Print the record of the file as a JSON object or a CSV row, on one line
+  void printRecord();
+
   std::string path_;
   int align_{0};  // for the alignment of the summary output
+  //! Values of the metadata in the record of the file, by key in the order in which the keys first occur
+  std::vector<std::pair<std::string, std::vector<std::string>>> record_;
+  //! Position of each key in record_
+  std::unordered_map<std::string, size_t> recordIndex_;
+  //! The line printed for the record, kept to reuse its memory for the next file
+  std::string line_;
 };
 
-/// @brief %Rename a file to its metadata creation timestamp, in the specified format.
+/*!
+  @brief %Rename a file to its metadata creation timestamp, in the specified format.
+
+  A batch of files is renamed in three steps: probe() reads the timestamps and computes
+  the new names, which can be done in parallel, resolve() settles the collisions of the
+  names in the order of the files and execute() renames the files as planned.
+ */
 class Rename : public Task {
  public:
+  //! The rename of one file, as computed by probe() and resolve()
+  struct Plan {
+    std::string path;       //!< The file to rename
+    std::string newPath;    //!< The new path of the file
+    std::string stem;       //!< The new filename made from the format, without the extension
+    std::string value;      //!< The timestamp read from the file
+    std::tm tm{};           //!< The timestamp, broken down
+    bool rename{false};     //!< Whether the file is renamed, it is only touched with -T
+    bool skip{false};       //!< Whether the file is left alone, e.g., if it already has its new name
+    bool overwrite{false};  //!< Whether the file replaces an existing file
+    int ret{0};             //!< The return code for the file, the file is not changed unless 0
+    std::string out;        //!< Standard output for the file, not yet written
+    std::string err;        //!< Error output for the file, not yet written
+  };
+
   int run(const std::string& path) override;
   [[nodiscard]] Task::UniquePtr clone() const override;
+
+  //! Make run() only probe the files, into \em plan, or run normally if it is null
+  void setPlan(Plan* plan) {
+    plan_ = plan;
+  }
+  /*!
+    @brief Read the timestamp of file \em path and compute its new name,
+           without changing the file. Only the standard Exif timestamps are needed.
+    @return 0 if the file can be renamed or touched, else the return code for the file.
+   */
+  static int probe(const std::string& path, Plan& plan);
+  /*!
+    @brief Resolve the collisions of the new names with existing files and with the
+           names taken by earlier plans, according to the file exists policy. The
+           files renamed by earlier plans are accounted for in memory.
+    @param plans  The plans, in the order in which they are executed.
+    @param prompt Whether the user can be asked what to do, else an existing file is skipped.
+   */
+  static void resolve(std::vector<Plan>& plans, bool prompt);
+  //! Rename the file and set its timestamps as planned, or only report the plan with the dry run option
+  static int execute(const Plan& plan);
+
+ private:
+  Plan* plan_{nullptr};
 };  // class Rename
 
 //! %Adjust the Exif (or other metadata) timestamps
@@ -288,17 +385,39 @@ class Modify : public Task {
   [[nodiscard]] Task::UniquePtr clone() const override;
   //! Apply modification commands to the \em pImage, return 0 if successful.
   static int applyCommands(Exiv2::Image* pImage);
+};
+
+/*!
+  @brief The modification commands, compiled once into resolved keys and the
+         values read from the commands, to be applied to any number of images.
+
+  The metadata of an image are looked up by key through an index, which is
+  built when the program is applied to the image.
+ */
+class ModifyProgram {
+ public:
+  //! A compiled modification command
+  struct Instruction;
+
+  //! Compile \em modifyCmds
+  explicit ModifyProgram(const ModifyCmds& modifyCmds);
+  ~ModifyProgram();
+  ModifyProgram(const ModifyProgram&) = delete;
+  ModifyProgram& operator=(const ModifyProgram&) = delete;
+
+  /*!
+    @brief The program compiled from the modification commands of the command
+           line, or of the request processed on the current thread in server
+           mode, see Params::instance().
+   */
+  static const ModifyProgram& instance();
+
+  //! Apply the program to \em image, return 0 if successful
+  int apply(Exiv2::Image& image) const;
 
  private:
-  //! Add a metadatum to \em pImage according to \em modifyCmd
-  static int addMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd);
-  //! Set a metadatum in \em pImage according to \em modifyCmd
-  static int setMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd);
-  //! Delete a metadatum from \em pImage according to \em modifyCmd
-  static void delMetadatum(Exiv2::Image* pImage, const ModifyCmd& modifyCmd);
-  //! Register an XMP namespace according to \em modifyCmd
-  static void regNamespace(const ModifyCmd& modifyCmd);
-};
+  std::vector<Instruction> instructions_;
+};  // class ModifyProgram
 
 /// @brief %Copy ISO settings from any of the Nikon makernotes to the regular Exif tag, Exif.Photo.ISOSpeedRatings.
 class FixIso : public Task {
@@ -322,6 +441,21 @@ class FixCom : public Task {
   std::string path_;
 };
 
+/*!
+  @brief %Compare the metadata of two files, the two file arguments or the files
+         with the same relative path in the two directory arguments.
+
+  The digests of the metadata in canonical form are compared for each family, the
+  keys and values are only compared and printed for the families which differ.
+ */
+class Diff : public Task {
+ public:
+  /// @brief Compare the file \em path, in one of the two directories or the first file, with its counterpart.
+  /// @return 0 if the metadata is the same, 1 if it differs, negative if a file cannot be read.
+  int run(const std::string& path) override;
+  [[nodiscard]] Task::UniquePtr clone() const override;
+};
+
 }  // namespace Action
 
 #endif  // #ifndef ACTIONS_HPP_
@@ -24,4 +24,406 @@ bool strtol(const char* nptr, int64_t& n) {
   return true;
 }
 
+namespace {
+/*!
+  @brief Match \em ch against the bracket expression which starts at \em pos,
+         after the '['. Return false if the expression is not closed, else set
+         \em matched and move \em pos after the closing ']'.
+ */
+bool matchBracket(std::string_view pattern, size_t& pos, char ch, bool& matched) {
+  size_t i = pos;
+  const bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+  if (negate)
+    ++i;
+  const auto c = static_cast<unsigned char>(ch);
+  bool found = false;
+  // A ']' right after the '[' or the negation is an ordinary character
+  for (size_t first = i; i < pattern.size();) {
+    if (pattern[i] == ']' && i != first) {
+      pos = i + 1;
+      matched = found != negate;
+      return true;
+    }
+    const auto lo = static_cast<unsigned char>(pattern[i]);
+    if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+      found = found || (lo <= c && c <= static_cast<unsigned char>(pattern[i + 2]));
+      i += 3;
+    } else {
+      found = found || lo == c;
+      ++i;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+bool globMatch(std::string_view pattern, std::string_view name) {
+  size_t p = 0;
+  size_t n = 0;
+  // Position after the last '*' and the part of the name it matches so far, to backtrack to
+  size_t star = std::string_view::npos;
+  size_t starName = 0;
+  while (n < name.size()) {
+    if (p < pattern.size()) {
+      if (pattern[p] == '*') {
+        star = ++p;
+        starName = n;
+        continue;
+      }
+      size_t next = p + 1;
+      bool matched = false;
+      if (pattern[p] == '?') {
+        matched = true;
+      } else if (pattern[p] != '[' || !matchBracket(pattern, next, name[n], matched)) {
+        // An unclosed '[' matches itself
+        matched = pattern[p] == name[n];
+      }
+      if (matched) {
+        p = next;
+        ++n;
+        continue;
+      }
+    }
+    if (star == std::string_view::npos)
+      return false;
+    p = star;
+    n = ++starName;
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    ++p;
+  return p == pattern.size();
+}
+
+namespace {
+//! Return the length of the valid UTF-8 sequence of more than one byte at \em pos, or 0
+size_t utf8Length(std::string_view text, size_t pos) {
+  const auto byte = [&](size_t i) { return static_cast<unsigned char>(text[pos + i]); };
+  const auto c = byte(0);
+  size_t len = 0;
+  // Second byte range for each lead byte, which excludes overlong forms and surrogates
+  unsigned char lo = 0x80;
+  unsigned char hi = 0xbf;
+  if (c >= 0xc2 && c <= 0xdf) {
+    len = 2;
+  } else if (c >= 0xe0 && c <= 0xef) {
+    len = 3;
+    lo = c == 0xe0 ? 0xa0 : lo;
+    hi = c == 0xed ? 0x9f : hi;
+  } else if (c >= 0xf0 && c <= 0xf4) {
+    len = 4;
+    lo = c == 0xf0 ? 0x90 : lo;
+    hi = c == 0xf4 ? 0x8f : hi;
+  }
+  if (len == 0 || pos + len > text.size() || byte(1) < lo || byte(1) > hi)
+    return 0;
+  for (size_t i = 2; i < len; ++i) {
+    if ((byte(i) & 0xc0) != 0x80)
+      return 0;
+  }
+  return len;
+}
+}  // namespace
+
+void appendJsonString(std::string& buf, std::string_view text) {
+  static constexpr char hex[] = "0123456789abcdef";
+  buf += '"';
+  // Runs of characters which need no escaping are appended at once
+  size_t run = 0;
+  size_t i = 0;
+  while (i < text.size()) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+      ++i;
+      continue;
+    }
+    if (c >= 0x80) {
+      if (auto len = utf8Length(text, i)) {
+        i += len;
+        continue;
+      }
+    }
+    buf.append(text, run, i - run);
+    switch (c) {
+      case '"':
+        buf += "\\\"";
+        break;
+      case '\\':
+        buf += "\\\\";
+        break;
+      case '\n':
+        buf += "\\n";
+        break;
+      case '\r':
+        buf += "\\r";
+        break;
+      case '\t':
+        buf += "\\t";
+        break;
+      default:
+        buf += "\\u00";
+        buf += hex[c >> 4];
+        buf += hex[c & 0xf];
+        break;
+    }
+    run = ++i;
+  }
+  buf.append(text, run);
+  buf += '"';
+}
+
+void appendCsvField(std::string& buf, std::string_view text) {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    buf.append(text);
+    return;
+  }
+  buf += '"';
+  for (size_t pos = 0;;) {
+    const auto quote = text.find('"', pos);
+    if (quote == std::string_view::npos) {
+      buf.append(text, pos);
+      break;
+    }
+    buf.append(text, pos, quote + 1 - pos);
+    buf += '"';
+    pos = quote + 1;
+  }
+  buf += '"';
+}
+
+const JsonValue* JsonValue::member(std::string_view name) const {
+  for (const auto& [key, value] : members_) {
+    if (key == name)
+      return &value;
+  }
+  return nullptr;
+}
+
+namespace {
+//! Recursive descent parser of parseJson()
+class JsonParser {
+ public:
+  explicit JsonParser(std::string_view text) : text_(text) {
+  }
+
+  bool parse(JsonValue& value) {
+    if (!parseValue(value, 0))
+      return false;
+    skipSpace();
+    return pos_ == text_.size();
+  }
+
+ private:
+  //! Limit of the nesting of arrays and objects, to bound the recursion
+  static constexpr int maxDepth = 64;
+
+  void skipSpace() {
+    while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+                                   text_[pos_] == '\r'))
+      ++pos_;
+  }
+
+  //! Skip white space and \em c, if it follows
+  bool consume(char c) {
+    skipSpace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool literal(std::string_view word) {
+    if (!text_.substr(pos_).starts_with(word))
+      return false;
+    pos_ += word.size();
+    return true;
+  }
+
+  bool parseValue(JsonValue& value, int depth) {
+    skipSpace();
+    if (pos_ == text_.size() || depth > maxDepth)
+      return false;
+    switch (text_[pos_]) {
+      case '{':
+        ++pos_;
+        value.type_ = JsonValue::object;
+        if (consume('}'))
+          return true;
+        do {
+          std::pair<std::string, JsonValue> member;
+          skipSpace();
+          if (!parseString(member.first) || !consume(':') || !parseValue(member.second, depth + 1))
+            return false;
+          value.members_.push_back(std::move(member));
+        } while (consume(','));
+        return consume('}');
+      case '[':
+        ++pos_;
+        value.type_ = JsonValue::array;
+        if (consume(']'))
+          return true;
+        do {
+          if (!parseValue(value.items_.emplace_back(), depth + 1))
+            return false;
+        } while (consume(','));
+        return consume(']');
+      case '"':
+        value.type_ = JsonValue::string;
+        return parseString(value.text_);
+      case 't':
+      case 'f':
+        value.type_ = JsonValue::boolean;
+        value.text_ = text_[pos_] == 't' ? "true" : "false";
+        return literal(value.text_);
+      case 'n':
+        value.type_ = JsonValue::null;
+        return literal("null");
+      default:
+        value.type_ = JsonValue::number;
+        return parseNumber(value.text_);
+    }
+  }
+
+  bool parseString(std::string& str) {
+    if (pos_ == text_.size() || text_[pos_] != '"')
+      return false;
+    ++pos_;
+    while (pos_ < text_.size()) {
+      const auto c = static_cast<unsigned char>(text_[pos_++]);
+      if (c == '"')
+        return true;
+      if (c < 0x20)
+        return false;
+      if (c != '\\') {
+        str += static_cast<char>(c);
+        continue;
+      }
+      if (pos_ == text_.size())
+        return false;
+      switch (text_[pos_++]) {
+        case '"':
+          str += '"';
+          break;
+        case '\\':
+          str += '\\';
+          break;
+        case '/':
+          str += '/';
+          break;
+        case 'b':
+          str += '\b';
+          break;
+        case 'f':
+          str += '\f';
+          break;
+        case 'n':
+          str += '\n';
+          break;
+        case 'r':
+          str += '\r';
+          break;
+        case 't':
+          str += '\t';
+          break;
+        case 'u': {
+          uint32_t code = 0;
+          if (!parseHex(code))
+            return false;
+          // A high surrogate must be followed by a low one, which together encode a supplementary character
+          if (code >= 0xd800 && code <= 0xdbff) {
+            uint32_t low = 0;
+            if (!literal("\\u") || !parseHex(low) || low < 0xdc00 || low > 0xdfff)
+              return false;
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          } else if (code >= 0xdc00 && code <= 0xdfff) {
+            return false;
+          }
+          appendUtf8(str, code);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  bool parseHex(uint32_t& code) {
+    if (pos_ + 4 > text_.size())
+      return false;
+    for (size_t i = 0; i < 4; ++i) {
+      const char c = text_[pos_++];
+      code <<= 4;
+      if (c >= '0' && c <= '9')
+        code |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        code |= c - 'A' + 10;
+      else
+        return false;
+    }
+    return true;
+  }
+
+  static void appendUtf8(std::string& str, uint32_t code) {
+    if (code < 0x80) {
+      str += static_cast<char>(code);
+    } else if (code < 0x800) {
+      str += static_cast<char>(0xc0 | (code >> 6));
+      str += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+      str += static_cast<char>(0xe0 | (code >> 12));
+      str += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+      str += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+      str += static_cast<char>(0xf0 | (code >> 18));
+      str += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+      str += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+      str += static_cast<char>(0x80 | (code & 0x3f));
+    }
+  }
+
+  //! Parse a number, -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?, into its text
+  bool parseNumber(std::string& number) {
+    const auto start = pos_;
+    const auto digits = [this] {
+      const auto first = pos_;
+      while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9')
+        ++pos_;
+      return pos_ - first;
+    };
+    if (pos_ < text_.size() && text_[pos_] == '-')
+      ++pos_;
+    if (pos_ < text_.size() && text_[pos_] == '0') {
+      ++pos_;
+    } else if (digits() == 0) {
+      return false;
+    }
+    if (pos_ < text_.size() && text_[pos_] == '.') {
+      ++pos_;
+      if (digits() == 0)
+        return false;
+    }
+    if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+      ++pos_;
+      if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-'))
+        ++pos_;
+      if (digits() == 0)
+        return false;
+    }
+    number = text_.substr(start, pos_ - start);
+    return true;
+  }
+
+  std::string_view text_;
+  size_t pos_{0};
+};
+}  // namespace
+
+bool parseJson(std::string_view text, JsonValue& value) {
+  value = JsonValue();
+  return JsonParser(text).parse(value);
+}
+
 }  // namespace Util
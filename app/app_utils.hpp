@@ -4,6 +4,10 @@
 #define APP_UTILS_HPP_
 
 #include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace Util {
 /*!
@@ -12,6 +16,47 @@ namespace Util {
          n is not modified if the conversion is unsuccessful. See strtol(2).
  */
 bool strtol(const char* nptr, int64_t& n);
+
+/*!
+  @brief Return true if \em name matches the shell wildcard \em pattern.
+         '*' matches any sequence of characters, '?' any one character and
+         [...] one of the enclosed characters or ranges like a-z. The set is
+         negated if it starts with '!' or '^'. See fnmatch(3).
+ */
+bool globMatch(std::string_view pattern, std::string_view name);
+
+/*!
+  @brief Append \em text to \em buf as a JSON string, in double quotes. Bytes
+         which are not part of valid UTF-8 sequences are taken as Latin-1
+         characters and escaped, so that the output is always valid JSON.
+ */
+void appendJsonString(std::string& buf, std::string_view text);
+
+/*!
+  @brief Append \em text to \em buf as a CSV field (RFC 4180): in double
+         quotes, with quotes doubled, if it contains a comma, a quote or a
+         line break, else as it is.
+ */
+void appendCsvField(std::string& buf, std::string_view text);
+
+//! A JSON value, as read by parseJson()
+struct JsonValue {
+  enum Type { null, boolean, number, string, array, object };
+  Type type_{null};
+  std::string text_;                                        //!< The string, or the JSON text of a number or boolean
+  std::vector<JsonValue> items_;                            //!< The elements of an array
+  std::vector<std::pair<std::string, JsonValue>> members_;  //!< The members of an object, in order
+
+  //! Return the member \em name of an object, or nullptr if there is none
+  [[nodiscard]] const JsonValue* member(std::string_view name) const;
+};
+
+/*!
+  @brief Parse \em text, a single JSON value (RFC 8259), into \em value.
+         Strings are returned in UTF-8. Returns false if \em text is not
+         valid JSON or nests arrays and objects too deeply.
+ */
+bool parseJson(std::string_view text, JsonValue& value);
 }  // namespace Util
 
 #endif  // APP_UTILS_HPP_
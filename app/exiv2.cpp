@@ -15,12 +15,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <regex>
+#include <sstream>
+#include <thread>
+#include <utility>
 
 #include <filesystem>
 namespace fs = std::filesystem;
@@ -37,6 +46,9 @@ namespace fs = std::filesystem;
 // *****************************************************************************
 // local declarations
 namespace {
+//! The Params of the request processed on the current thread in server mode, see Params::Scope
+thread_local Params* threadParams = nullptr;
+
 constexpr auto emptyYodAdjust_ = std::array{
     Params::YodAdjust{false, "-Y", 0},
     Params::YodAdjust{false, "-O", 0},
@@ -111,13 +123,110 @@ bool parseLine(ModifyCmd& modifyCmd, const std::string& line, int num);
   @param input Input string, assumed to be UTF-8
  */
 std::string parseEscapes(const std::string& input);
+
+//! Lock function for the XMP toolkit, \em mutex is a std::mutex
+void xmpLock(void* mutex, bool lock);
+
+//! Log message handler which writes to the error output of the action running on the current thread
+void logHandler(int level, const char* s);
+
+//! A file to process, or a directory which could not be read
+struct FileEntry {
+  std::string path;   //!< Path of the file or directory
+  std::string error;  //!< Why the directory could not be read, empty for files
+};
+
+/*!
+  @brief Call \em onFile with each file to process, in order: the file
+         arguments and, with -R, the files found in the directories among
+         them. Each directory is read at once, then its entries are visited
+         in the order of their names, depth first. The diff action gets the
+         first of its two files only, or the files of walkDirectoryPair().
+ */
+void walkFiles(const Params& params, const std::function<void(FileEntry&&)>& onFile);
+
+//! Call \em onFile with each file to process in \em dir and its subdirectories, see walkFiles()
+void walkDirectory(const Params& params, const fs::path& dir, const std::function<void(FileEntry&&)>& onFile);
+
+/*!
+  @brief Call \em onFile with each file to compare in the two directories of the
+         diff action, once for each relative path, in the order of the relative
+         paths. The path is that of the file in the first directory if it is in
+         both directories.
+ */
+void walkDirectoryPair(const Params& params, const std::function<void(FileEntry&&)>& onFile);
+
+/*!
+  @brief Run \em task on \em entry, the file with index \em n.
+  @return The return code of the task.
+ */
+int runTask(Action::Task& task, const Params& params, size_t n, const FileEntry& entry);
+
+/*!
+  @brief Run \em task on all files, one after the other.
+  @return The first non-zero return code of the task, in the order of the files.
+ */
+int runSerial(Action::Task& task, const Params& params);
+
+/*!
+  @brief Run clones of \em task on several files in parallel, with as many
+         worker threads as requested with -j. The files are found by another
+         thread, which feeds a bounded queue, so that the first files are
+         processed while directories are still walked. The output for each
+         file is buffered and written in the order of the files.
+  @return The first non-zero return code of the task, in the order of the files.
+ */
+int runParallel(const Action::Task& task, const Params& params);
+
+/*!
+  @brief Rename all files in three steps, without prompting the user: the
+         timestamps of the files are read and their new names computed, in
+         parallel with -j, then the name collisions are resolved in memory, in
+         the order of the files, and finally the files are renamed, one after
+         the other. The output for each file is written in the order of the files.
+  @return The first non-zero return code, in the order of the files.
+ */
+int runRename(const Params& params);
+
+//! A request in server mode, see runServer()
+struct Request {
+  std::string id;                  //!< The id of the request as JSON, empty if it has none
+  std::unique_ptr<Params> params;  //!< The options and files of the request
+  Action::Task::UniquePtr task;    //!< The action of the request
+  std::string out;                 //!< Standard output of the request
+  std::string err;                 //!< Error output of the request
+  int ret{EXIT_SUCCESS};           //!< Return code of the request
+  bool done{false};                //!< Whether the request is processed
+  bool exclusive{false};           //!< Whether the request registers XMP namespaces, and is processed alone
+};
+
+/*!
+  @brief Read the request in \em line, a JSON object, into \em request. The
+         options are parsed with a Params instance of its own. Errors are
+         reported on std::cerr and leave the request done, with a return
+         code of 1. The namespaces are registered process-wide: \em drain is
+         called, and the request made exclusive, before the first modify
+         command of the request registers one.
+ */
+void readRequest(const std::string& line, const Params& server, Request& request, const std::function<void()>& drain);
+
+/*!
+  @brief Process the requests read from stdin, one JSON object per line, on as
+         many worker threads as requested with -j. A response with the output
+         and the return code of each request is written to stdout, one JSON
+         object per line, in the order of the requests.
+  @return 0 at the end of the input.
+ */
+int runServer(const Params& params);
 }  // namespace
 
 // *****************************************************************************
 // Main
 int main(int argc, char* const argv[]) {
-  Exiv2::XmpParser::initialize();
+  static std::mutex xmpMutex;
+  Exiv2::XmpParser::initialize(xmpLock, &xmpMutex);
   ::atexit(Exiv2::XmpParser::terminate);
+  Exiv2::LogMsg::setHandler(logHandler);
 
 #ifdef EXV_ENABLE_NLS
   setlocale(LC_ALL, "");
@@ -146,37 +255,40 @@ int main(int argc, char* const argv[]) {
     return 0;
   }
 
+  if (params.server_) {
+    return runServer(params);
+  }
+
   int returnCode = EXIT_SUCCESS;
 
   try {
     // Create the required action class
     auto task = Action::TaskFactory::instance().create(static_cast<Action::TaskType>(params.action_));
 
+    if (params.action_ == Action::print && params.outputFormat_ == Params::ofCsv) {
+      Action::Print::printCsvHeader();
+    }
+    // Makernotes are not decoded if none of their tags are needed
+    if (!params.needsMakerNotes()) {
+      Exiv2::enableMakerNoteDecoding(false);
+    }
+
     // Process all files
     auto filesCount = params.files_.size();
     if (params.action_ & Action::extract && params.target_ & Params::ctStdInOut && filesCount > 1) {
       std::cerr << params.progname() << ": " << _("Only one file is allowed when extracting to stdout") << '\n';
       returnCode = EXIT_FAILURE;
     } else {
-      int w = [=]() {
-        if (filesCount > 9) {
-          if (filesCount > 99)
-            return 3;
-          return 2;
-        }
-        return 1;
-      }();
-      int n = 1;
-      for (const auto& file : params.files_) {
-        // If extracting to stdout then ignore verbose
-        if (params.verbose_ && !(params.action_ & Action::extract && params.target_ & Params::ctStdInOut)) {
-          std::cout << _("File") << " " << std::setw(w) << std::right << n++ << "/" << filesCount << ": " << file
-                    << '\n';
-        }
-        task->setBinary(params.binary_);
-        int ret = task->run(file);
-        if (returnCode == EXIT_SUCCESS)
-          returnCode = ret;
+      // Files to or from stdin and stdout cannot be processed in parallel
+      // Files are renamed as planned, unless the user may be asked what to do with each file in turn
+      if (params.action_ == Action::rename &&
+          (params.dryRun_ || params.jobs_ > 1 || params.fileExistsPolicy_ != Params::askPolicy)) {
+        returnCode = runRename(params);
+      } else if (params.jobs_ > 1 && (filesCount > 1 || params.recursive_) &&
+                 !(params.target_ & Params::ctStdInOut)) {
+        returnCode = runParallel(*task, params);
+      } else {
+        returnCode = runSerial(*task, params);
       }
 
       Action::TaskFactory::instance().cleanup();
@@ -195,7 +307,7 @@ int main(int argc, char* const argv[]) {
 // class Params
 
 Params::Params() :
-    optstring_(":hVvqfbuktTFa:Y:O:D:r:p:P:d:e:i:c:m:M:l:S:g:K:n:Q:"),
+    optstring_(":hVvqfbuktTFNa:Y:O:D:r:p:P:d:e:i:c:m:M:l:S:g:K:n:Q:j:RG:X:B"),
     target_(ctExif | ctIptc | ctComment | ctXmp),
     yodAdjust_(emptyYodAdjust_),
     format_("%Y%m%d_%H%M%S") {
@@ -203,7 +315,18 @@ Params::Params() :
 
 Params& Params::instance() {
   static Params instance_;
-  return instance_;
+  return threadParams ? *threadParams : instance_;
+}
+
+std::unique_ptr<Params> Params::create() {
+  return std::unique_ptr<Params>(new Params());
+}
+
+Params::Scope::Scope(Params& params) : prev_(std::exchange(threadParams, &params)) {
+}
+
+Params::Scope::~Scope() {
+  threadParams = prev_;
 }
 
 void Params::version(bool verbose, std::ostream& os) {
@@ -261,6 +384,8 @@ void Params::help(std::ostream& os) const {
           "                standard Exif tag\n")
      << _("  fc | fixcom   Convert the Unicode Exif user comment to UCS-2. The current\n"
           "                character encoding can be specified with the -n option\n")
+     << _("  di | diff     Compare the metadata of two files, or of the files with the\n"
+          "                same names in two directories, and print the differences\n")
      << _("\nOptions:\n") << _("   -h      Display this help and exit\n")
      << _("   -V      Show the program version and exit\n") << _("   -v      Be verbose during the program run\n")
      << _("   -q      Silence warnings and error messages (quiet)\n")
@@ -276,6 +401,12 @@ void Params::help(std::ostream& os) const {
      << _("   -T      Only set the file timestamp from Exif metadata ('rename' action)\n")
      << _("   -f      Do not prompt before overwriting existing files (force)\n")
      << _("   -F      Do not prompt before renaming files (Force)\n")
+     << _("   -N      Only report what the 'rename' action would do (dry run)\n")
+     << _("   -j n    Process n files in parallel, 0 for one per processor core (jobs)\n")
+     << _("   -R      Process the files in directories and their subdirectories (recursive)\n")
+     << _("   -G glob Only process the files in directories whose name matches 'glob' (include)\n")
+     << _("   -X glob Skip the files and directories whose name matches 'glob' (exclude)\n")
+     << _("   -B      Process the JSON requests read from stdin, one per line (server)\n")
      << _("   -a time Time adjustment in the format [+|-]HH[:MM[:SS]]. For 'adjust' action\n")
      << _("   -Y yrs  Year adjustment with the 'adjust' action\n")
      << _("   -O mon  Month adjustment with the 'adjust' action\n")
@@ -307,6 +438,8 @@ void Params::help(std::ostream& os) const {
      << _("             V : Plain data value, data type and the word 'set'\n")
      << _("             t : Interpreted (translated) human readable values\n")
      << _("             h : Hex dump of the data\n")
+     << _("             J : JSON Lines, one object per file with the values (t or v) by key\n")
+     << _("             C : CSV, one row per file with the values (t or v) of the -K keys\n")
      << _("   -d tgt1  Delete target(s) for the 'delete' action. Possible targets are:\n")
      << _("             a : All supported metadata (the default)\n") << _("             e : Exif tags\n")
      << _("             t : Exif thumbnail only\n") << _("             i : IPTC tags\n")
@@ -362,7 +495,8 @@ int Params::option(int opt, const std::string& optArg, int optOpt) {
       verbose_ = true;
       break;
     case 'q':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::mute);
+      if (!request_)
+        Exiv2::LogMsg::setLevel(Exiv2::LogMsg::mute);
       break;
     case 'Q':
       rc = setLogLevel(optArg);
@@ -384,6 +518,9 @@ int Params::option(int opt, const std::string& optArg, int optOpt) {
       force_ = true;
       fileExistsPolicy_ = renamePolicy;
       break;
+    case 'N':
+      dryRun_ = true;
+      break;
     case 'g':
       rc = evalGrep(optArg);
       break;
@@ -448,6 +585,21 @@ int Params::option(int opt, const std::string& optArg, int optOpt) {
     case 'S':
       suffix_ = optArg;
       break;
+    case 'j':
+      rc = evalJobs(optArg);
+      break;
+    case 'R':
+      recursive_ = true;
+      break;
+    case 'G':
+      includes_.push_back(optArg);
+      break;
+    case 'X':
+      excludes_.push_back(optArg);
+      break;
+    case 'B':
+      server_ = true;
+      break;
     case ':':
       std::cerr << progname() << ": " << _("Option") << " -" << static_cast<char>(optOpt) << " "
                 << _("requires an argument\n");
@@ -468,31 +620,44 @@ int Params::option(int opt, const std::string& optArg, int optOpt) {
 
 int Params::setLogLevel(const std::string& optArg) {
   int rc = 0;
+  auto level = Exiv2::LogMsg::level();
   const auto logLevel = static_cast<char>(tolower(optArg[0]));
   switch (logLevel) {
     case 'd':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::debug);
+      level = Exiv2::LogMsg::debug;
       break;
     case 'i':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::info);
+      level = Exiv2::LogMsg::info;
       break;
     case 'w':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::warn);
+      level = Exiv2::LogMsg::warn;
       break;
     case 'e':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::error);
+      level = Exiv2::LogMsg::error;
       break;
     case 'm':
-      Exiv2::LogMsg::setLevel(Exiv2::LogMsg::mute);
+      level = Exiv2::LogMsg::mute;
       break;
     default:
       std::cerr << progname() << ": " << _("Option") << " -Q: " << _("Invalid argument") << " \"" << optArg << "\"\n";
       rc = 1;
       break;
   }
+  if (rc == 0 && !request_)
+    Exiv2::LogMsg::setLevel(level);
   return rc;
 }  // Params::setLogLevel
 
+int Params::evalJobs(const std::string& optArg) {
+  int64_t jobs = 0;
+  if (!Util::strtol(optArg.c_str(), jobs) || jobs < 0) {
+    std::cerr << progname() << ": " << _("Option") << " -j: " << _("Invalid argument") << " \"" << optArg << "\"\n";
+    return 1;
+  }
+  jobs_ = jobs == 0 ? std::max(1U, std::thread::hardware_concurrency()) : static_cast<size_t>(jobs);
+  return 0;
+}  // Params::evalJobs
+
 int Params::evalGrep(const std::string& optArg) {
   // check that string ends in "/i"
   bool bIgnoreCase = optArg.size() > 2 && optArg.back() == 'i' && optArg[optArg.size() - 2] == '/';
@@ -511,15 +676,40 @@ int Params::evalGrep(const std::string& optArg) {
     return 1;
   }
 
+  // patterns without special characters of a POSIX basic regex other than '.' are searched for without the regex.
+  // + ? | ( ) { } are ordinary characters in a basic regex, its groups and intervals need a backslash.
+  if (pattern.find_first_of("[\\*^$") == std::string::npos) {
+    if (bIgnoreCase)
+      std::transform(pattern.begin(), pattern.end(), pattern.begin(), [](unsigned char c) { return std::tolower(c); });
+    grepLiterals_.push_back({std::move(pattern), bIgnoreCase});
+  } else {
+    grepRegexes_.push_back(greps_.back());
+  }
+
   return 0;
 }  // Params::evalGrep
 
 int Params::evalKey(const std::string& optArg) {
   int result = 0;
   keys_.push_back(optArg);
+  keySet_.insert(optArg);
   return result;
 }  // Params::evalKey
 
+bool Params::needsMakerNotes() const {
+  // The rename action only reads the standard Exif timestamps
+  if (action_ == Action::rename)
+    return false;
+  if (action_ != Action::print || printMode_ != pmList || keys_.empty())
+    return true;
+  return std::any_of(keys_.begin(), keys_.end(), [](const std::string& key) {
+    if (!key.starts_with("Exif."))
+      return false;
+    auto group = key.substr(5, key.find('.', 5) - 5);
+    return Exiv2::ExifTags::isMakerGroup(group);
+  });
+}  // Params::needsMakerNotes
+
 int Params::evalRename(int opt, const std::string& optArg) {
   int rc = 0;
   switch (action_) {
@@ -738,6 +928,12 @@ int Params::evalPrintFlags(const std::string& optArg) {
           case 'd':
             printItems_ |= prDesc;
             break;
+          case 'J':
+            outputFormat_ = ofJson;
+            break;
+          case 'C':
+            outputFormat_ = ofCsv;
+            break;
           default:
             std::cerr << progname() << ": " << _("Unrecognized print item") << " `" << i << "'\n";
             rc = 1;
@@ -918,7 +1114,15 @@ int Params::nonoption(const std::string& argv) {
       action = true;
       action_ = Action::fixcom;
     }
-    if (action_ == Action::none) {
+    if (argv == "di" || argv == "diff") {
+      if (action_ != Action::none && action_ != Action::diff) {
+        std::cerr << progname() << ": " << _("Action diff is not compatible with the given options\n");
+        rc = 1;
+      }
+      action = true;
+      action_ = Action::diff;
+    }
+    if (action_ == Action::none && !server_) {
       // if everything else fails, assume print as the default action
       action_ = Action::print;
     }
@@ -1010,13 +1214,14 @@ int Params::getopt(int argc, char* const Argv[]) {
   argv.back() = nullptr;
 
   const std::unordered_map<std::string, std::string> longs{
-      {"--adjust", "-a"},    {"--binary", "-b"},  {"--comment", "-c"}, {"--delete", "-d"},   {"--days", "-D"},
-      {"--extract", "-e"},   {"--force", "-f"},   {"--Force", "-F"},   {"--grep", "-g"},     {"--help", "-h"},
-      {"--insert", "-i"},    {"--keep", "-k"},    {"--key", "-K"},     {"--location", "-l"}, {"--modify", "-m"},
-      {"--Modify", "-M"},    {"--encode", "-n"},  {"--months", "-O"},  {"--print", "-p"},    {"--Print", "-P"},
-      {"--quiet", "-q"},     {"--log", "-Q"},     {"--rename", "-r"},  {"--suffix", "-S"},   {"--timestamp", "-t"},
-      {"--Timestamp", "-T"}, {"--unknown", "-u"}, {"--verbose", "-v"}, {"--Version", "-V"},  {"--version", "-V"},
-      {"--years", "-Y"},
+      {"--adjust", "-a"},    {"--binary", "-b"},    {"--server", "-B"},  {"--comment", "-c"},   {"--delete", "-d"},
+      {"--days", "-D"},      {"--dry-run", "-N"},   {"--extract", "-e"}, {"--exclude", "-X"},   {"--force", "-f"},
+      {"--Force", "-F"},     {"--grep", "-g"},      {"--help", "-h"},    {"--include", "-G"},   {"--insert", "-i"},
+      {"--jobs", "-j"},      {"--keep", "-k"},      {"--key", "-K"},     {"--location", "-l"},  {"--modify", "-m"},
+      {"--Modify", "-M"},    {"--encode", "-n"},    {"--months", "-O"},  {"--print", "-p"},     {"--Print", "-P"},
+      {"--quiet", "-q"},     {"--log", "-Q"},       {"--rename", "-r"},  {"--recursive", "-R"}, {"--suffix", "-S"},
+      {"--timestamp", "-t"}, {"--Timestamp", "-T"}, {"--unknown", "-u"}, {"--verbose", "-v"},   {"--Version", "-V"},
+      {"--version", "-V"},   {"--years", "-Y"},
   };
 
   for (int i = 0; i < argc; i++) {
@@ -1033,7 +1238,7 @@ int Params::getopt(int argc, char* const Argv[]) {
   if (help_ || version_) {
     goto cleanup;
   }
-  if (action_ == Action::none) {
+  if (action_ == Action::none && !server_) {
     // This shouldn't happen since print is taken as default action
     std::cerr << progname() << ": " << _("An action must be specified\n");
     rc = 1;
@@ -1047,10 +1252,27 @@ int Params::getopt(int argc, char* const Argv[]) {
     std::cerr << progname() << ": " << _("Modify action requires at least one -c, -m or -M option\n");
     rc = 1;
   }
-  if (files_.empty()) {
+  if (files_.empty() && !server_) {
     std::cerr << progname() << ": " << _("At least one file is required\n");
     rc = 1;
   }
+  if (!files_.empty() && server_) {
+    std::cerr << progname() << ": " << _("Files cannot be given with --server, they are given with each request\n");
+    rc = 1;
+  }
+  if (action_ == Action::diff && !server_) {
+    std::error_code ec;
+    if (files_.size() != 2) {
+      std::cerr << progname() << ": " << _("Diff action requires two files or two directories\n");
+      rc = 1;
+    } else if (fs::is_directory(files_.front(), ec) != fs::is_directory(files_.back(), ec)) {
+      std::cerr << progname() << ": " << _("Diff action cannot compare a file with a directory\n");
+      rc = 1;
+    } else if (fs::is_directory(files_.front(), ec)) {
+      // The files in the two directories are compared
+      recursive_ = true;
+    }
+  }
   // Parse command files
   if (rc == 0 && !cmdFiles_.empty() && !parseCmdFiles(modifyCmds_, cmdFiles_)) {
     std::cerr << progname() << ": " << _("Error parsing -m option arguments\n");
@@ -1061,7 +1283,13 @@ int Params::getopt(int argc, char* const Argv[]) {
     std::cerr << progname() << ": " << _("Error parsing -M option arguments\n");
     rc = 1;
   }
-  if (rc == 0 && (!cmdFiles_.empty() || !cmdLines_.empty())) {
+  // Compile the commands now, before any files are processed in parallel and while
+  // the namespaces registered by the commands are known to resolve the XMP keys
+  if (rc == 0) {
+    modifyProgram_ = std::make_shared<const Action::ModifyProgram>(modifyCmds_);
+  }
+  // The namespaces of a request are unregistered by the server, once no other request is processed
+  if (rc == 0 && !request_ && (!cmdFiles_.empty() || !cmdLines_.empty())) {
     // We'll set them again, after reading the file
     Exiv2::XmpProperties::unregisterNs();
   }
@@ -1081,6 +1309,25 @@ int Params::getopt(int argc, char* const Argv[]) {
     std::cerr << progname() << ": " << _("-T option can only be used with rename action\n");
     rc = 1;
   }
+  if (dryRun_ && action_ != Action::rename) {
+    std::cerr << progname() << ": " << _("-N option can only be used with rename action\n");
+    rc = 1;
+  }
+  if (outputFormat_ == ofCsv && keys_.empty()) {
+    std::cerr << progname() << ": " << _("CSV output requires at least one -K option\n");
+    rc = 1;
+  }
+  if ((!includes_.empty() || !excludes_.empty()) && !recursive_) {
+    std::cerr << progname() << ": " << _("-G and -X options can only be used with -R\n");
+    rc = 1;
+  }
+  // Set defaults for metadata types and data columns of the list print mode
+  if (printTags_ == MetadataId::invalid) {
+    printTags_ = MetadataId::exif | MetadataId::iptc | MetadataId::xmp;
+  }
+  if (printItems_ == 0) {
+    printItems_ = prKey | prType | prCount | prTrans;
+  }
 
 cleanup:
   // cleanup the argument vector
@@ -1415,6 +1662,8 @@ bool parseLine(ModifyCmd& modifyCmd, const std::string& line, int num) {
 
     // Registration needs to be done immediately as the new namespaces are
     // looked up during parsing of subsequent lines (to validate XMP keys).
+    if (auto& params = Params::instance(); params.beforeRegisterNs_)
+      std::exchange(params.beforeRegisterNs_, nullptr)();
     Exiv2::XmpProperties::registerNs(modifyCmd.value_, modifyCmd.key_);
   }
 
@@ -1498,4 +1747,539 @@ std::string parseEscapes(const std::string& input) {
   return result;
 }
 
+void xmpLock(void* mutex, bool lock) {
+  if (lock) {
+    static_cast<std::mutex*>(mutex)->lock();
+  } else {
+    static_cast<std::mutex*>(mutex)->unlock();
+  }
+}
+
+void logHandler(int level, const char* s) {
+  switch (static_cast<Exiv2::LogMsg::Level>(level)) {
+    case Exiv2::LogMsg::debug:
+      Action::err() << "Debug: ";
+      break;
+    case Exiv2::LogMsg::info:
+      Action::err() << "Info: ";
+      break;
+    case Exiv2::LogMsg::warn:
+      Action::err() << "Warning: ";
+      break;
+    case Exiv2::LogMsg::error:
+      Action::err() << "Error: ";
+      break;
+    default:
+      break;
+  }
+  Action::err() << s;
+}
+
+void walkDirectory(const Params& params, const fs::path& dir, const std::function<void(FileEntry&&)>& onFile) {
+  auto matches = [](const std::vector<std::string>& patterns, const std::string& name) {
+    return std::any_of(patterns.begin(), patterns.end(),
+                       [&](const std::string& pattern) { return Util::globMatch(pattern, name); });
+  };
+
+  // The entries carry the file types read with the directory, which need no further system calls
+  std::error_code ec;
+  std::vector<fs::directory_entry> entries;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    entries.push_back(*it);
+  if (ec) {
+    onFile({dir.string(), ec.message()});
+    return;
+  }
+  std::sort(entries.begin(), entries.end());
+
+  for (const auto& entry : entries) {
+    const auto name = entry.path().filename().string();
+    if (matches(params.excludes_, name))
+      continue;
+    // Symbolic links to directories are not followed, so that there are no cycles
+    if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+      walkDirectory(params, entry.path(), onFile);
+    } else if (entry.is_regular_file(ec) && (params.includes_.empty() || matches(params.includes_, name))) {
+      onFile({entry.path().string(), {}});
+    }
+  }
+}
+
+void walkDirectoryPair(const Params& params, const std::function<void(FileEntry&&)>& onFile) {
+  // The files by their paths relative to the directories, with the path in the first
+  // directory if the file is in both of them
+  std::map<std::string, FileEntry> entries;
+  for (const auto& dir : {params.files_.back(), params.files_.front()}) {
+    walkDirectory(params, dir, [&](FileEntry&& entry) {
+      if (!entry.error.empty()) {
+        onFile(std::move(entry));
+        return;
+      }
+      auto relative = fs::path(entry.path).lexically_relative(dir).generic_string();
+      entries.insert_or_assign(std::move(relative), std::move(entry));
+    });
+  }
+  for (auto& [relative, entry] : entries)
+    onFile(std::move(entry));
+}
+
+void walkFiles(const Params& params, const std::function<void(FileEntry&&)>& onFile) {
+  if (params.action_ == Action::diff) {
+    // Two files are compared once, as a pair
+    if (params.recursive_)
+      walkDirectoryPair(params, onFile);
+    else
+      onFile({params.files_.front(), {}});
+    return;
+  }
+  for (const auto& file : params.files_) {
+    std::error_code ec;
+    if (params.recursive_ && fs::is_directory(file, ec)) {
+      walkDirectory(params, file, onFile);
+    } else {
+      onFile({file, {}});
+    }
+  }
+}
+
+int runTask(Action::Task& task, const Params& params, size_t n, const FileEntry& entry) {
+  if (!entry.error.empty()) {
+    Action::err() << entry.path << ": " << _("Failed to read the directory") << ": " << entry.error << '\n';
+    return 1;
+  }
+  // If extracting to stdout then ignore verbose
+  if (params.verbose_ && !(params.action_ & Action::extract && params.target_ & Params::ctStdInOut)) {
+    Action::out() << _("File") << " ";
+    // The number of files found in directories is not known in advance
+    if (params.recursive_ || params.action_ == Action::diff) {
+      Action::out() << n + 1;
+    } else {
+      const auto filesCount = params.files_.size();
+      int w = [=]() {
+        if (filesCount > 9) {
+          if (filesCount > 99)
+            return 3;
+          return 2;
+        }
+        return 1;
+      }();
+      Action::out() << std::setw(w) << std::right << n + 1 << "/" << filesCount;
+    }
+    Action::out() << ": " << entry.path << '\n';
+  }
+  task.setBinary(params.binary_);
+  return task.run(entry.path);
+}
+
+int runSerial(Action::Task& task, const Params& params) {
+  int returnCode = EXIT_SUCCESS;
+  size_t n = 0;
+  walkFiles(params, [&](FileEntry&& entry) {
+    int ret = runTask(task, params, n++, entry);
+    if (returnCode == EXIT_SUCCESS)
+      returnCode = ret;
+  });
+  return returnCode;
+}
+
+int runParallel(const Action::Task& task, const Params& params) {
+  struct Result {
+    std::string out;
+    std::string err;
+    int ret{EXIT_SUCCESS};
+    bool done{false};
+  };
+
+  const auto jobs = params.recursive_ ? params.jobs_ : std::min(params.jobs_, params.files_.size());
+  // Results of the files finished ahead of the next one to write are kept in a ring
+  // of slots, so that memory does not grow with the number of files
+  const size_t window = 4 * jobs;
+  std::vector<Result> results(window);
+  // Files found and not yet taken by a worker, at most window of them
+  std::deque<FileEntry> queue;
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t found = 0;
+  bool walked = false;
+  size_t taken = 0;
+  size_t written = 0;
+
+  auto walker = [&] {
+    walkFiles(params, [&](FileEntry&& entry) {
+      {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [&] { return queue.size() < window; });
+        queue.push_back(std::move(entry));
+        ++found;
+      }
+      cv.notify_all();
+    });
+    {
+      auto guard = std::scoped_lock(mutex);
+      walked = true;
+    }
+    cv.notify_all();
+  };
+
+  auto worker = [&] {
+    auto clone = task.clone();
+    while (true) {
+      size_t n = 0;
+      FileEntry entry;
+      {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [&] { return (!queue.empty() && taken < written + window) || (walked && queue.empty()); });
+        if (queue.empty())
+          return;
+        n = taken++;
+        entry = std::move(queue.front());
+        queue.pop_front();
+      }
+      cv.notify_all();
+      Result result;
+      {
+        Action::OutputBuffer buffer;
+        try {
+          result.ret = runTask(*clone, params, n, entry);
+        } catch (const std::exception& exc) {
+          Action::err() << "Uncaught exception: " << exc.what() << '\n';
+          result.ret = EXIT_FAILURE;
+        }
+        result.out = buffer.out();
+        result.err = buffer.err();
+      }
+      result.done = true;
+      {
+        auto guard = std::scoped_lock(mutex);
+        results[n % window] = std::move(result);
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(walker);
+  for (size_t i = 0; i < jobs; ++i)
+    threads.emplace_back(worker);
+
+  int returnCode = EXIT_SUCCESS;
+  for (size_t n = 0;; ++n) {
+    Result result;
+    {
+      std::unique_lock lock(mutex);
+      cv.wait(lock, [&] { return results[n % window].done || (walked && n == found); });
+      if (!results[n % window].done)
+        break;
+      result = std::exchange(results[n % window], Result());
+      written = n + 1;
+    }
+    cv.notify_all();
+    // std::cerr is tied to std::cout, which is flushed before the errors are written
+    std::cout << result.out;
+    std::cerr << result.err;
+    if (returnCode == EXIT_SUCCESS)
+      returnCode = result.ret;
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+  return returnCode;
+}
+
+int runRename(const Params& params) {
+  std::vector<FileEntry> entries;
+  walkFiles(params, [&](FileEntry&& entry) { entries.push_back(std::move(entry)); });
+  std::vector<Action::Rename::Plan> plans(entries.size());
+
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    Action::Rename rename;
+    for (size_t n = next++; n < entries.size(); n = next++) {
+      auto& plan = plans[n];
+      rename.setPlan(&plan);
+      Action::OutputBuffer buffer;
+      try {
+        plan.ret = runTask(rename, params, n, entries[n]);
+      } catch (const std::exception& exc) {
+        Action::err() << "Uncaught exception: " << exc.what() << '\n';
+        plan.ret = EXIT_FAILURE;
+      }
+      plan.out = buffer.out();
+      plan.err = buffer.err();
+    }
+  };
+  const auto jobs = std::min(params.jobs_, entries.size());
+  if (jobs > 1) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < jobs; ++i)
+      threads.emplace_back(worker);
+    for (auto& thread : threads)
+      thread.join();
+  } else {
+    worker();
+  }
+
+  Action::Rename::resolve(plans, false);
+
+  int returnCode = EXIT_SUCCESS;
+  for (auto& plan : plans) {
+    std::cout << plan.out;
+    std::cerr << plan.err;
+    int ret = Action::Rename::execute(plan);
+    if (returnCode == EXIT_SUCCESS)
+      returnCode = ret;
+  }
+  return returnCode;
+}
+
+void readRequest(const std::string& line, const Params& server, Request& request, const std::function<void()>& drain) {
+  auto fail = [&](const std::string& message) {
+    std::cerr << server.progname() << ": " << message << '\n';
+    request.ret = EXIT_FAILURE;
+    request.done = true;
+  };
+  auto isString = [](const Util::JsonValue& value) { return value.type_ == Util::JsonValue::string; };
+  auto isStrings = [&](const Util::JsonValue& value) {
+    return value.type_ == Util::JsonValue::array && std::all_of(value.items_.begin(), value.items_.end(), isString);
+  };
+
+  Util::JsonValue json;
+  if (!Util::parseJson(line, json) || json.type_ != Util::JsonValue::object)
+    return fail(_("Invalid request, a JSON object is expected"));
+  // The id is returned with the response, to match it with the request
+  if (auto id = json.member("id")) {
+    if (isString(*id))
+      Util::appendJsonString(request.id, id->text_);
+    else if (id->type_ == Util::JsonValue::number)
+      request.id = id->text_;
+    else
+      return fail(_("Invalid request, the id must be a string or a number"));
+  }
+  for (const auto& [name, value] : json.members_) {
+    if (name != "id" && name != "action" && name != "options" && name != "path")
+      return fail(_("Invalid request, unknown member") + std::string(" \"") + name + '"');
+  }
+
+  // The command line of the request: its options, the action and the files
+  std::vector<std::string> args{server.progname()};
+  if (auto options = json.member("options")) {
+    if (!isStrings(*options))
+      return fail(_("Invalid request, the options must be an array of strings"));
+    for (const auto& option : options->items_)
+      args.push_back(option.text_);
+  }
+  if (auto action = json.member("action")) {
+    if (!isString(*action))
+      return fail(_("Invalid request, the action must be a string"));
+    args.push_back(action->text_);
+  }
+  if (auto path = json.member("path")) {
+    if (isString(*path)) {
+      args.push_back(path->text_);
+    } else if (isStrings(*path)) {
+      for (const auto& item : path->items_)
+        args.push_back(item.text_);
+    } else {
+      return fail(_("Invalid request, the path must be a string or an array of strings"));
+    }
+  }
+  std::vector<char*> argv;
+  for (auto& arg : args)
+    argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  request.params = Params::create();
+  auto& params = *request.params;
+  // The log level is that of the server, -q and -Q only apply to its command line
+  params.request_ = true;
+  params.beforeRegisterNs_ = [&] {
+    request.exclusive = true;
+    drain();
+  };
+  const Params::Scope scope(params);
+  const int rc = params.getopt(static_cast<int>(args.size()), argv.data());
+  params.beforeRegisterNs_ = nullptr;
+  if (rc != 0)
+    return fail(_("Invalid options in the request"));
+  if (params.help_) {
+    params.help();
+    request.done = true;
+    return;
+  }
+  if (params.version_) {
+    Params::version(params.verbose_);
+    request.done = true;
+    return;
+  }
+  if (params.server_)
+    return fail(_("A request cannot start another server"));
+  // stdin carries the requests and stdout the responses
+  if (params.target_ & Params::ctStdInOut ||
+      std::find(params.files_.begin(), params.files_.end(), "-") != params.files_.end())
+    return fail(_("stdin and stdout cannot be used by a request"));
+  request.task = Action::TaskFactory::instance().create(static_cast<Action::TaskType>(params.action_));
+}
+
+int runServer(const Params& params) {
+  //! Redirects a stream to another one for as long as it exists
+  class Redirect {
+   public:
+    Redirect(std::ostream& os, const std::ostream& to) : os_(os), buf_(os.rdbuf(to.rdbuf())) {
+    }
+    ~Redirect() {
+      os_.rdbuf(buf_);
+    }
+    Redirect(const Redirect&) = delete;
+    Redirect& operator=(const Redirect&) = delete;
+
+   private:
+    std::ostream& os_;
+    std::streambuf* buf_;
+  };
+
+  const size_t window = 4 * params.jobs_;
+  // The requests from the first one that is not answered yet, in the order in which they were read
+  std::deque<std::unique_ptr<Request>> requests;
+  // Index in requests of the first request which is not taken by a worker
+  size_t next = 0;
+  bool eof = false;
+  std::mutex mutex;
+  std::condition_variable cv;
+  // Held to write to std::cout and std::cerr, or to redirect them
+  std::mutex stdio;
+
+  // Wait until the requests read so far are processed. The XMP namespaces are
+  // process-wide: a request which registers some is processed alone, once the
+  // requests before it are processed, and its namespaces are unregistered before
+  // the next request is read.
+  auto drain = [&] {
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [&] { return std::all_of(requests.begin(), requests.end(), [](auto& r) { return r->done; }); });
+  };
+
+  auto reader = [&] {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (line.find_first_not_of(" \t") == std::string::npos)
+        continue;
+      auto request = std::make_unique<Request>();
+      bool exclusive = false;
+      {
+        // Params reports errors on std::cerr, and writes the help and the version on std::cout,
+        // which carries the responses. This output is returned with the response instead.
+        auto guard = std::scoped_lock(stdio);
+        std::ostringstream out;
+        std::ostringstream err;
+        try {
+          const Redirect redirectOut(std::cout, out);
+          const Redirect redirectErr(std::cerr, err);
+          readRequest(line, params, *request, drain);
+        } catch (const std::exception& exc) {
+          err << "Uncaught exception: " << exc.what() << '\n';
+          request->ret = EXIT_FAILURE;
+          request->done = true;
+        }
+        request->out = out.str();
+        request->err = err.str();
+      }
+      {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [&] { return requests.size() < window; });
+        exclusive = request->exclusive;
+        requests.push_back(std::move(request));
+      }
+      cv.notify_all();
+      if (exclusive) {
+        drain();
+        Exiv2::XmpProperties::unregisterNs();
+      }
+    }
+    {
+      auto guard = std::scoped_lock(mutex);
+      eof = true;
+    }
+    cv.notify_all();
+  };
+
+  auto worker = [&] {
+    while (true) {
+      Request* request = nullptr;
+      {
+        std::unique_lock lock(mutex);
+        // Requests which are done already, because they are invalid, are skipped
+        auto ready = [&] {
+          while (next < requests.size() && requests[next]->done)
+            ++next;
+          return next < requests.size() || eof;
+        };
+        cv.wait(lock, ready);
+        if (next == requests.size())
+          return;
+        request = requests[next++].get();
+      }
+      {
+        Action::OutputBuffer buffer;
+        const Params::Scope scope(*request->params);
+        const auto& requestParams = *request->params;
+        try {
+          if (requestParams.action_ == Action::print && requestParams.outputFormat_ == Params::ofCsv)
+            Action::Print::printCsvHeader();
+          request->ret = runSerial(*request->task, requestParams);
+        } catch (const std::exception& exc) {
+          Action::err() << "Uncaught exception: " << exc.what() << '\n';
+          request->ret = EXIT_FAILURE;
+        }
+        request->out += buffer.out();
+        request->err += buffer.err();
+      }
+      {
+        auto guard = std::scoped_lock(mutex);
+        request->done = true;
+      }
+      cv.notify_all();
+    }
+  };
+
+  // Reading the requests must not flush std::cout, which is written by another thread
+  std::cin.tie(nullptr);
+  std::vector<std::thread> threads;
+  threads.emplace_back(reader);
+  for (size_t i = 0; i < params.jobs_; ++i)
+    threads.emplace_back(worker);
+
+  while (true) {
+    std::unique_ptr<Request> request;
+    {
+      std::unique_lock lock(mutex);
+      cv.wait(lock, [&] { return (!requests.empty() && requests.front()->done) || (eof && requests.empty()); });
+      if (requests.empty())
+        break;
+      request = std::move(requests.front());
+      requests.pop_front();
+      // The first request may be done without having been taken, if it is invalid
+      next -= next > 0 ? 1 : 0;
+    }
+    cv.notify_all();
+
+    std::string response = "{";
+    if (!request->id.empty())
+      response.append("\"id\":").append(request->id).append(",");
+    // The return code is the exit status that exiv2 would have with the command line of the request
+    response.append("\"rc\":").append(std::to_string(static_cast<unsigned int>(request->ret) % 256));
+    response.append(",\"stdout\":");
+    Util::appendJsonString(response, request->out);
+    response.append(",\"stderr\":");
+    Util::appendJsonString(response, request->err);
+    response.append("}\n");
+    auto guard = std::scoped_lock(stdio);
+    std::cout << response << std::flush;
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+  return EXIT_SUCCESS;
+}
+
 }  // namespace
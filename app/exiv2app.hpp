@@ -16,9 +16,16 @@
 #include "types.hpp"
 
 // + standard includes
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <regex>
 #include <set>
+#include <unordered_set>
+
+namespace Action {
+class ModifyProgram;
+}
 
 //! Command identifiers
 enum class CmdId {
@@ -115,10 +122,29 @@ class Params : public Util::Getopt {
 
   /*!
     @brief Controls all access to the global Params instance.
-    @return Reference to the global Params instance.
+    @return Reference to the global Params instance, or to the one of the
+            Scope which exists on the current thread.
   */
   static Params& instance();
 
+  //! Create a Params instance for the command line of a request in server mode
+  static std::unique_ptr<Params> create();
+
+  /*!
+    @brief Makes a Params instance, one created for a request, the one that
+           instance() returns on the current thread, for as long as it exists.
+   */
+  class Scope {
+   public:
+    explicit Scope(Params& params);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    Params* prev_;
+  };
+
   //! Prevent copy-construction: not implemented.
   ~Params() override = default;
   Params(const Params&) = delete;
@@ -136,6 +162,13 @@ class Params : public Util::Getopt {
     pmRecursive,
   };
 
+  //! Enumerates the output formats of the list print mode
+  enum OutputFormat {
+    ofText,  //!< Aligned columns
+    ofJson,  //!< JSON Lines, one object per file
+    ofCsv,   //!< CSV, one row per file with the -K keys as columns
+  };
+
   //! Individual items to print, bitmap
   enum PrintItem : uint32_t {
     prTag = 1,
@@ -202,6 +235,7 @@ class Params : public Util::Getopt {
   bool adjust_{false};                            //!< Adjustment flag.
   PrintMode printMode_{pmSummary};                //!< Print mode.
   PrintItem printItems_{0};                       //!< Print items.
+  OutputFormat outputFormat_{ofText};             //!< Output format of the list print mode.
   MetadataId printTags_{Exiv2::mdNone};           //!< Print tags (bitmap of MetadataId flags).
   //! %Action (integer rather than TaskType to avoid dependency).
   int action_{0};
@@ -222,9 +256,33 @@ class Params : public Util::Getopt {
   std::vector<std::regex> greps_;       //!< List of keys to 'grep' from the metadata
   Keys keys_;                           //!< List of keys to match from the metadata
   std::string charset_;                 //!< Charset to use for UNICODE Exif user comment
+  size_t jobs_{1};                      //!< Number of files processed in parallel (-j option arg)
+  bool recursive_{false};               //!< Process the files in directories and their subdirectories
+  std::vector<std::string> includes_;   //!< Name patterns of the files to process in directories (-G)
+  std::vector<std::string> excludes_;   //!< Name patterns of the files and directories to skip (-X)
+  bool server_{false};                  //!< Process the requests read from stdin (--server)
+  bool dryRun_{false};                  //!< Only report the renames (-N)
+  //! The options are those of a request in server mode: -q and -Q leave the log level of the server alone
+  bool request_{false};
+  //! Called, if set, before a modify command registers an XMP namespace while the options are parsed
+  std::function<void()> beforeRegisterNs_;
 
   Exiv2::DataBuf stdinBuf;  //!< DataBuf with the binary bytes from stdin
 
+  //! A -g pattern without special characters other than '.', which is matched without a regex
+  struct GrepLiteral {
+    std::string text_;  //!< The pattern, in lower case if the case is ignored
+    bool ignoreCase_;   //!< Whether the pattern ends in "/i"
+  };
+  //! The -g patterns that are literals
+  std::vector<GrepLiteral> grepLiterals_;
+  //! The -g patterns that are regular expressions
+  std::vector<std::regex> grepRegexes_;
+  //! The keys of keys_, to look them up
+  std::unordered_set<std::string> keySet_;
+  //! The program compiled from modifyCmds_
+  std::shared_ptr<const Action::ModifyProgram> modifyProgram_;
+
  private:
   bool first_{true};
 
@@ -233,6 +291,7 @@ class Params : public Util::Getopt {
   //! @name Helpers
   //@{
   int setLogLevel(const std::string& optarg);
+  int evalJobs(const std::string& optarg);
   int evalGrep(const std::string& optarg);
   int evalKey(const std::string& optarg);
   int evalRename(int opt, const std::string& optarg);
@@ -274,6 +333,17 @@ class Params : public Util::Getopt {
   //! Print version information to an output stream.
   static void version(bool verbose = false, std::ostream& os = std::cout);
 
+  //! Return true if more than one file may be processed, then the output for each file is labelled with its name.
+  [[nodiscard]] bool manyFiles() const {
+    return files_.size() > 1 || recursive_;
+  }
+
+  /*!
+    @brief Return false if no makernote tags are needed: with the rename action, or if only tags
+           outside of makernotes can be printed, because -K keys restrict the list print mode.
+   */
+  [[nodiscard]] bool needsMakerNotes() const;
+
   //! getStdin binary data read from stdin to DataBuf
   /*
       stdin can be used by multiple images in the exiv2 command line:
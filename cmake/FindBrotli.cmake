@@ -25,6 +25,7 @@ find_path(BROTLI_INCLUDE_DIR "brotli/decode.h")
 
 find_library(BROTLICOMMON_LIBRARY NAMES brotlicommon)
 find_library(BROTLIDEC_LIBRARY NAMES brotlidec)
+find_library(BROTLIENC_LIBRARY NAMES brotlienc)
 
 find_package_handle_standard_args(Brotli
     FOUND_VAR
@@ -40,6 +41,15 @@ find_package_handle_standard_args(Brotli
 set(Brotli_INCLUDE_DIRS ${BROTLI_INCLUDE_DIR})
 set(Brotli_LIBRARIES ${BROTLICOMMON_LIBRARY} ${BROTLIDEC_LIBRARY})
 
+# The encoder is optional: without it, brob boxes are read but metadata is written uncompressed
+if(BROTLI_FOUND AND BROTLIENC_LIBRARY)
+  set(BROTLIENC_FOUND TRUE)
+  list(APPEND Brotli_LIBRARIES ${BROTLIENC_LIBRARY})
+else()
+  set(BROTLIENC_FOUND FALSE)
+endif()
+
 mark_as_advanced(BROTLI_INCLUDE_DIR)
 mark_as_advanced(BROTLICOMMON_LIBRARY)
 mark_as_advanced(BROTLIDEC_LIBRARY)
+mark_as_advanced(BROTLIENC_LIBRARY)
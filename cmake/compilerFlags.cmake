@@ -18,6 +18,10 @@ if ( MINGW OR UNIX OR MSYS ) # MINGW, Linux, APPLE, CYGWIN
 
     set (CMAKE_CXX_FLAGS_DEBUG "-g3 -gstrict-dwarf -O0")
 
+    # 64-bit off_t for fseeko/ftello on 32-bit targets, so that files larger than 2 GB can be accessed.
+    # Meson does the same by default.
+    add_compile_definitions(_FILE_OFFSET_BITS=64)
+
     if (CMAKE_GENERATOR MATCHES "Xcode")
         set(CMAKE_XCODE_ATTRIBUTE_GCC_VERSION "com.apple.compilers.llvm.clang.1_0")
         if (EXIV2_ENABLE_EXTERNAL_XMP)
@@ -57,6 +57,9 @@
 // Define if you have the brotli library.
 #cmakedefine EXV_HAVE_BROTLI
 
+// Define if you have the brotli encoder library.
+#cmakedefine EXV_HAVE_BROTLIENC
+
 /* Define if you have (Exiv2/xmpsdk) Adobe XMP Toolkit. */
 #cmakedefine EXV_HAVE_XMP_TOOLKIT
 
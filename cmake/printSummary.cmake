@@ -52,6 +52,7 @@ else()
 endif()
 OptionOutput( "Building BMFF support:              " EXIV2_ENABLE_BMFF                  )
 OptionOutput( "Brotli support for JPEG XL:         " EXIV2_ENABLE_BMFF AND BROTLI_FOUND )
+OptionOutput( "Brotli compression for JPEG XL:     " EXIV2_ENABLE_BMFF AND BROTLIENC_FOUND )
 OptionOutput( "Native language support:            " EXIV2_ENABLE_NLS                   )
 OptionOutput( "Building video support:             " EXIV2_ENABLE_VIDEO                 )
 OptionOutput( "Nikon lens database:                " EXIV2_ENABLE_LENSDATA              )
@@ -20,6 +20,13 @@ namespace Exiv2 {
 
 /*!
   @brief Class to access ASF video files.
+
+  Metadata is read from the Header Object, which is read at once and decoded
+  from memory. The Data Object which follows it is never read. The WM/...
+  attributes of the Extended Content Description Object listed in
+  asfvideo.cpp are written back from the corresponding Xmp.video properties,
+  in place: the Header Object keeps its size, the Padding Objects it contains
+  make room for the attributes.
  */
 class EXIV2API AsfVideo : public Image {
  public:
@@ -84,7 +91,15 @@ class EXIV2API AsfVideo : public Image {
 
     [[nodiscard]] std::string to_string() const;
 
+    //! Write the 16 bytes of the GUID to \em bytes, in the byte order of ASF files
+    void copyTo(uint8_t* bytes) const;
+
     bool operator<(const GUIDTag& other) const;
+
+    //! Hash function for unordered containers keyed by GUID
+    struct Hash {
+      size_t operator()(const GUIDTag& guid) const noexcept;
+    };
   };
 
  private:
@@ -97,7 +112,7 @@ class EXIV2API AsfVideo : public Image {
     uint64_t remaining_size_{};
 
    public:
-    explicit HeaderReader(const BasicIo::UniquePtr& io);
+    explicit HeaderReader(BasicIo& io);
 
     [[nodiscard]] uint64_t getSize() const {
       return size_;
@@ -114,55 +129,63 @@ class EXIV2API AsfVideo : public Image {
 
  protected:
   /*!
-    @brief Check for a valid tag and decode the block at the current IO
-    position. Calls tagDecoder() or skips to next tag, if required.
+    @brief Check for a valid tag and decode the block at the current position
+    of \em io. Calls tagDecoder() or skips to next tag, if required.
    */
-  void decodeBlock();
+  void decodeBlock(BasicIo& io);
 
-  void decodeHeader();
+  void decodeHeader(BasicIo& io);
   /*!
     @brief Interpret File_Properties tag information, and save it in
         the respective XMP container.
    */
-  void fileProperties();
+  void fileProperties(BasicIo& io);
   /*!
     @brief Interpret Stream_Properties tag information, and save it
         in the respective XMP container.
    */
-  void streamProperties();
+  void streamProperties(BasicIo& io);
   /*!
     @brief Interpret Codec_List tag information, and save it in
         the respective XMP container.
    */
-  void codecList();
+  void codecList(BasicIo& io);
   /*!
     @brief Interpret Content_Description tag information, and save it
         in the respective XMP container.
    */
-  void contentDescription();
+  void contentDescription(BasicIo& io);
   /*!
     @brief Interpret Extended_Stream_Properties tag information, and
         save it in the respective XMP container.
    */
-  void extendedStreamProperties();
+  void extendedStreamProperties(BasicIo& io);
   /*!
     @brief Interpret Header_Extension tag information, and save it in
         the respective XMP container.
    */
-  void headerExtension() const;
+  void headerExtension(BasicIo& io) const;
   /*!
     @brief Interpret Metadata, Extended_Content_Description,
         Metadata_Library tag information, and save it in the respective
         XMP container.
    */
-  void extendedContentDescription();
+  void extendedContentDescription(BasicIo& io);
 
-  void DegradableJPEGMedia();
+  void DegradableJPEGMedia(BasicIo& io);
+
+  /*!
+    @brief Read the Header Object, which starts the file, into memory.
+    @throw Error if it is larger than the file or too large to be read at once.
+   */
+  [[nodiscard]] DataBuf readHeaderObject() const;
 
  private:
   //! Variable to store height and width of a video frame.
   uint64_t height_{};
   uint64_t width_{};
+  //! The XMP properties as read, to find those changed when writing
+  XmpData readXmpData_;
 
 };  // Class AsfVideo
 
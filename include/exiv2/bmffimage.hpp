@@ -33,7 +33,8 @@ struct Iloc {
 // class definitions
 
 /*!
-  @brief Class to access BMFF images.
+  @brief Class to access BMFF images. Metadata can only be written to
+      JPEG XL files, all other BMFF images are read-only.
  */
 class EXIV2API BmffImage : public Image {
  public:
@@ -126,6 +127,13 @@ class EXIV2API BmffImage : public Image {
     @warning This function should only be called by readMetadata()
    */
   uint64_t boxHandler(std::ostream& out, Exiv2::PrintStructureOption option, uint64_t pbox_end, size_t depth);
+  /*!
+    @brief Write a JPEG XL file with the current Exif and XMP metadata to
+        \em outIo. Existing Exif and xml boxes (plain or brob) are replaced,
+        all other boxes, including the codestream, are copied unchanged.
+        A bare codestream is wrapped in a container.
+   */
+  void doWriteMetadata(BasicIo& outIo);
 
   uint32_t fileType_{0};
   std::set<size_t> visits_;
@@ -136,6 +144,13 @@ class EXIV2API BmffImage : public Image {
   std::map<uint32_t, Iloc> ilocs_;
   bool bReadMetadata_{false};
   const size_t max_box_depth_;
+  //! Compressed and uncompressed payload of a brob box
+  struct BrobCacheEntry {
+    DataBuf compressed_;
+    DataBuf uncompressed_;
+  };
+  //! Uncompressed brob payloads by box address, reused while the box content is unchanged
+  std::map<uint64_t, BrobCacheEntry> brobCache_;
   //@}
 
   /*!
@@ -152,6 +167,18 @@ class EXIV2API BmffImage : public Image {
    */
 #ifdef EXV_HAVE_BROTLI
   static void brotliUncompress(const byte* compressedBuf, size_t compressedBufSize, DataBuf& arr);
+#ifdef EXV_HAVE_BROTLIENC
+  /*!
+    @brief Wrapper around brotli to compress JXL brob content.
+   */
+  static void brotliCompress(const byte* buf, size_t size, DataBuf& arr);
+#endif
+  /*!
+    @brief Return the uncompressed payload of the brob box at \em address.
+        \em data is the box content (inner type and compressed data). The
+        result is cached and only inflated again when the content changes.
+   */
+  const DataBuf& brobPayload(uint64_t address, const DataBuf& data);
 #endif
 
 };  // class BmffImage
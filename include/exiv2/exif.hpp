@@ -563,6 +563,33 @@ class EXIV2API ExifParser {
 
 };  // class ExifParser
 
+/*!
+  @brief Enable or disable the decoding of makernotes when Exif data is read.
+
+  Makernotes are decoded by default. Without decoding, the makernote is only
+  available as the undecoded Exif.Photo.MakerNote tag, which saves the time to
+  parse it when no makernote tags are needed. Exif data read this way should
+  not be written back to an image.
+
+  @param enable Whether makernotes are decoded.
+  @return The previous setting.
+ */
+EXIV2API bool enableMakerNoteDecoding(bool enable = true);
+
+/*!
+  @brief Return the Exif metadata in canonical form, with the values written as
+         by Exifdatum::toString().
+
+  Tags that locate data in the file, such as IFD pointers, strip offsets and
+  the offset of the thumbnail, are left out, as they change when the same
+  metadata is written with another layout. So is the makernote as a whole and
+  its offset, the makernote tags are included instead.
+ */
+EXIV2API CanonicalMetadata canonicalMetadata(const ExifData& exifData);
+
+//! Return the digest of the Exif metadata in canonical form, see digest(const CanonicalMetadata&)
+EXIV2API uint64_t digest(const ExifData& exifData);
+
 }  // namespace Exiv2
 
 #endif  // #ifndef EXIF_HPP_
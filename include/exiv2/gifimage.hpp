@@ -16,8 +16,8 @@ namespace Exiv2 {
 // class definitions
 
 /*!
-  @brief Class to access raw GIF images. Exif/IPTC metadata are supported
-         directly.
+  @brief Class to access raw GIF images. XMP metadata is supported through
+         the "XMP DataXMP" application extension.
  */
 class EXIV2API GifImage : public Image {
  public:
@@ -42,8 +42,9 @@ class EXIV2API GifImage : public Image {
   //@{
   void readMetadata() override;
   /*!
-    @brief Todo: Write metadata back to the image. This method is not
-        yet(?) implemented. Calling it will throw an Error(ErrorCode::kerWritingImageFormatUnsupported).
+    @brief Write XMP metadata back to the image. Existing XMP application
+        extensions are removed and the new packet is inserted in front of
+        the trailer; all other blocks are copied without being decoded.
    */
   void writeMetadata() override;
   /*!
@@ -68,6 +69,9 @@ class EXIV2API GifImage : public Image {
   [[nodiscard]] std::string mimeType() const override;
   //@}
 
+ private:
+  void doWriteMetadata(BasicIo& outIo);
+
 };  // class GifImage
 
 // *****************************************************************************
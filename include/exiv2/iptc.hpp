@@ -303,6 +303,12 @@ class EXIV2API IptcParser {
 
 };  // class IptcParser
 
+//! Return the IPTC metadata in canonical form, with the values written as by Iptcdatum::toString()
+EXIV2API CanonicalMetadata canonicalMetadata(const IptcData& iptcData);
+
+//! Return the digest of the IPTC metadata in canonical form, see digest(const CanonicalMetadata&)
+EXIV2API uint64_t digest(const IptcData& iptcData);
+
 }  // namespace Exiv2
 
 #endif  // #ifndef IPTC_HPP_
@@ -118,6 +118,15 @@ class EXIV2API MatroskaVideo : public Image {
   //! @name Manipulators
   //@{
   void readMetadata() override;
+  /*!
+    @brief Write Xmp.video.Title to the segment Info and Xmp.video.Title,
+        Xmp.video.DateTimeOriginal and Xmp.video.GPSCoordinates as the
+        TITLE, DATE_RECORDED and RECORDING_LOCATION SimpleTags of the
+        segment Tags. Elements are rewritten in place, using the Void
+        elements after them, moved into another run of Void elements or
+        appended to the segment; the SeekHead and the segment size are
+        updated accordingly. Clusters are never read or moved.
+   */
   void writeMetadata() override;
   //@}
 
@@ -142,6 +151,26 @@ class EXIV2API MatroskaVideo : public Image {
         Calls contentManagement() or skips to next tag, if required.
    */
   void decodeBlock();
+  /*!
+    @brief Record the positions of the Seek entries in the SeekHead at \em offset.
+        Positions are converted to absolute file offsets using the start of the segment.
+    @param offset Offset of the SeekHead payload.
+    @param size Size of the SeekHead payload.
+   */
+  void decodeSeekHead(uint64_t offset, uint64_t size);
+  /*!
+    @brief Decode the top level elements which were not met before the first
+        cluster, like Tags and Chapters written after the clusters. They are
+        located with the SeekHead or, if there is none, by following the level 1
+        elements from the first cluster.
+   */
+  void decodeIndexedElements();
+  /*!
+    @brief Decode the element at \em offset if it is the level 1 element \em id
+        and has not been decoded yet.
+    @return true if the element was decoded.
+   */
+  bool decodeElementAt(uint64_t offset, uint64_t id);
   /*!
     @brief Interpret tag information, and save it in the respective XMP container.
     @param tag Pointer to current tag,
@@ -165,6 +194,16 @@ class EXIV2API MatroskaVideo : public Image {
   uint32_t track_count_{};
   double time_code_scale_ = 1.0;
   uint64_t stream_{};
+  //! Offset of the segment payload, to which SeekHead positions are relative
+  uint64_t segmentStart_{};
+  //! Element ids, with their length marker, and absolute offsets listed in the SeekHeads
+  std::vector<std::pair<uint64_t, uint64_t>> seekEntries_;
+  //! Offsets of the level 1 elements decoded so far
+  std::vector<uint64_t> decodedElements_;
+  //! Name of the SimpleTag being decoded
+  std::string simpleTagName_;
+  //! The XMP properties as read, to find those changed when writing
+  XmpData readXmpData_;
 
   static constexpr double bytesMB = 1048576;
 
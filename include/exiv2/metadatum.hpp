@@ -288,6 +288,20 @@ EXIV2API bool cmpMetadataByTag(const Metadatum& lhs, const Metadatum& rhs);
  */
 EXIV2API bool cmpMetadataByKey(const Metadatum& lhs, const Metadatum& rhs);
 
+/*!
+  @brief Metadata in canonical form: the key and the value of each metadatum,
+         ordered by key. See canonicalMetadata() for ExifData, IptcData and XmpData.
+ */
+using CanonicalMetadata = std::vector<std::pair<std::string, std::string>>;
+
+/*!
+  @brief Return a 64-bit digest of metadata in canonical form. The digest
+         only depends on the keys and the values, it is the same on all
+         platforms and in all versions of the library, so that it can be
+         stored to detect changes of the metadata later.
+ */
+EXIV2API uint64_t digest(const CanonicalMetadata& metadata);
+
 }  // namespace Exiv2
 
 #endif  // #ifndef METADATUM_HPP_
@@ -27,6 +27,8 @@
 #include "exif.hpp"
 #include "image.hpp"
 
+#include <functional>
+
 // *****************************************************************************
 // namespace extensions
 namespace Exiv2 {
@@ -34,6 +36,24 @@ namespace Exiv2 {
 // *****************************************************************************
 // class definitions
 
+//! A sample of a timed metadata track, see QuickTimeVideo::readTimedMetadata()
+struct TimedMetadataSample {
+  uint32_t trackId{0};        //!< ID of the track, from its track header
+  std::string format;         //!< Format of its sample description, e.g. "gpmd", "rtmd", "mebx" or "camm"
+  uint64_t index{0};          //!< Index of the sample in the track, starting at 0
+  uint64_t time{0};           //!< Decoding time of the sample, in units of timeScale
+  uint32_t timeScale{0};      //!< Time units per second of the track
+  uint64_t offset{0};         //!< Offset of the sample in the file
+  const byte* data{nullptr};  //!< The sample, only valid during the callback
+  size_t size{0};             //!< Size of the sample
+};
+
+/*!
+  @brief Function called for each timed metadata sample. Returns false to
+      stop reading.
+ */
+using TimedMetadataCallback = std::function<bool(const TimedMetadataSample& sample)>;
+
 /*!
   @brief Class to access QuickTime video files.
  */
@@ -58,29 +78,63 @@ class EXIV2API QuickTimeVideo : public Image {
   //! @name Manipulators
   //@{
   void readMetadata() override;
+  /*!
+    @brief Write the XMP packet to the top-level XMP uuid box. The file is
+        updated in place: the box reuses the space of the previous XMP box
+        and of adjacent free atoms, or is appended to the end of the file.
+        The media data is never moved.
+   */
   void writeMetadata() override;
+  /*!
+    @brief Set whether readMetadata() computes Xmp.video.FrameRate. This
+        requires decoding the time-to-sample table of each track, which
+        has hundreds of thousands of entries in variable frame rate
+        videos. The default is true.
+   */
+  void computeFrameRate(bool flag);
+
+  /*!
+    @brief Read the samples of the timed metadata tracks, such as the GPS
+        and motion sensor tracks of action cameras and dashcams, and call
+        \em callback for each of them, in the order of the tracks.
+
+    The tracks are those with a metadata handler ("meta" or "camm") or a
+    sample description in a known metadata format ("gpmd", "rtmd", "mebx",
+    "camm"). The samples are located with the sample tables of each track
+    and read a chunk at a time. Neither the tables nor the media data are
+    read at once, so that arbitrarily long recordings can be processed.
+    Does not depend on readMetadata().
+
+    @return The number of samples passed to \em callback.
+    @throw Error if the file cannot be read or its sample tables are corrupted.
+   */
+  uint64_t readTimedMetadata(const TimedMetadataCallback& callback);
   //@}
 
   //! @name Accessors
   //@{
   [[nodiscard]] std::string mimeType() const override;
+  //! Return whether readMetadata() computes Xmp.video.FrameRate.
+  [[nodiscard]] bool computeFrameRate() const;
   //@}
 
  protected:
   /*!
-    @brief Check for a valid tag and decode the block at the current IO
-    position. Calls tagDecoder() or skips to next tag, if required.
+    @brief Check for a valid tag and decode the block at the current position
+    of \em io. Calls tagDecoder() or skips to next tag, if required.
    */
-  void decodeBlock(size_t recursion_depth, std::string const& entered_from = "");
+  void decodeBlock(BasicIo& io, size_t recursion_depth, std::string const& entered_from = "");
   /*!
     @brief Interpret tag information, and call the respective function
         to save it in the respective XMP container. Decodes a Tag
         Information and saves it in the respective XMP container, if
         the block size is small.
+    @param io Source of the data block, positioned at it. The decoders
+        read from it rather than from io_.
     @param buf Data buffer which contains tag ID.
     @param size Size of the data block used to store Tag Information.
    */
-  void tagDecoder(Exiv2::DataBuf& buf, size_t size, size_t recursion_depth);
+  void tagDecoder(BasicIo& io, Exiv2::DataBuf& buf, size_t size, size_t recursion_depth);
 
  private:
   /*!
@@ -88,110 +142,115 @@ class EXIV2API QuickTimeVideo : public Image {
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void fileTypeDecoder(size_t size);
+  void fileTypeDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Media Header Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void mediaHeaderDecoder(size_t size);
+  void mediaHeaderDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Video Header Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void videoHeaderDecoder(size_t size);
+  void videoHeaderDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Movie Header Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void movieHeaderDecoder(size_t size);
+  void movieHeaderDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Track Header Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void trackHeaderDecoder(size_t size);
+  void trackHeaderDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Handler Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void handlerDecoder(size_t size);
+  void handlerDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Tag which contain other sub-tags,
         and save it in the respective XMP container.
    */
-  void multipleEntriesDecoder(size_t recursion_depth);
+  void multipleEntriesDecoder(BasicIo& io, size_t recursion_depth);
   /*!
     @brief Interpret Sample Description Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void sampleDesc(size_t size);
+  void sampleDesc(BasicIo& io, size_t size);
   /*!
     @brief Interpret Image Description Tag, and save it
         in the respective XMP container.
+    @param io Sample description table, positioned at the entry.
    */
-  void imageDescDecoder();
+  void imageDescDecoder(BasicIo& io);
   /*!
     @brief Interpret User Data Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void userDataDecoder(size_t size, size_t recursion_depth);
+  void userDataDecoder(BasicIo& io, size_t size, size_t recursion_depth);
   /*!
     @brief Interpret Preview Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void previewTagDecoder(size_t size);
+  void previewTagDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Meta Keys Tags, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void keysTagDecoder(size_t size);
+  void keysTagDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Track Aperture Tags, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void trackApertureTagDecoder(size_t size);
+  void trackApertureTagDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Nikon Tag, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void NikonTagsDecoder(size_t size);
+  void NikonTagsDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Tags from Different Camera make, and save it
         in the respective XMP container.
     @param size Size of the data block used to store Tag Information.
    */
-  void CameraTagsDecoder(size_t size);
+  void CameraTagsDecoder(BasicIo& io, size_t size);
   /*!
     @brief Interpret Audio Description Tag, and save it
         in the respective XMP container.
+    @param io Sample description table, positioned at the entry.
    */
-  void audioDescDecoder();
+  void audioDescDecoder(BasicIo& io);
   /*!
     @brief Helps to calculate Frame Rate from timeToSample chunk,
         and save it in the respective XMP container.
+    @param size Size of the data block used to store Tag Information.
    */
-  void timeToSampleDecoder();
+  void timeToSampleDecoder(BasicIo& io, size_t size);
   /*!
     @brief Recognizes which stream is currently under processing,
         and save its information in currentStream_ .
+    @param size Size of the track atom. The handler atom is only searched
+        for within the track, not in the rest of the file.
    */
-  void setMediaStream();
+  void setMediaStream(BasicIo& io, size_t size);
   /*!
     @brief Used to discard a tag along with its data. The Tag will
         be skipped and not decoded.
     @param size Size of the data block that is to skipped.
    */
-  void discard(size_t size);
+  void discard(BasicIo& io, size_t size);
 
   //! Variable which stores Time Scale unit, used to calculate time.
   uint64_t timeScale_ = 0;
@@ -199,11 +258,15 @@ class EXIV2API QuickTimeVideo : public Image {
   int currentStream_ = 0;
   //! Variable to check the end of metadata traversing.
   bool continueTraversing_ = false;
+  //! Decode the time-to-sample tables to compute the frame rate.
+  bool computeFrameRate_ = true;
   //! Variable to store height and width of a video frame.
   uint64_t height_ = 0;
   uint64_t width_ = 0;
   //! Prevent stack exhaustion due to excessively deep recursion.
   const size_t max_recursion_depth_;
+  //! The XMP properties as read, to find those changed when writing.
+  XmpData readXmpData_;
 
 };  // QuickTimeVideo End
 
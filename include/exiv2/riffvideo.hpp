@@ -34,6 +34,13 @@ class EXIV2API RiffVideo : public Image {
   //! @name Manipulators
   //@{
   void readMetadata() override;
+  /*!
+    @brief Write the Xmp.video and Xmp.audio properties which are read from
+        the INFO list back to it, and the other XMP properties to the _PMX
+        chunk. Chunks are rewritten in place, using the JUNK chunks after
+        them, moved into another run of JUNK chunks or appended to the last
+        RIFF chunk, whose size is updated. The media data is never moved.
+   */
   void writeMetadata() override;
   //@}
 
@@ -50,6 +57,9 @@ class EXIV2API RiffVideo : public Image {
    public:
     explicit HeaderReader(const BasicIo::UniquePtr& io);
 
+    HeaderReader(std::string id, uint64_t size) : id_(std::move(id)), size_(size) {
+    }
+
     [[nodiscard]] uint64_t getSize() const {
       return size_;
     }
@@ -128,6 +138,12 @@ class EXIV2API RiffVideo : public Image {
   @param size_ Size of the data block used to store Tag Information.
  */
   void readJunk(uint64_t size_) const;
+  /*!
+  @brief Interpret the OpenDML extended AVI header (dmlh). Its frame count includes the frames of the
+  RIFF AVIX extensions, unlike the one in the main AVI header.
+  @param size_ Size of the data block used to store Tag Information.
+ */
+  void readOdmlHeader(uint64_t size_);
 
   static std::string getStreamType(uint32_t stream);
   /*!
@@ -167,8 +183,13 @@ class EXIV2API RiffVideo : public Image {
   static constexpr auto CHUNK_ID_ODML = "ODML";
   static constexpr auto CHUNK_ID_VPRP = "VPRP";
   static constexpr auto CHUNK_ID_IDX1 = "IDX1";
+  static constexpr auto CHUNK_ID_DMLH = "DMLH";
 
   int streamType_{};
+  //! Frame rate from the main AVI header, for the duration computed from the OpenDML frame count
+  double frameRate_{};
+  //! The XMP properties as read, to find those changed when writing
+  XmpData readXmpData_;
 
 };  // Class RiffVideo
 
@@ -15,8 +15,9 @@ namespace Exiv2 {
 // class definitions
 
 /*!
-  @brief Class to access raw TARGA images. This is just a stub - we only
-      read width and height.
+  @brief Class to access raw TARGA images. Width and height are read from
+      the header; author, comments, date and software are read from the
+      TARGA 2.0 extension area and exposed as XMP and image comment.
  */
 class EXIV2API TgaImage : public Image {
  public:
@@ -67,6 +68,10 @@ class EXIV2API TgaImage : public Image {
   [[nodiscard]] std::string mimeType() const override;
   //@}
 
+ private:
+  //! Read the metadata held in the TARGA 2.0 extension area, if any
+  void readExtensionArea();
+
 };  // class TgaImage
 
 // *****************************************************************************
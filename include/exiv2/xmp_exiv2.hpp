@@ -393,6 +393,12 @@ class EXIV2API XmpParser {
 // *****************************************************************************
 // free functions, template and inline definitions
 
+//! Return the XMP metadata in canonical form, with the values written as by Xmpdatum::toString()
+EXIV2API CanonicalMetadata canonicalMetadata(const XmpData& xmpData);
+
+//! Return the digest of the XMP metadata in canonical form, see digest(const CanonicalMetadata&)
+EXIV2API uint64_t digest(const XmpData& xmpData);
+
 template <typename T>
 Xmpdatum& Xmpdatum::operator=(const T& value) {
 #ifdef __cpp_if_constexpr
@@ -4,6 +4,7 @@
 
 #include "basicio.hpp"
 #include "config.h"
+#include "convert.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
@@ -11,6 +12,8 @@
 #include "image_int.hpp"
 
 #include <cstring>
+#include <unordered_map>
+#include <utility>
 
 // *****************************************************************************
 // class member definitions
@@ -57,6 +60,13 @@ AsfVideo::GUIDTag::GUIDTag(const uint8_t* bytes) {
   }
 }
 
+void AsfVideo::GUIDTag::copyTo(uint8_t* bytes) const {
+  ul2Data(bytes, data1_, littleEndian);
+  us2Data(bytes + DWORD, data2_, littleEndian);
+  us2Data(bytes + DWORD + WORD, data3_, littleEndian);
+  std::copy(data4_.begin(), data4_.end(), bytes + QWORD);
+}
+
 std::string AsfVideo::GUIDTag::to_string() const {
   // Concatenate all strings into a single string
   // Convert the string to uppercase
@@ -75,7 +85,32 @@ bool AsfVideo::GUIDTag::operator<(const GUIDTag& other) const {
   return std::lexicographical_compare(data4_.begin(), data4_.end(), other.data4_.begin(), other.data4_.end());
 }
 
+size_t AsfVideo::GUIDTag::Hash::operator()(const GUIDTag& guid) const noexcept {
+  uint64_t value = (static_cast<uint64_t>(guid.data1_) << 32) | (guid.data2_ << 16) | guid.data3_;
+  for (auto b : guid.data4_)
+    value = value * 31 + b;
+  return std::hash<uint64_t>()(value);
+}
+
 constexpr AsfVideo::GUIDTag Header(0x75B22630, 0x668E, 0x11CF, {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C});
+constexpr AsfVideo::GUIDTag FileProperties(0x8CABDCA1, 0xA947, 0x11CF,
+                                           {0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65});
+constexpr AsfVideo::GUIDTag StreamProperties(0xB7DC0791, 0xA9B7, 0x11CF,
+                                             {0x8E, 0xE6, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65});
+constexpr AsfVideo::GUIDTag HeaderExtension(0x5FBF03B5, 0xA92E, 0x11CF,
+                                            {0x8E, 0xE3, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65});
+constexpr AsfVideo::GUIDTag CodecList(0x86D15240, 0x311D, 0x11D0, {0xA3, 0xA4, 0x00, 0xA0, 0xC9, 0x03, 0x48, 0xF6});
+constexpr AsfVideo::GUIDTag ContentDescription(0x75B22633, 0x668E, 0x11CF,
+                                               {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C});
+constexpr AsfVideo::GUIDTag ExtendedContentDescription(0xD2D0A440, 0xE307, 0x11D2,
+                                                       {0x97, 0xF0, 0x00, 0xA0, 0xC9, 0x5E, 0xA8, 0x50});
+constexpr AsfVideo::GUIDTag Padding(0x1806D474, 0xCADF, 0x4509, {0xA4, 0xBA, 0x9A, 0xAB, 0xCB, 0x96, 0xAA, 0xE8});
+constexpr AsfVideo::GUIDTag ExtendedStreamProperties(0x14E6A5CB, 0xC672, 0x4332,
+                                                     {0x83, 0x99, 0xA9, 0x69, 0x52, 0x06, 0x5B, 0x5A});
+constexpr AsfVideo::GUIDTag AudioMedia(0xF8699E40, 0x5B4D, 0x11CF, {0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B});
+constexpr AsfVideo::GUIDTag VideoMedia(0xBC19EFC0, 0x5B4D, 0x11CF, {0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B});
+constexpr AsfVideo::GUIDTag DegradableJpegMedia(0x35907DE0, 0xE415, 0x11CF,
+                                                {0xA9, 0x17, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B});
 
 const std::map<AsfVideo::GUIDTag, std::string> GUIDReferenceTags = {
     //!< Top-level ASF object GUIDS
@@ -87,25 +122,25 @@ const std::map<AsfVideo::GUIDTag, std::string> GUIDReferenceTags = {
     {{0x3CB73FD0, 0x0C4A, 0x4803, {0x95, 0x3D, 0xED, 0xF7, 0xB6, 0x22, 0x8F, 0x0C}}, "Timecode_Index"},
 
     //!< Header Object GUIDs
-    {{0x8CABDCA1, 0xA947, 0x11CF, {0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65}}, "File_Properties"},
-    {{0xB7DC0791, 0xA9B7, 0x11CF, {0x8E, 0xE6, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65}}, "Stream_Properties"},
-    {{0x5FBF03B5, 0xA92E, 0x11CF, {0x8E, 0xE3, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65}}, "Header_Extension"},
-    {{0x86D15240, 0x311D, 0x11D0, {0xA3, 0xA4, 0x00, 0xA0, 0xC9, 0x03, 0x48, 0xF6}}, "Codec_List"},
+    {FileProperties, "File_Properties"},
+    {StreamProperties, "Stream_Properties"},
+    {HeaderExtension, "Header_Extension"},
+    {CodecList, "Codec_List"},
     {{0x1EFB1A30, 0x0B62, 0x11D0, {0xA3, 0x9B, 0x00, 0xA0, 0xC9, 0x03, 0x48, 0xF6}}, "Script_Command"},
     {{0xF487CD01, 0xA951, 0x11CF, {0x8E, 0xE6, 0x00, 0xC0, 0x00, 0xC2, 0x05, 0x36}}, "Marker"},
     {{0xD6E229DC, 0x35DA, 0x11D1, {0x90, 0x34, 0x00, 0xA0, 0xC9, 0x03, 0x49, 0xBE}}, "Bitrate_Mutual_Exclusion"},
     {{0x75B22635, 0x668E, 0x11CF, {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C}}, "Error_Correction"},
-    {{0x75B22633, 0x668E, 0x11CF, {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C}}, "Content_Description"},
-    {{0xD2D0A440, 0xE307, 0x11D2, {0x97, 0xF0, 0x00, 0xA0, 0xC9, 0x5E, 0xA8, 0x50}}, "Extended_Content_Description"},
+    {ContentDescription, "Content_Description"},
+    {ExtendedContentDescription, "Extended_Content_Description"},
     {{0x2211B3FA, 0xBD23, 0x11D2, {0xB4, 0xB7, 0x00, 0xA0, 0xC9, 0x55, 0xFC, 0x6E}}, "Content_Branding"},
     {{0x7BF875CE, 0x468D, 0x11D1, {0x8D, 0x82, 0x00, 0x60, 0x97, 0xC9, 0xA2, 0xB2}}, "Stream_Bitrate_Properties"},
     {{0x2211B3FB, 0xBD23, 0x11D2, {0xB4, 0xB7, 0x00, 0xA0, 0xC9, 0x55, 0xFC, 0x6E}}, "Content_Encryption"},
     {{0x298AE614, 0x2622, 0x4C17, {0xB9, 0x35, 0xDA, 0xE0, 0x7E, 0xE9, 0x28, 0x9C}}, "Extended_Content_Encryption"},
     {{0x2211B3FC, 0xBD23, 0x11D2, {0xB4, 0xB7, 0x00, 0xA0, 0xC9, 0x55, 0xFC, 0x6E}}, "Digital_Signature"},
-    {{0x1806D474, 0xCADF, 0x4509, {0xA4, 0xBA, 0x9A, 0xAB, 0xCB, 0x96, 0xAA, 0xE8}}, "Padding"},
+    {Padding, "Padding"},
 
     //!< Header Extension Object GUIDs
-    {{0x14E6A5CB, 0xC672, 0x4332, {0x83, 0x99, 0xA9, 0x69, 0x52, 0x06, 0x5B, 0x5A}}, "Extended_Stream_Properties"},
+    {ExtendedStreamProperties, "Extended_Stream_Properties"},
     {{0xA08649CF, 0x4775, 0x4670, {0x8A, 0x16, 0x6E, 0x35, 0x35, 0x75, 0x66, 0xCD}}, "Advanced_Mutual_Exclusion"},
     {{0xD1465A40, 0x5A79, 0x4338, {0xB7, 0x1B, 0xE3, 0x6B, 0x8F, 0xD6, 0xC2, 0x49}}, "Group_Mutual_Exclusion"},
     {{0xD4FED15B, 0x88D3, 0x454F, {0x81, 0xF0, 0xED, 0x5C, 0x45, 0x99, 0x9E, 0x24}}, "Stream_Prioritization"},
@@ -120,11 +155,11 @@ const std::map<AsfVideo::GUIDTag, std::string> GUIDReferenceTags = {
     {{0x43058533, 0x6981, 0x49E6, {0x9B, 0x74, 0xAD, 0x12, 0xCB, 0x86, 0xD5, 0x8C}}, "Advanced_Content_Encryption"},
 
     //!< Stream Properties Object Stream Type GUIDs
-    {{0xF8699E40, 0x5B4D, 0x11CF, {0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B}}, "Audio_Media"},
-    {{0xBC19EFC0, 0x5B4D, 0x11CF, {0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B}}, "Video_Media"},
+    {AudioMedia, "Audio_Media"},
+    {VideoMedia, "Video_Media"},
     {{0x59DACFC0, 0x59E6, 0x11D0, {0xA3, 0xAC, 0x00, 0xA0, 0xC9, 0x03, 0x48, 0xF6}}, "Command_Media"},
     {{0xB61BE100, 0x5B4E, 0x11CF, {0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B}}, "JFIF_Media"},
-    {{0x35907DE0, 0xE415, 0x11CF, {0xA9, 0x17, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B}}, "Degradable_JPEG_Media"},
+    {DegradableJpegMedia, "Degradable_JPEG_Media"},
     {{0x91BD222C, 0xF21C, 0x497A, {0x8B, 0x6D, 0x5A, 0xA8, 0x6B, 0xFC, 0x01, 0x85}}, "File_Transfer_Media"},
     {{0x3AFB65E2, 0x47EF, 0x40F2, {0xAC, 0x2C, 0x70, 0xA9, 0x0D, 0x71, 0xD3, 0x43}}, "Binary_Media"},
 
@@ -176,6 +211,66 @@ const std::map<AsfVideo::GUIDTag, std::string> GUIDReferenceTags = {
      "Payload_Extension_System_Degradable_JPEG"},
 };
 
+//! Objects decoded by AsfVideo::decodeBlock()
+enum class AsfObject {
+  header,
+  fileProperties,
+  streamProperties,
+  headerExtension,
+  codecList,
+  contentDescription,
+  extendedContentDescription,
+  extendedStreamProperties,
+  degradableJpegMedia,
+};
+
+//! Decoder of each object, looked up by hash
+const std::unordered_map<AsfVideo::GUIDTag, AsfObject, AsfVideo::GUIDTag::Hash> asfObjectDecoders = {
+    {Header, AsfObject::header},
+    {FileProperties, AsfObject::fileProperties},
+    {StreamProperties, AsfObject::streamProperties},
+    {HeaderExtension, AsfObject::headerExtension},
+    {CodecList, AsfObject::codecList},
+    {ContentDescription, AsfObject::contentDescription},
+    {ExtendedContentDescription, AsfObject::extendedContentDescription},
+    {ExtendedStreamProperties, AsfObject::extendedStreamProperties},
+    {DegradableJpegMedia, AsfObject::degradableJpegMedia},
+};
+
+//! Extended Content Description attributes read into and written from XMP properties, as strings
+constexpr std::pair<const char*, const char*> wmAttributes[] = {
+    {"WM/AlbumTitle", "Xmp.video.Album"},   {"WM/AlbumArtist", "Xmp.video.Artist"},
+    {"WM/Genre", "Xmp.video.Genre"},        {"WM/Year", "Xmp.video.Year"},
+    {"WM/Composer", "Xmp.video.Composer"},  {"WM/Producer", "Xmp.video.Producer"},
+    {"WM/Director", "Xmp.video.Director"},  {"WM/EncodedBy", "Xmp.video.EncodedBy"},
+    {"WM/ToolName", "Xmp.video.Software"},  {"WM/Language", "Xmp.video.Language"},
+};
+
+//! XMP key of the attribute \em name, nullptr if it is not one of wmAttributes
+static const char* wmAttributeKey(const std::string& name) {
+  for (auto&& [attribute, key] : wmAttributes) {
+    if (name == attribute)
+      return key;
+  }
+  return nullptr;
+}
+
+//! Name of the attribute stored in the XMP property \em key, nullptr if it is not one of wmAttributes
+static const char* wmAttributeName(const std::string& key) {
+  for (auto&& [attribute, property] : wmAttributes) {
+    if (key == property)
+      return attribute;
+  }
+  return nullptr;
+}
+
+//! Size of the Header Object fields preceding the objects it contains
+constexpr size_t headerObjectFieldsSize = GUID + QWORD + DWORD + BYTE + BYTE;
+//! Size of the Header Extension Object fields preceding the objects it contains
+constexpr size_t headerExtensionFieldsSize = GUID + QWORD + GUID + WORD + DWORD;
+//! Largest Header Object read into memory
+constexpr uint64_t maxHeaderObjectSize = 64 * 1024 * 1024;
+
 /*!
   @brief Function used to check if data stored in buf is equivalent to
       ASF Header TagVocabulary's GUID.
@@ -186,7 +281,117 @@ static bool isASFType(const byte buf[]) {
   return Header == AsfVideo::GUIDTag(buf);
 }
 
-AsfVideo::AsfVideo(BasicIo::UniquePtr io) : Image(ImageType::asf, mdNone, std::move(io)) {
+//! \em text as an ASF string: UTF-16LE with a null terminator
+static Blob toUtf16(std::string text) {
+  if (!convertStringCharset(text, "UTF-8", "UCS-2LE"))
+    throw Error(ErrorCode::kerImageWriteFailed);
+  Blob utf16(text.begin(), text.end());
+  utf16.insert(utf16.end(), {0, 0});
+  return utf16;
+}
+
+//! The ASF string of \em size bytes at \em data, without its null terminator, in UTF-8
+static std::string fromUtf16(const byte* data, size_t size) {
+  std::string text(reinterpret_cast<const char*>(data), size);
+  while (text.size() >= WORD && text[text.size() - 2] == 0 && text.back() == 0)
+    text.resize(text.size() - WORD);
+  convertStringCharset(text, "UCS-2LE", "UTF-8");
+  return text;
+}
+
+//! Append the object \em guid with \em size bytes of \em payload to \em out
+static void appendObject(Blob& out, const AsfVideo::GUIDTag& guid, const byte* payload, size_t size) {
+  byte header[GUID + QWORD];
+  guid.copyTo(header);
+  ull2Data(header + GUID, GUID + QWORD + size, littleEndian);
+  out.insert(out.end(), header, header + sizeof(header));
+  if (size > 0)
+    out.insert(out.end(), payload, payload + size);
+}
+
+//! Offsets and sizes of the objects in [begin, end) of \em data
+static std::vector<std::pair<size_t, size_t>> asfObjects(const DataBuf& data, size_t begin, size_t end) {
+  std::vector<std::pair<size_t, size_t>> objects;
+  for (size_t offset = begin; offset < end;) {
+    Internal::enforce(end - offset >= GUID + QWORD, ErrorCode::kerCorruptedMetadata);
+    const uint64_t size = data.read_uint64(offset + GUID, littleEndian);
+    Internal::enforce(size >= GUID + QWORD && size <= end - offset, ErrorCode::kerCorruptedMetadata);
+    objects.emplace_back(offset, static_cast<size_t>(size));
+    offset += static_cast<size_t>(size);
+  }
+  return objects;
+}
+
+/*!
+  @brief Payload of the Extended Content Description Object with the WM/... attributes of \em xmpData.
+      The other descriptors of the \em size bytes of the old payload \em old are kept as they are.
+  @return The payload, empty if there are no descriptors.
+ */
+static Blob extendedContentDescriptionPayload(const byte* old, size_t size, const XmpData& xmpData) {
+  Blob descriptors;
+  size_t count = 0;
+  std::vector<std::string> written;
+  const auto appendDescriptor = [&](const std::string& name, const std::string& value) {
+    const Blob utf16Name = toUtf16(name);
+    const Blob utf16Value = toUtf16(value);
+    Internal::enforce(utf16Name.size() <= std::numeric_limits<uint16_t>::max() &&
+                          utf16Value.size() <= std::numeric_limits<uint16_t>::max(),
+                      ErrorCode::kerImageWriteFailed);
+    byte field[WORD];
+    us2Data(field, static_cast<uint16_t>(utf16Name.size()), littleEndian);
+    descriptors.insert(descriptors.end(), field, field + WORD);
+    descriptors.insert(descriptors.end(), utf16Name.begin(), utf16Name.end());
+    us2Data(field, 0 /*Unicode string*/, littleEndian);
+    descriptors.insert(descriptors.end(), field, field + WORD);
+    us2Data(field, static_cast<uint16_t>(utf16Value.size()), littleEndian);
+    descriptors.insert(descriptors.end(), field, field + WORD);
+    descriptors.insert(descriptors.end(), utf16Value.begin(), utf16Value.end());
+    written.push_back(name);
+    ++count;
+  };
+
+  // The attributes keep their place, those without a property are removed
+  if (size > 0) {
+    Internal::enforce(size >= WORD, ErrorCode::kerCorruptedMetadata);
+    const uint16_t oldCount = getUShort(old, littleEndian);
+    size_t pos = WORD;
+    for (uint16_t i = 0; i < oldCount; ++i) {
+      Internal::enforce(size - pos >= WORD, ErrorCode::kerCorruptedMetadata);
+      const uint16_t nameLength = getUShort(old + pos, littleEndian);
+      Internal::enforce(size - pos - WORD >= nameLength + 2 * WORD, ErrorCode::kerCorruptedMetadata);
+      const std::string name = fromUtf16(old + pos + WORD, nameLength);
+      const uint16_t type = getUShort(old + pos + WORD + nameLength, littleEndian);
+      const uint16_t valueLength = getUShort(old + pos + 2 * WORD + nameLength, littleEndian);
+      const size_t end = pos + 3 * WORD + nameLength + valueLength;
+      Internal::enforce(end <= size, ErrorCode::kerCorruptedMetadata);
+
+      const char* key = wmAttributeKey(name);
+      auto property = key ? xmpData.findKey(XmpKey(key)) : xmpData.end();
+      if (!key || (type != 0 && property == xmpData.end())) {
+        descriptors.insert(descriptors.end(), old + pos, old + end);
+        ++count;
+      } else if (property != xmpData.end() && std::find(written.begin(), written.end(), name) == written.end()) {
+        appendDescriptor(name, property->toString());
+      }
+      pos = end;
+    }
+  }
+  for (auto&& [name, key] : wmAttributes) {
+    auto property = xmpData.findKey(XmpKey(key));
+    if (property != xmpData.end() && std::find(written.begin(), written.end(), name) == written.end())
+      appendDescriptor(name, property->toString());
+  }
+
+  if (count == 0)
+    return {};
+  Internal::enforce(count <= std::numeric_limits<uint16_t>::max(), ErrorCode::kerImageWriteFailed);
+  Blob payload(WORD);
+  us2Data(payload.data(), static_cast<uint16_t>(count), littleEndian);
+  payload.insert(payload.end(), descriptors.begin(), descriptors.end());
+  return payload;
+}
+
+AsfVideo::AsfVideo(BasicIo::UniquePtr io) : Image(ImageType::asf, mdXmp, std::move(io)) {
 }  // AsfVideo::AsfVideo
 
 std::string AsfVideo::mimeType() const {
@@ -194,6 +399,96 @@ std::string AsfVideo::mimeType() const {
 }
 
 void AsfVideo::writeMetadata() {
+  // Only the WM/ attributes are stored, the other properties must be those read from the file
+  Internal::enforceXmpStored(xmpData_, readXmpData_,
+                             [](const std::string& key) { return wmAttributeName(key) != nullptr; });
+
+  if (io_->open() != 0)
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  IoCloser closer(*io_);
+  if (!isAsfType(*io_, false))
+    throw Error(ErrorCode::kerNoImageInInputData);
+
+  const DataBuf header = readHeaderObject();
+  const auto objects = asfObjects(header, headerObjectFieldsSize, header.size());
+  auto description = std::find_if(objects.begin(), objects.end(), [&](const auto& object) {
+    return GUIDTag(header.c_data(object.first)) == ExtendedContentDescription;
+  });
+  Blob oldPayload;
+  if (description != objects.end())
+    oldPayload.assign(header.c_data(description->first + GUID + QWORD),
+                      header.c_data(description->first) + description->second);
+  const Blob payload = extendedContentDescriptionPayload(oldPayload.data(), oldPayload.size(), xmpData_);
+  if (payload == oldPayload)
+    return;
+
+  // The objects are rewritten without the Padding Objects, which leave the room for the new attributes.
+  // The Header Object keeps its size: the Data Object which follows it is not moved.
+  Blob children;
+  uint32_t count = 0;
+  for (auto&& [offset, size] : objects) {
+    const GUIDTag guid(header.c_data(offset));
+    if (guid == Padding)
+      continue;
+    if (description != objects.end() && offset == description->first) {
+      if (!payload.empty()) {
+        appendObject(children, ExtendedContentDescription, payload.data(), payload.size());
+        ++count;
+      }
+      continue;
+    }
+    if (guid == HeaderExtension) {
+      Internal::enforce(size >= headerExtensionFieldsSize, ErrorCode::kerCorruptedMetadata);
+      Blob extension(header.c_data(offset), header.c_data(offset + headerExtensionFieldsSize));
+      for (auto&& [nestedOffset, nestedSize] : asfObjects(header, offset + headerExtensionFieldsSize, offset + size)) {
+        if (!(GUIDTag(header.c_data(nestedOffset)) == Padding))
+          extension.insert(extension.end(), header.c_data(nestedOffset), header.c_data(nestedOffset) + nestedSize);
+      }
+      ull2Data(extension.data() + GUID, extension.size(), littleEndian);
+      ul2Data(extension.data() + headerExtensionFieldsSize - DWORD,
+              static_cast<uint32_t>(extension.size() - headerExtensionFieldsSize), littleEndian);
+      children.insert(children.end(), extension.begin(), extension.end());
+    } else {
+      children.insert(children.end(), header.c_data(offset), header.c_data(offset) + size);
+    }
+    ++count;
+  }
+  if (description == objects.end()) {
+    appendObject(children, ExtendedContentDescription, payload.data(), payload.size());
+    ++count;
+  }
+
+  const size_t used = headerObjectFieldsSize + children.size();
+  if (used > header.size() || (used < header.size() && header.size() - used < GUID + QWORD)) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Not enough padding in the ASF Header Object to write the attributes.\n";
+#endif
+    throw Error(ErrorCode::kerImageWriteFailed);
+  }
+  if (used < header.size()) {
+    const Blob padding(header.size() - used - GUID - QWORD);
+    appendObject(children, Padding, padding.data(), padding.size());
+    ++count;
+  }
+
+  Blob rewritten(header.c_data(), header.c_data(headerObjectFieldsSize));
+  ul2Data(rewritten.data() + GUID + QWORD, count, littleEndian);
+  rewritten.insert(rewritten.end(), children.begin(), children.end());
+  io_->seekOrThrow(0, BasicIo::beg, ErrorCode::kerImageWriteFailed);
+  if (io_->write(rewritten.data(), rewritten.size()) != rewritten.size())
+    throw Error(ErrorCode::kerImageWriteFailed);
+}  // AsfVideo::writeMetadata
+
+DataBuf AsfVideo::readHeaderObject() const {
+  io_->seekOrThrow(0, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  HeaderReader objectHeader(*io_);
+  const uint64_t size = objectHeader.getSize();
+  Internal::enforce(size >= headerObjectFieldsSize && size <= io_->size() && size <= maxHeaderObjectSize,
+                    ErrorCode::kerCorruptedMetadata);
+  DataBuf header(static_cast<size_t>(size));
+  io_->seekOrThrow(0, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  io_->readOrThrow(header.data(), header.size(), ErrorCode::kerCorruptedMetadata);
+  return header;
 }
 
 void AsfVideo::readMetadata() {
@@ -209,20 +504,25 @@ void AsfVideo::readMetadata() {
 
   IoCloser closer(*io_);
   clearMetadata();
+  readXmpData_.clear();
   io_->seek(0, BasicIo::beg);
   height_ = width_ = 1;
 
   xmpData()["Xmp.video.FileSize"] = io_->size() / 1048576.;
   xmpData()["Xmp.video.MimeType"] = mimeType();
 
-  decodeBlock();
+  // The objects are decoded from the Header Object in memory
+  const DataBuf header = readHeaderObject();
+  MemIo headerIo(header.c_data(), header.size());
+  decodeBlock(headerIo);
 
   xmpData_["Xmp.video.AspectRatio"] = getAspectRatio(width_, height_);
+  readXmpData_ = xmpData_;
 }  // AsfVideo::readMetadata
 
-AsfVideo::HeaderReader::HeaderReader(const BasicIo::UniquePtr& io) : IdBuf_(GUID) {
-  if (io->size() >= io->tell() + GUID + QWORD) {
-    io->readOrThrow(IdBuf_.data(), IdBuf_.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
+AsfVideo::HeaderReader::HeaderReader(BasicIo& io) : IdBuf_(GUID) {
+  if (io.size() >= io.tell() + GUID + QWORD) {
+    io.readOrThrow(IdBuf_.data(), IdBuf_.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
 
     size_ = readQWORDTag(io);
     if (size_ >= GUID + QWORD)
@@ -230,201 +530,214 @@ AsfVideo::HeaderReader::HeaderReader(const BasicIo::UniquePtr& io) : IdBuf_(GUID
   }
 }
 
-void AsfVideo::decodeBlock() {
-  Internal::enforce(GUID + QWORD <= io_->size() - io_->tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
-  HeaderReader objectHeader(io_);
+void AsfVideo::decodeBlock(BasicIo& io) {
+  Internal::enforce(GUID + QWORD <= io.size() - io.tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
+  const size_t objectStart = io.tell();
+  HeaderReader objectHeader(io);
 #ifdef EXIV2_DEBUG_MESSAGES
-  EXV_INFO << "decodeBlock = " << GUIDTag(objectHeader.getId().data()).to_string()
-           << "\tsize= " << objectHeader.getSize() << "\t " << io_->tell() << "/" << io_->size() << '\n';
+  auto name = GUIDReferenceTags.find(GUIDTag(objectHeader.getId().data()));
+  EXV_INFO << "decodeBlock = " << GUIDTag(objectHeader.getId().data()).to_string() << " "
+           << (name != GUIDReferenceTags.end() ? name->second : "") << "\tsize= " << objectHeader.getSize() << "\t "
+           << io.tell() << "/" << io.size() << '\n';
 #endif
-  Internal::enforce(objectHeader.getSize() <= io_->size() - io_->tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
-  auto tag = GUIDReferenceTags.find(GUIDTag(objectHeader.getId().data()));
-
-  if (tag != GUIDReferenceTags.end()) {
-    if (tag->second == "Header")
-      decodeHeader();
-    else if (tag->second == "File_Properties")
-      fileProperties();
-    else if (tag->second == "Stream_Properties")
-      streamProperties();
-    else if (tag->second == "Header_Extension")
-      headerExtension();
-    else if (tag->second == "Codec_List")
-      codecList();
-    else if (tag->second == "Extended_Content_Description")
-      extendedContentDescription();
-    else if (tag->second == "Content_Description")
-      contentDescription();
-    else if (tag->second == "Extended_Stream_Properties")
-      extendedStreamProperties();
-    else if (tag->second == "Degradable_JPEG_Media")
-      DegradableJPEGMedia();
-    else {  // tag found but not processed
-      // Make sure that the remaining size is non-zero, so that we won't
-      // keep revisiting the same location in the file.
-      const uint64_t remaining_size = objectHeader.getRemainingSize();
-      Internal::enforce(remaining_size > 0, Exiv2::ErrorCode::kerCorruptedMetadata);
-      io_->seekOrThrow(io_->tell() + remaining_size, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  // Make sure that the remaining size is non-zero, so that we won't keep
+  // revisiting the same location in the file.
+  const uint64_t remaining_size = objectHeader.getRemainingSize();
+  Internal::enforce(remaining_size > 0 && remaining_size <= io.size() - io.tell(),
+                    Exiv2::ErrorCode::kerCorruptedMetadata);
+
+  auto decoder = asfObjectDecoders.find(GUIDTag(objectHeader.getId().data()));
+  if (decoder != asfObjectDecoders.end()) {
+    switch (decoder->second) {
+      case AsfObject::header:
+        decodeHeader(io);
+        break;
+      case AsfObject::fileProperties:
+        fileProperties(io);
+        break;
+      case AsfObject::streamProperties:
+        streamProperties(io);
+        break;
+      case AsfObject::headerExtension:
+        headerExtension(io);
+        break;
+      case AsfObject::codecList:
+        codecList(io);
+        break;
+      case AsfObject::contentDescription:
+        contentDescription(io);
+        break;
+      case AsfObject::extendedContentDescription:
+        extendedContentDescription(io);
+        break;
+      case AsfObject::extendedStreamProperties:
+        extendedStreamProperties(io);
+        break;
+      case AsfObject::degradableJpegMedia:
+        DegradableJPEGMedia(io);
+        break;
     }
-  } else {  // tag not found
-    // Make sure that the remaining size is non-zero, so that we won't keep
-    // revisiting the same location in the file.
-    const uint64_t remaining_size = objectHeader.getRemainingSize();
-    Internal::enforce(remaining_size > 0, Exiv2::ErrorCode::kerCorruptedMetadata);
-    io_->seekOrThrow(io_->tell() + remaining_size, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
   }
+  // Continue after the object, however much of it the decoder read
+  io.seekOrThrow(objectStart + GUID + QWORD + remaining_size, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
 
 }  // AsfVideo::decodeBlock
 
-void AsfVideo::decodeHeader() {
+void AsfVideo::decodeHeader(BasicIo& io) {
   DataBuf nbHeadersBuf(DWORD + 1);
-  io_->readOrThrow(nbHeadersBuf.data(), DWORD, Exiv2::ErrorCode::kerCorruptedMetadata);
+  io.readOrThrow(nbHeadersBuf.data(), DWORD, Exiv2::ErrorCode::kerCorruptedMetadata);
 
   uint32_t nb_headers = Exiv2::getULong(nbHeadersBuf.data(), littleEndian);
   Internal::enforce(nb_headers < std::numeric_limits<uint32_t>::max(), Exiv2::ErrorCode::kerCorruptedMetadata);
-  io_->seekOrThrow(io_->tell() + (BYTE * 2), BasicIo::beg,
+  io.seekOrThrow(io.tell() + (BYTE * 2), BasicIo::beg,
                    ErrorCode::kerFailedToReadImageData);  // skip two reserved tags
   for (uint32_t i = 0; i < nb_headers; i++) {
-    decodeBlock();
+    decodeBlock(io);
   }
 }
 
-void AsfVideo::extendedStreamProperties() {
-  xmpData()["Xmp.video.StartTimecode"] = readQWORDTag(io_);  // Start Time
-  xmpData()["Xmp.video.EndTimecode"] = readWORDTag(io_);     // End Time
-
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Data Bitrate
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Buffer Size
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Initial Buffer Fullness
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Alternate Data Bitrate
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Alternate Buffer Size
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Alternate Initial Buffer Fullness
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Maximum Object Size
-  io_->seek(io_->tell() + DWORD, BasicIo::beg);  // ignore Flags Buffer Size
-  io_->seek(io_->tell() + WORD, BasicIo::beg);   // ignore Flags Stream Number
-  io_->seek(io_->tell() + WORD, BasicIo::beg);   // ignore Stream Language ID Index
-
-  xmpData()["Xmp.video.FrameRate"] = readWORDTag(io_);  // Average Time Per Frame
-  uint16_t stream_name_count = readWORDTag(io_);
-  uint16_t payload_ext_sys_count = readWORDTag(io_);
+void AsfVideo::extendedStreamProperties(BasicIo& io) {
+  xmpData()["Xmp.video.StartTimecode"] = readQWORDTag(io);  // Start Time
+  xmpData()["Xmp.video.EndTimecode"] = readWORDTag(io);     // End Time
+
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Data Bitrate
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Buffer Size
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Initial Buffer Fullness
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Alternate Data Bitrate
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Alternate Buffer Size
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Alternate Initial Buffer Fullness
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Maximum Object Size
+  io.seek(io.tell() + DWORD, BasicIo::beg);  // ignore Flags Buffer Size
+  io.seek(io.tell() + WORD, BasicIo::beg);   // ignore Flags Stream Number
+  io.seek(io.tell() + WORD, BasicIo::beg);   // ignore Stream Language ID Index
+
+  xmpData()["Xmp.video.FrameRate"] = readWORDTag(io);  // Average Time Per Frame
+  uint16_t stream_name_count = readWORDTag(io);
+  uint16_t payload_ext_sys_count = readWORDTag(io);
 
   for (uint16_t i = 0; i < stream_name_count; i++) {
-    io_->seek(io_->tell() + WORD, BasicIo::beg);  // ignore Language ID Index
-    uint16_t stream_length = readWORDTag(io_);
+    io.seek(io.tell() + WORD, BasicIo::beg);  // ignore Language ID Index
+    uint16_t stream_length = readWORDTag(io);
     if (stream_length)
-      io_->seek(io_->tell() + stream_length, BasicIo::beg);  // ignore Stream name
+      io.seek(io.tell() + stream_length, BasicIo::beg);  // ignore Stream name
   }
 
   for (uint16_t i = 0; i < payload_ext_sys_count; i++) {
-    io_->seek(io_->tell() + GUID, BasicIo::beg);  // ignore Extension System ID
-    io_->seek(io_->tell() + WORD, BasicIo::beg);  // ignore Extension Data Size
-    uint16_t ext_sys_info_length = readWORDTag(io_);
+    io.seek(io.tell() + GUID, BasicIo::beg);  // ignore Extension System ID
+    io.seek(io.tell() + WORD, BasicIo::beg);  // ignore Extension Data Size
+    uint16_t ext_sys_info_length = readWORDTag(io);
     if (ext_sys_info_length)
-      io_->seek(io_->tell() + ext_sys_info_length, BasicIo::beg);  // ignore Extension System Info
+      io.seek(io.tell() + ext_sys_info_length, BasicIo::beg);  // ignore Extension System Info
   }
 }  // AsfVideo::extendedStreamProperties
 
-void AsfVideo::DegradableJPEGMedia() {
-  uint32_t width = readDWORDTag(io_);
+void AsfVideo::DegradableJPEGMedia(BasicIo& io) {
+  uint32_t width = readDWORDTag(io);
   width_ = width;
   xmpData_["Xmp.video.Width"] = width;
 
-  uint32_t height = readDWORDTag(io_);
+  uint32_t height = readDWORDTag(io);
   height_ = height;
   xmpData_["Xmp.video.Height"] = height;
 
-  io_->seek(io_->tell() + (WORD * 3) /*3 Reserved*/, BasicIo::beg);
+  io.seek(io.tell() + (WORD * 3) /*3 Reserved*/, BasicIo::beg);
 
-  uint32_t interchange_data_length = readWORDTag(io_);
-  io_->seek(io_->tell() + interchange_data_length /*Interchange data*/, BasicIo::beg);
+  uint32_t interchange_data_length = readWORDTag(io);
+  io.seek(io.tell() + interchange_data_length /*Interchange data*/, BasicIo::beg);
 }
 
-void AsfVideo::streamProperties() {
+void AsfVideo::streamProperties(BasicIo& io) {
   DataBuf streamTypedBuf(GUID);
-  io_->readOrThrow(streamTypedBuf.data(), streamTypedBuf.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
+  io.readOrThrow(streamTypedBuf.data(), streamTypedBuf.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
 
   enum class streamTypeInfo { Audio = 1, Video = 2 };
   auto stream = static_cast<streamTypeInfo>(0);
 
   auto tag_stream_type = GUIDReferenceTags.find(GUIDTag(streamTypedBuf.data()));
   if (tag_stream_type != GUIDReferenceTags.end()) {
-    if (tag_stream_type->second == "Audio_Media")
+    if (tag_stream_type->first == AudioMedia)
       stream = streamTypeInfo::Audio;
-    else if (tag_stream_type->second == "Video_Media")
+    else if (tag_stream_type->first == VideoMedia)
       stream = streamTypeInfo::Video;
 
-    io_->seek(io_->tell() + GUID, BasicIo::beg);  // ignore Error Correction Type
+    io.seek(io.tell() + GUID, BasicIo::beg);  // ignore Error Correction Type
 
-    uint64_t time_offset = readQWORDTag(io_);
+    uint64_t time_offset = readQWORDTag(io);
     if (stream == streamTypeInfo::Video)
       xmpData()["Xmp.video.TimeOffset"] = time_offset;
     else if (stream == streamTypeInfo::Audio)
       xmpData()["Xmp.audio.TimeOffset"] = time_offset;
 
-    auto specific_data_length = readDWORDTag(io_);
-    auto correction_data_length = readDWORDTag(io_);
+    auto specific_data_length = readDWORDTag(io);
+    auto correction_data_length = readDWORDTag(io);
 
-    io_->seek(io_->tell() + WORD /*Flags*/ + DWORD /*Reserved*/ + specific_data_length + correction_data_length,
+    io.seek(io.tell() + WORD /*Flags*/ + DWORD /*Reserved*/ + specific_data_length + correction_data_length,
               BasicIo::beg);
   }
 
 }  // AsfVideo::streamProperties
 
-void AsfVideo::codecList() {
-  io_->seek(io_->tell() + GUID /*reserved*/, BasicIo::beg);
-  auto entries_count = readDWORDTag(io_);
+void AsfVideo::codecList(BasicIo& io) {
+  io.seek(io.tell() + GUID /*reserved*/, BasicIo::beg);
+  auto entries_count = readDWORDTag(io);
   for (uint32_t i = 0; i < entries_count; i++) {
-    uint16_t codec_type = readWORDTag(io_) * 2;
+    uint16_t codec_type = readWORDTag(io) * 2;
     std::string codec = (codec_type == 1) ? "Xmp.video" : "Xmp.audio";
 
-    if (uint16_t codec_name_length = readWORDTag(io_) * 2)
-      xmpData()[codec + std::string(".CodecName")] = readStringWcharTag(io_, codec_name_length);
+    if (uint16_t codec_name_length = readWORDTag(io) * 2)
+      xmpData()[codec + std::string(".CodecName")] = readStringWcharTag(io, codec_name_length);
 
-    if (uint16_t codec_desc_length = readWORDTag(io_))
-      xmpData()[codec + std::string(".CodecDescription")] = readStringWcharTag(io_, codec_desc_length);
+    if (uint16_t codec_desc_length = readWORDTag(io))
+      xmpData()[codec + std::string(".CodecDescription")] = readStringWcharTag(io, codec_desc_length);
 
-    uint16_t codec_info_length = readWORDTag(io_);
-    Internal::enforce(codec_info_length && codec_info_length < io_->size() - io_->tell(),
+    uint16_t codec_info_length = readWORDTag(io);
+    Internal::enforce(codec_info_length && codec_info_length <= io.size() - io.tell(),
                       Exiv2::ErrorCode::kerCorruptedMetadata);
-    xmpData()[codec + std::string(".CodecInfo")] = readStringTag(io_, codec_info_length);
+    xmpData()[codec + std::string(".CodecInfo")] = readStringTag(io, codec_info_length);
   }
 }  // AsfVideo::codecList
 
-void AsfVideo::headerExtension() const {
-  io_->seek(io_->tell() + GUID /*reserved1*/ + WORD /*Reserved2*/, BasicIo::beg);
-  auto header_ext_data_length = readDWORDTag(io_);
-  io_->seek(io_->tell() + header_ext_data_length, BasicIo::beg);
+void AsfVideo::headerExtension(BasicIo& io) const {
+  io.seek(io.tell() + GUID /*reserved1*/ + WORD /*Reserved2*/, BasicIo::beg);
+  auto header_ext_data_length = readDWORDTag(io);
+  io.seek(io.tell() + header_ext_data_length, BasicIo::beg);
 }  // AsfVideo::headerExtension
 
-void AsfVideo::extendedContentDescription() {
-  uint16_t content_descriptor_count = readWORDTag(io_);
+void AsfVideo::extendedContentDescription(BasicIo& io) {
+  uint16_t content_descriptor_count = readWORDTag(io);
   std::string value;
 
   for (uint16_t i = 0; i < content_descriptor_count; i++) {
-    if (uint16_t descriptor_name_length = readWORDTag(io_))
-      value += readStringWcharTag(io_, descriptor_name_length);  // Descriptor Name
+    std::string name;
+    if (uint16_t descriptor_name_length = readWORDTag(io))
+      name = readStringWcharTag(io, descriptor_name_length);  // Descriptor Name
+    value += name;
 
-    uint16_t descriptor_value_data_type = readWORDTag(io_);
-    if (uint16_t descriptor_value_length = readWORDTag(io_)) {
+    uint16_t descriptor_value_data_type = readWORDTag(io);
+    if (uint16_t descriptor_value_length = readWORDTag(io)) {
       // Descriptor Value
       switch (descriptor_value_data_type) {
-        case 0 /*Unicode string */:
-          value += std::string(": ") + readStringWcharTag(io_, descriptor_value_length);
+        case 0 /*Unicode string */: {
+          const std::string text = readStringWcharTag(io, descriptor_value_length);
+          if (auto key = wmAttributeKey(name))
+            xmpData()[key] = text;
+          value += std::string(": ") + text;
           break;
+        }
         case 1 /*BYTE array  */:
-          value += std::string(": ") + readStringTag(io_, descriptor_value_length);
+          value += std::string(": ") + readStringTag(io, descriptor_value_length);
           break;
         case 2 /*BOOL*/:
-          value += std::string(": ") + std::to_string(readWORDTag(io_));
+          value += std::string(": ") + std::to_string(readWORDTag(io));
           break;
         case 3 /*DWORD */:
-          value += std::string(": ") + std::to_string(readDWORDTag(io_));
+          value += std::string(": ") + std::to_string(readDWORDTag(io));
           break;
         case 4 /*QWORD */:
-          value += std::string(": ") + std::to_string(readQWORDTag(io_));
+          value += std::string(": ") + std::to_string(readQWORDTag(io));
           break;
         case 5 /*WORD*/:
-          value += std::string(": ") + std::to_string(readWORDTag(io_));
+          value += std::string(": ") + std::to_string(readWORDTag(io));
           break;
       }
     }
@@ -434,44 +747,44 @@ void AsfVideo::extendedContentDescription() {
   xmpData()["Xmp.video.ExtendedContentDescription"] = value;
 }  // AsfVideo::extendedContentDescription
 
-void AsfVideo::contentDescription() {
-  uint16_t title_length = readWORDTag(io_);
-  uint16_t author_length = readWORDTag(io_);
-  uint16_t copyright_length = readWORDTag(io_);
-  uint16_t desc_length = readWORDTag(io_);
-  uint16_t rating_length = readWORDTag(io_);
+void AsfVideo::contentDescription(BasicIo& io) {
+  uint16_t title_length = readWORDTag(io);
+  uint16_t author_length = readWORDTag(io);
+  uint16_t copyright_length = readWORDTag(io);
+  uint16_t desc_length = readWORDTag(io);
+  uint16_t rating_length = readWORDTag(io);
 
   if (title_length)
-    xmpData()["Xmp.video.Title"] = readStringWcharTag(io_, title_length);
+    xmpData()["Xmp.video.Title"] = readStringWcharTag(io, title_length);
 
   if (author_length)
-    xmpData()["Xmp.video.Author"] = readStringWcharTag(io_, author_length);
+    xmpData()["Xmp.video.Author"] = readStringWcharTag(io, author_length);
 
   if (copyright_length)
-    xmpData()["Xmp.video.Copyright"] = readStringWcharTag(io_, copyright_length);
+    xmpData()["Xmp.video.Copyright"] = readStringWcharTag(io, copyright_length);
 
   if (desc_length)
-    xmpData()["Xmp.video.Description"] = readStringWcharTag(io_, desc_length);
+    xmpData()["Xmp.video.Description"] = readStringWcharTag(io, desc_length);
 
   if (rating_length)
-    xmpData()["Xmp.video.Rating"] = readStringWcharTag(io_, rating_length);
+    xmpData()["Xmp.video.Rating"] = readStringWcharTag(io, rating_length);
 
 }  // AsfVideo::extendedContentDescription
 
-void AsfVideo::fileProperties() {
+void AsfVideo::fileProperties(BasicIo& io) {
   DataBuf FileIddBuf(GUID);
-  io_->readOrThrow(FileIddBuf.data(), FileIddBuf.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
+  io.readOrThrow(FileIddBuf.data(), FileIddBuf.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
   xmpData()["Xmp.video.FileID"] = GUIDTag(FileIddBuf.data()).to_string();
-  xmpData()["Xmp.video.FileLength"] = readQWORDTag(io_);
-  xmpData()["Xmp.video.CreationDate"] = readQWORDTag(io_);
-  xmpData()["Xmp.video.DataPackets"] = readQWORDTag(io_);
-  xmpData()["Xmp.video.duration"] = readQWORDTag(io_);
-  xmpData()["Xmp.video.SendDuration"] = readQWORDTag(io_);
-  xmpData()["Xmp.video.Preroll"] = readQWORDTag(io_);
-
-  io_->seek(io_->tell() + DWORD + DWORD + DWORD,
+  xmpData()["Xmp.video.FileLength"] = readQWORDTag(io);
+  xmpData()["Xmp.video.CreationDate"] = readQWORDTag(io);
+  xmpData()["Xmp.video.DataPackets"] = readQWORDTag(io);
+  xmpData()["Xmp.video.duration"] = readQWORDTag(io);
+  xmpData()["Xmp.video.SendDuration"] = readQWORDTag(io);
+  xmpData()["Xmp.video.Preroll"] = readQWORDTag(io);
+
+  io.seek(io.tell() + DWORD + DWORD + DWORD,
             BasicIo::beg);  // ignore Flags, Minimum Data Packet Size and Maximum Data Packet Size
-  xmpData()["Xmp.video.MaxBitRate"] = readDWORDTag(io_);
+  xmpData()["Xmp.video.MaxBitRate"] = readDWORDTag(io);
 }  // AsfVideo::fileProperties
 
 Image::UniquePtr newAsfInstance(BasicIo::UniquePtr io, bool /*create*/) {
@@ -495,6 +495,10 @@ size_t FileIo::tell() const {
   auto pos = ftello(p_->fp_);
 #endif
   Internal::enforce(pos >= 0, ErrorCode::kerInputDataReadFailed);
+  // On 32-bit builds positions beyond 4 GB cannot be represented
+  if constexpr (sizeof(size_t) < sizeof(pos))
+    Internal::enforce(static_cast<uint64_t>(pos) <= std::numeric_limits<size_t>::max(),
+                      ErrorCode::kerInputDataReadFailed);
   return static_cast<size_t>(pos);
 }
 
@@ -511,6 +515,8 @@ size_t FileIo::size() const {
   Impl::StructStat buf;
   if (p_->stat(buf))
     return std::numeric_limits<size_t>::max();
+  if constexpr (sizeof(size_t) < sizeof(buf.st_size))
+    Internal::enforce(buf.st_size < std::numeric_limits<size_t>::max(), ErrorCode::kerInputDataReadFailed);
   return static_cast<size_t>(buf.st_size);
 }
 
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "basicio_int.hpp"
+
+#include "enforce.hpp"
+#include "error.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2::Internal {
+WindowIo::WindowIo(BasicIo& src, size_t start, size_t size) : src_(src), start_(start), size_(size) {
+}
+
+WindowIo::~WindowIo() {
+  munmap();
+}
+
+int WindowIo::open() {
+  idx_ = 0;
+  eof_ = false;
+  return src_.isopen() ? 0 : 1;
+}
+
+int WindowIo::close() {
+  return munmap() == 0 ? 0 : 2;
+}
+
+size_t WindowIo::write(const byte* /*data*/, size_t /*wcount*/) {
+  return 0;
+}
+
+size_t WindowIo::write(BasicIo& /*src*/) {
+  return 0;
+}
+
+int WindowIo::putb(byte /*data*/) {
+  return EOF;
+}
+
+DataBuf WindowIo::read(size_t rcount) {
+  DataBuf buf(rcount);
+  size_t readCount = read(buf.data(), buf.size());
+  buf.resize(readCount);
+  return buf;
+}
+
+size_t WindowIo::read(byte* buf, size_t rcount) {
+  const size_t avail = size_ - idx_;
+  const size_t allow = std::min(rcount, avail);
+  size_t readCount = 0;
+  if (allow > 0 && src_.seek(static_cast<int64_t>(start_ + idx_), BasicIo::beg) == 0) {
+    readCount = src_.read(buf, allow);
+  }
+  idx_ += readCount;
+  if (rcount > readCount) {
+    eof_ = true;
+  }
+  return readCount;
+}
+
+int WindowIo::getb() {
+  byte b = 0;
+  if (read(&b, 1) != 1) {
+    return EOF;
+  }
+  return b;
+}
+
+void WindowIo::transfer(BasicIo& /*src*/) {
+  throw Error(ErrorCode::kerFunctionNotSupported, "WindowIo::transfer");
+}
+
+int WindowIo::seek(int64_t offset, Position pos) {
+  int64_t newIdx = 0;
+
+  switch (pos) {
+    case BasicIo::cur:
+      newIdx = idx_ + offset;
+      break;
+    case BasicIo::beg:
+      newIdx = offset;
+      break;
+    case BasicIo::end:
+      newIdx = size_ + offset;
+      break;
+  }
+
+  if (newIdx < 0)
+    return 1;
+
+  if (newIdx > static_cast<int64_t>(size_)) {
+    eof_ = true;
+    return 1;
+  }
+
+  idx_ = static_cast<size_t>(newIdx);
+  eof_ = false;
+  return 0;
+}
+
+byte* WindowIo::mmap(bool isWriteable) {
+  if (isWriteable)
+    throw Error(ErrorCode::kerFunctionNotSupported, "WindowIo::mmap");
+  byte* data = src_.mmap(false);
+  mapped_ = data != nullptr;
+  return data ? data + start_ : nullptr;
+}
+
+int WindowIo::munmap() {
+  if (!mapped_)
+    return 0;
+  mapped_ = false;
+  return src_.munmap();
+}
+
+void WindowIo::populateFakeData() {
+}
+
+size_t WindowIo::tell() const {
+  return idx_;
+}
+
+size_t WindowIo::size() const {
+  return size_;
+}
+
+bool WindowIo::isopen() const {
+  return src_.isopen();
+}
+
+int WindowIo::error() const {
+  return src_.error();
+}
+
+bool WindowIo::eof() const {
+  return eof_;
+}
+
+const std::string& WindowIo::path() const noexcept {
+  return src_.path();
+}
+
+// *****************************************************************************
+// free functions
+size_t toSize(FileOffset value) {
+  if constexpr (sizeof(size_t) < sizeof(FileOffset))
+    enforce(value <= std::numeric_limits<size_t>::max(), ErrorCode::kerCorruptedMetadata);
+  return static_cast<size_t>(value);
+}
+
+int64_t toSeekOffset(FileOffset value) {
+  enforce(value <= static_cast<FileOffset>(std::numeric_limits<int64_t>::max()), ErrorCode::kerCorruptedMetadata);
+  return static_cast<int64_t>(value);
+}
+
+void copyRange(BasicIo& src, FileOffset offset, FileOffset count, BasicIo& dst) {
+  src.seekOrThrow(toSeekOffset(offset), BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  DataBuf buf(static_cast<size_t>(std::min<FileOffset>(count, 64 * 1024)));
+  while (count > 0) {
+    const auto n = static_cast<size_t>(std::min<FileOffset>(count, buf.size()));
+    src.readOrThrow(buf.data(), n, ErrorCode::kerFailedToReadImageData);
+    if (dst.write(buf.c_data(), n) != n)
+      throw Error(ErrorCode::kerImageWriteFailed);
+    count -= n;
+  }
+}
+
+}  // namespace Exiv2::Internal
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef BASICIO_INT_HPP
+#define BASICIO_INT_HPP
+
+// *****************************************************************************
+// included header files
+#include "basicio.hpp"
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2::Internal {
+// *****************************************************************************
+// type definitions
+
+/*!
+  @brief Absolute position or length within a file.
+
+  BasicIo reports positions as size_t, which is only 32 bits wide on 32-bit
+  builds. Offsets read from file structures (box, atom, chunk and element
+  sizes) are kept in this type and only narrowed with toSize() or
+  toSeekOffset(), which throw if the value does not fit.
+ */
+using FileOffset = uint64_t;
+
+// *****************************************************************************
+// class definitions
+
+/*!
+  @brief Read-only view of a byte range of another BasicIo instance.
+
+  Allows an image embedded in a larger file (e.g. the PNG metadata image
+  of a PGF file) to be parsed in place, without copying it into memory.
+  The underlying BasicIo must outlive the window and be open while the
+  window is used. Each read seeks the underlying BasicIo, so interleaving
+  access to both is safe.
+ */
+class WindowIo : public BasicIo {
+ public:
+  //! @name Creators
+  //@{
+  /*!
+    @brief Constructor.
+    @param src   Underlying BasicIo instance. Not owned.
+    @param start Offset of the window in \em src.
+    @param size  Size of the window in bytes.
+   */
+  WindowIo(BasicIo& src, size_t start, size_t size);
+  //! Destructor. Releases the mapping made by mmap().
+  ~WindowIo() override;
+  //@}
+
+  //! @name Manipulators
+  //@{
+  //! Reset the position to the start of the window. The underlying BasicIo must be open.
+  int open() override;
+  //! Release the mapping made by mmap(), the underlying BasicIo is left open.
+  int close() override;
+  //! Not supported, returns 0.
+  size_t write(const byte* data, size_t wcount) override;
+  //! Not supported, returns 0.
+  size_t write(BasicIo& src) override;
+  //! Not supported, returns EOF.
+  int putb(byte data) override;
+  DataBuf read(size_t rcount) override;
+  size_t read(byte* buf, size_t rcount) override;
+  int getb() override;
+  //! Not supported, throws Error(ErrorCode::kerFunctionNotSupported).
+  void transfer(BasicIo& src) override;
+  int seek(int64_t offset, Position pos) override;
+  //! Map the underlying BasicIo read-only and return a pointer to the start of the window.
+  byte* mmap(bool isWriteable = false) override;
+  //! Unmap the underlying BasicIo if it was mapped by mmap().
+  int munmap() override;
+  void populateFakeData() override;
+  //@}
+
+  //! @name Accessors
+  //@{
+  [[nodiscard]] size_t tell() const override;
+  [[nodiscard]] size_t size() const override;
+  [[nodiscard]] bool isopen() const override;
+  [[nodiscard]] int error() const override;
+  [[nodiscard]] bool eof() const override;
+  //! Path of the underlying BasicIo.
+  [[nodiscard]] const std::string& path() const noexcept override;
+  //@}
+
+  // NOT IMPLEMENTED
+  //! Copy constructor
+  WindowIo(const WindowIo&) = delete;
+  //! Assignment operator
+  WindowIo& operator=(const WindowIo&) = delete;
+
+ private:
+  BasicIo& src_;
+  size_t start_;
+  size_t size_;
+  size_t idx_{0};
+  bool eof_{false};
+  bool mapped_{false};
+};  // class WindowIo
+
+// *****************************************************************************
+// free functions
+
+/*!
+  @brief Narrow a file offset or length to size_t.
+  @throw Error(ErrorCode::kerCorruptedMetadata) if \em value does not fit.
+ */
+size_t toSize(FileOffset value);
+
+/*!
+  @brief Convert a file offset to the signed type taken by BasicIo::seek().
+  @throw Error(ErrorCode::kerCorruptedMetadata) if \em value does not fit.
+ */
+int64_t toSeekOffset(FileOffset value);
+
+/*!
+  @brief Copy \em count bytes starting at \em offset from \em src to \em dst,
+      at the current position of \em dst, through a bounded buffer.
+      On return \em src is positioned just after the copied range.
+  @throw Error if reading or writing fails.
+ */
+void copyRange(BasicIo& src, FileOffset offset, FileOffset count, BasicIo& dst);
+
+}  // namespace Exiv2::Internal
+
+#endif  // BASICIO_INT_HPP
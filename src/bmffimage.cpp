@@ -4,6 +4,7 @@
 #include "bmffimage.hpp"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
 #include "config.h"
 #include "enforce.hpp"
 #include "error.hpp"
@@ -18,12 +19,19 @@
 #ifdef EXV_HAVE_BROTLI
 #include <brotli/decode.h>  // for JXL brob
 #endif
+#ifdef EXV_HAVE_BROTLIENC
+#include <brotli/encode.h>
+#endif
 
 // + standard includes
+#include <array>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <tuple>
+#include <vector>
 
 enum TAG {
   ftyp = 0x66747970U,  //!< "ftyp" File type box */
@@ -42,6 +50,9 @@ enum TAG {
   mif1 = 0x6d696631U,  //!< "mif1" HEIF */
   crx = 0x63727820U,   //!< "crx " Canon CR3 */
   jxl = 0x6a786c20U,   //!< "jxl " JPEG XL file type */
+  JXL = 0x4a584c20U,   //!< "JXL " JPEG XL signature box */
+  jxlc = 0x6a786c63U,  //!< "jxlc" JPEG XL codestream */
+  jxlp = 0x6a786c70U,  //!< "jxlp" JPEG XL partial codestream */
   moov = 0x6d6f6f76U,  //!< "moov" Movie */
   meta = 0x6d657461U,  //!< "meta" Metadata */
   mdat = 0x6d646174U,  //!< "mdat" Media data */
@@ -114,6 +125,40 @@ static bool skipBox(uint32_t box) {
   return box == 0 || box == TAG::mdat;  // mdat is where the main image lives and can be huge
 }
 
+namespace {
+//! Signature box and file type box written in front of a bare JPEG XL codestream
+constexpr std::array<byte, 32> jxlContainerHeader{
+    0x00, 0x00, 0x00, 0x0c, 'J', 'X', 'L', ' ', 0x0d, 0x0a, 0x87, 0x0a,  // JXL signature box
+    0x00, 0x00, 0x00, 0x14, 'f', 't', 'y', 'p', 'j', 'x', 'l', ' ',      // ftyp box
+    0x00, 0x00, 0x00, 0x00, 'j', 'x', 'l', ' ',                          //
+};
+
+//! JPEG XL files are either a bare codestream or an ISO BMFF container starting with the "JXL " box
+enum class JxlLayout { none, codestream, container };
+
+JxlLayout jxlLayout(BasicIo& io) {
+  std::array<byte, 12> buf;
+  io.seekOrThrow(0, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  if (io.read(buf.data(), buf.size()) >= 2 && buf[0] == 0xff && buf[1] == 0x0a)
+    return JxlLayout::codestream;
+  if (!io.error() && !io.eof() && getULong(buf.data(), bigEndian) == 12 &&
+      getULong(buf.data() + 4, bigEndian) == TAG::JXL)
+    return JxlLayout::container;
+  return JxlLayout::none;
+}
+
+//! Write a box with a 32-bit length. An optional prefix (brob inner type) precedes the payload.
+void writeBox(BasicIo& outIo, uint32_t type, const byte* prefix, size_t prefixSize, const byte* data, size_t size) {
+  Internal::enforce(size <= std::numeric_limits<uint32_t>::max() - 8 - prefixSize, ErrorCode::kerImageWriteFailed);
+  std::array<byte, 8> hdr;
+  ul2Data(hdr.data(), static_cast<uint32_t>(8 + prefixSize + size), bigEndian);
+  ul2Data(hdr.data() + 4, type, bigEndian);
+  if (outIo.write(hdr.data(), hdr.size()) != hdr.size() || outIo.write(prefix, prefixSize) != prefixSize ||
+      outIo.write(data, size) != size)
+    throw Error(ErrorCode::kerImageWriteFailed);
+}
+}  // namespace
+
 std::string BmffImage::mimeType() const {
   switch (fileType_) {
     case TAG::avci:
@@ -238,6 +283,30 @@ void BmffImage::brotliUncompress(const byte* compressedBuf, size_t compressedBuf
     throw Error(ErrorCode::kerFailedToReadImageData);
   }
 }
+
+#ifdef EXV_HAVE_BROTLIENC
+void BmffImage::brotliCompress(const byte* buf, size_t size, DataBuf& arr) {
+  size_t encodedSize = BrotliEncoderMaxCompressedSize(size);
+  if (encodedSize == 0)
+    throw Error(ErrorCode::kerImageWriteFailed);
+  arr.alloc(encodedSize);
+  if (!BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, size, buf,
+                             &encodedSize, arr.data()))
+    throw Error(ErrorCode::kerImageWriteFailed);
+  arr.resize(encodedSize);
+}
+#endif
+
+const DataBuf& BmffImage::brobPayload(uint64_t address, const DataBuf& data) {
+  auto& entry = brobCache_[address];
+  if (entry.compressed_.size() != data.size() || entry.compressed_.cmpBytes(0, data.c_data(), data.size()) != 0) {
+    DataBuf arr;
+    brotliUncompress(data.c_data(4), data.size() - 4, arr);
+    entry.uncompressed_ = std::move(arr);
+    entry.compressed_ = DataBuf(data.c_data(), data.size());
+  }
+  return entry.uncompressed_;
+}
 #endif
 
 uint64_t BmffImage::boxHandler(std::ostream& out /* = std::cout*/, Exiv2::PrintStructureOption option /* = kpsNone */,
@@ -547,13 +616,13 @@ uint64_t BmffImage::boxHandler(std::ostream& out /* = std::cout*/, Exiv2::PrintS
         out << "type: " << toAscii(realType);
       }
 #ifdef EXV_HAVE_BROTLI
-      DataBuf arr;
-      brotliUncompress(data.c_data(4), data.size() - 4, arr);
+      const DataBuf& arr = brobPayload(address, data);
       if (realType == TAG::exif) {
         uint32_t offset = Safe::add(arr.read_uint32(0, endian_), 4u);
         Internal::enforce(Safe::add(offset, 4u) < arr.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
-        Internal::TiffParserWorker::decode(exifData(), iptcData(), xmpData(), arr.c_data(offset), arr.size() - offset,
-                                           Internal::Tag::root, Internal::TiffMapping::findDecoder);
+        setByteOrder(Internal::TiffParserWorker::decode(exifData(), iptcData(), xmpData(), arr.c_data(offset),
+                                                        arr.size() - offset, Internal::Tag::root,
+                                                        Internal::TiffMapping::findDecoder));
       } else if (realType == TAG::xml) {
         try {
           Exiv2::XmpParser::decode(xmpData(), std::string(arr.c_str(), arr.size()));
@@ -618,8 +687,10 @@ void BmffImage::parseTiff(uint32_t root_tag, uint64_t length, uint64_t start) {
         punt = i;
     }
     if (punt != eof) {
-      Internal::TiffParserWorker::decode(exifData(), iptcData(), xmpData(), exif.c_data(punt), exif.size() - punt,
-                                         root_tag, Internal::TiffMapping::findDecoder);
+      ByteOrder bo = Internal::TiffParserWorker::decode(exifData(), iptcData(), xmpData(), exif.c_data(punt),
+                                                        exif.size() - punt, root_tag, Internal::TiffMapping::findDecoder);
+      if (root_tag == Internal::Tag::root)
+        setByteOrder(bo);
     }
   }
   io_->seek(restore, BasicIo::beg);
@@ -690,16 +761,22 @@ void BmffImage::parseCr3Preview(const DataBuf& data, std::ostream& out, bool bTr
   nativePreviews_.push_back(std::move(nativePreview));
 }
 
-void BmffImage::setExifData(const ExifData& /*exifData*/) {
-  throw(Error(ErrorCode::kerInvalidSettingForImage, "Exif metadata", "BMFF"));
+void BmffImage::setExifData(const ExifData& exifData) {
+  // only JPEG XL files can be written
+  if (fileType_ != TAG::jxl)
+    throw(Error(ErrorCode::kerInvalidSettingForImage, "Exif metadata", "BMFF"));
+  Image::setExifData(exifData);
 }
 
 void BmffImage::setIptcData(const IptcData& /*iptcData*/) {
   throw(Error(ErrorCode::kerInvalidSettingForImage, "IPTC metadata", "BMFF"));
 }
 
-void BmffImage::setXmpData(const XmpData& /*xmpData*/) {
-  throw(Error(ErrorCode::kerInvalidSettingForImage, "XMP metadata", "BMFF"));
+void BmffImage::setXmpData(const XmpData& xmpData) {
+  // only JPEG XL files can be written
+  if (fileType_ != TAG::jxl)
+    throw(Error(ErrorCode::kerInvalidSettingForImage, "XMP metadata", "BMFF"));
+  Image::setXmpData(xmpData);
 }
 
 void BmffImage::setComment(const std::string&) {
@@ -730,6 +807,13 @@ void BmffImage::readMetadata() {
   exifID_ = unknownID_;
   xmpID_ = unknownID_;
 
+  // a bare JPEG XL codestream has no boxes and no metadata
+  if (jxlLayout(*io_) == JxlLayout::codestream) {
+    fileType_ = TAG::jxl;
+    bReadMetadata_ = true;
+    return;
+  }
+
   uint64_t address = 0;
   const auto file_end = io_->size();
   while (address < file_end) {
@@ -764,6 +848,8 @@ void BmffImage::printStructure(std::ostream& out, Exiv2::PrintStructureOption op
     case kpsRecursive: {
       openOrThrow();
       IoCloser closer(*io_);
+      if (jxlLayout(*io_) == JxlLayout::codestream)
+        break;
 
       uint64_t address = 0;
       const auto file_end = io_->size();
@@ -776,10 +862,132 @@ void BmffImage::printStructure(std::ostream& out, Exiv2::PrintStructureOption op
 }
 
 void BmffImage::writeMetadata() {
-  // bmff files are read-only
-  throw(Error(ErrorCode::kerWritingImageFormatUnsupported, "BMFF"));
+  openOrThrow();
+  IoCloser closer(*io_);
+  // only JPEG XL files can be written, other bmff files are read-only
+  if (jxlLayout(*io_) == JxlLayout::none)
+    throw(Error(ErrorCode::kerWritingImageFormatUnsupported, "BMFF"));
+
+  MemIo tempIo;
+  doWriteMetadata(tempIo);  // may throw
+  io_->close();
+  io_->transfer(tempIo);  // may throw
+  brobCache_.clear();
 }  // BmffImage::writeMetadata
 
+void BmffImage::doWriteMetadata(BasicIo& outIo) {
+  Blob exif;
+  if (!exifData_.empty()) {
+    ExifParser::encode(exif, byteOrder() == invalidByteOrder ? littleEndian : byteOrder(), exifData_);
+    // The Exif box starts with the offset of the TIFF header
+    exif.insert(exif.begin(), 4, 0);
+  }
+  if (!writeXmpFromPacket() && XmpParser::encode(xmpPacket_, xmpData_) > 1) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to encode XMP metadata.\n";
+#endif
+    throw Error(ErrorCode::kerImageWriteFailed);
+  }
+
+  // Metadata that was Brotli compressed before is compressed again, if the encoder is available
+  bool brobExif = false;
+  bool brobXmp = false;
+  auto writeMetadataBoxes = [&] {
+    const std::pair<uint32_t, bool> boxes[] = {{TAG::exif, brobExif}, {TAG::xml, brobXmp}};
+    for (auto&& [type, compress] : boxes) {
+      const byte* data = type == TAG::exif ? exif.data() : reinterpret_cast<const byte*>(xmpPacket_.data());
+      const size_t size = type == TAG::exif ? exif.size() : xmpPacket_.size();
+      if (size == 0)
+        continue;
+#ifdef EXV_HAVE_BROTLIENC
+      if (compress) {
+        DataBuf arr;
+        brotliCompress(data, size, arr);
+        std::array<byte, 4> realType;
+        ul2Data(realType.data(), type, endian_);
+        writeBox(outIo, TAG::brob, realType.data(), realType.size(), arr.c_data(), arr.size());
+        continue;
+      }
+#endif
+      writeBox(outIo, type, nullptr, 0, data, size);
+    }
+  };
+
+  const uint64_t file_end = io_->size();
+  if (jxlLayout(*io_) == JxlLayout::codestream) {
+    // Wrap the codestream in a container: signature, ftyp, metadata, jxlc
+    if (exif.empty() && xmpPacket_.empty()) {
+      Internal::copyRange(*io_, 0, file_end, outIo);
+      return;
+    }
+    if (outIo.write(jxlContainerHeader.data(), jxlContainerHeader.size()) != jxlContainerHeader.size())
+      throw Error(ErrorCode::kerImageWriteFailed);
+    writeMetadataBoxes();
+    std::array<byte, 16> hdr;
+    size_t hdrsize = 8;
+    if (file_end <= std::numeric_limits<uint32_t>::max() - hdrsize) {
+      ul2Data(hdr.data(), static_cast<uint32_t>(file_end + hdrsize), bigEndian);
+    } else {
+      hdrsize = 16;
+      ul2Data(hdr.data(), 1, bigEndian);
+      ull2Data(hdr.data() + 8, file_end + hdrsize, bigEndian);
+    }
+    ul2Data(hdr.data() + 4, TAG::jxlc, bigEndian);
+    if (outIo.write(hdr.data(), hdrsize) != hdrsize)
+      throw Error(ErrorCode::kerImageWriteFailed);
+    Internal::copyRange(*io_, 0, file_end, outIo);
+    return;
+  }
+
+  // Find out which metadata boxes are compressed, only box headers are read
+  std::vector<std::tuple<uint64_t, uint64_t, uint32_t, uint32_t>> boxes;  // address, length, type, brob type
+  uint64_t address = 0;
+  while (address < file_end) {
+    std::array<byte, 16> hdr;
+    io_->seekOrThrow(address, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+    Internal::enforce(file_end - address >= 8, ErrorCode::kerCorruptedMetadata);
+    io_->readOrThrow(hdr.data(), 8, ErrorCode::kerFailedToReadImageData);
+    uint64_t length = getULong(hdr.data(), endian_);
+    const uint32_t type = getULong(hdr.data() + 4, endian_);
+    uint64_t hdrsize = 8;
+    if (length == 1) {
+      Internal::enforce(file_end - address >= 16, ErrorCode::kerCorruptedMetadata);
+      io_->readOrThrow(hdr.data() + 8, 8, ErrorCode::kerFailedToReadImageData);
+      length = getULongLong(hdr.data() + 8, endian_);
+      hdrsize = 16;
+    } else if (length == 0) {
+      length = file_end - address;
+    }
+    Internal::enforce(length >= hdrsize && length <= file_end - address, ErrorCode::kerCorruptedMetadata);
+
+    uint32_t realType = 0;
+    if (type == TAG::brob) {
+      Internal::enforce(length >= hdrsize + 4, ErrorCode::kerCorruptedMetadata);
+      io_->readOrThrow(hdr.data(), 4, ErrorCode::kerFailedToReadImageData);
+      realType = getULong(hdr.data(), endian_);
+      brobExif |= realType == TAG::exif;
+      brobXmp |= realType == TAG::xml;
+    }
+    boxes.emplace_back(address, length, type, realType);
+    address += length;
+  }
+
+  // Copy all boxes except the old metadata. The new metadata takes the place of
+  // the old metadata, or goes in front of the codestream.
+  bool written = false;
+  for (auto&& [start, length, type, realType] : boxes) {
+    const bool isMetadata = type == TAG::exif || type == TAG::xml || realType == TAG::exif || realType == TAG::xml;
+    if (!written && (isMetadata || type == TAG::jxlc || type == TAG::jxlp)) {
+      writeMetadataBoxes();
+      written = true;
+    }
+    if (!isMetadata)
+      Internal::copyRange(*io_, start, length, outIo);
+  }
+  if (!written)
+    writeMetadataBoxes();
+}  // BmffImage::doWriteMetadata
+
 // *************************************************************************
 // free functions
 Image::UniquePtr newBmffInstance(BasicIo::UniquePtr io, bool create) {
@@ -802,8 +1010,10 @@ bool isBmffType(BasicIo& iIo, bool advance) {
   bool const is_ftyp = (buf[4] == 'f' && buf[5] == 't' && buf[6] == 'y' && buf[7] == 'p');
   // jxl files have a special start indicator of "JXL "
   bool const is_jxl = (buf[4] == 'J' && buf[5] == 'X' && buf[6] == 'L' && buf[7] == ' ');
+  // or are a bare jxl codestream
+  bool const is_jxl_codestream = (buf[0] == 0xff && buf[1] == 0x0a);
 
-  bool matched = is_jxl || is_ftyp;
+  bool matched = is_jxl || is_ftyp || is_jxl_codestream;
   if (!advance || !matched) {
     iIo.seek(0, BasicIo::beg);
   }
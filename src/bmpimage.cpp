@@ -23,7 +23,7 @@
 // *****************************************************************************
 // class member definitions
 namespace Exiv2 {
-BmpImage::BmpImage(BasicIo::UniquePtr io) : Image(ImageType::bmp, mdNone, std::move(io)) {
+BmpImage::BmpImage(BasicIo::UniquePtr io) : Image(ImageType::bmp, mdIccProfile, std::move(io)) {
 }
 
 std::string BmpImage::mimeType() const {
@@ -80,10 +80,51 @@ void BmpImage::readMetadata() {
     meter) 46      4 bytes  color count 50      4 bytes  important colors       number of "important" colors
   */
   byte buf[26];
-  if (io_->read(buf, sizeof(buf)) == sizeof(buf)) {
-    pixelWidth_ = getULong(buf + 18, littleEndian);
-    pixelHeight_ = getULong(buf + 22, littleEndian);
+  if (io_->read(buf, sizeof(buf)) != sizeof(buf))
+    return;
+  pixelWidth_ = getULong(buf + 18, littleEndian);
+  pixelHeight_ = getULong(buf + 22, littleEndian);
+
+  /*
+    A BITMAPV5HEADER (header size 124) may embed an ICC profile:
+
+    offset  length   name                   description
+    ======  =======  =====================  =======
+    70      4 bytes  color space type       'MBED' = embedded profile
+    126     4 bytes  profile data offset    relative to the start of the header (offset 14)
+    130     4 bytes  profile size
+  */
+  constexpr uint32_t profileEmbedded = 0x4D424544;  // 'MBED'
+  if (getULong(buf + 14, littleEndian) < 124)
+    return;
+  // The fields from the color space type to the profile size, a truncated header has no profile
+  byte v5[64];
+  if (io_->seek(70, BasicIo::beg) != 0 || io_->read(v5, sizeof(v5)) != sizeof(v5)) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Truncated BMP V5 header.\n";
+#endif
+    return;
+  }
+  if (getULong(v5, littleEndian) != profileEmbedded)
+    return;
+  const uint64_t offset = 14 + uint64_t{getULong(v5 + 56, littleEndian)};
+  const size_t size = getULong(v5 + 60, littleEndian);
+  if (size < 4 || offset > io_->size() || size > io_->size() - offset) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Invalid embedded ICC profile in BMP image.\n";
+#endif
+    return;
+  }
+  DataBuf icc(size);
+  io_->seekOrThrow(static_cast<int64_t>(offset), BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  io_->readOrThrow(icc.data(), icc.size(), ErrorCode::kerFailedToReadImageData);
+  if (icc.read_uint32(0, bigEndian) != size) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Invalid embedded ICC profile in BMP image.\n";
+#endif
+    return;
   }
+  setIccProfile(std::move(icc), false);
 }
 
 void BmpImage::writeMetadata() {
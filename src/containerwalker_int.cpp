@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "containerwalker_int.hpp"
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+using Exiv2::byte;
+
+//! Largest header of all formats: BMFF box with 64-bit size
+constexpr size_t maxHeaderSize = 16;
+
+//! Smallest header of \em format
+size_t minHeaderSize(Exiv2::Internal::ContainerFormat format) {
+  return format == Exiv2::Internal::ContainerFormat::ebml ? 2 : 8;
+}
+
+//! Length of the EBML variable size integer starting with \em b, 0 if invalid
+size_t vintLength(byte b) {
+  for (size_t len = 1; len <= 8; ++len) {
+    if (b & (0x80 >> (len - 1)))
+      return len;
+  }
+  return 0;
+}
+}  // namespace
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2::Internal {
+std::string fourccToString(uint64_t id) {
+  std::string name(4, ' ');
+  for (size_t i = 0; i < 4; ++i)
+    name[i] = static_cast<char>((id >> (8 * (3 - i))) & 0xff);
+  return name;
+}
+
+ContainerWalker::ContainerWalker(BasicIo& io, ContainerFormat format, size_t maxDepth, ErrorCode err) :
+    io_(io), format_(format), maxDepth_(maxDepth), err_(err) {
+}
+
+bool ContainerWalker::readHeader(FileOffset offset, FileOffset end, size_t depth, ContainerEntry& entry) {
+  if (offset >= end)
+    return false;
+  // Trailing bytes too short for any header
+  if (truncatedAllowed_ && end - offset < minHeaderSize(format_))
+    return false;
+
+  // Fetch the largest possible header at once and decode it from memory
+  std::array<byte, maxHeaderSize> buf{};
+  const auto avail = static_cast<size_t>(std::min<FileOffset>(end - offset, buf.size()));
+  io_.seekOrThrow(toSeekOffset(offset), BasicIo::beg, err_);
+  io_.readOrThrow(buf.data(), avail, err_);
+
+  entry = ContainerEntry();
+  entry.offset = offset;
+  entry.depth = depth;
+  size_t headerSize = 8;
+  switch (format_) {
+    case ContainerFormat::riff:
+      enforce(avail >= 8, err_);
+      entry.id = getULong(buf.data(), bigEndian);
+      entry.size = getULong(buf.data() + 4, littleEndian);
+      if ((entry.id == fourcc("RIFF") || entry.id == fourcc("LIST")) && entry.size >= 4 && avail >= 12)
+        entry.formType = getULong(buf.data() + 8, bigEndian);
+      break;
+    case ContainerFormat::png:
+      enforce(avail >= 8, err_);
+      entry.size = getULong(buf.data(), bigEndian);
+      entry.id = getULong(buf.data() + 4, bigEndian);
+      break;
+    case ContainerFormat::bmff:
+      enforce(avail >= 8, err_);
+      entry.size = getULong(buf.data(), bigEndian);
+      entry.id = getULong(buf.data() + 4, bigEndian);
+      if (entry.size == 1) {
+        enforce(avail >= 16, err_);
+        headerSize = 16;
+        entry.size = getULongLong(buf.data() + 8, bigEndian);
+      } else if (entry.size == 0) {
+        entry.unknownSize = true;
+        entry.size = end - offset;
+      }
+      enforce(entry.size >= headerSize, err_);
+      entry.size -= headerSize;
+      break;
+    case ContainerFormat::ebml: {
+      const size_t idLength = vintLength(buf[0]);
+      enforce(idLength > 0 && idLength <= 4 && idLength < avail, err_);
+      const size_t sizeLength = vintLength(buf[idLength]);
+      enforce(sizeLength > 0 && idLength + sizeLength <= avail, err_);
+      for (size_t i = 0; i < idLength; ++i)
+        entry.id = (entry.id << 8) | buf[i];
+      // The length marker is not part of the size; all value bits set means unknown size
+      FileOffset size = buf[idLength] & (0xff >> sizeLength);
+      bool allOnes = size == (0xffu >> sizeLength);
+      for (size_t i = 1; i < sizeLength; ++i) {
+        size = (size << 8) | buf[idLength + i];
+        allOnes = allOnes && buf[idLength + i] == 0xff;
+      }
+      headerSize = idLength + sizeLength;
+      entry.unknownSize = allOnes;
+      entry.size = allOnes ? end - offset - headerSize : size;
+      break;
+    }
+  }
+  entry.dataOffset = offset + headerSize;
+  enforce(entry.dataOffset <= end, err_);
+  if (truncatedAllowed_ && entry.size > end - entry.dataOffset) {
+    entry.size = end - entry.dataOffset;
+    entry.truncated = true;
+  }
+  enforce(entry.size <= end - entry.dataOffset, err_);
+  entry.childOffset = entry.dataOffset;
+  if (entry.formType != 0)
+    entry.childOffset += 4;
+  return true;
+}
+
+DataBuf ContainerWalker::readPayload(const ContainerEntry& entry, size_t maxSize) {
+  enforce(entry.size <= maxSize, err_);
+  DataBuf buf(static_cast<size_t>(entry.size));
+  io_.seekOrThrow(toSeekOffset(entry.dataOffset), BasicIo::beg, err_);
+  if (!buf.empty())
+    io_.readOrThrow(buf.data(), buf.size(), err_);
+  return buf;
+}
+
+FileOffset ContainerWalker::nextOffset(const ContainerEntry& entry) const {
+  if (entry.truncated)
+    return entry.end();
+  switch (format_) {
+    case ContainerFormat::riff:
+      return entry.end() + (entry.size & 1);
+    case ContainerFormat::png:
+      return entry.end() + 4;
+    default:
+      return entry.end();
+  }
+}
+
+}  // namespace Exiv2::Internal
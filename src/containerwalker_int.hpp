@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef CONTAINERWALKER_INT_HPP
+#define CONTAINERWALKER_INT_HPP
+
+// *****************************************************************************
+// included header files
+#include "basicio_int.hpp"
+#include "enforce.hpp"
+#include "error.hpp"
+
+#include <string>
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2::Internal {
+// *****************************************************************************
+// type definitions
+
+//! Container formats understood by ContainerWalker
+enum class ContainerFormat {
+  riff,  //!< RIFF chunks (AVI, WAV, WebP): fourcc, 32-bit little endian size, payload padded to an even size
+  bmff,  //!< ISO base media boxes: 32-bit big endian size (1: 64-bit size follows, 0: up to the end), fourcc
+  ebml,  //!< EBML elements (Matroska, WebM): variable length id and size
+  png,   //!< PNG chunks: 32-bit big endian length, fourcc, payload, 4 byte CRC
+};
+
+//! A chunk, box or element found by ContainerWalker
+struct ContainerEntry {
+  //! Fourcc as a big endian number, or the EBML id including its length marker
+  uint64_t id{0};
+  //! Form type of RIFF and LIST chunks, 0 for other entries
+  uint32_t formType{0};
+  //! Offset of the header
+  FileOffset offset{0};
+  //! Offset of the payload
+  FileOffset dataOffset{0};
+  //! Size of the payload, without padding or CRC
+  FileOffset size{0};
+  //! Offset of the first child entry when descending, set to the default for the format before the visitor runs
+  FileOffset childOffset{0};
+  //! Nesting level, 0 for the entries passed to walk()
+  size_t depth{0};
+  //! The size was not specified in the file (EBML unknown size, BMFF size 0) and extends to the end of the parent
+  bool unknownSize{false};
+  //! The entry was cut short by the end of its parent, see ContainerWalker::setTruncatedAllowed()
+  bool truncated{false};
+
+  //! Offset just after the payload
+  [[nodiscard]] FileOffset end() const {
+    return dataOffset + size;
+  }
+};
+
+//! What ContainerWalker does once an entry has been visited
+enum class WalkAction {
+  next,     //!< Continue with the next sibling. The payload is skipped without reading it.
+  descend,  //!< Walk the payload, from ContainerEntry::childOffset, as a sequence of child entries
+  stop,     //!< Stop walking altogether
+};
+
+//! Fourcc \em code as the big endian number used for ContainerEntry::id
+constexpr uint32_t fourcc(const char (&code)[5]) {
+  return (static_cast<uint32_t>(static_cast<unsigned char>(code[0])) << 24) |
+         (static_cast<uint32_t>(static_cast<unsigned char>(code[1])) << 16) |
+         (static_cast<uint32_t>(static_cast<unsigned char>(code[2])) << 8) |
+         static_cast<uint32_t>(static_cast<unsigned char>(code[3]));
+}
+
+//! The four characters of the fourcc \em id
+std::string fourccToString(uint64_t id);
+
+// *****************************************************************************
+// class definitions
+
+/*!
+  @brief Walks the chunk, box or element structure of a container file.
+
+  Headers are decoded from a single read each; payloads are never read by
+  the walker. The visitor is called for each entry and decides whether to
+  skip it, descend into it or stop. It may read the payload from the
+  BasicIo: the walker repositions itself for the next entry regardless of
+  how much the visitor read. Entries which do not fit into their parent and
+  nesting deeper than the configured limit are rejected with an exception.
+ */
+class ContainerWalker {
+ public:
+  //! @name Creators
+  //@{
+  /*!
+    @brief Constructor.
+    @param io       Open BasicIo to walk. Not owned.
+    @param format   Container format.
+    @param maxDepth Maximum nesting level.
+    @param err      Error code thrown for entries exceeding their parent or the nesting limit.
+   */
+  ContainerWalker(BasicIo& io, ContainerFormat format, size_t maxDepth = 16,
+                  ErrorCode err = ErrorCode::kerCorruptedMetadata);
+  //@}
+
+  //! @name Manipulators
+  //@{
+  /*!
+    @brief Walk the entries in [begin, end), calling \em visitor for each.
+        \em visitor is called as <code>WalkAction visitor(ContainerEntry& entry)</code>.
+    @return false if the walk was stopped by the visitor, true otherwise.
+   */
+  template <typename Visitor>
+  bool walk(FileOffset begin, FileOffset end, Visitor&& visitor) {
+    return walkLevel(begin, end, 0, visitor);
+  }
+
+  /*!
+    @brief Accept entries which extend beyond their parent and cut them short
+        instead of throwing, and ignore trailing bytes too short for a header.
+        Useful for formats which are often truncated, like video files from an
+        interrupted recording.
+   */
+  void setTruncatedAllowed(bool allowed) {
+    truncatedAllowed_ = allowed;
+  }
+
+  /*!
+    @brief Decode the header at \em offset.
+    @return false if \em offset is at or beyond \em end, i.e. there are no more entries.
+    @throw Error if the header is truncated or the entry does not fit before \em end.
+   */
+  bool readHeader(FileOffset offset, FileOffset end, size_t depth, ContainerEntry& entry);
+
+  /*!
+    @brief Read the payload of \em entry, which must not be larger than \em maxSize.
+    @throw Error if the payload is too large or cannot be read.
+   */
+  DataBuf readPayload(const ContainerEntry& entry, size_t maxSize);
+  //@}
+
+  //! @name Accessors
+  //@{
+  //! Offset of the entry following \em entry, including padding and CRC.
+  [[nodiscard]] FileOffset nextOffset(const ContainerEntry& entry) const;
+  //@}
+
+ private:
+  template <typename Visitor>
+  bool walkLevel(FileOffset begin, FileOffset end, size_t depth, Visitor& visitor) {
+    enforce(depth <= maxDepth_, err_);
+    ContainerEntry entry;
+    for (FileOffset offset = begin; readHeader(offset, end, depth, entry); offset = nextOffset(entry)) {
+      switch (visitor(entry)) {
+        case WalkAction::next:
+          break;
+        case WalkAction::descend:
+          enforce(entry.childOffset >= entry.dataOffset && entry.childOffset <= entry.end(), err_);
+          if (!walkLevel(entry.childOffset, entry.end(), depth + 1, visitor))
+            return false;
+          break;
+        case WalkAction::stop:
+          return false;
+      }
+    }
+    return true;
+  }
+
+  BasicIo& io_;
+  ContainerFormat format_;
+  size_t maxDepth_;
+  ErrorCode err_;
+  bool truncatedAllowed_{false};
+};  // class ContainerWalker
+
+}  // namespace Exiv2::Internal
+
+#endif  // CONTAINERWALKER_INT_HPP
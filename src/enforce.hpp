@@ -18,6 +18,9 @@
  * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
  */
 
+#ifndef ENFORCE_HPP
+#define ENFORCE_HPP
+
 #include <string>
 
 #include "error.hpp"
@@ -46,3 +49,5 @@ constexpr void enforce(bool condition, Exiv2::ErrorCode err_code, T&&... args) {
   enforce<Exiv2::Error>(condition, err_code, std::forward<T>(args)...);
 }
 }  // namespace Exiv2::Internal
+
+#endif  // ENFORCE_HPP
@@ -128,6 +128,9 @@ int64_t sumToLong(const Exiv2::Exifdatum& md);
 //! Helper function to delete all tags of a specific IFD from the metadata.
 void eraseIfd(Exiv2::ExifData& ed, Exiv2::IfdId ifdId);
 
+//! Return true if the tag locates data in the file, rather than describing the image
+bool isLayoutTag(const Exiv2::Exifdatum& md);
+
 }  // namespace
 
 // *****************************************************************************
@@ -661,6 +664,22 @@ WriteMethod ExifParser::encode(Blob& blob, const byte* pData, size_t size, ByteO
 
 }  // ExifParser::encode
 
+CanonicalMetadata canonicalMetadata(const ExifData& exifData) {
+  CanonicalMetadata metadata;
+  metadata.reserve(exifData.count());
+  for (const auto& md : exifData) {
+    if (!isLayoutTag(md))
+      metadata.emplace_back(md.key(), md.toString());
+  }
+  std::stable_sort(metadata.begin(), metadata.end(),
+                   [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  return metadata;
+}
+
+uint64_t digest(const ExifData& exifData) {
+  return digest(canonicalMetadata(exifData));
+}
+
 }  // namespace Exiv2
 
 // *****************************************************************************
@@ -737,5 +756,26 @@ int64_t sumToLong(const Exiv2::Exifdatum& md) {
 void eraseIfd(Exiv2::ExifData& ed, Exiv2::IfdId ifdId) {
   ed.erase(std::remove_if(ed.begin(), ed.end(), Exiv2::FindExifdatum(ifdId)), ed.end());
 }
+
+bool isLayoutTag(const Exiv2::Exifdatum& md) {
+  // The offset and byte order of the makernote
+  if (md.ifdId() == Exiv2::IfdId::mnId)
+    return true;
+  if (Exiv2::Internal::isMakerIfd(md.ifdId()))
+    return false;
+  switch (md.tag()) {
+    case 0x0111:  // StripOffsets
+    case 0x0144:  // TileOffsets
+    case 0x014a:  // SubIFDs
+    case 0x0201:  // JPEGInterchangeFormat
+    case 0x8769:  // ExifTag
+    case 0x8825:  // GPSTag
+    case 0x927c:  // MakerNote
+    case 0xa005:  // InteroperabilityTag
+      return true;
+    default:
+      return false;
+  }
+}
 //! @endcond
 }  // namespace
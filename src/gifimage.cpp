@@ -3,20 +3,137 @@
 // included header files
 #include "gifimage.hpp"
 
+#include "basicio.hpp"
+#include "basicio_int.hpp"
 #include "config.h"
 #include "error.hpp"
 #include "futils.hpp"
+#include "xmp_exiv2.hpp"
 
+#include <algorithm>
 #include <array>
+#include <vector>
 
 #ifdef EXIV2_DEBUG_MESSAGES
 #include <iostream>
 #endif
 
+// *****************************************************************************
+// local declarations
+namespace {
+using Exiv2::BasicIo;
+using Exiv2::byte;
+using Exiv2::Internal::copyRange;
+
+/*
+  GIF block structure (https://www.w3.org/Graphics/GIF/spec-gif89a.txt):
+
+  Header                     6 bytes   "GIF87a" or "GIF89a"
+  Logical Screen Descriptor  7 bytes   width, height, packed fields, background, aspect
+  [Global Color Table]       3 * 2^(N+1) bytes if bit 7 of the packed fields is set
+  Blocks:
+    0x21 <label> <sub-blocks> 0x00     extension
+    0x2C <9 bytes> [LCT] <lzw> <sub-blocks> 0x00  image
+    0x3B                               trailer
+
+  XMP is stored in an application extension with the identifier "XMP DataXMP".
+  The packet bytes follow the identifier verbatim and are terminated by a
+  258-byte "magic trailer" (0x01, 0xFF, 0xFE, ..., 0x01, 0x00, 0x00), which
+  lets readers walking the packet as sub-blocks land on the block terminator.
+*/
+constexpr byte gifExtensionIntroducer = 0x21;
+constexpr byte gifImageSeparator = 0x2C;
+constexpr byte gifTrailer = 0x3B;
+constexpr byte gifApplicationLabel = 0xFF;
+constexpr std::array<byte, 11> gifXmpAppId{'X', 'M', 'P', ' ', 'D', 'a', 't', 'a', 'X', 'M', 'P'};
+//! Size of the introducer, label, identifier length and identifier of an XMP extension
+constexpr size_t gifXmpHeaderSize = 3 + gifXmpAppId.size();
+constexpr size_t gifXmpMagicTrailerSize = 258;
+
+//! Position of the blocks of interest in a GIF stream
+struct GifLayout {
+  std::vector<std::pair<size_t, size_t>> xmpBlocks_;  //!< [begin, end) of each XMP application extension
+  size_t trailer_{0};                                 //!< Position of the trailer byte (or the end of the data)
+  bool hasTrailer_{false};
+};
+
+//! Skip a chain of data sub-blocks. Only the length bytes are read.
+void skipSubBlocks(BasicIo& io) {
+  for (;;) {
+    const int len = io.getb();
+    if (len == EOF)
+      throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+    if (len == 0)
+      return;
+    io.seekOrThrow(len, BasicIo::cur, Exiv2::ErrorCode::kerFailedToReadImageData);
+  }
+}
+
+/*!
+  @brief Scan the block structure of a GIF stream, starting right after the
+      signature. Image data and extensions are skipped by their sub-block
+      lengths; nothing but block headers is read.
+ */
+GifLayout scanGif(BasicIo& io) {
+  GifLayout layout;
+  std::array<byte, 9> buf;
+  io.readOrThrow(buf.data(), 7, Exiv2::ErrorCode::kerFailedToReadImageData);
+  if (buf[4] & 0x80)
+    io.seekOrThrow(3 << ((buf[4] & 0x07) + 1), BasicIo::cur, Exiv2::ErrorCode::kerFailedToReadImageData);
+
+  for (;;) {
+    const size_t start = io.tell();
+    const int c = io.getb();
+    if (c == EOF) {
+      layout.trailer_ = start;
+      break;
+    }
+    if (c == gifTrailer) {
+      layout.trailer_ = start;
+      layout.hasTrailer_ = true;
+      break;
+    }
+    if (c == gifExtensionIntroducer) {
+      const int label = io.getb();
+      if (label == EOF)
+        throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+      if (label == gifApplicationLabel) {
+        const int idLen = io.getb();
+        if (idLen == EOF)
+          throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+        bool isXmp = false;
+        if (idLen == gifXmpAppId.size()) {
+          std::array<byte, gifXmpAppId.size()> id;
+          io.readOrThrow(id.data(), id.size(), Exiv2::ErrorCode::kerFailedToReadImageData);
+          isXmp = id == gifXmpAppId;
+        } else {
+          io.seekOrThrow(idLen, BasicIo::cur, Exiv2::ErrorCode::kerFailedToReadImageData);
+        }
+        skipSubBlocks(io);
+        if (isXmp)
+          layout.xmpBlocks_.emplace_back(start, io.tell());
+      } else {
+        skipSubBlocks(io);
+      }
+    } else if (c == gifImageSeparator) {
+      io.readOrThrow(buf.data(), buf.size(), Exiv2::ErrorCode::kerFailedToReadImageData);
+      if (buf[8] & 0x80)
+        io.seekOrThrow(3 << ((buf[8] & 0x07) + 1), BasicIo::cur, Exiv2::ErrorCode::kerFailedToReadImageData);
+      if (io.getb() == EOF)  // LZW minimum code size
+        throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+      skipSubBlocks(io);
+    } else {
+      throw Exiv2::Error(Exiv2::ErrorCode::kerCorruptedMetadata);
+    }
+  }
+  return layout;
+}
+}  // namespace
+
 // *****************************************************************************
 // class member definitions
 namespace Exiv2 {
-GifImage::GifImage(BasicIo::UniquePtr io) : Image(ImageType::gif, mdNone, std::move(io)) {
+GifImage::GifImage(BasicIo::UniquePtr io) : Image(ImageType::gif, mdXmp, std::move(io)) {
 }
 
 std::string GifImage::mimeType() const {
@@ -55,17 +172,104 @@ void GifImage::readMetadata() {
   clearMetadata();
 
   byte buf[4];
-  if (io_->read(buf, sizeof(buf)) == sizeof(buf)) {
-    pixelWidth_ = getShort(buf, littleEndian);
-    pixelHeight_ = getShort(buf + 2, littleEndian);
+  if (io_->read(buf, sizeof(buf)) != sizeof(buf))
+    return;
+  pixelWidth_ = getShort(buf, littleEndian);
+  pixelHeight_ = getShort(buf + 2, littleEndian);
+
+  io_->seekOrThrow(6, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  const GifLayout layout = scanGif(*io_);
+  if (layout.xmpBlocks_.empty())
+    return;
+
+  const auto [begin, end] = layout.xmpBlocks_.front();
+  const size_t size = end - begin - gifXmpHeaderSize;
+  DataBuf xmpPacket(size);
+  io_->seekOrThrow(begin + gifXmpHeaderSize, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  io_->readOrThrow(xmpPacket.data(), xmpPacket.size(), ErrorCode::kerFailedToReadImageData);
+  if (size < gifXmpMagicTrailerSize || xmpPacket.read_uint8(size - gifXmpMagicTrailerSize) != 0x01 ||
+      xmpPacket.read_uint8(size - gifXmpMagicTrailerSize + 1) != 0xFF) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to find the end of the XMP packet.\n";
+#endif
+    return;
+  }
+  xmpPacket_.assign(xmpPacket.c_str(), size - gifXmpMagicTrailerSize);
+  if (!xmpPacket_.empty() && XmpParser::decode(xmpData_, xmpPacket_)) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to decode XMP metadata.\n";
+#endif
   }
 }  // GifImage::readMetadata
 
 void GifImage::writeMetadata() {
-  // Todo: implement me!
-  throw(Error(ErrorCode::kerWritingImageFormatUnsupported, "GIF"));
+  if (io_->open() != 0) {
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  }
+  IoCloser closer(*io_);
+  MemIo tempIo;
+
+  doWriteMetadata(tempIo);  // may throw
+  io_->close();
+  io_->transfer(tempIo);  // may throw
 }  // GifImage::writeMetadata
 
+void GifImage::doWriteMetadata(BasicIo& outIo) {
+  if (!io_->isopen())
+    throw Error(ErrorCode::kerInputDataReadFailed);
+  if (!outIo.isopen())
+    throw Error(ErrorCode::kerImageWriteFailed);
+
+  if (!isGifType(*io_, true)) {
+    if (io_->error() || io_->eof())
+      throw Error(ErrorCode::kerInputDataReadFailed);
+    throw Error(ErrorCode::kerNoImageInInputData);
+  }
+  const GifLayout layout = scanGif(*io_);
+
+  if (!writeXmpFromPacket() && XmpParser::encode(xmpPacket_, xmpData_) > 1) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to encode XMP metadata.\n";
+#endif
+    throw Error(ErrorCode::kerImageWriteFailed);
+  }
+
+  // Extensions are a GIF89a feature
+  if (xmpPacket_.empty()) {
+    copyRange(*io_, 0, 6, outIo);
+  } else if (outIo.write(reinterpret_cast<const byte*>("GIF89a"), 6) != 6) {
+    throw Error(ErrorCode::kerImageWriteFailed);
+  }
+
+  // Splice out all existing XMP extensions, everything else is copied verbatim
+  size_t pos = 6;
+  for (auto&& [begin, end] : layout.xmpBlocks_) {
+    copyRange(*io_, pos, begin - pos, outIo);
+    pos = end;
+  }
+  copyRange(*io_, pos, layout.trailer_ - pos, outIo);
+
+  if (!xmpPacket_.empty()) {
+    const std::array<byte, 3> header{gifExtensionIntroducer, gifApplicationLabel, gifXmpAppId.size()};
+    std::array<byte, gifXmpMagicTrailerSize> trailer;
+    trailer.front() = 0x01;
+    for (size_t i = 1; i < trailer.size() - 1; ++i)
+      trailer[i] = static_cast<byte>(0x100 - i);
+    trailer.back() = 0x00;
+
+    if (outIo.write(header.data(), header.size()) != header.size() ||
+        outIo.write(gifXmpAppId.data(), gifXmpAppId.size()) != gifXmpAppId.size() ||
+        outIo.write(reinterpret_cast<const byte*>(xmpPacket_.data()), xmpPacket_.size()) != xmpPacket_.size() ||
+        outIo.write(trailer.data(), trailer.size()) != trailer.size())
+      throw Error(ErrorCode::kerImageWriteFailed);
+  }
+
+  if (outIo.putb(gifTrailer) == EOF)
+    throw Error(ErrorCode::kerImageWriteFailed);
+  if (layout.hasTrailer_ && io_->size() > layout.trailer_ + 1)
+    copyRange(*io_, layout.trailer_ + 1, io_->size() - layout.trailer_ - 1, outIo);
+}  // GifImage::doWriteMetadata
+
 // *************************************************************************
 // free functions
 Image::UniquePtr newGifInstance(BasicIo::UniquePtr io, bool /*create*/) {
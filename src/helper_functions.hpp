@@ -34,14 +34,19 @@ static constexpr size_t DWORD = 0x4;
 static constexpr size_t QWORD = 0x8;
 static constexpr size_t GUID = 0x10;
 
+[[nodiscard]] uint64_t readQWORDTag(BasicIo& io);
 [[nodiscard]] uint64_t readQWORDTag(const Exiv2::BasicIo::UniquePtr& io);
 
+[[nodiscard]] uint32_t readDWORDTag(BasicIo& io);
 [[nodiscard]] uint32_t readDWORDTag(const Exiv2::BasicIo::UniquePtr& io);
 
+[[nodiscard]] uint16_t readWORDTag(BasicIo& io);
 [[nodiscard]] uint16_t readWORDTag(const Exiv2::BasicIo::UniquePtr& io);
 
+[[nodiscard]] std::string readStringWcharTag(BasicIo& io, size_t length);
 [[nodiscard]] std::string readStringWcharTag(const Exiv2::BasicIo::UniquePtr& io, size_t length);
 
+[[nodiscard]] std::string readStringTag(BasicIo& io, size_t length = DWORD);
 [[nodiscard]] std::string readStringTag(const Exiv2::BasicIo::UniquePtr& io, size_t length = DWORD);
 
 /*!
@@ -73,49 +73,50 @@ struct Registry {
   AccessMode iptcSupport_;
   AccessMode xmpSupport_;
   AccessMode commentSupport_;
+  AccessMode iccProfileSupport_;
 };
 
 /// \todo Use std::unordered_map for implementing the registry. Avoid to use ImageType::none
 constexpr Registry registry[] = {
-    // image type       creation fct     type check  Exif mode    IPTC mode    XMP mode     Comment mode
-    //---------------  ---------------  ----------  -----------  -----------  -----------  ------------
-    {ImageType::jpeg, newJpegInstance, isJpegType, amReadWrite, amReadWrite, amReadWrite, amReadWrite},
-    {ImageType::exv, newExvInstance, isExvType, amReadWrite, amReadWrite, amReadWrite, amReadWrite},
-    {ImageType::cr2, newCr2Instance, isCr2Type, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::crw, newCrwInstance, isCrwType, amReadWrite, amNone, amNone, amReadWrite},
-    {ImageType::mrw, newMrwInstance, isMrwType, amRead, amRead, amRead, amNone},
-    {ImageType::tiff, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::webp, newWebPInstance, isWebPType, amReadWrite, amNone, amReadWrite, amNone},
-    {ImageType::dng, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::nef, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::pef, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::arw, newTiffInstance, isTiffType, amRead, amRead, amRead, amNone},
-    {ImageType::rw2, newRw2Instance, isRw2Type, amRead, amRead, amRead, amNone},
-    {ImageType::sr2, newTiffInstance, isTiffType, amRead, amRead, amRead, amNone},
-    {ImageType::srw, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::orf, newOrfInstance, isOrfType, amReadWrite, amReadWrite, amReadWrite, amNone},
+    // image type       creation fct     type check  Exif mode    IPTC mode    XMP mode     Comment mode  ICC mode
+    //---------------  ---------------  ----------  -----------  -----------  -----------  ------------  --------
+    {ImageType::jpeg, newJpegInstance, isJpegType, amReadWrite, amReadWrite, amReadWrite, amReadWrite, amNone},
+    {ImageType::exv, newExvInstance, isExvType, amReadWrite, amReadWrite, amReadWrite, amReadWrite, amNone},
+    {ImageType::cr2, newCr2Instance, isCr2Type, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::crw, newCrwInstance, isCrwType, amReadWrite, amNone, amNone, amReadWrite, amNone},
+    {ImageType::mrw, newMrwInstance, isMrwType, amRead, amRead, amRead, amNone, amNone},
+    {ImageType::tiff, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::webp, newWebPInstance, isWebPType, amReadWrite, amNone, amReadWrite, amNone, amNone},
+    {ImageType::dng, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::nef, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::pef, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::arw, newTiffInstance, isTiffType, amRead, amRead, amRead, amNone, amNone},
+    {ImageType::rw2, newRw2Instance, isRw2Type, amRead, amRead, amRead, amNone, amNone},
+    {ImageType::sr2, newTiffInstance, isTiffType, amRead, amRead, amRead, amNone, amNone},
+    {ImageType::srw, newTiffInstance, isTiffType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::orf, newOrfInstance, isOrfType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
 #ifdef EXV_HAVE_LIBZ
-    {ImageType::png, newPngInstance, isPngType, amReadWrite, amReadWrite, amReadWrite, amReadWrite},
+    {ImageType::png, newPngInstance, isPngType, amReadWrite, amReadWrite, amReadWrite, amReadWrite, amNone},
 #endif  // EXV_HAVE_LIBZ
-    {ImageType::pgf, newPgfInstance, isPgfType, amReadWrite, amReadWrite, amReadWrite, amReadWrite},
-    {ImageType::raf, newRafInstance, isRafType, amRead, amRead, amRead, amNone},
-    {ImageType::eps, newEpsInstance, isEpsType, amNone, amNone, amReadWrite, amNone},
-    {ImageType::xmp, newXmpInstance, isXmpType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::gif, newGifInstance, isGifType, amNone, amNone, amNone, amNone},
-    {ImageType::psd, newPsdInstance, isPsdType, amReadWrite, amReadWrite, amReadWrite, amNone},
-    {ImageType::tga, newTgaInstance, isTgaType, amNone, amNone, amNone, amNone},
-    {ImageType::bmp, newBmpInstance, isBmpType, amNone, amNone, amNone, amNone},
-    {ImageType::jp2, newJp2Instance, isJp2Type, amReadWrite, amReadWrite, amReadWrite, amNone},
+    {ImageType::pgf, newPgfInstance, isPgfType, amReadWrite, amReadWrite, amReadWrite, amReadWrite, amNone},
+    {ImageType::raf, newRafInstance, isRafType, amRead, amRead, amRead, amNone, amNone},
+    {ImageType::eps, newEpsInstance, isEpsType, amNone, amNone, amReadWrite, amNone, amNone},
+    {ImageType::xmp, newXmpInstance, isXmpType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::gif, newGifInstance, isGifType, amNone, amNone, amReadWrite, amNone, amNone},
+    {ImageType::psd, newPsdInstance, isPsdType, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
+    {ImageType::tga, newTgaInstance, isTgaType, amNone, amNone, amRead, amRead, amNone},
+    {ImageType::bmp, newBmpInstance, isBmpType, amNone, amNone, amNone, amNone, amRead},
+    {ImageType::jp2, newJp2Instance, isJp2Type, amReadWrite, amReadWrite, amReadWrite, amNone, amNone},
 // needs to be before bmff because some ftyp files are handled as qt and
 // the rest should fall through to bmff
 #ifdef EXV_ENABLE_VIDEO
-    {ImageType::qtime, newQTimeInstance, isQTimeType, amRead, amNone, amRead, amNone},
-    {ImageType::asf, newAsfInstance, isAsfType, amRead, amNone, amRead, amNone},
-    {ImageType::riff, newRiffInstance, isRiffType, amRead, amNone, amRead, amNone},
-    {ImageType::mkv, newMkvInstance, isMkvType, amRead, amNone, amRead, amNone},
+    {ImageType::qtime, newQTimeInstance, isQTimeType, amRead, amNone, amReadWrite, amNone, amNone},
+    {ImageType::asf, newAsfInstance, isAsfType, amRead, amNone, amReadWrite, amNone, amNone},
+    {ImageType::riff, newRiffInstance, isRiffType, amRead, amNone, amReadWrite, amNone, amNone},
+    {ImageType::mkv, newMkvInstance, isMkvType, amRead, amNone, amReadWrite, amNone, amNone},
 #endif  // EXV_ENABLE_VIDEO
 #ifdef EXV_ENABLE_BMFF
-    {ImageType::bmff, newBmffInstance, isBmffType, amRead, amRead, amRead, amNone},
+    {ImageType::bmff, newBmffInstance, isBmffType, amRead, amRead, amRead, amNone, amNone},
 #endif  // EXV_ENABLE_BMFF
 };
 
@@ -746,6 +747,8 @@ AccessMode ImageFactory::checkMode(ImageType type, MetadataId metadataId) {
     return r->xmpSupport_;
   if (metadataId == mdComment)
     return r->commentSupport_;
+  if (metadataId == mdIccProfile)
+    return r->iccProfileSupport_;
   return amNone;
 }
 
@@ -3,6 +3,8 @@
 #include "config.h"
 
 #include "image_int.hpp"
+#include "error.hpp"
+#include "xmp_exiv2.hpp"
 
 #include <cstddef>
 #include <string>
@@ -12,4 +14,25 @@ namespace Exiv2::Internal {
   return std::string(2 * i, ' ');
 }
 
+void enforceXmpStored(const XmpData& xmpData, const XmpData& read,
+                      const std::function<bool(const std::string&)>& stored) {
+  std::string lost;
+  for (const auto& xmp : xmpData) {
+    if (stored(xmp.key()))
+      continue;
+    auto it = read.findKey(XmpKey(xmp.key()));
+    if (it != read.end() && it->toString() == xmp.toString())
+      continue;
+    if (!lost.empty())
+      lost += ", ";
+    lost += xmp.key();
+  }
+  if (lost.empty())
+    return;
+#ifndef SUPPRESS_WARNINGS
+  EXV_WARNING << "This file format cannot store the XMP properties " << lost << ".\n";
+#endif
+  throw Error(ErrorCode::kerImageWriteFailed);
+}
+
 }  // namespace Exiv2::Internal
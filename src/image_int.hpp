@@ -9,6 +9,7 @@
 
 #include <cstddef>  // for size_t
 #include <cstdint>  // for int32_t
+#include <functional>
 #include <ostream>  // for ostream, basic_ostream::put
 #include <string>
 
@@ -24,6 +25,10 @@
 #define stringFormatTo std::format_to
 #endif
 
+namespace Exiv2 {
+class XmpData;
+}
+
 // *****************************************************************************
 // namespace extensions
 namespace Exiv2::Internal {
@@ -100,6 +105,18 @@ constexpr binaryToStringHelper<T> binaryToString(Slice<T>&& sl) noexcept {
 /// @brief indent output for kpsRecursive in \em printStructure() \em .
 std::string indent(size_t i);
 
+/*!
+  @brief Check that the XMP properties of an image, which stores only some of them in its own
+         format, can be written: each property must either be stored by the writer or be
+         unchanged from the properties read from the file. The others are reported in a warning.
+  @param xmpData The XMP properties to write
+  @param read The XMP properties read from the file
+  @param stored Whether the property with the given key is stored by the writer
+  @throw Error kerImageWriteFailed if a property cannot be written
+ */
+void enforceXmpStored(const XmpData& xmpData, const XmpData& read,
+                      const std::function<bool(const std::string&)>& stored);
+
 }  // namespace Exiv2::Internal
 
 #endif  // #ifndef IMAGE_INT_HPP_
@@ -454,6 +454,21 @@ DataBuf IptcParser::encode(const IptcData& iptcData) {
   return buf;
 }  // IptcParser::encode
 
+CanonicalMetadata canonicalMetadata(const IptcData& iptcData) {
+  CanonicalMetadata metadata;
+  metadata.reserve(iptcData.count());
+  for (const auto& md : iptcData)
+    metadata.emplace_back(md.key(), md.toString());
+  // Repeated datasets keep their order
+  std::stable_sort(metadata.begin(), metadata.end(),
+                   [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  return metadata;
+}
+
+uint64_t digest(const IptcData& iptcData) {
+  return digest(canonicalMetadata(iptcData));
+}
+
 }  // namespace Exiv2
 
 // *****************************************************************************
@@ -6,6 +6,7 @@
 #include "config.h"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
@@ -19,6 +20,7 @@
 #include <algorithm>
 #include <array>
 #include <iostream>
+#include <limits>
 
 #ifdef EXIV2_DEBUG_MESSAGES
 #include <fstream>
@@ -716,6 +718,15 @@ void Jp2Image::doWriteMetadata(BasicIo& outIo) {
                    "This is the last box of file."
                 << '\n';
 #endif
+      if (box.type != kJp2BoxType::Header && box.type != kJp2BoxType::Uuid) {
+        // Typically the codestream, which may be larger than 4 GB: copy it as it is, keeping the null size
+        if (outIo.write(bheaderBuf.c_data(), bheaderBuf.size()) != bheaderBuf.size())
+          throw Error(ErrorCode::kerImageWriteFailed);
+        Internal::copyRange(*io_, io_->tell(), io_->size() - io_->tell(), outIo);
+        break;
+      }
+      Internal::enforce(io_->size() - io_->tell() <= std::numeric_limits<uint32_t>::max() - 8,
+                        ErrorCode::kerCorruptedMetadata);
       box.length = static_cast<uint32_t>(io_->size() - io_->tell() + 8);
     }
     if (box.length < 8) {
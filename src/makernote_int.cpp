@@ -7,6 +7,7 @@
 // included header files
 #include "config.h"
 
+#include "exif.hpp"
 #include "makernote_int.hpp"
 #include "safe_op.hpp"
 #include "tiffcomposite_int.hpp"
@@ -16,6 +17,7 @@
 
 // + standard includes
 #include <array>
+#include <atomic>
 #include <iostream>
 
 #ifdef EXV_ENABLE_FILESYSTEM
@@ -46,8 +48,19 @@ std::string getExifModel(Exiv2::Internal::TiffComponent* pRoot);
 
 //! Nikon en/decryption function
 void ncrypt(Exiv2::byte* pData, uint32_t size, uint32_t count, uint32_t serial);
+
+//! Whether makernotes are decoded when Exif data is read
+std::atomic<bool> decodeMakerNotes{true};
 }  // namespace
 
+// *****************************************************************************
+// free functions
+namespace Exiv2 {
+bool enableMakerNoteDecoding(bool enable) {
+  return decodeMakerNotes.exchange(enable);
+}
+}  // namespace Exiv2
+
 // *****************************************************************************
 // class member definitions
 namespace Exiv2::Internal {
@@ -141,6 +154,8 @@ bool TiffMnRegistry::operator==(IfdId key) const {
 
 std::unique_ptr<TiffComponent> TiffMnCreator::create(uint16_t tag, IfdId group, std::string_view make,
                                                      const byte* pData, size_t size, ByteOrder byteOrder) {
+  if (!decodeMakerNotes)
+    return nullptr;
   if (auto tmr = Exiv2::find(registry_, make))
     return tmr->newMnFct_(tag, group, tmr->mnGroup_, pData, size, byteOrder);
   return nullptr;
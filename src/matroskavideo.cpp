@@ -22,16 +22,22 @@
 #include "config.h"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
+#include "containerwalker_int.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
 #include "helper_functions.hpp"
+#include "image_int.hpp"
 #include "matroskavideo.hpp"
 
 // + standard includes
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <vector>
 // *****************************************************************************
 // class member definitions
 namespace Exiv2::Internal {
@@ -580,24 +586,163 @@ const MatroskaTag streamRate[] = {
       bytes are used to calculate the rest of the Tag.
       Returns Tag Value.
  */
-[[nodiscard]] static size_t returnTagValue(const byte* buf, size_t size) {
+[[nodiscard]] static uint64_t returnTagValue(const byte* buf, size_t size) {
   enforce(size > 0 && size <= 8, Exiv2::ErrorCode::kerCorruptedMetadata);
 
-  size_t b0 = buf[0] & (0xff >> size);
-  size_t tag = b0 << ((size - 1) * 8);
+  // 64 bits wide even on 32-bit builds: element sizes of clusters may exceed 4 GB
+  uint64_t b0 = buf[0] & (0xff >> size);
+  uint64_t tag = b0 << ((size - 1) * 8);
   for (size_t i = 1; i < size; ++i) {
-    tag |= static_cast<size_t>(buf[i]) << ((size - i - 1) * 8);
+    tag |= static_cast<uint64_t>(buf[i]) << ((size - i - 1) * 8);
   }
 
   return tag;
 }
+
+/*!
+  @brief Find the tag \em id in matroskaTags with a binary search over the
+      tags ordered by id. Like Exiv2::find(), the first of equal ids wins.
+ */
+[[nodiscard]] static const MatroskaTag* findTag(uint64_t id) {
+  static const auto sorted = [] {
+    std::vector<const MatroskaTag*> tags;
+    for (const auto& tag : matroskaTags)
+      tags.push_back(&tag);
+    std::stable_sort(tags.begin(), tags.end(), [](const auto* a, const auto* b) { return a->_id < b->_id; });
+    return tags;
+  }();
+  auto it = std::lower_bound(sorted.begin(), sorted.end(), id, [](const auto* tag, uint64_t i) { return tag->_id < i; });
+  return it != sorted.end() && (*it)->_id == id ? *it : nullptr;
+}
+
+//! Length markers of 1 and 2 byte ids and of the 4 byte level 1 ids
+constexpr uint64_t ebmlMarker1 = 0x80;
+constexpr uint64_t ebmlMarker2 = 0x4000;
+constexpr uint64_t ebmlMarker4 = 0x10000000;
+
+//! Level 1 elements which may follow the clusters, with their length marker as in SeekID
+constexpr uint64_t indexedElements[] = {
+    Info | ebmlMarker4, Tracks | ebmlMarker4, Tags | ebmlMarker4, Attachments | ebmlMarker4, Chapters | ebmlMarker4,
+};
+
+[[nodiscard]] static bool isIndexedElement(uint64_t id) {
+  return std::find(std::begin(indexedElements), std::end(indexedElements), id) != std::end(indexedElements);
+}
+
+//! Most level 1 elements followed after the first Cluster when the file has no SeekHead. Muxers write a Cluster
+//! every few seconds: this covers several hours of video, and bounds the reads for files with tiny clusters.
+constexpr size_t maxFollowedElements = 16384;
+
+//! SimpleTag names and the XMP properties they are read into and written from
+constexpr std::pair<const char*, const char*> simpleTagProperties[] = {
+    {"TITLE", "Xmp.video.Title"},
+    {"DATE_RECORDED", "Xmp.video.DateTimeOriginal"},
+    {"RECORDING_LOCATION", "Xmp.video.GPSCoordinates"},
+};
+
+//! Largest element read into memory when rewriting the SeekHead, Info or Tags
+constexpr size_t maxRewrittenSize = 16 * 1024 * 1024;
+
+//! Append the element \em id, including its length marker, with the shortest possible size to \em out
+static void appendElement(Blob& out, uint64_t id, const byte* payload, size_t size) {
+  int shift = 24;
+  while (shift > 0 && (id >> shift) == 0)
+    shift -= 8;
+  for (; shift >= 0; shift -= 8)
+    out.push_back(static_cast<byte>(id >> shift));
+  // A size with all value bits set means unknown size
+  size_t length = 1;
+  while (length < 8 && size >= (uint64_t{1} << (7 * length)) - 1)
+    ++length;
+  out.push_back(static_cast<byte>((0x80 >> (length - 1)) | (static_cast<uint64_t>(size) >> (8 * (length - 1)))));
+  for (size_t i = length - 1; i-- > 0;)
+    out.push_back(static_cast<byte>(static_cast<uint64_t>(size) >> (8 * i)));
+  if (size > 0)
+    out.insert(out.end(), payload, payload + size);
+}
+
+static void appendElement(Blob& out, uint64_t id, const Blob& payload) {
+  appendElement(out, id, payload.data(), payload.size());
+}
+
+static void appendElement(Blob& out, uint64_t id, const std::string& payload) {
+  appendElement(out, id, reinterpret_cast<const byte*>(payload.data()), payload.size());
+}
+
+//! Header of a Void element of \em size bytes in total, which must be at least 2
+[[nodiscard]] static Blob voidHeader(uint64_t size) {
+  Blob header{static_cast<byte>(Void | ebmlMarker1)};
+  if (size - 2 < 0x7f) {
+    header.push_back(static_cast<byte>(0x80 | (size - 2)));
+  } else {
+    header.push_back(0x01);
+    for (int shift = 48; shift >= 0; shift -= 8)
+      header.push_back(static_cast<byte>((size - 9) >> shift));
+  }
+  return header;
+}
+
+//! Call <code>visitor(entry, element)</code> for each element in \em data, \em element pointing to its header
+template <typename Visitor>
+static void forEachElement(const byte* data, size_t size, Visitor&& visitor) {
+  if (size == 0)
+    return;
+  MemIo io(data, size);
+  ContainerWalker walker(io, ContainerFormat::ebml);
+  walker.walk(0, size, [&](const ContainerEntry& entry) {
+    visitor(entry, data + entry.offset);
+    return WalkAction::next;
+  });
+}
+
+//! The payload of \em entry, an element at \em element, as a string without trailing NUL characters
+[[nodiscard]] static std::string elementString(const ContainerEntry& entry, const byte* element) {
+  std::string str(reinterpret_cast<const char*>(element + (entry.dataOffset - entry.offset)), toSize(entry.size));
+  return str.substr(0, str.find('\0'));
+}
+
+//! The TagName and TagString of the SimpleTag at \em element
+[[nodiscard]] static std::pair<std::string, std::string> simpleTagValue(const ContainerEntry& entry,
+                                                                       const byte* element) {
+  std::pair<std::string, std::string> value;
+  forEachElement(element + (entry.dataOffset - entry.offset), toSize(entry.size),
+                 [&](const ContainerEntry& child, const byte* childElement) {
+                   if (child.id == (Xmp_video_TagName | ebmlMarker2))
+                     value.first = elementString(child, childElement);
+                   else if (child.id == (Xmp_video_TagString | ebmlMarker2))
+                     value.second = elementString(child, childElement);
+                 });
+  return value;
+}
+
+//! Whether \em name is the name of a SimpleTag read into an XMP property
+[[nodiscard]] static bool isProperty(const std::string& name) {
+  return std::any_of(std::begin(simpleTagProperties), std::end(simpleTagProperties),
+                     [&](const auto& property) { return name == property.first; });
+}
+
+//! Whether the Tag at \em element applies to the whole segment, i.e. its Targets only give a target type
+[[nodiscard]] static bool isSegmentTag(const ContainerEntry& entry, const byte* element) {
+  bool segmentTag = true;
+  forEachElement(element + (entry.dataOffset - entry.offset), toSize(entry.size),
+                 [&](const ContainerEntry& child, const byte* target) {
+                   if (child.id != (Targets | ebmlMarker2))
+                     return;
+                   forEachElement(target + (child.dataOffset - child.offset), toSize(child.size),
+                                  [&](const ContainerEntry& type, const byte*) {
+                                    segmentTag = segmentTag && (type.id == (TargetTypeValue | ebmlMarker2) ||
+                                                                type.id == (Xmp_video_TargetType | ebmlMarker2));
+                                  });
+                 });
+  return segmentTag;
+}
 }  // namespace Exiv2::Internal
 
 namespace Exiv2 {
 
 using namespace Exiv2::Internal;
 
-MatroskaVideo::MatroskaVideo(BasicIo::UniquePtr io) : Image(ImageType::mkv, mdNone, std::move(io)) {
+MatroskaVideo::MatroskaVideo(BasicIo::UniquePtr io) : Image(ImageType::mkv, mdXmp, std::move(io)) {
 }  // MatroskaVideo::MatroskaVideo
 
 std::string MatroskaVideo::mimeType() const {
@@ -605,7 +750,315 @@ std::string MatroskaVideo::mimeType() const {
 }
 
 void MatroskaVideo::writeMetadata() {
-}
+  // Only the SimpleTag properties are stored, the others must be those read from the file
+  enforceXmpStored(xmpData_, readXmpData_, [](const std::string& key) {
+    return std::any_of(std::begin(simpleTagProperties), std::end(simpleTagProperties),
+                       [&key](const auto& property) { return key == property.second; });
+  });
+
+  if (io_->open() != 0)
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  IoCloser closer(*io_);
+  if (!isMkvType(*io_, false))
+    throw Error(ErrorCode::kerNoImageInInputData);
+
+  const auto property = [this](const char* key) {
+    auto it = xmpData_.findKey(XmpKey(key));
+    return it == xmpData_.end() ? std::string() : it->toString();
+  };
+
+  // Level 1 elements of the first segment. Clusters are skipped by their size and never read.
+  ContainerWalker walker(*io_, ContainerFormat::ebml);
+  ContainerEntry segment;
+  bool hasSegment = false;
+  walker.walk(0, io_->size(), [&](const ContainerEntry& entry) {
+    hasSegment = entry.id == (SegmentHeader | ebmlMarker4);
+    segment = entry;
+    return hasSegment ? WalkAction::stop : WalkAction::next;
+  });
+  if (!hasSegment)
+    throw Error(ErrorCode::kerNoImageInInputData);
+  std::vector<ContainerEntry> elements;
+  walker.walk(segment.dataOffset, segment.end(), [&](const ContainerEntry& entry) {
+    elements.push_back(entry);
+    return WalkAction::next;
+  });
+
+  constexpr size_t none = std::numeric_limits<size_t>::max();
+  const auto findElement = [&](uint64_t id) {
+    auto it = std::find_if(elements.begin(), elements.end(), [id](const auto& e) { return e.id == id; });
+    return it == elements.end() ? none : static_cast<size_t>(it - elements.begin());
+  };
+  const auto isVoid = [](const ContainerEntry& e) { return e.id == (Void | ebmlMarker1); };
+  // An element can grow into the Void elements which follow it
+  const auto spanEnd = [&](size_t index) {
+    while (index + 1 < elements.size() && isVoid(elements[index + 1]))
+      ++index;
+    return elements[index].end();
+  };
+  const auto readElement = [&](size_t index) { return walker.readPayload(elements[index], maxRewrittenSize); };
+
+  const size_t seekHead = findElement(SeekHead | ebmlMarker4);
+  const size_t info = findElement(Info | ebmlMarker4);
+  const size_t tags = findElement(Tags | ebmlMarker4);
+
+  // Runs of Void elements, except those after the elements rewritten below: these can grow into them.
+  // The space they leave is added once they are placed.
+  struct Run {
+    uint64_t offset;
+    uint64_t size;
+  };
+  std::vector<Run> runs;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    if (!isVoid(elements[i]) || (i > 0 && isVoid(elements[i - 1])))
+      continue;
+    if (i > 0 && (i - 1 == seekHead || i - 1 == info || i - 1 == tags))
+      continue;
+    runs.push_back({elements[i].offset, spanEnd(i) - elements[i].offset});
+  }
+
+  // All writes are planned before the file is modified
+  struct Write {
+    uint64_t offset;
+    Blob data;
+  };
+  std::vector<Write> writes;
+  Blob appended;
+  const uint64_t appendOffset = segment.end();
+
+  const auto fits = [](uint64_t space, size_t size) { return space == size || space >= size + 2; };
+  const auto writeAt = [&](uint64_t offset, Blob data, uint64_t space) {
+    const size_t size = data.size();
+    writes.push_back({offset, std::move(data)});
+    if (space > size)
+      writes.push_back({offset + size, voidHeader(space - size)});
+  };
+  // Write an element over the old one, into a run of Void elements or append it, and return its offset
+  const auto place = [&](size_t old, Blob data) -> uint64_t {
+    if (old != none && !data.empty() && fits(spanEnd(old) - elements[old].offset, data.size())) {
+      const uint64_t offset = elements[old].offset;
+      const uint64_t space = spanEnd(old) - offset;
+      if (space > data.size())
+        runs.push_back({offset + data.size(), space - data.size()});
+      writeAt(offset, std::move(data), space);
+      return offset;
+    }
+    if (old != none) {
+      writes.push_back({elements[old].offset, voidHeader(elements[old].end() - elements[old].offset)});
+      runs.push_back({elements[old].offset, spanEnd(old) - elements[old].offset});
+    }
+    if (data.empty())
+      return 0;
+    auto run = std::find_if(runs.begin(), runs.end(), [&](const Run& r) { return fits(r.size, data.size()); });
+    if (run != runs.end()) {
+      const uint64_t offset = run->offset;
+      const uint64_t space = run->size;
+      run->offset += data.size();
+      run->size -= data.size();
+      writeAt(offset, std::move(data), space);
+      return offset;
+    }
+    const uint64_t offset = appendOffset + appended.size();
+    appended.insert(appended.end(), data.begin(), data.end());
+    return offset;
+  };
+
+  // Elements written, for the SeekHead
+  struct Placed {
+    uint64_t id;
+    size_t old;       //!< Index of the element written over, none if there was none
+    uint64_t offset;  //!< New offset, 0 if the element was removed
+  };
+  std::vector<Placed> placed;
+
+  // Info: the title is replaced, the other children are kept
+  const std::string title = property("Xmp.video.Title");
+  std::string oldTitle;
+  Blob infoPayload;
+  if (info != none) {
+    const DataBuf payload = readElement(info);
+    forEachElement(payload.c_data(), payload.size(), [&](const ContainerEntry& entry, const byte* element) {
+      if (entry.id == (Xmp_video_Title | ebmlMarker2))
+        oldTitle = elementString(entry, element);
+      else if (entry.id != (CRC_32 | ebmlMarker1))
+        infoPayload.insert(infoPayload.end(), element, element + (entry.end() - entry.offset));
+    });
+  }
+  if (title != oldTitle) {
+    if (!title.empty())
+      appendElement(infoPayload, Xmp_video_Title | ebmlMarker2, title);
+    Blob element;
+    appendElement(element, Info | ebmlMarker4, infoPayload);
+    placed.push_back({Info | ebmlMarker4, info, place(info, std::move(element))});
+  }
+
+  // Tags: the SimpleTags of the properties are removed from all Tags and the current values are
+  // added to the first Tag applying to the whole segment, the other SimpleTags are kept. The title
+  // is stored in Info, and in a SimpleTag only if the file has one already.
+  DataBuf tagsData;
+  if (tags != none)
+    tagsData = readElement(tags);
+  std::vector<std::pair<std::string, std::string>> oldValues;
+  forEachElement(tagsData.c_data(), tagsData.size(), [&](const ContainerEntry& entry, const byte* element) {
+    if (entry.id != (Tag | ebmlMarker2))
+      return;
+    forEachElement(element + (entry.dataOffset - entry.offset), toSize(entry.size),
+                   [&](const ContainerEntry& child, const byte* childElement) {
+                     if (child.id != (SimpleTag | ebmlMarker2))
+                       return;
+                     auto simpleTag = simpleTagValue(child, childElement);
+                     if (isProperty(simpleTag.first))
+                       oldValues.push_back(std::move(simpleTag));
+                   });
+  });
+  const bool hasTitleTag =
+      std::any_of(oldValues.begin(), oldValues.end(), [](const auto& value) { return value.first == "TITLE"; });
+
+  std::vector<std::pair<std::string, std::string>> newValues;
+  Blob simpleTags;
+  for (auto&& [name, key] : simpleTagProperties) {
+    const std::string value = property(key);
+    if (value.empty() || (std::string(name) == "TITLE" && !hasTitleTag))
+      continue;
+    newValues.emplace_back(name, value);
+    Blob simpleTag;
+    appendElement(simpleTag, Xmp_video_TagName | ebmlMarker2, std::string(name));
+    appendElement(simpleTag, Xmp_video_TagString | ebmlMarker2, value);
+    appendElement(simpleTags, SimpleTag | ebmlMarker2, simpleTag);
+  }
+  Blob tagsPayload;
+  bool hasSegmentTag = false;
+  forEachElement(tagsData.c_data(), tagsData.size(), [&](const ContainerEntry& entry, const byte* element) {
+    if (entry.id == (CRC_32 | ebmlMarker1))
+      return;
+    if (entry.id != (Tag | ebmlMarker2)) {
+      tagsPayload.insert(tagsPayload.end(), element, element + (entry.end() - entry.offset));
+      return;
+    }
+    const bool isFirstSegmentTag = !hasSegmentTag && isSegmentTag(entry, element);
+    hasSegmentTag = hasSegmentTag || isFirstSegmentTag;
+    Blob tag;
+    bool hasSimpleTag = false;
+    forEachElement(element + (entry.dataOffset - entry.offset), toSize(entry.size),
+                   [&](const ContainerEntry& child, const byte* childElement) {
+                     const bool isSimpleTag = child.id == (SimpleTag | ebmlMarker2);
+                     if (child.id == (CRC_32 | ebmlMarker1) ||
+                         (isSimpleTag && isProperty(simpleTagValue(child, childElement).first)))
+                       return;
+                     hasSimpleTag = hasSimpleTag || isSimpleTag;
+                     tag.insert(tag.end(), childElement, childElement + (child.end() - child.offset));
+                   });
+    if (isFirstSegmentTag) {
+      tag.insert(tag.end(), simpleTags.begin(), simpleTags.end());
+      hasSimpleTag = hasSimpleTag || !simpleTags.empty();
+    }
+    // A Tag needs at least one SimpleTag
+    if (hasSimpleTag)
+      appendElement(tagsPayload, Tag | ebmlMarker2, tag);
+  });
+  if (!hasSegmentTag && !simpleTags.empty()) {
+    Blob targets;
+    const byte movie = 50;
+    appendElement(targets, TargetTypeValue | ebmlMarker2, &movie, 1);
+    Blob tag;
+    appendElement(tag, Targets | ebmlMarker2, targets);
+    tag.insert(tag.end(), simpleTags.begin(), simpleTags.end());
+    appendElement(tagsPayload, Tag | ebmlMarker2, tag);
+  }
+  std::sort(oldValues.begin(), oldValues.end());
+  std::sort(newValues.begin(), newValues.end());
+  if (oldValues != newValues) {
+    // Tags needs at least one Tag
+    Blob element;
+    if (!tagsPayload.empty())
+      appendElement(element, Tags | ebmlMarker4, tagsPayload);
+    placed.push_back({Tags | ebmlMarker4, tags, place(tags, std::move(element))});
+  }
+
+  // SeekHead entries of the moved elements. There is no room to move the SeekHead itself.
+  if (seekHead != none) {
+    std::vector<std::pair<uint64_t, uint64_t>> seeks;
+    const DataBuf payload = readElement(seekHead);
+    forEachElement(payload.c_data(), payload.size(), [&](const ContainerEntry& entry, const byte* element) {
+      if (entry.id != (Seek | ebmlMarker2))
+        return;
+      uint64_t id = 0;
+      uint64_t position = 0;
+      forEachElement(element + (entry.dataOffset - entry.offset), toSize(entry.size),
+                     [&](const ContainerEntry& child, const byte* childElement) {
+                       uint64_t value = 0;
+                       for (uint64_t i = child.dataOffset - child.offset; i < child.end() - child.offset; ++i)
+                         value = (value << 8) | childElement[i];
+                       if (child.id == (SeekID | ebmlMarker2))
+                         id = value;
+                       else if (child.id == (SeekPosition | ebmlMarker2))
+                         position = value;
+                     });
+      seeks.emplace_back(id, position);
+    });
+    bool changed = false;
+    for (const auto& p : placed) {
+      if (p.old != none && p.offset == elements[p.old].offset)
+        continue;
+      changed = true;
+      auto seek = seeks.end();
+      if (p.old != none) {
+        const uint64_t position = elements[p.old].offset - segment.dataOffset;
+        seek = std::find(seeks.begin(), seeks.end(), std::make_pair(p.id, position));
+      }
+      if (seek != seeks.end() && p.offset == 0)
+        seeks.erase(seek);
+      else if (seek != seeks.end())
+        seek->second = p.offset - segment.dataOffset;
+      else if (p.offset != 0)
+        seeks.emplace_back(p.id, p.offset - segment.dataOffset);
+    }
+    if (changed) {
+      Blob seekPayload;
+      for (auto&& [id, position] : seeks) {
+        Blob seek;
+        Blob idBytes;
+        Blob positionBytes;
+        for (int shift = 24; shift >= 0; shift -= 8)
+          if ((id >> shift) != 0 || shift == 0)
+            idBytes.push_back(static_cast<byte>(id >> shift));
+        for (int shift = 56; shift >= 0; shift -= 8)
+          if ((position >> shift) != 0 || shift == 0)
+            positionBytes.push_back(static_cast<byte>(position >> shift));
+        appendElement(seek, SeekID | ebmlMarker2, idBytes);
+        appendElement(seek, SeekPosition | ebmlMarker2, positionBytes);
+        appendElement(seekPayload, Seek | ebmlMarker2, seek);
+      }
+      Blob element;
+      appendElement(element, SeekHead | ebmlMarker4, seekPayload);
+      const uint64_t space = spanEnd(seekHead) - elements[seekHead].offset;
+      enforce(fits(space, element.size()), ErrorCode::kerImageWriteFailed);
+      writeAt(elements[seekHead].offset, std::move(element), space);
+    }
+  }
+
+  // Appended elements extend the segment, which must therefore end the file
+  if (!appended.empty()) {
+    enforce(appendOffset == io_->size(), ErrorCode::kerImageWriteFailed);
+    if (!segment.unknownSize) {
+      const size_t length = toSize(segment.dataOffset - segment.offset - 4);
+      const uint64_t size = segment.size + appended.size();
+      enforce(size < (uint64_t{1} << (7 * length)) - 1, ErrorCode::kerImageWriteFailed);
+      Blob field(length);
+      for (size_t i = 0; i < length; ++i)
+        field[length - 1 - i] = static_cast<byte>(size >> (8 * i));
+      field[0] |= static_cast<byte>(0x80 >> (length - 1));
+      writes.push_back({segment.offset + 4, std::move(field)});
+    }
+    writes.push_back({appendOffset, std::move(appended)});
+  }
+
+  for (auto&& write : writes) {
+    io_->seekOrThrow(toSeekOffset(write.offset), BasicIo::beg, ErrorCode::kerImageWriteFailed);
+    if (io_->write(write.data.data(), write.data.size()) != write.data.size())
+      throw Error(ErrorCode::kerImageWriteFailed);
+  }
+}  // MatroskaVideo::writeMetadata
 
 void MatroskaVideo::readMetadata() {
   if (io_->open() != 0)
@@ -620,33 +1073,39 @@ void MatroskaVideo::readMetadata() {
 
   IoCloser closer(*io_);
   clearMetadata();
+  readXmpData_.clear();
   continueTraversing_ = true;
   height_ = width_ = 1;
+  segmentStart_ = 0;
+  seekEntries_.clear();
+  decodedElements_.clear();
+  simpleTagName_.clear();
 
   xmpData_["Xmp.video.FileSize"] = io_->size() / bytesMB;
   xmpData_["Xmp.video.MimeType"] = mimeType();
 
   while (continueTraversing_)
     decodeBlock();
+  decodeIndexedElements();
 
   xmpData_["Xmp.video.AspectRatio"] = getAspectRatio(width_, height_);
+  readXmpData_ = xmpData_;
 }
 
 void MatroskaVideo::decodeBlock() {
-  byte buf[8];
-  io_->read(buf, 1);
+  // Fetch the largest possible header, an 8 byte id and an 8 byte size, with one read and decode it from memory
+  const uint64_t offset = io_->tell();
+  byte buf[16];
+  const size_t avail = io_->read(buf, sizeof(buf));
+  const uint32_t idLength = avail > 0 ? findBlockSize(buf[0]) : 0;  // 0-8
 
-  if (io_->eof()) {
+  if (avail == 0 || idLength >= avail) {
     continueTraversing_ = false;
     return;
   }
 
-  uint32_t block_size = findBlockSize(buf[0]);  // 0-8
-  if (block_size > 0)
-    io_->read(buf + 1, block_size - 1);
-
-  auto tag_id = returnTagValue(buf, block_size);
-  const MatroskaTag* tag = Exiv2::find(matroskaTags, tag_id);
+  auto tag_id = returnTagValue(buf, idLength);
+  const MatroskaTag* tag = findTag(tag_id);
 
   if (!tag) {
     continueTraversing_ = false;
@@ -656,16 +1115,30 @@ void MatroskaVideo::decodeBlock() {
   // tag->dump(std::cout);
 
   if (tag->_id == Cues || tag->_id == Cluster) {
+    // Stay at the element: the elements which follow it are found from there
+    io_->seek(toSeekOffset(offset), BasicIo::beg);
     continueTraversing_ = false;
     return;
   }
 
-  io_->read(buf, 1);
-  block_size = findBlockSize(buf[0]);  // 0-8
-
-  if (block_size > 0)
-    io_->read(buf + 1, block_size - 1);
-  size_t size = returnTagValue(buf, block_size);
+  const uint32_t sizeLength = findBlockSize(buf[idLength]);  // 0-8
+  if (idLength + sizeLength > avail) {
+    continueTraversing_ = false;
+    return;
+  }
+  const uint64_t size = returnTagValue(buf + idLength, sizeLength);
+  io_->seek(toSeekOffset(offset + idLength + sizeLength), BasicIo::beg);
+
+  if (tag->_id == SegmentHeader)
+    segmentStart_ = io_->tell();
+  if (tag->_id == SeekHead || isIndexedElement(tag->_id | ebmlMarker4))
+    decodedElements_.push_back(offset);
+  if (tag->_id == SeekHead) {
+    const uint64_t dataOffset = io_->tell();
+    decodeSeekHead(dataOffset, size);
+    io_->seek(toSeekOffset(std::min(size, io_->size() - dataOffset) + dataOffset), BasicIo::beg);
+    return;
+  }
 
   if (tag->isComposite() && !tag->isSkipped())
     return;
@@ -679,12 +1152,12 @@ void MatroskaVideo::decodeBlock() {
   }
 #endif
   if (tag->isSkipped() || size > bufMaxSize) {
-    io_->seek(size, BasicIo::cur);
+    io_->seek(toSeekOffset(size), BasicIo::cur);
     return;
   }
 
   DataBuf buf2(bufMaxSize + 1);
-  io_->read(buf2.data(), size);
+  io_->read(buf2.data(), static_cast<size_t>(size));
   switch (tag->_type) {
     case InternalField:
       decodeInternalTags(tag, buf2.data());
@@ -701,7 +1174,7 @@ void MatroskaVideo::decodeBlock() {
       decodeBooleanTags(tag, buf2.data());
       break;
     case Date:
-      decodeDateTags(tag, buf2.data(), size);
+      decodeDateTags(tag, buf2.data(), static_cast<size_t>(size));
       break;
     case Float:
       decodeFloatTags(tag, buf2.data());
@@ -715,6 +1188,111 @@ void MatroskaVideo::decodeBlock() {
   }
 }  // MatroskaVideo::decodeBlock
 
+void MatroskaVideo::decodeSeekHead(uint64_t offset, uint64_t size) {
+  const uint64_t end = offset + std::min(size, io_->size() - offset);
+  ContainerWalker walker(*io_, ContainerFormat::ebml);
+  walker.setTruncatedAllowed(true);
+  try {
+    walker.walk(offset, end, [&](const ContainerEntry& seek) {
+      if (seek.id != (Seek | ebmlMarker2))
+        return WalkAction::next;
+      uint64_t id = 0;
+      uint64_t position = 0;
+      bool hasPosition = false;
+      walker.walk(seek.dataOffset, seek.end(), [&](const ContainerEntry& entry) {
+        if ((entry.id == (SeekID | ebmlMarker2) || entry.id == (SeekPosition | ebmlMarker2)) && entry.size > 0 &&
+            entry.size <= 8) {
+          DataBuf value = walker.readPayload(entry, 8);
+          uint64_t number = 0;
+          for (auto b : value)
+            number = (number << 8) | b;
+          if (entry.id == (SeekID | ebmlMarker2)) {
+            id = number;
+          } else {
+            position = number;
+            hasPosition = true;
+          }
+        }
+        return WalkAction::next;
+      });
+      if (id && hasPosition && position < io_->size() - segmentStart_)
+        seekEntries_.emplace_back(id, segmentStart_ + position);
+      return WalkAction::next;
+    });
+  } catch (const Error&) {
+    // The SeekHead is only an index: a damaged one does not make the file unreadable
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to decode the Matroska SeekHead at offset " << offset << ".\n";
+#endif
+  }
+}
+
+void MatroskaVideo::decodeIndexedElements() {
+  const uint64_t stop = io_->tell();
+  const bool atEnd = io_->eof() || stop >= io_->size();
+
+  // Entries are appended while iterating when a SeekHead refers to a further SeekHead
+  for (size_t i = 0; i < seekEntries_.size(); ++i) {
+    const auto [id, offset] = seekEntries_[i];
+    if (id == (SeekHead | ebmlMarker4) || isIndexedElement(id))
+      decodeElementAt(offset, id);
+  }
+  if (!seekEntries_.empty() || atEnd)
+    return;
+
+  // Without a SeekHead, follow the level 1 elements from the first Cluster or Cues to those muxers write after
+  // them. Bytes which are not part of this chain of elements, like the media data, are never decoded.
+  ContainerWalker walker(*io_, ContainerFormat::ebml);
+  walker.setTruncatedAllowed(true);
+  size_t followed = 0;
+  try {
+    walker.walk(stop, io_->size(), [&](const ContainerEntry& entry) {
+      if (entry.offset == stop && entry.id != (Cluster | ebmlMarker4) && entry.id != (Cues | ebmlMarker4))
+        return WalkAction::stop;
+      if (++followed > maxFollowedElements) {
+#ifndef SUPPRESS_WARNINGS
+        EXV_WARNING << "More than " << maxFollowedElements << " Matroska elements after offset " << stop
+                    << ": not looking further for the elements after the clusters.\n";
+#endif
+        return WalkAction::stop;
+      }
+      if (isIndexedElement(entry.id)) {
+        // An element which cannot be decoded adds none of its tags
+        const XmpData decoded = xmpData_;
+        try {
+          decodeElementAt(entry.offset, entry.id);
+        } catch (const Error&) {
+          xmpData_ = decoded;
+          throw;
+        }
+      }
+      return WalkAction::next;
+    });
+  } catch (const Error&) {
+    // The elements after the clusters are optional: damaged ones do not make the file unreadable
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Failed to decode the Matroska elements after offset " << stop << ".\n";
+#endif
+  }
+}
+
+bool MatroskaVideo::decodeElementAt(uint64_t offset, uint64_t id) {
+  if (std::find(decodedElements_.begin(), decodedElements_.end(), offset) != decodedElements_.end())
+    return false;
+
+  ContainerWalker walker(*io_, ContainerFormat::ebml);
+  walker.setTruncatedAllowed(true);
+  ContainerEntry entry;
+  if (!walker.readHeader(offset, io_->size(), 1, entry) || entry.id != id)
+    return false;
+
+  io_->seek(toSeekOffset(offset), BasicIo::beg);
+  continueTraversing_ = true;
+  while (continueTraversing_ && io_->tell() < entry.end())
+    decodeBlock();
+  return true;
+}
+
 void MatroskaVideo::decodeInternalTags(const MatroskaTag* tag, const byte* buf) {
   uint64_t key = getULongLong(buf, bigEndian);
   if (!key)
@@ -770,6 +1348,16 @@ void MatroskaVideo::decodeStringTags(const MatroskaTag* tag, const byte* buf) {
   } else {
     xmpData_[tag->_label] = buf;
   }
+
+  // The value of a SimpleTag follows its name
+  const std::string value(reinterpret_cast<const char*>(buf));
+  if (tag->_id == Xmp_video_TagName) {
+    simpleTagName_ = value;
+  } else if (tag->_id == Xmp_video_TagString) {
+    for (auto&& [name, key] : simpleTagProperties)
+      if (simpleTagName_ == name)
+        xmpData_[key] = value;
+  }
 }
 
 void MatroskaVideo::decodeIntegerTags(const MatroskaTag* tag, const byte* buf) {
@@ -30,4 +30,21 @@ bool cmpMetadataByKey(const Metadatum& lhs, const Metadatum& rhs) {
   return lhs.key() < rhs.key();
 }
 
+uint64_t digest(const CanonicalMetadata& metadata) {
+  // 64-bit FNV-1a, over the keys and values, each terminated by a null character
+  uint64_t hash = 0xcbf29ce484222325;
+  auto add = [&hash](const std::string& text) {
+    for (auto c : text) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 0x100000001b3;
+    }
+    hash *= 0x100000001b3;
+  };
+  for (const auto& [key, value] : metadata) {
+    add(key);
+    add(value);
+  }
+  return hash;
+}
+
 }  // namespace Exiv2
@@ -4,6 +4,7 @@
 #include "pgfimage.hpp"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
 #include "config.h"
 #include "enforce.hpp"
 #include "error.hpp"
@@ -108,14 +109,10 @@ void PgfImage::readMetadata() {
   if (size == 0)
     return;
 
-  DataBuf imgData(size);
-  const size_t bufRead = io_->read(imgData.data(), imgData.size());
-  if (io_->error())
-    throw Error(ErrorCode::kerFailedToReadImageData);
-  if (bufRead != imgData.size())
-    throw Error(ErrorCode::kerInputDataReadFailed);
-
-  auto image = Exiv2::ImageFactory::open(imgData.c_data(), imgData.size());
+  // Parse the metadata image in place, it is usually a PNG image
+  auto image = ImageFactory::open(std::make_unique<Internal::WindowIo>(*io_, io_->tell(), size));
+  if (!image)
+    throw Error(ErrorCode::kerMemoryContainsUnknownImageType);
   image->readMetadata();
   exifData() = image->exifData();
   iptcData() = image->iptcData();
@@ -156,12 +153,20 @@ void PgfImage::doWriteMetadata(BasicIo& outIo) {
   // Ensure PGF version.
   byte mnb = readPgfMagicNumber(*io_);
 
-  readPgfHeaderSize(*io_);
+  size_t headerSize = readPgfHeaderSize(*io_);
 
   uint32_t w = 0;
   uint32_t h = 0;
   DataBuf header = readPgfHeaderStructure(*io_, w, h);
 
+  // The old metadata image ends where the compressed image data starts
+  Internal::enforce(headerSize <= std::numeric_limits<size_t>::max() - 8, ErrorCode::kerCorruptedMetadata);
+  const size_t dataStart = headerSize + 8;
+  if (dataStart < io_->tell() || dataStart > io_->size())
+    throw Error(ErrorCode::kerInputDataReadFailed);
+
+  // The metadata image is built in memory: its size is written in the PGF header before it. It only holds the
+  // metadata and a 1x1 pixel image, unlike the compressed image data which is copied in chunks below.
   auto img = ImageFactory::create(ImageType::png);
 
   img->setExifData(exifData_);
@@ -169,7 +174,6 @@ void PgfImage::doWriteMetadata(BasicIo& outIo) {
   img->setXmpData(xmpData_);
   img->writeMetadata();
   size_t imgSize = img->io().size();
-  DataBuf imgBuf = img->io().read(imgSize);
 
 #ifdef EXIV2_DEBUG_MESSAGES
   std::cout << "Exiv2::PgfImage::doWriteMetadata: Creating image to host metadata (" << imgSize << " bytes)\n";
@@ -207,18 +211,10 @@ void PgfImage::doWriteMetadata(BasicIo& outIo) {
     throw Error(ErrorCode::kerImageWriteFailed);
 
   // Write new metadata byte array.
-  if (outIo.write(imgBuf.c_data(), imgBuf.size()) != imgBuf.size())
-    throw Error(ErrorCode::kerImageWriteFailed);
+  Internal::copyRange(img->io(), 0, imgSize, outIo);
 
-  // Copy the rest of PGF image data.
-
-  DataBuf buf(4096);
-  size_t readSize = io_->read(buf.data(), buf.size());
-  while (readSize != 0) {
-    if (outIo.write(buf.c_data(), readSize) != readSize)
-      throw Error(ErrorCode::kerImageWriteFailed);
-    readSize = io_->read(buf.data(), buf.size());
-  }
+  // Splice in the compressed PGF image data, skipping the old metadata image.
+  Internal::copyRange(*io_, dataStart, io_->size() - dataStart, outIo);
   if (outIo.error())
     throw Error(ErrorCode::kerImageWriteFailed);
 
@@ -7,6 +7,8 @@
 #include <zlib.h>  // To uncompress IccProfiles
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
+#include "containerwalker_int.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
@@ -369,19 +371,6 @@ void PngImage::printStructure(std::ostream& out, PrintStructureOption option, si
   }
 }
 
-static void readChunk(DataBuf& buffer, BasicIo& io) {
-#ifdef EXIV2_DEBUG_MESSAGES
-  std::cout << "Exiv2::PngImage::readMetadata: Position: " << io.tell() << '\n';
-#endif
-  const size_t bufRead = io.read(buffer.data(), buffer.size());
-  if (io.error()) {
-    throw Error(ErrorCode::kerFailedToReadImageData);
-  }
-  if (bufRead != buffer.size()) {
-    throw Error(ErrorCode::kerInputDataReadFailed);
-  }
-}
-
 void PngImage::readMetadata() {
 #ifdef EXIV2_DEBUG_MESSAGES
   std::cerr << "Exiv2::PngImage::readMetadata: Reading PNG file " << io_->path() << '\n';
@@ -396,77 +385,57 @@ void PngImage::readMetadata() {
   clearMetadata();
 
   const size_t imgSize = io_->size();
-  DataBuf cheaderBuf(8);  // Chunk header: 4 bytes (data size) + 4 bytes (chunk type).
-
-  while (!io_->eof()) {
-    readChunk(cheaderBuf, *io_);  // Read chunk header.
-
-    // Decode chunk data length.
-    uint32_t chunkLength = cheaderBuf.read_uint32(0, Exiv2::bigEndian);
-    if (chunkLength > imgSize - io_->tell()) {
-      throw Exiv2::Error(ErrorCode::kerFailedToReadImageData);
-    }
-
-    std::string chunkType(cheaderBuf.c_str(4), 4);
+  ContainerWalker walker(*io_, ContainerFormat::png, 0, ErrorCode::kerFailedToReadImageData);
+  const bool complete = !walker.walk(pngSignature.size(), imgSize, [&](const ContainerEntry& chunk) {
 #ifdef EXIV2_DEBUG_MESSAGES
-    std::cout << "Exiv2::PngImage::readMetadata: chunk type: " << chunkType << " length: " << chunkLength << '\n';
+    std::cout << "Exiv2::PngImage::readMetadata: chunk type: " << fourccToString(chunk.id)
+              << " length: " << chunk.size << '\n';
 #endif
+    if (chunk.id == fourcc("IEND")) {
+      return WalkAction::stop;  // Last chunk found: we stop parsing.
+    }
 
     /// \todo analyse remaining chunks of the standard
-    // Perform a chunk triage for item that we need.
-    if (chunkType == "IEND" || chunkType == "IHDR" || chunkType == "tEXt" || chunkType == "zTXt" ||
-        chunkType == "eXIf" || chunkType == "iTXt" || chunkType == "iCCP") {
-      DataBuf chunkData(chunkLength);
-      if (chunkLength > 0) {
-        readChunk(chunkData, *io_);  // Extract chunk data.
-      }
-
-      if (chunkType == "IEND") {
-        return;  // Last chunk found: we stop parsing.
-      }
-      if (chunkType == "IHDR" && chunkData.size() >= 8) {
-        PngChunk::decodeIHDRChunk(chunkData, &pixelWidth_, &pixelHeight_);
-      } else if (chunkType == "tEXt") {
-        PngChunk::decodeTXTChunk(this, chunkData, PngChunk::tEXt_Chunk);
-      } else if (chunkType == "zTXt") {
-        PngChunk::decodeTXTChunk(this, chunkData, PngChunk::zTXt_Chunk);
-      } else if (chunkType == "iTXt") {
-        PngChunk::decodeTXTChunk(this, chunkData, PngChunk::iTXt_Chunk);
-      } else if (chunkType == "eXIf") {
-        ByteOrder bo = TiffParser::decode(exifData(), iptcData(), xmpData(), chunkData.c_data(), chunkData.size());
-        setByteOrder(bo);
-      } else if (chunkType == "iCCP") {
-        // The ICC profile name can vary from 1-79 characters.
-        uint32_t iccOffset = 0;
-        do {
-          enforce(iccOffset < 80 && iccOffset < chunkLength, Exiv2::ErrorCode::kerCorruptedMetadata);
-        } while (chunkData.read_uint8(iccOffset++) != 0x00);
-
-        profileName_ = std::string(chunkData.c_str(), iccOffset - 1);
-        ++iccOffset;  // +1 = 'compressed' flag
-        enforce(iccOffset <= chunkLength, Exiv2::ErrorCode::kerCorruptedMetadata);
-
-        zlibToDataBuf(chunkData.c_data(iccOffset), static_cast<uLongf>(chunkLength - iccOffset), iccProfile_);
-#ifdef EXIV2_DEBUG_MESSAGES
-        std::cout << "Exiv2::PngImage::readMetadata: profile name: " << profileName_ << '\n';
-        std::cout << "Exiv2::PngImage::readMetadata: iccProfile.size_ (uncompressed) : " << iccProfile_.size() << '\n';
-#endif
-      }
-
-      // Set chunkLength to 0 in case we have read a supported chunk type. Otherwise, we need to seek the
-      // file to the next chunk position.
-      chunkLength = 0;
+    // Perform a chunk triage for item that we need. Other chunks are skipped without reading them.
+    if (chunk.id != fourcc("IHDR") && chunk.id != fourcc("tEXt") && chunk.id != fourcc("zTXt") &&
+        chunk.id != fourcc("eXIf") && chunk.id != fourcc("iTXt") && chunk.id != fourcc("iCCP")) {
+      return WalkAction::next;
     }
 
-    // Move to the next chunk: chunk data size + 4 CRC bytes.
+    DataBuf chunkData = walker.readPayload(chunk, imgSize);
+    if (chunk.id == fourcc("IHDR") && chunkData.size() >= 8) {
+      PngChunk::decodeIHDRChunk(chunkData, &pixelWidth_, &pixelHeight_);
+    } else if (chunk.id == fourcc("tEXt")) {
+      PngChunk::decodeTXTChunk(this, chunkData, PngChunk::tEXt_Chunk);
+    } else if (chunk.id == fourcc("zTXt")) {
+      PngChunk::decodeTXTChunk(this, chunkData, PngChunk::zTXt_Chunk);
+    } else if (chunk.id == fourcc("iTXt")) {
+      PngChunk::decodeTXTChunk(this, chunkData, PngChunk::iTXt_Chunk);
+    } else if (chunk.id == fourcc("eXIf")) {
+      ByteOrder bo = TiffParser::decode(exifData(), iptcData(), xmpData(), chunkData.c_data(), chunkData.size());
+      setByteOrder(bo);
+    } else if (chunk.id == fourcc("iCCP")) {
+      // The ICC profile name can vary from 1-79 characters.
+      size_t iccOffset = 0;
+      do {
+        enforce(iccOffset < 80 && iccOffset < chunkData.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
+      } while (chunkData.read_uint8(iccOffset++) != 0x00);
+
+      profileName_ = std::string(chunkData.c_str(), iccOffset - 1);
+      ++iccOffset;  // +1 = 'compressed' flag
+      enforce(iccOffset <= chunkData.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
+
+      zlibToDataBuf(chunkData.c_data(iccOffset), static_cast<uLongf>(chunkData.size() - iccOffset), iccProfile_);
 #ifdef EXIV2_DEBUG_MESSAGES
-    std::cout << "Exiv2::PngImage::readMetadata: Seek to offset: " << chunkLength + 4 << '\n';
+      std::cout << "Exiv2::PngImage::readMetadata: profile name: " << profileName_ << '\n';
+      std::cout << "Exiv2::PngImage::readMetadata: iccProfile.size_ (uncompressed) : " << iccProfile_.size() << '\n';
 #endif
-    io_->seek(chunkLength + 4, BasicIo::cur);
-    if (io_->error() || io_->eof()) {
-      throw Error(ErrorCode::kerFailedToReadImageData);
     }
-  }
+    return WalkAction::next;
+  });
+  // The file ended before the IEND chunk
+  if (!complete)
+    throw Error(ErrorCode::kerInputDataReadFailed);
 }  // PngImage::readMetadata
 
 void PngImage::writeMetadata() {
@@ -517,6 +486,33 @@ void PngImage::doWriteMetadata(BasicIo& outIo) {
     if (dataOffset > 0x7FFFFFFF)
       throw Exiv2::Error(ErrorCode::kerFailedToReadImageData);
 
+    const std::string szChunk(cheaderBuf.begin() + 4, cheaderBuf.end());
+
+    if (szChunk != "IEND" && szChunk != "IHDR" && szChunk != "tEXt" && szChunk != "zTXt" && szChunk != "iTXt") {
+      // The content of these chunks is not inspected: skip or copy them without loading them,
+      // so that large IDAT chunks never need to be held in memory.
+      const size_t chunkStart = io_->tell() - 8;
+      if (dataOffset + 4 > io_->size() - io_->tell())
+        throw Error(ErrorCode::kerInputDataReadFailed);
+      if (szChunk == "eXIf" || szChunk == "iCCP") {
+        // do nothing (strip): Exif metadata is written following IHDR
+        // together with the ICC profile as fresh eXIf and iCCP chunks
+#ifdef EXIV2_DEBUG_MESSAGES
+        std::cout << "Exiv2::PngImage::doWriteMetadata: strip " << szChunk << " chunk (length: " << dataOffset << ")"
+                  << '\n';
+#endif
+        io_->seekOrThrow(chunkStart + 8 + dataOffset + 4, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+      } else {
+        // Write all others chunk as well.
+#ifdef EXIV2_DEBUG_MESSAGES
+        std::cout << "Exiv2::PngImage::doWriteMetadata:  copy " << szChunk << " chunk (length: " << dataOffset << ")"
+                  << '\n';
+#endif
+        Internal::copyRange(*io_, chunkStart, 8 + dataOffset + 4, outIo);
+      }
+      continue;
+    }
+
     // Read whole chunk : Chunk header + Chunk data (not fixed size - can be null) + CRC (4 bytes).
 
     DataBuf chunkBuf(8 + dataOffset + 4);  // Chunk header (8 bytes) + Chunk data + CRC (4 bytes).
@@ -527,8 +523,6 @@ void PngImage::doWriteMetadata(BasicIo& outIo) {
     if (bufRead != dataOffset + 4)
       throw Error(ErrorCode::kerInputDataReadFailed);
 
-    const std::string szChunk(cheaderBuf.begin() + 4, cheaderBuf.end());
-
     if (szChunk == "IEND") {
       // Last chunk found: we write it and done.
 #ifdef EXIV2_DEBUG_MESSAGES
@@ -538,14 +532,7 @@ void PngImage::doWriteMetadata(BasicIo& outIo) {
         throw Error(ErrorCode::kerImageWriteFailed);
       return;
     }
-    if (szChunk == "eXIf" || szChunk == "iCCP") {
-      // do nothing (strip): Exif metadata is written following IHDR
-      // together with the ICC profile as fresh eXIf and iCCP chunks
-#ifdef EXIV2_DEBUG_MESSAGES
-      std::cout << "Exiv2::PngImage::doWriteMetadata: strip " << szChunk << " chunk (length: " << dataOffset << ")"
-                << '\n';
-#endif
-    } else if (szChunk == "IHDR") {
+    if (szChunk == "IHDR") {
 #ifdef EXIV2_DEBUG_MESSAGES
       std::cout << "Exiv2::PngImage::doWriteMetadata: Write IHDR chunk (length: " << dataOffset << ")\n";
 #endif
@@ -659,14 +646,6 @@ void PngImage::doWriteMetadata(BasicIo& outIo) {
         if (outIo.write(chunkBuf.c_data(), chunkBuf.size()) != chunkBuf.size())
           throw Error(ErrorCode::kerImageWriteFailed);
       }
-    } else {
-      // Write all others chunk as well.
-#ifdef EXIV2_DEBUG_MESSAGES
-      std::cout << "Exiv2::PngImage::doWriteMetadata:  copy " << szChunk << " chunk (length: " << dataOffset << ")"
-                << '\n';
-#endif
-      if (outIo.write(chunkBuf.c_data(), chunkBuf.size()) != chunkBuf.size())
-        throw Error(ErrorCode::kerImageWriteFailed);
     }
   }
 
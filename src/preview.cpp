@@ -721,7 +721,7 @@ DataBuf LoaderTiff::getData() const {
         // this saves one copying of the buffer
         uint32_t offset = dataValue.toUint32(0);
         uint32_t size = sizes.toUint32(0);
-        if (Safe::add(offset, size) <= static_cast<uint32_t>(io.size()))
+        if (Safe::add(offset, size) <= io.size())
           dataValue.setDataArea(base + offset, size);
       } else {
         // FIXME: the buffer is probably copied twice, it should be optimized
@@ -737,7 +737,7 @@ DataBuf LoaderTiff::getData() const {
           // But e.g in malicious files some of these values could be negative
           // That's why we check again for each step here to really make sure we don't overstep
           Internal::enforce(Safe::add(idxBuf, size) <= size_, ErrorCode::kerCorruptedMetadata);
-          if (size != 0 && Safe::add(offset, size) <= static_cast<uint32_t>(io.size())) {
+          if (size != 0 && Safe::add(offset, size) <= io.size()) {
             std::copy_n(base + offset, size, buf.begin() + idxBuf);
           }
 
@@ -22,18 +22,26 @@
 #include "config.h"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
+#include "containerwalker_int.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
 #include "helper_functions.hpp"
+#include "image_int.hpp"
 #include "quicktimevideo.hpp"
 #include "safe_op.hpp"
 #include "tags.hpp"
 #include "tags_int.hpp"
 // + standard includes
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <limits>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 // *****************************************************************************
 // class member definitions
 namespace Exiv2::Internal {
@@ -480,6 +488,14 @@ enum imageDescTags {
   BitDepth
 };
 enum audioDescTags { AudioFormat, AudioVendorID = 4, AudioChannels, AudioSampleRate = 7, MOV_AudioFormat = 13 };
+//! Number of bytes read by imageDescDecoder() and audioDescDecoder() for each sample description
+static constexpr size_t sampleDescReadSize = 4 + 82;
+//! UUID of the top-level box holding the XMP packet, from the XMP specification part 3
+static constexpr std::array<byte, 16> xmpUuid{
+    0xbe, 0x7a, 0xcf, 0xcb, 0x97, 0xa9, 0x42, 0xe8, 0x9c, 0x71, 0x99, 0x94, 0x91, 0xe3, 0xaf, 0xac,
+};
+//! Top-level atoms up to this size are read into memory at once, larger ones are decoded from the file
+static constexpr uint64_t maxBulkAtomSize = 64 * 1024 * 1024;
 
 /*!
   @brief Function used to check equality of a Tags with a
@@ -529,6 +545,82 @@ static bool dataIgnoreList(Exiv2::DataBuf& buf) {
 
   return false;
 }
+
+//! Number of sample table entries read at once by SampleTable
+static constexpr size_t sampleTableBatchSize = 4096;
+//! Chunks of timed metadata samples up to this size are read at once, the samples of larger ones one by one
+static constexpr uint64_t maxSampleChunkSize = 16 * 1024 * 1024;
+//! Largest sample description table of a timed metadata track
+static constexpr size_t maxSampleDescSize = 1024 * 1024;
+
+/*!
+  @brief Sequential reader of the entries of a sample table atom: stts, stsc, stsz, stco or co64.
+      The entries are read in batches, never the whole table at once.
+ */
+class SampleTable {
+ public:
+  SampleTable() = default;
+
+  /*!
+    @brief Constructor.
+    @param io         File containing the table. Not owned.
+    @param atom       The table atom.
+    @param headerSize Size of the fields preceding the entries. The number of entries is the last one.
+    @param entrySize  Size of an entry.
+
+    The entries are checked against the size of the table when they are read: the sample size
+    table has no entries if all samples have the same size.
+   */
+  SampleTable(BasicIo& io, const ContainerEntry& atom, size_t headerSize, size_t entrySize) :
+      io_(&io), header_(headerSize), entrySize_(entrySize), next_(atom.dataOffset + headerSize), end_(atom.end()) {
+    enforce(atom.size >= headerSize, ErrorCode::kerCorruptedMetadata);
+    io.seekOrThrow(toSeekOffset(atom.dataOffset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+    io.readOrThrow(header_.data(), header_.size(), ErrorCode::kerCorruptedMetadata);
+    count_ = header_.read_uint32(headerSize - 4, bigEndian);
+  }
+
+  //! Header field at \em offset
+  [[nodiscard]] uint32_t field(size_t offset) const {
+    return header_.read_uint32(offset, bigEndian);
+  }
+
+  //! Number of entries
+  [[nodiscard]] uint32_t count() const {
+    return count_;
+  }
+
+  //! Whether all entries have been read
+  [[nodiscard]] bool atEnd() const {
+    return read_ == count_;
+  }
+
+  //! The next entry. Must not be called at the end.
+  const byte* next() {
+    if (position_ == buffered_) {
+      buffered_ = std::min<uint64_t>(sampleTableBatchSize, count_ - read_);
+      buffer_.alloc(buffered_ * entrySize_);
+      enforce(buffer_.size() <= end_ - next_, ErrorCode::kerCorruptedMetadata);
+      io_->seekOrThrow(toSeekOffset(next_), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+      io_->readOrThrow(buffer_.data(), buffer_.size(), ErrorCode::kerCorruptedMetadata);
+      next_ += buffer_.size();
+      position_ = 0;
+    }
+    ++read_;
+    return buffer_.c_data(entrySize_ * position_++);
+  }
+
+ private:
+  BasicIo* io_{nullptr};
+  DataBuf header_;
+  size_t entrySize_{1};
+  uint32_t count_{0};
+  uint64_t read_{0};
+  uint64_t next_{0};
+  uint64_t end_{0};
+  DataBuf buffer_;
+  size_t buffered_{0};
+  size_t position_{0};
+};  // class SampleTable
 }  // namespace Exiv2::Internal
 
 namespace Exiv2 {
@@ -536,18 +628,330 @@ namespace Exiv2 {
 using namespace Exiv2::Internal;
 
 QuickTimeVideo::QuickTimeVideo(BasicIo::UniquePtr io, size_t max_recursion_depth) :
-    Image(ImageType::qtime, mdNone, std::move(io)),
+    Image(ImageType::qtime, mdXmp, std::move(io)),
     timeScale_(1),
     currentStream_(Null),
     max_recursion_depth_(max_recursion_depth) {
 }  // QuickTimeVideo::QuickTimeVideo
 
+void QuickTimeVideo::computeFrameRate(bool flag) {
+  computeFrameRate_ = flag;
+}
+
+bool QuickTimeVideo::computeFrameRate() const {
+  return computeFrameRate_;
+}
+
 std::string QuickTimeVideo::mimeType() const {
   return "video/quicktime";
 }
 
 void QuickTimeVideo::writeMetadata() {
-}
+  if (io_->open() != 0)
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  IoCloser closer(*io_);
+  if (!isQTimeType(*io_, false))
+    throw Error(ErrorCode::kerNoImageInInputData);
+
+  // Xmp.video and Xmp.audio properties describe the streams and are recomputed when reading,
+  // changes to them cannot be stored
+  if (!writeXmpFromPacket()) {
+    enforceXmpStored(xmpData_, readXmpData_, [](const std::string& key) {
+      return key.rfind("Xmp.video.", 0) != 0 && key.rfind("Xmp.audio.", 0) != 0;
+    });
+    XmpData xmpData = xmpData_;
+    for (auto it = xmpData.begin(); it != xmpData.end();) {
+      if (it->groupName() == "video" || it->groupName() == "audio")
+        it = xmpData.erase(it);
+      else
+        ++it;
+    }
+    if (XmpParser::encode(xmpPacket_, xmpData) > 1) {
+#ifndef SUPPRESS_WARNINGS
+      EXV_WARNING << "Failed to encode XMP metadata.\n";
+#endif
+      throw Error(ErrorCode::kerImageWriteFailed);
+    }
+  }
+
+  // Runs of adjacent free, skip and XMP atoms are the space that can be reused in place
+  struct Run {
+    uint64_t offset;
+    uint64_t size;
+    bool hasXmp;
+  };
+  std::vector<Run> runs;
+  std::optional<uint64_t> xmpOffset;
+  ContainerEntry last;
+  ContainerWalker walker(*io_, ContainerFormat::bmff, 0);
+  walker.setTruncatedAllowed(true);
+  walker.walk(0, io_->size(), [&](const ContainerEntry& atom) {
+    last = atom;
+    bool isXmp = false;
+    if (atom.id == fourcc("uuid") && atom.size >= xmpUuid.size()) {
+      std::array<byte, 16> uuid;
+      io_->seekOrThrow(toSeekOffset(atom.dataOffset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+      io_->readOrThrow(uuid.data(), uuid.size());
+      isXmp = uuid == xmpUuid;
+    }
+    if (isXmp && !xmpOffset)
+      xmpOffset = atom.offset;
+    if (isXmp || atom.id == fourcc("free") || atom.id == fourcc("skip")) {
+      if (!runs.empty() && runs.back().offset + runs.back().size == atom.offset) {
+        runs.back().size += atom.end() - atom.offset;
+        runs.back().hasXmp |= isXmp;
+      } else {
+        runs.push_back({atom.offset, atom.end() - atom.offset, isXmp});
+      }
+    }
+    return WalkAction::next;
+  });
+
+  const auto writeOrThrow = [this](uint64_t offset, const byte* data, size_t size) {
+    io_->seekOrThrow(toSeekOffset(offset), BasicIo::beg, ErrorCode::kerImageWriteFailed);
+    if (io_->write(data, size) != size)
+      throw Error(ErrorCode::kerImageWriteFailed);
+  };
+  // Header of a free atom of the given total size, with a 64-bit size if needed
+  const auto writeFree = [&](uint64_t offset, uint64_t size) {
+    std::array<byte, 16> header{};
+    size_t headerSize = 8;
+    if (size > std::numeric_limits<uint32_t>::max()) {
+      headerSize = 16;
+      ul2Data(header.data(), 1, bigEndian);
+      ull2Data(header.data() + 8, size, bigEndian);
+    } else {
+      ul2Data(header.data(), static_cast<uint32_t>(size), bigEndian);
+    }
+    ul2Data(header.data() + 4, fourcc("free"), bigEndian);
+    writeOrThrow(offset, header.data(), headerSize);
+  };
+
+  Blob box;
+  if (!xmpPacket_.empty()) {
+    const size_t boxSize = 8 + xmpUuid.size() + xmpPacket_.size();
+    enforce(boxSize <= std::numeric_limits<uint32_t>::max(), ErrorCode::kerImageWriteFailed);
+    box.resize(8);
+    ul2Data(box.data(), static_cast<uint32_t>(boxSize), bigEndian);
+    ul2Data(box.data() + 4, fourcc("uuid"), bigEndian);
+    box.insert(box.end(), xmpUuid.begin(), xmpUuid.end());
+    box.insert(box.end(), xmpPacket_.begin(), xmpPacket_.end());
+  }
+
+  // Prefer the run with the current XMP box, then the first one large enough. The rest of the
+  // run, if any, becomes a free atom.
+  const auto fits = [&box](const Run& run) { return run.size == box.size() || run.size >= box.size() + 8; };
+  auto run = std::find_if(runs.begin(), runs.end(), [&](const Run& r) { return r.hasXmp && fits(r); });
+  if (run == runs.end())
+    run = std::find_if(runs.begin(), runs.end(), fits);
+
+  // All checks are done before the first write, and the current XMP box is only given up once
+  // the new box has been written, such that a failure never leaves the file without XMP.
+  // No room in the file means the box is appended after the last atom, over trailing bytes too
+  // short for an atom. An atom extending to the end of the file, or cut short by it, gets its
+  // actual size then, which must fit into its 32-bit header unless it has a 64-bit one.
+  const bool append = !box.empty() && run == runs.end();
+  const bool largeSize = last.dataOffset - last.offset == 16;
+  std::optional<uint64_t> lastSize;
+  if (append && (last.unknownSize || last.truncated)) {
+    lastSize = last.end() - last.offset;
+    enforce(largeSize || *lastSize <= std::numeric_limits<uint32_t>::max(), ErrorCode::kerImageWriteFailed);
+  }
+
+  if (append) {
+    // The media data stays where it is, so the chunk offsets in moov remain valid
+    if (lastSize && largeSize) {
+      std::array<byte, 8> header;
+      ull2Data(header.data(), *lastSize, bigEndian);
+      writeOrThrow(last.offset + 8, header.data(), header.size());
+    } else if (lastSize) {
+      std::array<byte, 4> header;
+      ul2Data(header.data(), static_cast<uint32_t>(*lastSize), bigEndian);
+      writeOrThrow(last.offset, header.data(), header.size());
+    }
+    writeOrThrow(last.end(), box.data(), box.size());
+  } else if (!box.empty()) {
+    writeOrThrow(run->offset, box.data(), box.size());
+    if (run->size > box.size())
+      writeFree(run->offset + box.size(), run->size - box.size());
+  }
+
+  if (xmpOffset && (box.empty() || append || !run->hasXmp)) {
+    // The current XMP box was not reused: turn it into a free atom
+    std::array<byte, 4> type;
+    ul2Data(type.data(), fourcc("free"), bigEndian);
+    writeOrThrow(*xmpOffset + 4, type.data(), type.size());
+  }
+}  // QuickTimeVideo::writeMetadata
+
+uint64_t QuickTimeVideo::readTimedMetadata(const TimedMetadataCallback& callback) {
+  if (io_->open() != 0)
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  IoCloser closer(*io_);
+  if (!isQTimeType(*io_, false))
+    throw Error(ErrorCode::kerNotAnImage, "QuickTime");
+
+  struct Track {
+    uint32_t id{0};
+    uint32_t timeScale{0};
+    uint32_t handler{0};
+    std::vector<std::string> formats;
+    std::optional<ContainerEntry> stts, stsc, stsz, stco;
+  };
+
+  // The sample tables of each track are located from the atom headers, the media data is skipped
+  std::vector<Track> tracks;
+  ContainerWalker walker(*io_, ContainerFormat::bmff);
+  walker.setTruncatedAllowed(true);
+  walker.walk(0, io_->size(), [&](const ContainerEntry& atom) {
+    if (atom.id == fourcc("moov") || atom.id == fourcc("mdia") || atom.id == fourcc("minf") ||
+        atom.id == fourcc("stbl"))
+      return WalkAction::descend;
+    if (atom.id == fourcc("trak")) {
+      tracks.emplace_back();
+      return WalkAction::descend;
+    }
+    if (tracks.empty() || atom.depth < 2)
+      return WalkAction::next;
+    Track& track = tracks.back();
+    // Version 1 of the track and media headers has 64-bit times
+    if (atom.id == fourcc("tkhd") || atom.id == fourcc("mdhd")) {
+      const DataBuf header = walker.readPayload(atom, 256);
+      const size_t offset = header.size() > 0 && header.read_uint8(0) == 1 ? 20 : 12;
+      enforce(header.size() >= offset + 4, ErrorCode::kerCorruptedMetadata);
+      if (atom.id == fourcc("tkhd"))
+        track.id = header.read_uint32(offset, bigEndian);
+      else
+        track.timeScale = header.read_uint32(offset, bigEndian);
+    } else if (atom.id == fourcc("hdlr")) {
+      const DataBuf handler = walker.readPayload(atom, 1024);
+      enforce(handler.size() >= 12, ErrorCode::kerCorruptedMetadata);
+      track.handler = handler.read_uint32(8, bigEndian);
+    } else if (atom.id == fourcc("stsd")) {
+      const DataBuf table = walker.readPayload(atom, maxSampleDescSize);
+      enforce(table.size() >= 8, ErrorCode::kerCorruptedMetadata);
+      const uint32_t count = table.read_uint32(4, bigEndian);
+      for (size_t offset = 8; track.formats.size() < count && table.size() - offset >= 8;) {
+        const uint32_t size = table.read_uint32(offset, bigEndian);
+        enforce(size >= 8 && size <= table.size() - offset, ErrorCode::kerCorruptedMetadata);
+        track.formats.push_back(fourccToString(table.read_uint32(offset + 4, bigEndian)));
+        offset += size;
+      }
+    } else if (atom.id == fourcc("stts")) {
+      track.stts = atom;
+    } else if (atom.id == fourcc("stsc")) {
+      track.stsc = atom;
+    } else if (atom.id == fourcc("stsz")) {
+      track.stsz = atom;
+    } else if (atom.id == fourcc("stco") || atom.id == fourcc("co64")) {
+      track.stco = atom;
+    }
+    return WalkAction::next;
+  });
+
+  const auto isTimedMetadata = [](const Track& track) {
+    if (track.handler == fourcc("meta") || track.handler == fourcc("camm"))
+      return true;
+    return std::any_of(track.formats.begin(), track.formats.end(), [](const std::string& format) {
+      return format == "gpmd" || format == "rtmd" || format == "mebx" || format == "camm";
+    });
+  };
+
+  uint64_t samples = 0;
+  DataBuf chunk;
+  std::vector<uint32_t> sizes;
+  for (const auto& track : tracks) {
+    if (!isTimedMetadata(track) || !track.stsc || !track.stsz || !track.stco)
+      continue;
+    const bool co64 = track.stco->id == fourcc("co64");
+    SampleTable chunkOffsets(*io_, *track.stco, 8, co64 ? 8 : 4);
+    SampleTable chunkRuns(*io_, *track.stsc, 8, 12);
+    SampleTable sampleSizes(*io_, *track.stsz, 12, 4);
+    const uint32_t sampleSize = sampleSizes.field(4);
+    SampleTable times;
+    if (track.stts)
+      times = SampleTable(*io_, *track.stts, 8, 8);
+
+    TimedMetadataSample sample;
+    sample.trackId = track.id;
+    sample.timeScale = track.timeScale;
+    uint64_t timeRemaining = 0;
+    uint32_t delta = 0;
+    // The current run of chunks with the same number of samples, and the first chunk of the next one
+    uint32_t samplesPerChunk = 0;
+    uint32_t description = 0;
+    uint64_t nextRun = 0;
+    uint32_t nextSamplesPerChunk = 0;
+    uint32_t nextDescription = 0;
+    const auto readRun = [&] {
+      if (chunkRuns.atEnd()) {
+        nextRun = std::numeric_limits<uint64_t>::max();
+        return;
+      }
+      const byte* entry = chunkRuns.next();
+      nextRun = getULong(entry, bigEndian);
+      nextSamplesPerChunk = getULong(entry + 4, bigEndian);
+      nextDescription = getULong(entry + 8, bigEndian);
+    };
+    readRun();
+
+    for (uint64_t chunkNumber = 1; !chunkOffsets.atEnd() && sample.index < sampleSizes.count(); ++chunkNumber) {
+      const byte* entry = chunkOffsets.next();
+      const uint64_t offset = co64 ? getULongLong(entry, bigEndian) : getULong(entry, bigEndian);
+      while (nextRun <= chunkNumber) {
+        samplesPerChunk = nextSamplesPerChunk;
+        description = nextDescription;
+        readRun();
+      }
+      sample.format = description > 0 && description <= track.formats.size() ? track.formats[description - 1] : "";
+
+      // Sizes of the samples in the chunk: the chunk is read at once unless it is too large
+      const uint64_t count = std::min<uint64_t>(samplesPerChunk, sampleSizes.count() - sample.index);
+      sizes.clear();
+      uint64_t chunkSize = count * sampleSize;
+      for (uint64_t i = 0; sampleSize == 0 && i < count; ++i) {
+        sizes.push_back(getULong(sampleSizes.next(), bigEndian));
+        chunkSize = Safe::add<uint64_t>(chunkSize, sizes.back());
+      }
+      enforce(offset <= io_->size() && chunkSize <= io_->size() - offset, ErrorCode::kerCorruptedMetadata);
+      const bool bulk = chunkSize <= maxSampleChunkSize;
+      if (bulk) {
+        chunk.alloc(static_cast<size_t>(chunkSize));
+        io_->seekOrThrow(toSeekOffset(offset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+        io_->readOrThrow(chunk.data(), chunk.size(), ErrorCode::kerCorruptedMetadata);
+      }
+
+      sample.offset = offset;
+      for (uint64_t i = 0; i < count; ++i) {
+        const uint32_t size = sampleSize != 0 ? sampleSize : sizes[i];
+        if (timeRemaining == 0 && !times.atEnd()) {
+          const byte* run = times.next();
+          timeRemaining = getULong(run, bigEndian);
+          delta = getULong(run + 4, bigEndian);
+        }
+        sample.size = size;
+        if (bulk) {
+          sample.data = chunk.c_data(static_cast<size_t>(sample.offset - offset));
+        } else {
+          enforce(size <= maxSampleChunkSize, ErrorCode::kerCorruptedMetadata);
+          chunk.alloc(size);
+          io_->seekOrThrow(toSeekOffset(sample.offset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+          io_->readOrThrow(chunk.data(), chunk.size(), ErrorCode::kerCorruptedMetadata);
+          sample.data = chunk.c_data();
+        }
+        ++samples;
+        if (!callback(sample))
+          return samples;
+        sample.offset += size;
+        sample.time += delta;
+        if (timeRemaining > 0)
+          --timeRemaining;
+        ++sample.index;
+      }
+    }
+  }
+  return samples;
+}  // QuickTimeVideo::readTimedMetadata
 
 void QuickTimeVideo::readMetadata() {
   if (io_->open() != 0)
@@ -562,19 +966,64 @@ void QuickTimeVideo::readMetadata() {
 
   IoCloser closer(*io_);
   clearMetadata();
+  readXmpData_.clear();
   continueTraversing_ = true;
   height_ = width_ = 1;
 
   xmpData_["Xmp.video.FileSize"] = static_cast<double>(io_->size()) / static_cast<double>(1048576);
   xmpData_["Xmp.video.MimeType"] = mimeType();
 
-  while (continueTraversing_)
-    decodeBlock(0);
+  // Index first: the top-level atoms are located from their headers alone, so that the media
+  // data is never read wherever moov is. The other atoms are decoded from a single read each.
+  const auto decodeUpTo = [this](BasicIo& io, uint64_t end) {
+    continueTraversing_ = true;
+    while (continueTraversing_ && io.tell() < end)
+      decodeBlock(io, 0);
+  };
+  DataBuf atomData;
+  DataBuf type(4 + 1);
+  XmpData packetData;
+  ContainerWalker walker(*io_, ContainerFormat::bmff, 0);
+  walker.setTruncatedAllowed(true);
+  walker.walk(0, io_->size(), [&](const ContainerEntry& atom) {
+    ul2Data(type.data(), static_cast<uint32_t>(atom.id), bigEndian);
+    if (ignoreList(type))
+      return WalkAction::next;
+
+    const uint64_t atomSize = atom.end() - atom.offset;
+    if (atomSize > maxBulkAtomSize) {
+      io_->seekOrThrow(toSeekOffset(atom.offset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+      decodeUpTo(*io_, atom.end());
+      return WalkAction::next;
+    }
+    atomData.resize(static_cast<size_t>(atomSize));
+    io_->seekOrThrow(toSeekOffset(atom.offset), BasicIo::beg, ErrorCode::kerCorruptedMetadata);
+    io_->readOrThrow(atomData.data(), atomData.size());
+
+    const auto headerSize = static_cast<size_t>(atom.dataOffset - atom.offset);
+    if (atom.id == fourcc("uuid") && atom.size >= xmpUuid.size() &&
+        atomData.cmpBytes(headerSize, xmpUuid.data(), xmpUuid.size()) == 0) {
+      xmpPacket_.assign(atomData.c_str(headerSize + xmpUuid.size()), atomData.size() - headerSize - xmpUuid.size());
+      if (!xmpPacket_.empty() && XmpParser::decode(packetData, xmpPacket_)) {
+#ifndef SUPPRESS_WARNINGS
+        EXV_WARNING << "Failed to decode XMP metadata.\n";
+#endif
+      }
+      return WalkAction::next;
+    }
+
+    MemIo atomIo(atomData.c_data(), atomData.size());
+    decodeUpTo(atomIo, atomSize);
+    return WalkAction::next;
+  });
 
   xmpData_["Xmp.video.AspectRatio"] = getAspectRatio(width_, height_);
+  for (const auto& xmp : packetData)
+    xmpData_.add(xmp);
+  readXmpData_ = xmpData_;
 }  // QuickTimeVideo::readMetadata
 
-void QuickTimeVideo::decodeBlock(size_t recursion_depth, std::string const& entered_from) {
+void QuickTimeVideo::decodeBlock(BasicIo& io, size_t recursion_depth, std::string const& entered_from) {
   enforce(recursion_depth < max_recursion_depth_, Exiv2::ErrorCode::kerCorruptedMetadata);
 
   const long bufMinSize = 4;
@@ -582,15 +1031,15 @@ void QuickTimeVideo::decodeBlock(size_t recursion_depth, std::string const& ente
   uint64_t size = 0;
   buf.data()[4] = '\0';
 
-  io_->read(buf.data(), 4);
-  if (io_->eof()) {
+  io.read(buf.data(), 4);
+  if (io.eof()) {
     continueTraversing_ = false;
     return;
   }
 
   size = buf.read_uint32(0, bigEndian);
 
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
 
   // we have read 2x 4 bytes
   size_t hdrsize = 8;
@@ -599,249 +1048,258 @@ void QuickTimeVideo::decodeBlock(size_t recursion_depth, std::string const& ente
     // The box size is encoded as a uint64_t, so we need to read another 8 bytes.
     DataBuf data(8);
     hdrsize += 8;
-    io_->readOrThrow(data.data(), data.size());
+    io.readOrThrow(data.data(), data.size());
     size = data.read_uint64(0, bigEndian);
   } else if (size == 0 && entered_from == "meta") {
     size = buf.read_uint32(0, bigEndian);
-    io_->readOrThrow(buf.data(), 4, Exiv2::ErrorCode::kerCorruptedMetadata);
+    io.readOrThrow(buf.data(), 4, Exiv2::ErrorCode::kerCorruptedMetadata);
   }
 
   enforce(size >= hdrsize, Exiv2::ErrorCode::kerCorruptedMetadata);
-  enforce(size - hdrsize <= io_->size() - io_->tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
+  enforce(size - hdrsize <= io.size() - io.tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
   enforce(size - hdrsize <= std::numeric_limits<size_t>::max(), Exiv2::ErrorCode::kerCorruptedMetadata);
 
   // std::cerr<<"Tag=>"<<buf.data()<<"     size=>"<<size-hdrsize << '\n';
+  // buf only holds the atom type: the atom data is read by the decoders, or skipped
+  // without loading it, which matters for media data atoms of several GB
   const auto newsize = static_cast<size_t>(size - hdrsize);
-  if (newsize > buf.size()) {
-    buf.resize(newsize);
-  }
-  tagDecoder(buf, newsize, recursion_depth + 1);
+  tagDecoder(io, buf, newsize, recursion_depth + 1);
 }  // QuickTimeVideo::decodeBlock
 
+// Read the whole atom data at once, for decoders which pick fields from it
+static DataBuf readAtomData(BasicIo& io, size_t size) {
+  enforce(size <= io.size() - io.tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
+  DataBuf data(size);
+  if (size > 0)
+    io.readOrThrow(data.data(), size);
+  return data;
+}
+
 static std::string readString(BasicIo& io, size_t size) {
   enforce(size <= io.size() - io.tell(), Exiv2::ErrorCode::kerCorruptedMetadata);
-  Exiv2::DataBuf str(size + 1);
-  io.readOrThrow(str.data(), size);
-  str.write_uint8(size, 0);  // nul-terminate string
-  return Exiv2::toString(str.data());
+  std::string str(size, '\0');
+  if (size > 0)
+    io.readOrThrow(reinterpret_cast<byte*>(str.data()), size);
+  str.erase(std::find(str.begin(), str.end(), '\0'), str.end());  // up to the first nul
+  return str;
 }
 
-void QuickTimeVideo::tagDecoder(Exiv2::DataBuf& buf, size_t size, size_t recursion_depth) {
+void QuickTimeVideo::tagDecoder(BasicIo& io, Exiv2::DataBuf& buf, size_t size, size_t recursion_depth) {
   enforce(recursion_depth < max_recursion_depth_, Exiv2::ErrorCode::kerCorruptedMetadata);
   assert(buf.size() > 4);
 
   if (ignoreList(buf))
-    discard(size);
+    discard(io, size);
 
   else if (dataIgnoreList(buf)) {
-    decodeBlock(recursion_depth + 1, Exiv2::toString(buf.data()));
+    decodeBlock(io, recursion_depth + 1, Exiv2::toString(buf.data()));
   } else if (equalsQTimeTag(buf, "ftyp"))
-    fileTypeDecoder(size);
+    fileTypeDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "trak"))
-    setMediaStream();
+    setMediaStream(io, size);
 
   else if (equalsQTimeTag(buf, "mvhd"))
-    movieHeaderDecoder(size);
+    movieHeaderDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "tkhd"))
-    trackHeaderDecoder(size);
+    trackHeaderDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "mdhd"))
-    mediaHeaderDecoder(size);
+    mediaHeaderDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "hdlr"))
-    handlerDecoder(size);
+    handlerDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "vmhd"))
-    videoHeaderDecoder(size);
+    videoHeaderDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "udta"))
-    userDataDecoder(size, recursion_depth + 1);
+    userDataDecoder(io, size, recursion_depth + 1);
 
   else if (equalsQTimeTag(buf, "dref"))
-    multipleEntriesDecoder(recursion_depth + 1);
+    multipleEntriesDecoder(io, recursion_depth + 1);
 
   else if (equalsQTimeTag(buf, "stsd"))
-    sampleDesc(size);
+    sampleDesc(io, size);
 
   else if (equalsQTimeTag(buf, "stts"))
-    timeToSampleDecoder();
+    timeToSampleDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "pnot"))
-    previewTagDecoder(size);
+    previewTagDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "tapt"))
-    trackApertureTagDecoder(size);
+    trackApertureTagDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "keys"))
-    keysTagDecoder(size);
+    keysTagDecoder(io, size);
 
   else if (equalsQTimeTag(buf, "url ")) {
     if (currentStream_ == Video)
-      xmpData_["Xmp.video.URL"] = readString(*io_, size);
+      xmpData_["Xmp.video.URL"] = readString(io, size);
     else if (currentStream_ == Audio)
-      xmpData_["Xmp.audio.URL"] = readString(*io_, size);
+      xmpData_["Xmp.audio.URL"] = readString(io, size);
   }
 
   else if (equalsQTimeTag(buf, "urn ")) {
     if (currentStream_ == Video)
-      xmpData_["Xmp.video.URN"] = readString(*io_, size);
+      xmpData_["Xmp.video.URN"] = readString(io, size);
     else if (currentStream_ == Audio)
-      xmpData_["Xmp.audio.URN"] = readString(*io_, size);
+      xmpData_["Xmp.audio.URN"] = readString(io, size);
   }
 
   else if (equalsQTimeTag(buf, "dcom")) {
-    xmpData_["Xmp.video.Compressor"] = readString(*io_, size);
+    xmpData_["Xmp.video.Compressor"] = readString(io, size);
   }
 
   else if (equalsQTimeTag(buf, "smhd")) {
-    io_->readOrThrow(buf.data(), 4);
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     xmpData_["Xmp.audio.Balance"] = buf.read_uint16(0, bigEndian);
   }
 
   else {
-    discard(size);
+    discard(io, size);
   }
 }  // QuickTimeVideo::tagDecoder
 
-void QuickTimeVideo::discard(size_t size) {
-  size_t cur_pos = io_->tell();
-  io_->seek(cur_pos + size, BasicIo::beg);
+void QuickTimeVideo::discard(BasicIo& io, size_t size) {
+  size_t cur_pos = io.tell();
+  io.seek(cur_pos + size, BasicIo::beg);
 }  // QuickTimeVideo::discard
 
-void QuickTimeVideo::previewTagDecoder(size_t size) {
+void QuickTimeVideo::previewTagDecoder(BasicIo& io, size_t size) {
   DataBuf buf(4);
-  size_t cur_pos = io_->tell();
-  io_->readOrThrow(buf.data(), 4);
+  size_t cur_pos = io.tell();
+  io.readOrThrow(buf.data(), 4);
   xmpData_["Xmp.video.PreviewDate"] = buf.read_uint32(0, bigEndian);
-  io_->readOrThrow(buf.data(), 2);
+  io.readOrThrow(buf.data(), 2);
   xmpData_["Xmp.video.PreviewVersion"] = getShort(buf.data(), bigEndian);
 
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   if (equalsQTimeTag(buf, "PICT"))
     xmpData_["Xmp.video.PreviewAtomType"] = "QuickDraw Picture";
   else
     xmpData_["Xmp.video.PreviewAtomType"] = std::string{buf.c_str(), 4};
 
-  io_->seek(cur_pos + size, BasicIo::beg);
+  io.seek(cur_pos + size, BasicIo::beg);
 }  // QuickTimeVideo::previewTagDecoder
 
-void QuickTimeVideo::keysTagDecoder(size_t size) {
+void QuickTimeVideo::keysTagDecoder(BasicIo& io, size_t size) {
   DataBuf buf(4);
-  size_t cur_pos = io_->tell();
-  io_->readOrThrow(buf.data(), 4);
+  size_t cur_pos = io.tell();
+  io.readOrThrow(buf.data(), 4);
   xmpData_["Xmp.video.PreviewDate"] = buf.read_uint32(0, bigEndian);
-  io_->readOrThrow(buf.data(), 2);
+  io.readOrThrow(buf.data(), 2);
   xmpData_["Xmp.video.PreviewVersion"] = getShort(buf.data(), bigEndian);
 
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   if (equalsQTimeTag(buf, "PICT"))
     xmpData_["Xmp.video.PreviewAtomType"] = "QuickDraw Picture";
   else
     xmpData_["Xmp.video.PreviewAtomType"] = std::string{buf.c_str(), 4};
 
-  io_->seek(cur_pos + size, BasicIo::beg);
+  io.seek(cur_pos + size, BasicIo::beg);
 }  // QuickTimeVideo::keysTagDecoder
 
-void QuickTimeVideo::trackApertureTagDecoder(size_t size) {
+void QuickTimeVideo::trackApertureTagDecoder(BasicIo& io, size_t size) {
   DataBuf buf(4);
   DataBuf buf2(2);
-  size_t cur_pos = io_->tell();
+  size_t cur_pos = io.tell();
   byte n = 3;
 
   while (n--) {
-    io_->seek(static_cast<long>(4), BasicIo::cur);
-    io_->readOrThrow(buf.data(), 4);
+    io.seek(static_cast<long>(4), BasicIo::cur);
+    io.readOrThrow(buf.data(), 4);
 
     if (equalsQTimeTag(buf, "clef")) {
-      io_->seek(static_cast<long>(4), BasicIo::cur);
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.seek(static_cast<long>(4), BasicIo::cur);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.CleanApertureWidth"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.CleanApertureHeight"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
     }
 
     else if (equalsQTimeTag(buf, "prof")) {
-      io_->seek(static_cast<long>(4), BasicIo::cur);
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.seek(static_cast<long>(4), BasicIo::cur);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.ProductionApertureWidth"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.ProductionApertureHeight"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
     }
 
     else if (equalsQTimeTag(buf, "enof")) {
-      io_->seek(static_cast<long>(4), BasicIo::cur);
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.seek(static_cast<long>(4), BasicIo::cur);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.EncodedPixelsWidth"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       xmpData_["Xmp.video.EncodedPixelsHeight"] =
           Exiv2::toString(buf.read_uint16(0, bigEndian)) + "." + Exiv2::toString(buf2.read_uint16(0, bigEndian));
     }
   }
-  io_->seek(static_cast<long>(cur_pos + size), BasicIo::beg);
+  io.seek(cur_pos + size, BasicIo::beg);
 }  // QuickTimeVideo::trackApertureTagDecoder
 
-void QuickTimeVideo::CameraTagsDecoder(size_t size_external) {
-  size_t cur_pos = io_->tell();
+void QuickTimeVideo::CameraTagsDecoder(BasicIo& io, size_t size_external) {
+  size_t cur_pos = io.tell();
   DataBuf buf(50);
   DataBuf buf2(4);
   const TagDetails* td;
 
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   if (equalsQTimeTag(buf, "NIKO")) {
-    io_->seek(cur_pos, BasicIo::beg);
+    io.seek(cur_pos, BasicIo::beg);
 
-    io_->readOrThrow(buf.data(), 24);
+    io.readOrThrow(buf.data(), 24);
     xmpData_["Xmp.video.Make"] = Exiv2::toString(buf.data());
-    io_->readOrThrow(buf.data(), 14);
+    io.readOrThrow(buf.data(), 14);
     xmpData_["Xmp.video.Model"] = Exiv2::toString(buf.data());
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     xmpData_["Xmp.video.ExposureTime"] =
         "1/" + Exiv2::toString(ceil(buf.read_uint32(0, littleEndian) / static_cast<double>(10)));
-    io_->readOrThrow(buf.data(), 4);
-    io_->readOrThrow(buf2.data(), 4);
+    io.readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf2.data(), 4);
     xmpData_["Xmp.video.FNumber"] =
         buf.read_uint32(0, littleEndian) / static_cast<double>(buf2.read_uint32(0, littleEndian));
-    io_->readOrThrow(buf.data(), 4);
-    io_->readOrThrow(buf2.data(), 4);
+    io.readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf2.data(), 4);
     xmpData_["Xmp.video.ExposureCompensation"] =
         buf.read_uint32(0, littleEndian) / static_cast<double>(buf2.read_uint32(0, littleEndian));
-    io_->readOrThrow(buf.data(), 10);
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 10);
+    io.readOrThrow(buf.data(), 4);
     td = Exiv2::find(whiteBalance, buf.read_uint32(0, littleEndian));
     if (td)
       xmpData_["Xmp.video.WhiteBalance"] = exvGettext(td->label_);
-    io_->readOrThrow(buf.data(), 4);
-    io_->readOrThrow(buf2.data(), 4);
+    io.readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf2.data(), 4);
     xmpData_["Xmp.video.FocalLength"] =
         buf.read_uint32(0, littleEndian) / static_cast<double>(buf2.read_uint32(0, littleEndian));
-    io_->seek(static_cast<long>(95), BasicIo::cur);
-    io_->readOrThrow(buf.data(), 48);
+    io.seek(static_cast<long>(95), BasicIo::cur);
+    io.readOrThrow(buf.data(), 48);
     buf.write_uint8(48, 0);
     xmpData_["Xmp.video.Software"] = Exiv2::toString(buf.data());
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     xmpData_["Xmp.video.ISO"] = buf.read_uint32(0, littleEndian);
   }
 
-  io_->seek(cur_pos + size_external, BasicIo::beg);
+  io.seek(cur_pos + size_external, BasicIo::beg);
 }  // QuickTimeVideo::CameraTagsDecoder
 
-void QuickTimeVideo::userDataDecoder(size_t size_external, size_t recursion_depth) {
+void QuickTimeVideo::userDataDecoder(BasicIo& io, size_t size_external, size_t recursion_depth) {
   enforce(recursion_depth < max_recursion_depth_, Exiv2::ErrorCode::kerCorruptedMetadata);
-  size_t cur_pos = io_->tell();
+  size_t cur_pos = io.tell();
   const TagVocabulary* td;
   const TagVocabulary* tv;
   const TagVocabulary* tv_internal;
@@ -853,12 +1311,12 @@ void QuickTimeVideo::userDataDecoder(size_t size_external, size_t recursion_dept
 
   while ((size_internal / 4 != 0) && (size_internal > 0)) {
     buf.data()[4] = '\0';
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     const size_t size = buf.read_uint32(0, bigEndian);
     if (size > size_internal)
       break;
     size_internal -= size;
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
 
     if (buf.data()[0] == 169)
       buf.data()[0] = ' ';
@@ -870,23 +1328,23 @@ void QuickTimeVideo::userDataDecoder(size_t size_external, size_t recursion_dept
       break;
 
     if (equalsQTimeTag(buf, "DcMD") || equalsQTimeTag(buf, "NCDT"))
-      userDataDecoder(size - 8, recursion_depth + 1);
+      userDataDecoder(io, size - 8, recursion_depth + 1);
 
     else if (equalsQTimeTag(buf, "NCTG"))
-      NikonTagsDecoder(size - 8);
+      NikonTagsDecoder(io, size - 8);
 
     else if (equalsQTimeTag(buf, "TAGS"))
-      CameraTagsDecoder(size - 8);
+      CameraTagsDecoder(io, size - 8);
 
     else if (equalsQTimeTag(buf, "CNCV") || equalsQTimeTag(buf, "CNFV") || equalsQTimeTag(buf, "CNMN") ||
              equalsQTimeTag(buf, "NCHD") || equalsQTimeTag(buf, "FFMV")) {
       enforce(tv, Exiv2::ErrorCode::kerCorruptedMetadata);
-      xmpData_[exvGettext(tv->label_)] = readString(*io_, size - 8);
+      xmpData_[exvGettext(tv->label_)] = readString(io, size - 8);
     }
 
     else if (equalsQTimeTag(buf, "CMbo") || equalsQTimeTag(buf, "Cmbo")) {
       enforce(tv, Exiv2::ErrorCode::kerCorruptedMetadata);
-      io_->readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf.data(), 2);
       buf.data()[2] = '\0';
       tv_internal = Exiv2::find(cameraByteOrderTags, Exiv2::toString(buf.data()));
 
@@ -897,19 +1355,19 @@ void QuickTimeVideo::userDataDecoder(size_t size_external, size_t recursion_dept
     }
 
     else if (tv) {
-      io_->readOrThrow(buf.data(), 4);
-      xmpData_[exvGettext(tv->label_)] = readString(*io_, size - 12);
+      io.readOrThrow(buf.data(), 4);
+      xmpData_[exvGettext(tv->label_)] = readString(io, size - 12);
     }
 
     else if (td)
-      tagDecoder(buf, size - 8, recursion_depth + 1);
+      tagDecoder(io, buf, size - 8, recursion_depth + 1);
   }
 
-  io_->seek(cur_pos + size_external, BasicIo::beg);
+  io.seek(cur_pos + size_external, BasicIo::beg);
 }  // QuickTimeVideo::userDataDecoder
 
-void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
-  size_t cur_pos = io_->tell();
+void QuickTimeVideo::NikonTagsDecoder(BasicIo& io, size_t size_external) {
+  size_t cur_pos = io.tell();
   DataBuf buf(201);
   DataBuf buf2(4 + 1);
   uint32_t TagID = 0;
@@ -919,111 +1377,111 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
   const TagDetails* td2;
 
   for (int i = 0; i < 100; i++) {
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     TagID = buf.read_uint32(0, bigEndian);
     td = Exiv2::find(NikonNCTGTags, TagID);
 
-    io_->readOrThrow(buf.data(), 2);
+    io.readOrThrow(buf.data(), 2);
     dataType = buf.read_uint16(0, bigEndian);
 
     std::memset(buf.data(), 0x0, buf.size());
-    io_->readOrThrow(buf.data(), 2);
+    io.readOrThrow(buf.data(), 2);
 
     if (TagID == 0x2000023) {
-      size_t local_pos = io_->tell();
+      size_t local_pos = io.tell();
       dataLength = buf.read_uint16(0, bigEndian);
       std::memset(buf.data(), 0x0, buf.size());
 
-      io_->readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
       xmpData_["Xmp.video.PictureControlVersion"] = Exiv2::toString(buf.data());
-      io_->readOrThrow(buf.data(), 20);
+      io.readOrThrow(buf.data(), 20);
       xmpData_["Xmp.video.PictureControlName"] = Exiv2::toString(buf.data());
-      io_->readOrThrow(buf.data(), 20);
+      io.readOrThrow(buf.data(), 20);
       xmpData_["Xmp.video.PictureControlBase"] = Exiv2::toString(buf.data());
-      io_->readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
       std::memset(buf.data(), 0x0, buf.size());
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(PictureControlAdjust, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.PictureControlAdjust"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.PictureControlAdjust"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(NormalSoftHard, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.PictureControlQuickAdjust"] = exvGettext(td2->label_);
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(NormalSoftHard, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.Sharpness"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.Sharpness"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(NormalSoftHard, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.Contrast"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.Contrast"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(NormalSoftHard, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.Brightness"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.Brightness"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(Saturation, static_cast<int>(buf.data()[0]) & 7);
       if (td2)
         xmpData_["Xmp.video.Saturation"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.Saturation"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       xmpData_["Xmp.video.HueAdjustment"] = static_cast<int>(buf.data()[0]) & 7;
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(FilterEffect, static_cast<int>(buf.data()[0]));
       if (td2)
         xmpData_["Xmp.video.FilterEffect"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.FilterEffect"] = static_cast<int>(buf.data()[0]);
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(ToningEffect, static_cast<int>(buf.data()[0]));
       if (td2)
         xmpData_["Xmp.video.ToningEffect"] = exvGettext(td2->label_);
       else
         xmpData_["Xmp.video.ToningEffect"] = static_cast<int>(buf.data()[0]);
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       xmpData_["Xmp.video.ToningSaturation"] = static_cast<int>(buf.data()[0]);
 
-      io_->seek(local_pos + dataLength, BasicIo::beg);
+      io.seek(local_pos + dataLength, BasicIo::beg);
     }
 
     else if (TagID == 0x2000024) {
-      size_t local_pos = io_->tell();
+      size_t local_pos = io.tell();
       dataLength = buf.read_uint16(0, bigEndian);
       std::memset(buf.data(), 0x0, buf.size());
 
-      io_->readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf.data(), 2);
       xmpData_["Xmp.video.TimeZone"] = Exiv2::getShort(buf.data(), bigEndian);
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(YesNo, static_cast<int>(buf.data()[0]));
       if (td2)
         xmpData_["Xmp.video.DayLightSavings"] = exvGettext(td2->label_);
 
-      io_->readOrThrow(buf.data(), 1);
+      io.readOrThrow(buf.data(), 1);
       td2 = Exiv2::find(DateDisplayFormat, static_cast<int>(buf.data()[0]));
       if (td2)
         xmpData_["Xmp.video.DateDisplayFormat"] = exvGettext(td2->label_);
 
-      io_->seek(local_pos + dataLength, BasicIo::beg);
+      io.seek(local_pos + dataLength, BasicIo::beg);
     }
 
     else if (dataType == 2 || dataType == 7) {
@@ -1036,10 +1494,10 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
         EXV_ERROR << "Xmp.video Nikon Tags, dataLength was found to be larger than 200."
                   << " Entries considered invalid. Not Processed.\n";
 #endif
-        io_->seek(io_->tell() + dataLength, BasicIo::beg);
+        io.seek(io.tell() + dataLength, BasicIo::beg);
         buf.data()[0] = '\0';
       } else {
-        io_->readOrThrow(buf.data(), dataLength);
+        io.readOrThrow(buf.data(), dataLength);
         buf.data()[dataLength] = '\0';
       }
 
@@ -1049,7 +1507,7 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
     } else if (dataType == 4) {
       dataLength = buf.read_uint16(0, bigEndian) * 4;
       std::memset(buf.data(), 0x0, buf.size());
-      io_->readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
       if (td)
         xmpData_[exvGettext(td->label_)] = Exiv2::toString(buf.read_uint32(0, bigEndian));
 
@@ -1059,13 +1517,13 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
         EXV_ERROR << "Xmp.video Nikon Tags, dataLength was found to be of inappropriate size."
                   << " Entries considered invalid. Not Processed.\n";
 #endif
-        io_->seek(io_->tell() + dataLength - 4, BasicIo::beg);
+        io.seek(io.tell() + dataLength - 4, BasicIo::beg);
       } else
-        io_->readOrThrow(buf.data(), dataLength - 4);
+        io.readOrThrow(buf.data(), dataLength - 4);
     } else if (dataType == 3) {
       dataLength = buf.read_uint16(0, bigEndian) * 2;
       std::memset(buf.data(), 0x0, buf.size());
-      io_->readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf.data(), 2);
       if (td)
         xmpData_[exvGettext(td->label_)] = Exiv2::toString(buf.read_uint16(0, bigEndian));
 
@@ -1075,14 +1533,14 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
         EXV_ERROR << "Xmp.video Nikon Tags, dataLength was found to be of inappropriate size."
                   << " Entries considered invalid. Not Processed.\n";
 #endif
-        io_->seek(io_->tell() + dataLength - 2, BasicIo::beg);
+        io.seek(io.tell() + dataLength - 2, BasicIo::beg);
       } else
-        io_->readOrThrow(buf.data(), dataLength - 2);
+        io.readOrThrow(buf.data(), dataLength - 2);
     } else if (dataType == 5) {
       dataLength = buf.read_uint16(0, bigEndian) * 8;
       std::memset(buf.data(), 0x0, buf.size());
-      io_->readOrThrow(buf.data(), 4);
-      io_->readOrThrow(buf2.data(), 4);
+      io.readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf2.data(), 4);
       if (td)
         xmpData_[exvGettext(td->label_)] = Exiv2::toString(static_cast<double>(buf.read_uint32(0, bigEndian)) /
                                                            static_cast<double>(buf2.read_uint32(0, bigEndian)));
@@ -1093,14 +1551,14 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
         EXV_ERROR << "Xmp.video Nikon Tags, dataLength was found to be of inappropriate size."
                   << " Entries considered invalid. Not Processed.\n";
 #endif
-        io_->seek(io_->tell() + dataLength - 8, BasicIo::beg);
+        io.seek(io.tell() + dataLength - 8, BasicIo::beg);
       } else
-        io_->readOrThrow(buf.data(), dataLength - 8);
+        io.readOrThrow(buf.data(), dataLength - 8);
     } else if (dataType == 8) {
       dataLength = buf.read_uint16(0, bigEndian) * 2;
       std::memset(buf.data(), 0x0, buf.size());
-      io_->readOrThrow(buf.data(), 2);
-      io_->readOrThrow(buf2.data(), 2);
+      io.readOrThrow(buf.data(), 2);
+      io.readOrThrow(buf2.data(), 2);
       if (td)
         xmpData_[exvGettext(td->label_)] =
             Exiv2::toString(buf.read_uint16(0, bigEndian)) + " " + Exiv2::toString(buf2.read_uint16(0, bigEndian));
@@ -1111,25 +1569,26 @@ void QuickTimeVideo::NikonTagsDecoder(size_t size_external) {
         EXV_ERROR << "Xmp.video Nikon Tags, dataLength was found to be of inappropriate size."
                   << " Entries considered invalid. Not Processed.\n";
 #endif
-        io_->seek(io_->tell() + dataLength - 4, BasicIo::beg);
+        io.seek(io.tell() + dataLength - 4, BasicIo::beg);
       } else
-        io_->readOrThrow(buf.data(), dataLength - 4);
+        io.readOrThrow(buf.data(), dataLength - 4);
     }
   }
 
-  io_->seek(cur_pos + size_external, BasicIo::beg);
+  io.seek(cur_pos + size_external, BasicIo::beg);
 }  // QuickTimeVideo::NikonTagsDecoder
 
-void QuickTimeVideo::setMediaStream() {
-  size_t current_position = io_->tell();
+void QuickTimeVideo::setMediaStream(BasicIo& io, size_t size) {
+  size_t current_position = io.tell();
+  const size_t end = current_position + std::min(size, io.size() - current_position);
   DataBuf buf(4 + 1);
 
-  while (!io_->eof()) {
-    io_->readOrThrow(buf.data(), 4);
+  while (!io.eof() && io.tell() + 16 <= end) {
+    io.readOrThrow(buf.data(), 4);
     if (equalsQTimeTag(buf, "hdlr")) {
-      io_->readOrThrow(buf.data(), 4);
-      io_->readOrThrow(buf.data(), 4);
-      io_->readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
+      io.readOrThrow(buf.data(), 4);
 
       if (equalsQTimeTag(buf, "vide"))
         currentStream_ = Video;
@@ -1143,23 +1602,25 @@ void QuickTimeVideo::setMediaStream() {
     }
   }
 
-  io_->seek(current_position, BasicIo::beg);
+  io.seek(current_position, BasicIo::beg);
 }  // QuickTimeVideo::setMediaStream
 
-void QuickTimeVideo::timeToSampleDecoder() {
-  DataBuf buf(4 + 1);
-  io_->readOrThrow(buf.data(), 4);
-  io_->readOrThrow(buf.data(), 4);
+void QuickTimeVideo::timeToSampleDecoder(BasicIo& io, size_t size) {
+  if (!computeFrameRate_) {
+    discard(io, size);
+    return;
+  }
+  // Variable frame rate videos have one entry per sample: decode the table from memory
+  const DataBuf data = readAtomData(io, size);
+  const size_t noOfEntries = data.size() < 8 ? 0 : std::min<size_t>(data.read_uint32(4, bigEndian), (size - 8) / 8);
   uint64_t totalframes = 0;
   uint64_t timeOfFrames = 0;
-  const uint32_t noOfEntries = buf.read_uint32(0, bigEndian);
 
-  for (uint32_t i = 0; i < noOfEntries; i++) {
-    io_->readOrThrow(buf.data(), 4);
-    const uint64_t temp = buf.read_uint32(0, bigEndian);
-    totalframes = Safe::add(totalframes, temp);
-    io_->readOrThrow(buf.data(), 4);
-    timeOfFrames = Safe::add(timeOfFrames, temp * buf.read_uint32(0, bigEndian));
+  for (size_t i = 0; i < noOfEntries; i++) {
+    const byte* entry = data.c_data(8 + 8 * i);
+    const uint64_t temp = getULong(entry, bigEndian);
+    totalframes += temp;  // At most 2^32 - 1 per 8 bytes of table, this cannot overflow
+    timeOfFrames = Safe::add(timeOfFrames, temp * getULong(entry + 4, bigEndian));
   }
   if (currentStream_ == Video) {
     if (timeOfFrames == 0)
@@ -1169,35 +1630,38 @@ void QuickTimeVideo::timeToSampleDecoder() {
   }
 }  // QuickTimeVideo::timeToSampleDecoder
 
-void QuickTimeVideo::sampleDesc(size_t size) {
-  DataBuf buf(100);
-  size_t cur_pos = io_->tell();
-  io_->readOrThrow(buf.data(), 4);
-  io_->readOrThrow(buf.data(), 4);
+void QuickTimeVideo::sampleDesc(BasicIo& io, size_t size) {
+  // The entries are decoded from memory. The description decoders read a fixed number of bytes,
+  // which may exceed short entries: the padding makes them read zeros instead.
+  DataBuf data = readAtomData(io, size);
+  data.resize(size + sampleDescReadSize);
+  MemIo table(data.c_data(), data.size());
+  DataBuf buf(4);
+  table.readOrThrow(buf.data(), 4);
+  table.readOrThrow(buf.data(), 4);
   const uint32_t noOfEntries = buf.read_uint32(0, bigEndian);
 
-  for (uint32_t i = 0; i < noOfEntries; i++) {
+  for (uint32_t i = 0; i < noOfEntries && table.tell() < size; i++) {
     if (currentStream_ == Video)
-      imageDescDecoder();
+      imageDescDecoder(table);
     else if (currentStream_ == Audio)
-      audioDescDecoder();
+      audioDescDecoder(table);
     else
       break;
   }
-  io_->seek(Safe::add(cur_pos, size), BasicIo::beg);
 }  // QuickTimeVideo::sampleDesc
 
-void QuickTimeVideo::audioDescDecoder() {
+void QuickTimeVideo::audioDescDecoder(BasicIo& io) {
   DataBuf buf(40);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   size_t size = 82;
 
   const TagVocabulary* td;
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     switch (i) {
       case AudioFormat:
         td = Exiv2::find(qTimeFileType, Exiv2::toString(buf.data()));
@@ -1223,20 +1687,20 @@ void QuickTimeVideo::audioDescDecoder() {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), static_cast<long>(size % 4));  // cause size is so small, this cast should be right.
+  io.readOrThrow(buf.data(), static_cast<long>(size % 4));  // cause size is so small, this cast should be right.
 }  // QuickTimeVideo::audioDescDecoder
 
-void QuickTimeVideo::imageDescDecoder() {
+void QuickTimeVideo::imageDescDecoder(BasicIo& io) {
   DataBuf buf(40);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   size_t size = 82;
 
   const TagVocabulary* td;
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
 
     switch (i) {
       case codec:
@@ -1262,11 +1726,11 @@ void QuickTimeVideo::imageDescDecoder() {
       case YResolution:
         xmpData_["Xmp.video.YResolution"] =
             buf.read_uint16(0, bigEndian) + ((buf.data()[2] * 256 + buf.data()[3]) * 0.01);
-        io_->readOrThrow(buf.data(), 3);
+        io.readOrThrow(buf.data(), 3);
         size -= 3;
         break;
       case CompressorName:
-        io_->readOrThrow(buf.data(), 32);
+        io.readOrThrow(buf.data(), 32);
         size -= 32;
         xmpData_["Xmp.video.Compressor"] = Exiv2::toString(buf.data());
         break;
@@ -1274,25 +1738,25 @@ void QuickTimeVideo::imageDescDecoder() {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), static_cast<long>(size % 4));
+  io.readOrThrow(buf.data(), static_cast<long>(size % 4));
   xmpData_["Xmp.video.BitDepth"] = static_cast<int>(buf.read_uint8(0));
 }  // QuickTimeVideo::imageDescDecoder
 
-void QuickTimeVideo::multipleEntriesDecoder(size_t recursion_depth) {
+void QuickTimeVideo::multipleEntriesDecoder(BasicIo& io, size_t recursion_depth) {
   enforce(recursion_depth < max_recursion_depth_, Exiv2::ErrorCode::kerCorruptedMetadata);
   DataBuf buf(4 + 1);
-  io_->readOrThrow(buf.data(), 4);
-  io_->readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
+  io.readOrThrow(buf.data(), 4);
   uint32_t noOfEntries;
 
   noOfEntries = buf.read_uint32(0, bigEndian);
 
   for (uint32_t i = 0; i < noOfEntries && continueTraversing_; i++) {
-    decodeBlock(recursion_depth + 1);
+    decodeBlock(io, recursion_depth + 1);
   }
 }  // QuickTimeVideo::multipleEntriesDecoder
 
-void QuickTimeVideo::videoHeaderDecoder(size_t size) {
+void QuickTimeVideo::videoHeaderDecoder(BasicIo& io, size_t size) {
   DataBuf buf(3);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[2] = '\0';
@@ -1301,7 +1765,7 @@ void QuickTimeVideo::videoHeaderDecoder(size_t size) {
   const TagDetails* td;
 
   for (int i = 0; size / 2 != 0; size -= 2, i++) {
-    io_->readOrThrow(buf.data(), 2);
+    io.readOrThrow(buf.data(), 2);
 
     switch (i) {
       case GraphicsMode:
@@ -1316,19 +1780,20 @@ void QuickTimeVideo::videoHeaderDecoder(size_t size) {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), size % 2);
+  io.readOrThrow(buf.data(), size % 2);
 }  // QuickTimeVideo::videoHeaderDecoder
 
-void QuickTimeVideo::handlerDecoder(size_t size) {
-  size_t cur_pos = io_->tell();
+void QuickTimeVideo::handlerDecoder(BasicIo& io, size_t size) {
+  const DataBuf data = readAtomData(io, size);
   DataBuf buf(100);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
 
   const TagVocabulary* tv;
 
-  for (int i = 0; i < 5; i++) {
-    io_->readOrThrow(buf.data(), 4);
+  const auto fields = static_cast<int>(std::min<size_t>(size / 4, 5));
+  for (int i = 0; i < fields; i++) {
+    std::copy_n(data.c_data(4 * i), 4, buf.begin());
 
     switch (i) {
       case HandlerClass:
@@ -1360,10 +1825,9 @@ void QuickTimeVideo::handlerDecoder(size_t size) {
         break;
     }
   }
-  io_->seek(cur_pos + size, BasicIo::beg);
 }  // QuickTimeVideo::handlerDecoder
 
-void QuickTimeVideo::fileTypeDecoder(size_t size) {
+void QuickTimeVideo::fileTypeDecoder(BasicIo& io, size_t size) {
   DataBuf buf(5);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
@@ -1371,7 +1835,7 @@ void QuickTimeVideo::fileTypeDecoder(size_t size) {
   const TagVocabulary* td;
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    io.readOrThrow(buf.data(), 4);
     td = Exiv2::find(qTimeFileType, Exiv2::toString(buf.data()));
 
     switch (i) {
@@ -1391,17 +1855,18 @@ void QuickTimeVideo::fileTypeDecoder(size_t size) {
     }
   }
   xmpData_.add(Exiv2::XmpKey("Xmp.video.CompatibleBrands"), v.get());
-  io_->readOrThrow(buf.data(), size % 4);
+  io.readOrThrow(buf.data(), size % 4);
 }  // QuickTimeVideo::fileTypeDecoder
 
-void QuickTimeVideo::mediaHeaderDecoder(size_t size) {
+void QuickTimeVideo::mediaHeaderDecoder(BasicIo& io, size_t size) {
   DataBuf buf(5);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
+  const DataBuf data = readAtomData(io, size);
   int64_t time_scale = 1;
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    std::copy_n(data.c_data(4 * i), 4, buf.begin());
 
     switch (i) {
       case MediaHeaderVersion:
@@ -1450,17 +1915,17 @@ void QuickTimeVideo::mediaHeaderDecoder(size_t size) {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), size % 4);
 }  // QuickTimeVideo::mediaHeaderDecoder
 
-void QuickTimeVideo::trackHeaderDecoder(size_t size) {
+void QuickTimeVideo::trackHeaderDecoder(BasicIo& io, size_t size) {
   DataBuf buf(5);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
+  const DataBuf data = readAtomData(io, size);
   int64_t temp = 0;
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    std::copy_n(data.c_data(4 * i), 4, buf.begin());
 
     switch (i) {
       case TrackHeaderVersion:
@@ -1525,16 +1990,16 @@ void QuickTimeVideo::trackHeaderDecoder(size_t size) {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), size % 4);
 }  // QuickTimeVideo::trackHeaderDecoder
 
-void QuickTimeVideo::movieHeaderDecoder(size_t size) {
+void QuickTimeVideo::movieHeaderDecoder(BasicIo& io, size_t size) {
   DataBuf buf(5);
   std::memset(buf.data(), 0x0, buf.size());
   buf.data()[4] = '\0';
+  const DataBuf data = readAtomData(io, size);
 
   for (int i = 0; size / 4 != 0; size -= 4, i++) {
-    io_->readOrThrow(buf.data(), 4);
+    std::copy_n(data.c_data(4 * i), 4, buf.begin());
 
     switch (i) {
       case MovieHeaderVersion:
@@ -1591,7 +2056,6 @@ void QuickTimeVideo::movieHeaderDecoder(size_t size) {
         break;
     }
   }
-  io_->readOrThrow(buf.data(), size % 4);
 }  // QuickTimeVideo::movieHeaderDecoder
 
 Image::UniquePtr newQTimeInstance(BasicIo::UniquePtr io, bool /*create*/) {
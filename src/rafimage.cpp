@@ -4,6 +4,7 @@
 #include "rafimage.hpp"
 
 #include "basicio.hpp"
+#include "basicio_int.hpp"
 #include "config.h"
 #include "enforce.hpp"
 #include "error.hpp"
@@ -11,7 +12,6 @@
 #include "image.hpp"
 #include "image_int.hpp"
 #include "jpgimage.hpp"
-#include "safe_op.hpp"
 #include "tiffimage.hpp"
 
 #include <array>
@@ -272,18 +272,15 @@ void RafImage::readMetadata() {
   byte jpg_img_length[4];
   if (io_->read(jpg_img_length, 4) != 4)
     throw Error(ErrorCode::kerFailedToReadImageData);
-  uint32_t jpg_img_off_u32 = Exiv2::getULong(jpg_img_offset, bigEndian);
-  uint32_t jpg_img_len_u32 = Exiv2::getULong(jpg_img_length, bigEndian);
-
-  Internal::enforce(Safe::add(jpg_img_off_u32, jpg_img_len_u32) <= io_->size(), ErrorCode::kerCorruptedMetadata);
-
-  auto jpg_img_off = static_cast<long>(jpg_img_off_u32);
-  auto jpg_img_len = static_cast<long>(jpg_img_len_u32);
+  // Widen before adding: offset + length may legitimately exceed 32 bits
+  const Internal::FileOffset jpg_img_off = Exiv2::getULong(jpg_img_offset, bigEndian);
+  const Internal::FileOffset jpg_img_len = Exiv2::getULong(jpg_img_length, bigEndian);
 
+  Internal::enforce(jpg_img_off + jpg_img_len <= io_->size(), ErrorCode::kerCorruptedMetadata);
   Internal::enforce(jpg_img_len >= 12, ErrorCode::kerCorruptedMetadata);
 
-  DataBuf jpg_buf(jpg_img_len);
-  if (io_->seek(jpg_img_off, BasicIo::beg) != 0)
+  DataBuf jpg_buf(Internal::toSize(jpg_img_len));
+  if (io_->seek(Internal::toSeekOffset(jpg_img_off), BasicIo::beg) != 0)
     throw Error(ErrorCode::kerFailedToReadImageData);
 
   if (!jpg_buf.empty()) {
@@ -319,16 +316,16 @@ void RafImage::readMetadata() {
     throw Error(ErrorCode::kerFailedToReadImageData);
   if (io_->read(readBuff.data(), 4) != 4)
     throw Error(ErrorCode::kerFailedToReadImageData);
-  uint32_t tiffOffset = Exiv2::getULong(readBuff.data(), bigEndian);
+  const Internal::FileOffset tiffOffset = Exiv2::getULong(readBuff.data(), bigEndian);
 
   if (io_->read(readBuff.data(), 4) != 4)
     throw Error(ErrorCode::kerFailedToReadImageData);
-  uint32_t tiffLength = Exiv2::getULong(readBuff.data(), bigEndian);
+  const Internal::FileOffset tiffLength = Exiv2::getULong(readBuff.data(), bigEndian);
 
   // sanity check.  Does tiff lie inside the file?
-  Internal::enforce(Safe::add(tiffOffset, tiffLength) <= io_->size(), ErrorCode::kerCorruptedMetadata);
+  Internal::enforce(tiffOffset + tiffLength <= io_->size(), ErrorCode::kerCorruptedMetadata);
 
-  if (io_->seek(tiffOffset, BasicIo::beg) != 0)
+  if (io_->seek(Internal::toSeekOffset(tiffOffset), BasicIo::beg) != 0)
     throw Error(ErrorCode::kerFailedToReadImageData);
 
   // Check if this really is a tiff and then call the tiff parser.
@@ -341,7 +338,7 @@ void RafImage::readMetadata() {
   const std::array<byte, 4> Id1{0x49, 0x49, 0x2A, 0x00};
   const std::array<byte, 4> Id2{0x4D, 0x4D, 0x00, 0x2A};
   if (readBuff == Id1 || readBuff == Id2) {
-    DataBuf tiff(tiffLength);
+    DataBuf tiff(Internal::toSize(tiffLength));
     io_->read(tiff.data(), tiff.size());
 
     if (!io_->error() && !io_->eof()) {
@@ -8,13 +8,18 @@
 
 // included header files
 #include "riffvideo.hpp"
+#include "containerwalker_int.hpp"
 #include "enforce.hpp"
 #include "error.hpp"
 #include "futils.hpp"
 #include "helper_functions.hpp"
+#include "image_int.hpp"
 #include "utils.hpp"
+#include "xmp_exiv2.hpp"
 
+#include <algorithm>
 #include <array>
+#include <limits>
 
 namespace Exiv2::Internal {
 
@@ -351,6 +356,43 @@ const std::map<uint16_t, std::string> audioEncodingValues = {
     {0xffff, "Development"},
 };
 
+//! Largest INFO list or XMP packet read into memory
+constexpr size_t maxMetadataChunkSize = 16 * 1024 * 1024;
+
+//! Append the chunk \em id with \em payload and its pad byte to \em out
+static void appendChunk(Blob& out, uint32_t id, const byte* payload, size_t size) {
+  enforce(size <= std::numeric_limits<uint32_t>::max(), ErrorCode::kerImageWriteFailed);
+  byte header[8];
+  ul2Data(header, id, bigEndian);
+  ul2Data(header + 4, static_cast<uint32_t>(size), littleEndian);
+  out.insert(out.end(), header, header + sizeof(header));
+  if (size > 0)
+    out.insert(out.end(), payload, payload + size);
+  if (size % 2 != 0)
+    out.push_back(0);
+}
+
+//! Header of a JUNK chunk of \em size bytes in total, which must be at least 8
+[[nodiscard]] static Blob junkHeader(uint64_t size) {
+  Blob header;
+  appendChunk(header, fourcc("JUNK"), nullptr, 0);
+  ul2Data(header.data() + 4, static_cast<uint32_t>(size - 8), littleEndian);
+  return header;
+}
+
+//! The INFO chunk written for each property: the first standard (I...) chunk it is read from
+[[nodiscard]] static std::vector<std::pair<std::string, std::string>> infoChunksToWrite() {
+  std::vector<std::pair<std::string, std::string>> chunks;
+  for (auto&& [id, key] : infoTags) {
+    auto it = std::find_if(chunks.begin(), chunks.end(), [&key = key](const auto& c) { return c.second == key; });
+    if (it == chunks.end())
+      chunks.emplace_back(id, key);
+    else if (it->first[0] != 'I' && id[0] == 'I')
+      it->first = id;
+  }
+  return chunks;
+}
+
 }  // namespace Exiv2::Internal
 // *****************************************************************************
 // class member definitions
@@ -359,7 +401,7 @@ namespace Exiv2 {
 
 enum streamTypeInfo { Audio = 1, MIDI, Text, Video };
 
-RiffVideo::RiffVideo(BasicIo::UniquePtr io) : Image(ImageType::riff, mdNone, std::move(io)) {
+RiffVideo::RiffVideo(BasicIo::UniquePtr io) : Image(ImageType::riff, mdXmp, std::move(io)) {
 }  // RiffVideo::RiffVideo
 
 std::string RiffVideo::mimeType() const {
@@ -367,6 +409,211 @@ std::string RiffVideo::mimeType() const {
 }
 
 void RiffVideo::writeMetadata() {
+  using namespace Internal;
+  if (io_->open() != 0)
+    throw Error(ErrorCode::kerDataSourceOpenFailed, io_->path(), strError());
+  IoCloser closer(*io_);
+  if (!isRiffType(*io_, false))
+    throw Error(ErrorCode::kerNoImageInInputData);
+
+  // Xmp.video and Xmp.audio properties go to the INFO list or are recomputed when reading,
+  // changes to the latter cannot be stored
+  const auto changed = [this](const std::string& key) {
+    auto it = xmpData_.findKey(XmpKey(key));
+    auto old = readXmpData_.findKey(XmpKey(key));
+    return it == xmpData_.end() || old == readXmpData_.end() || it->toString() != old->toString();
+  };
+  if (!writeXmpFromPacket()) {
+    enforceXmpStored(xmpData_, readXmpData_, [](const std::string& key) {
+      return (key.rfind("Xmp.video.", 0) != 0 && key.rfind("Xmp.audio.", 0) != 0) ||
+             std::any_of(infoTags.begin(), infoTags.end(), [&key](const auto& tag) { return tag.second == key; });
+    });
+    XmpData xmpData = xmpData_;
+    for (auto it = xmpData.begin(); it != xmpData.end();) {
+      if (it->groupName() == "video" || it->groupName() == "audio")
+        it = xmpData.erase(it);
+      else
+        ++it;
+    }
+    if (XmpParser::encode(xmpPacket_, xmpData) > 1) {
+#ifndef SUPPRESS_WARNINGS
+      EXV_WARNING << "Failed to encode XMP metadata.\n";
+#endif
+      throw Error(ErrorCode::kerImageWriteFailed);
+    }
+  }
+
+  // Chunks in the RIFF chunks: the main one and the OpenDML extensions. The movi lists are skipped
+  // by their size and never read.
+  ContainerWalker walker(*io_, ContainerFormat::riff);
+  ContainerEntry lastRiff;
+  std::vector<ContainerEntry> chunks;
+  walker.walk(0, io_->size(), [&](const ContainerEntry& entry) {
+    if (entry.id != fourcc("RIFF"))
+      return WalkAction::next;
+    lastRiff = entry;
+    walker.walk(entry.childOffset, entry.end(), [&](const ContainerEntry& chunk) {
+      chunks.push_back(chunk);
+      return WalkAction::next;
+    });
+    return WalkAction::next;
+  });
+
+  constexpr size_t none = std::numeric_limits<size_t>::max();
+  const auto isJunk = [](const ContainerEntry& c) { return c.id == fourcc("JUNK"); };
+  const auto follows = [&](size_t i) { return chunks[i].offset == walker.nextOffset(chunks[i - 1]); };
+  // A chunk can grow into the JUNK chunks which follow it
+  const auto spanEnd = [&](size_t index) {
+    while (index + 1 < chunks.size() && isJunk(chunks[index + 1]) && follows(index + 1))
+      ++index;
+    return std::min(walker.nextOffset(chunks[index]), lastRiff.end());
+  };
+  size_t info = none;
+  size_t xmp = none;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (info == none && chunks[i].id == fourcc("LIST") && chunks[i].formType == fourcc("INFO"))
+      info = i;
+    if (xmp == none && chunks[i].id == fourcc("_PMX"))
+      xmp = i;
+  }
+
+  // Runs of JUNK chunks, except those after the chunks rewritten below: these can grow into them.
+  // The space they leave is added once they are placed.
+  struct Run {
+    uint64_t offset;
+    uint64_t size;
+  };
+  std::vector<Run> runs;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (!isJunk(chunks[i]) || (i > 0 && follows(i) && (isJunk(chunks[i - 1]) || i - 1 == info || i - 1 == xmp)))
+      continue;
+    runs.push_back({chunks[i].offset, spanEnd(i) - chunks[i].offset});
+  }
+
+  // All writes are planned before the file is modified
+  struct Write {
+    uint64_t offset;
+    Blob data;
+  };
+  std::vector<Write> writes;
+  Blob appended;
+  const uint64_t appendOffset = lastRiff.end();
+  // Keep the chunks after the last one aligned if its pad byte is missing
+  if (!chunks.empty() && walker.nextOffset(chunks.back()) > appendOffset)
+    appended.push_back(0);
+  const size_t alignment = appended.size();
+
+  const auto fits = [](uint64_t space, size_t size) { return space == size || space >= size + 8; };
+  const auto writeAt = [&](uint64_t offset, Blob data, uint64_t space) {
+    const size_t size = data.size();
+    writes.push_back({offset, std::move(data)});
+    if (space > size)
+      writes.push_back({offset + size, junkHeader(space - size)});
+  };
+  // Write a chunk over the old one, into a run of JUNK chunks or append it
+  const auto place = [&](size_t old, Blob data) {
+    if (old != none && !data.empty() && fits(spanEnd(old) - chunks[old].offset, data.size())) {
+      const uint64_t offset = chunks[old].offset;
+      const uint64_t space = spanEnd(old) - offset;
+      if (space > data.size())
+        runs.push_back({offset + data.size(), space - data.size()});
+      writeAt(offset, std::move(data), space);
+      return;
+    }
+    if (old != none) {
+      Blob junk(4);
+      ul2Data(junk.data(), fourcc("JUNK"), bigEndian);
+      writes.push_back({chunks[old].offset, std::move(junk)});
+      runs.push_back({chunks[old].offset, spanEnd(old) - chunks[old].offset});
+    }
+    if (data.empty())
+      return;
+    auto run = std::find_if(runs.begin(), runs.end(), [&](const Run& r) { return fits(r.size, data.size()); });
+    if (run != runs.end()) {
+      const uint64_t offset = run->offset;
+      const uint64_t space = run->size;
+      run->offset += data.size();
+      run->size -= data.size();
+      writeAt(offset, std::move(data), space);
+      return;
+    }
+    appended.insert(appended.end(), data.begin(), data.end());
+  };
+
+  // INFO list: the chunks of changed properties get the new value where they are, those of removed
+  // properties are dropped and the other chunks are kept as they are. Changed properties without
+  // a chunk are added at the end.
+  const auto appendProperty = [&](Blob& payload, uint32_t id, const std::string& key) {
+    auto it = xmpData_.findKey(XmpKey(key));
+    if (it == xmpData_.end())
+      return;
+    // Strings are zero terminated
+    const std::string value = it->toString();
+    appendChunk(payload, id, reinterpret_cast<const byte*>(value.c_str()), value.size() + 1);
+  };
+  std::vector<std::string> inInfo;
+  Blob oldInfo;
+  Blob infoPayload;
+  if (info != none) {
+    const DataBuf payload = walker.readPayload(chunks[info], maxMetadataChunkSize);
+    oldInfo.assign(payload.cbegin() + 4, payload.cend());
+    MemIo list(payload.c_data(), payload.size());
+    ContainerWalker listWalker(list, ContainerFormat::riff);
+    listWalker.setTruncatedAllowed(true);
+    listWalker.walk(4, list.size(), [&](const ContainerEntry& chunk) {
+      auto tag = infoTags.find(fourccToString(chunk.id));
+      if (tag != infoTags.end())
+        inInfo.push_back(tag->second);
+      if (tag != infoTags.end() && changed(tag->second))
+        appendProperty(infoPayload, static_cast<uint32_t>(chunk.id), tag->second);
+      else
+        infoPayload.insert(infoPayload.end(), payload.c_data(toSize(chunk.offset)),
+                           payload.c_data() + toSize(std::min<FileOffset>(listWalker.nextOffset(chunk), list.size())));
+      return WalkAction::next;
+    });
+  }
+  for (auto&& [id, key] : infoChunksToWrite()) {
+    if (changed(key) && std::find(inInfo.begin(), inInfo.end(), key) == inInfo.end())
+      appendProperty(infoPayload, getULong(reinterpret_cast<const byte*>(id.data()), bigEndian), key);
+  }
+  if (infoPayload != oldInfo) {
+    Blob list;
+    if (!infoPayload.empty()) {
+      infoPayload.insert(infoPayload.begin(), {'I', 'N', 'F', 'O'});
+      appendChunk(list, fourcc("LIST"), infoPayload.data(), infoPayload.size());
+    }
+    place(info, std::move(list));
+  }
+
+  // XMP packet
+  std::string oldPacket;
+  if (xmp != none) {
+    const DataBuf payload = walker.readPayload(chunks[xmp], maxMetadataChunkSize);
+    oldPacket.assign(payload.c_str(), payload.size());
+  }
+  if (xmpPacket_ != oldPacket) {
+    Blob chunk;
+    if (!xmpPacket_.empty())
+      appendChunk(chunk, fourcc("_PMX"), reinterpret_cast<const byte*>(xmpPacket_.data()), xmpPacket_.size());
+    place(xmp, std::move(chunk));
+  }
+
+  // Appended chunks extend the last RIFF chunk, which must therefore end the file
+  if (appended.size() > alignment) {
+    enforce(appendOffset == io_->size(), ErrorCode::kerImageWriteFailed);
+    const uint64_t size = lastRiff.size + appended.size();
+    enforce(size <= std::numeric_limits<uint32_t>::max(), ErrorCode::kerImageWriteFailed);
+    Blob field(4);
+    ul2Data(field.data(), static_cast<uint32_t>(size), littleEndian);
+    writes.push_back({lastRiff.offset + 4, std::move(field)});
+    writes.push_back({appendOffset, std::move(appended)});
+  }
+
+  for (auto&& write : writes) {
+    io_->seekOrThrow(toSeekOffset(write.offset), BasicIo::beg, ErrorCode::kerImageWriteFailed);
+    if (io_->write(write.data.data(), write.data.size()) != write.data.size())
+      throw Error(ErrorCode::kerImageWriteFailed);
+  }
 }  // RiffVideo::writeMetadata
 
 void RiffVideo::readMetadata() {
@@ -382,6 +629,8 @@ void RiffVideo::readMetadata() {
 
   IoCloser closer(*io_);
   clearMetadata();
+  readXmpData_.clear();
+  frameRate_ = 0;
 
   xmpData_["Xmp.video.FileSize"] = io_->size();
   xmpData_["Xmp.video.MimeType"] = mimeType();
@@ -392,6 +641,7 @@ void RiffVideo::readMetadata() {
   xmpData_["Xmp.video.FileType"] = readStringTag(io_);
 
   decodeBlocks();
+  readXmpData_ = xmpData_;
 }  // RiffVideo::readMetadata
 
 RiffVideo::HeaderReader::HeaderReader(const BasicIo::UniquePtr& io) {
@@ -450,6 +700,8 @@ void RiffVideo::readChunk(const HeaderReader& header_) {
     readDataChunk(header_.getSize());
   else if (equal(header_.getId(), CHUNK_ID_JUNK))
     readJunk(header_.getSize());
+  else if (equal(header_.getId(), CHUNK_ID_DMLH))
+    readOdmlHeader(header_.getSize());
   else {
 #ifdef EXIV2_DEBUG_MESSAGES
     if (header_.getSize())
@@ -461,13 +713,44 @@ void RiffVideo::readChunk(const HeaderReader& header_) {
 }
 
 void RiffVideo::decodeBlocks() {
-  do {
-    if (HeaderReader header(io_); equal(header.getId(), CHUNK_ID_LIST)) {
-      readList(header);
-    } else {
-      readChunk(header);
+  // Recordings which were interrupted end in a truncated chunk: read what is there
+  Internal::ContainerWalker walker(*io_, Internal::ContainerFormat::riff);
+  walker.setTruncatedAllowed(true);
+  XmpData packetData;
+  walker.walk(io_->tell(), io_->size(), [&](const Internal::ContainerEntry& chunk) {
+    const HeaderReader header(Internal::fourccToString(chunk.id), chunk.size);
+    if (chunk.id == Internal::fourcc("LIST")) {
+      if (chunk.formType == Internal::fourcc("movi"))
+        return Internal::WalkAction::next;  // Media data
+      if (chunk.formType == Internal::fourcc("INFO")) {
+        io_->seekOrThrow(Internal::toSeekOffset(chunk.childOffset), BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+        readInfoListChunk(header.getSize());
+        return Internal::WalkAction::next;
+      }
+      return Internal::WalkAction::descend;
     }
-  } while (!io_->eof() && io_->tell() < io_->size());
+    if (chunk.id == Internal::fourcc("RIFF"))
+      return Internal::WalkAction::descend;  // OpenDML extension of files larger than 1 GB
+    if (chunk.id == Internal::fourcc("_PMX")) {
+      const DataBuf packet = walker.readPayload(chunk, Internal::maxMetadataChunkSize);
+      xmpPacket_.assign(packet.c_str(), packet.size());
+      if (!xmpPacket_.empty() && XmpParser::decode(packetData, xmpPacket_)) {
+#ifndef SUPPRESS_WARNINGS
+        EXV_WARNING << "Failed to decode XMP metadata.\n";
+#endif
+      }
+      return Internal::WalkAction::next;
+    }
+    // Standard and OpenDML indexes are large and carry no metadata
+    if (chunk.id == Internal::fourcc("idx1") || chunk.id == Internal::fourcc("indx") ||
+        (chunk.id >> 16) == (Internal::fourcc("ix00") >> 16))
+      return Internal::WalkAction::next;
+    io_->seekOrThrow(Internal::toSeekOffset(chunk.dataOffset), BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+    readChunk(header);
+    return Internal::WalkAction::next;
+  });
+  for (const auto& xmp : packetData)
+    xmpData_.add(xmp);
 }  // RiffVideo::decodeBlock
 
 void RiffVideo::readAviHeader() {
@@ -493,6 +776,7 @@ void RiffVideo::readAviHeader() {
   uint32_t TimeBetweenFrames = readDWORDTag(io_);
   xmpData_["Xmp.video.MicroSecPerFrame"] = TimeBetweenFrames;
   double frame_rate = 1000000. / TimeBetweenFrames;
+  frameRate_ = frame_rate;
 
   xmpData_["Xmp.video.MaxDataRate"] = readDWORDTag(io_);  // MaximumDataRate
 
@@ -660,6 +944,11 @@ void RiffVideo::readInfoListChunk(uint64_t size_) {
     if (auto it = Internal::infoTags.find(type); it != Internal::infoTags.end())
       xmpData_[it->second] = content;
     current_size += DWORD * 2 + size;
+    // Chunks are padded to an even size
+    if (size % 2 != 0 && current_size < size_) {
+      io_->seekOrThrow(io_->tell() + 1, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+      current_size += 1;
+    }
   }
 }
 
@@ -733,6 +1022,16 @@ void RiffVideo::readJunk(uint64_t size_) const {
   io_->seekOrThrow(io_->tell() + size_, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
 }
 
+void RiffVideo::readOdmlHeader(uint64_t size_) {
+  if (size_ < DWORD)
+    return;
+  const uint32_t frame_count = readDWORDTag(io_);  // dwTotalFrames
+  if (frame_count == 0)
+    return;
+  xmpData_["Xmp.video.FrameCount"] = frame_count;
+  fillDuration(frameRate_, frame_count);
+}
+
 std::string RiffVideo::getStreamType(uint32_t stream) {
   if (stream == 1)
     return "Mono";
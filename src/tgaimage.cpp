@@ -7,7 +7,10 @@
 #include "config.h"
 #include "error.hpp"
 #include "futils.hpp"
+#include "helper_functions.hpp"
 #include "image.hpp"
+#include "image_int.hpp"
+#include "xmp_exiv2.hpp"
 
 #ifdef EXIV2_DEBUG_MESSAGES
 #include <iostream>
@@ -16,7 +19,20 @@
 // *****************************************************************************
 // class member definitions
 namespace Exiv2 {
-TgaImage::TgaImage(BasicIo::UniquePtr io) : Image(ImageType::tga, mdNone, std::move(io)) {
+namespace {
+//! Size of the TGA 2.0 footer and of the extension area it points to
+constexpr size_t tgaFooterSize = 26;
+constexpr size_t tgaExtensionAreaSize = 495;
+
+//! Copy a space or NUL padded ASCII field out of the extension area
+std::string tgaString(const byte* data, size_t size) {
+  std::string s = string_from_unterminated(reinterpret_cast<const char*>(data), size);
+  s.erase(s.find_last_not_of(' ') + 1);
+  return s;
+}
+}  // namespace
+
+TgaImage::TgaImage(BasicIo::UniquePtr io) : Image(ImageType::tga, mdXmp | mdComment, std::move(io)) {
 }
 
 std::string TgaImage::mimeType() const {
@@ -81,8 +97,90 @@ void TgaImage::readMetadata() {
     pixelWidth_ = getShort(buf + 12, littleEndian);
     pixelHeight_ = getShort(buf + 14, littleEndian);
   }
+  readExtensionArea();
 }  // TgaImage::readMetadata
 
+void TgaImage::readExtensionArea() {
+  /*
+    TARGA 2.0 files end with a 26 byte footer:
+
+    offset  length   name
+    ======  =======  ===================================
+     0      4 bytes  extension area offset (0 = none)
+     4      4 bytes  developer directory offset
+     8     18 bytes  signature "TRUEVISION-XFILE.\0"
+
+    The extension area holds the metadata we are interested in:
+
+    offset  length     name
+    ======  =========  =================================
+      0       2 bytes  extension size (always 495)
+      2      41 bytes  author name
+     43     324 bytes  author comments (4 lines of 81 bytes)
+    367      12 bytes  date/time stamp (month, day, year, hour, minute, second)
+    379      41 bytes  job name/ID
+    420       6 bytes  job time
+    426      41 bytes  software ID
+    467       3 bytes  software version (number * 100, letter)
+  */
+  const size_t size = io_->size();
+  if (size < 18 + tgaFooterSize)
+    return;
+  byte footer[tgaFooterSize];
+  io_->seekOrThrow(size - tgaFooterSize, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  io_->readOrThrow(footer, sizeof(footer), ErrorCode::kerFailedToReadImageData);
+  if (memcmp(footer + 8, "TRUEVISION-XFILE", 16) != 0)
+    return;
+  const size_t offset = getULong(footer, littleEndian);
+  if (offset == 0 || offset > size - tgaFooterSize || size - tgaFooterSize - offset < tgaExtensionAreaSize)
+    return;
+
+  byte ext[tgaExtensionAreaSize];
+  io_->seekOrThrow(offset, BasicIo::beg, ErrorCode::kerFailedToReadImageData);
+  io_->readOrThrow(ext, sizeof(ext), ErrorCode::kerFailedToReadImageData);
+  if (getUShort(ext, littleEndian) != tgaExtensionAreaSize) {
+#ifndef SUPPRESS_WARNINGS
+    EXV_WARNING << "Unsupported TARGA extension area size.\n";
+#endif
+    return;
+  }
+
+  if (auto author = tgaString(ext + 2, 41); !author.empty())
+    xmpData_["Xmp.dc.creator"] = author;
+
+  std::string comment;
+  for (size_t line = 0; line < 4; ++line) {
+    auto text = tgaString(ext + 43 + (line * 81), 81);
+    if (text.empty())
+      continue;
+    if (!comment.empty())
+      comment += '\n';
+    comment += text;
+  }
+  comment_ = std::move(comment);
+
+  const uint16_t month = getUShort(ext + 367, littleEndian);
+  const uint16_t day = getUShort(ext + 369, littleEndian);
+  const uint16_t year = getUShort(ext + 371, littleEndian);
+  if (year != 0 && month >= 1 && month <= 12 && day >= 1 && day <= 31) {
+    xmpData_["Xmp.xmp.CreateDate"] =
+        stringFormat("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}", year, month, day, getUShort(ext + 373, littleEndian),
+                     getUShort(ext + 375, littleEndian), getUShort(ext + 377, littleEndian));
+  }
+
+  if (auto job = tgaString(ext + 379, 41); !job.empty())
+    xmpData_["Xmp.dc.title"] = job;
+
+  if (auto software = tgaString(ext + 426, 41); !software.empty()) {
+    if (const uint16_t version = getUShort(ext + 467, littleEndian); version != 0) {
+      software += stringFormat(" {}.{:02}", version / 100, version % 100);
+      if (ext[469] != ' ' && ext[469] != 0)
+        software += static_cast<char>(ext[469]);
+    }
+    xmpData_["Xmp.xmp.CreatorTool"] = software;
+  }
+}  // TgaImage::readExtensionArea
+
 void TgaImage::writeMetadata() {
   // Todo: implement me!
   throw(Error(ErrorCode::kerWritingImageFormatUnsupported, "TGA"));
@@ -106,7 +204,7 @@ bool isTgaType(BasicIo& iIo, bool /*advance*/) {
   }
   byte buf[26];
   const size_t curPos = iIo.tell();
-  if (curPos < 26)
+  if (iIo.size() < 26)
     return false;
 
   iIo.seek(-26, BasicIo::end);
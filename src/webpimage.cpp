@@ -10,6 +10,7 @@
 
 #include "basicio.hpp"
 #include "config.h"
+#include "containerwalker_int.hpp"
 #include "convert.hpp"
 #include "enforce.hpp"
 #include "futils.hpp"
@@ -485,7 +486,6 @@ void WebPImage::readMetadata() {
 
 void WebPImage::decodeChunks(uint32_t filesize) {
   DataBuf chunkId(5);
-  std::array<byte, WEBP_TAG_SIZE> size_buff;
   bool has_canvas_data = false;
 
 #ifdef EXIV2_DEBUG_MESSAGES
@@ -493,26 +493,27 @@ void WebPImage::decodeChunks(uint32_t filesize) {
 #endif
 
   chunkId.write_uint8(4, '\0');
-  while (!io_->eof() && io_->tell() < filesize) {
-    io_->readOrThrow(chunkId.data(), WEBP_TAG_SIZE, Exiv2::ErrorCode::kerCorruptedMetadata);
-    io_->readOrThrow(size_buff.data(), WEBP_TAG_SIZE, Exiv2::ErrorCode::kerCorruptedMetadata);
-
-    const uint32_t size = Exiv2::getULong(size_buff.data(), littleEndian);
-
-    // Check that `size` is within bounds.
-    Internal::enforce(io_->tell() <= filesize, Exiv2::ErrorCode::kerCorruptedMetadata);
-    Internal::enforce(size <= (filesize - io_->tell()), Exiv2::ErrorCode::kerCorruptedMetadata);
-
-    if (DataBuf payload(size); payload.empty()) {
-      io_->seek(size, BasicIo::cur);
-    } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) && !has_canvas_data) {
+  // Only the payloads of the chunks decoded below are read, the image data is skipped
+  Internal::ContainerWalker walker(*io_, Internal::ContainerFormat::riff, 0);
+  walker.walk(io_->tell(), filesize, [&](const Internal::ContainerEntry& chunk) {
+    ul2Data(chunkId.data(), static_cast<uint32_t>(chunk.id), bigEndian);
+    const bool canvasChunk =
+        equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) || equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8) ||
+        equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8L) || equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ANMF);
+    const bool metadataChunk = equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ICCP) ||
+                               equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_EXIF) ||
+                               equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_XMP);
+    if (chunk.size == 0 || (canvasChunk && has_canvas_data) || (!canvasChunk && !metadataChunk))
+      return Internal::WalkAction::next;
+
+    const auto size = static_cast<size_t>(chunk.size);
+    DataBuf payload = walker.readPayload(chunk, size);
+    if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) && !has_canvas_data) {
       Internal::enforce(size >= 10, Exiv2::ErrorCode::kerCorruptedMetadata);
 
       has_canvas_data = true;
       std::array<byte, WEBP_TAG_SIZE> size_buf;
 
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
-
       // Fetch width
       std::copy_n(payload.begin() + 4, 3, size_buf.begin());
       size_buf.back() = 0;
@@ -526,7 +527,6 @@ void WebPImage::decodeChunks(uint32_t filesize) {
       Internal::enforce(size >= 10, Exiv2::ErrorCode::kerCorruptedMetadata);
 
       has_canvas_data = true;
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
       std::array<byte, WEBP_TAG_SIZE> size_buf;
 
       // Fetch width""
@@ -547,8 +547,6 @@ void WebPImage::decodeChunks(uint32_t filesize) {
       std::array<byte, 2> size_buf_w;
       std::array<byte, 3> size_buf_h;
 
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
-
       // Fetch width
       std::copy_n(payload.begin() + 1, 2, size_buf_w.begin());
       size_buf_w.back() &= 0x3F;
@@ -565,8 +563,6 @@ void WebPImage::decodeChunks(uint32_t filesize) {
       has_canvas_data = true;
       std::array<byte, WEBP_TAG_SIZE> size_buf;
 
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
-
       // Fetch width
       std::copy_n(payload.begin() + 6, 3, size_buf.begin());
       size_buf.back() = 0;
@@ -577,11 +573,8 @@ void WebPImage::decodeChunks(uint32_t filesize) {
       size_buf.back() = 0;
       pixelHeight_ = Exiv2::getULong(size_buf.data(), littleEndian) + 1;
     } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ICCP)) {
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
       this->setIccProfile(std::move(payload));
     } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_EXIF)) {
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
-
       std::array<byte, 2> size_buff2;
       // 4 meaningful bytes + 2 padding bytes
       auto exifLongHeader = std::array<byte, 6>{0xFF, 0x01, 0xFF, 0xE1, 0x00, 0x00};
@@ -654,7 +647,6 @@ void WebPImage::decodeChunks(uint32_t filesize) {
         exifData_.clear();
       }
     } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_XMP)) {
-      io_->readOrThrow(payload.data(), payload.size(), Exiv2::ErrorCode::kerCorruptedMetadata);
       xmpPacket_.assign(payload.c_str(), payload.size());
       if (!xmpPacket_.empty() && XmpParser::decode(xmpData_, xmpPacket_)) {
 #ifndef SUPPRESS_WARNINGS
@@ -666,13 +658,9 @@ void WebPImage::decodeChunks(uint32_t filesize) {
         std::cout << binaryToHex(payload.c_data(), payload.size());
 #endif
       }
-    } else {
-      io_->seek(size, BasicIo::cur);
     }
-
-    if (io_->tell() % 2)
-      io_->seek(+1, BasicIo::cur);
-  }
+    return Internal::WalkAction::next;
+  });
 }
 
 /* =========================================== */
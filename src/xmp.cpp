@@ -633,6 +633,11 @@ void XmpParser::registerNs(const std::string& ns, const std::string& prefix) {
   try {
     initialize();
     AutoLock autoLock(xmpLockFct_, pLockData_);
+    // Namespaces are registered again for each packet encoded or decoded: leave them alone if
+    // they did not change, rather than remove them while other threads may be parsing
+    std::string registered;
+    if (SXMPMeta::GetNamespacePrefix(ns.c_str(), &registered) && registered == prefix + ":")
+      return;
     SXMPMeta::DeleteNamespace(ns.c_str());
 #ifdef EXV_ADOBE_XMPSDK
     SXMPMeta::RegisterNamespace(ns.c_str(), prefix.c_str(), nullptr);
@@ -906,6 +911,20 @@ int XmpParser::encode(std::string& /*xmpPacket*/, const XmpData& xmpData, uint16
 }  // XmpParser::encode
 #endif  // !EXV_HAVE_XMP_TOOLKIT
 
+CanonicalMetadata canonicalMetadata(const XmpData& xmpData) {
+  CanonicalMetadata metadata;
+  metadata.reserve(xmpData.count());
+  for (const auto& md : xmpData)
+    metadata.emplace_back(md.key(), md.toString());
+  std::stable_sort(metadata.begin(), metadata.end(),
+                   [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  return metadata;
+}
+
+uint64_t digest(const XmpData& xmpData) {
+  return digest(canonicalMetadata(xmpData));
+}
+
 }  // namespace Exiv2
 
 // *****************************************************************************
@@ -0,0 +1,35 @@
+# -*- coding: utf-8 -*-
+
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class AdjustPatchesJpegInPlace(metaclass=CaseMeta):
+    """Values that keep their size are written over the old ones, the rest of the file is not rewritten."""
+
+    def setUp(self):
+        shutil.copy(self.original, self.filename)
+
+    def tearDown(self):
+        with open(self.original, "rb") as original, open(self.filename, "rb") as patched:
+            before = original.read()
+            after = patched.read()
+        self.assertEqual(len(before), len(after))
+        self.assertLessEqual(sum(1 for b, a in zip(before, after) if b != a), 3 * 19)
+
+    original = path("$data_path/exiv2-nikon-d70.jpg")
+    filename = path("$tmp_path/exiv2-nikon-d70_in_place.jpg")
+    commands = [
+        "$exiv2 -a 1:00 -D 2 adjust $filename",
+        "$exiv2 -PEkt -g DateTime $filename",
+    ]
+    stdout = [
+        "",
+        """Exif.Image.DateTime                           2004:04:01 11:43:46
+Exif.Photo.DateTimeOriginal                   2004:04:01 11:43:46
+Exif.Photo.DateTimeDigitized                  2004:04:01 11:43:46
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
@@ -0,0 +1,37 @@
+# -*- coding: utf-8 -*-
+
+import filecmp
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class AsfWriteFailsForPropertiesWithoutAttribute(metaclass=CaseMeta):
+    """Only the WM/ attributes are stored in ASF files, setting other XMP properties fails."""
+
+    def setUp(self):
+        shutil.copy(self.original, self.filename)
+
+    def tearDown(self):
+        self.assertTrue(filecmp.cmp(self.original, self.filename, shallow=False))
+        os.remove(self.filename)
+
+    original = path("$data_path/sample_960x540.asf")
+    filename = path("$tmp_path/sample_960x540_unstored.asf")
+    commands = [
+        "$exiv2 -M\"set Xmp.dc.title Hello\" $filename",
+        "$exiv2 -M\"set Xmp.video.Title Hello\" $filename",
+    ]
+    stdout = [""] * len(commands)
+    stderr = [
+        """Warning: This file format cannot store the XMP properties Xmp.dc.title.
+Exiv2 exception in modify action for file $filename:
+Failed to write image
+""",
+        """Warning: This file format cannot store the XMP properties Xmp.video.Title.
+Exiv2 exception in modify action for file $filename:
+Failed to write image
+""",
+    ]
+    retval = [1] * len(commands)
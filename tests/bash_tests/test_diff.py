@@ -0,0 +1,86 @@
+# -*- coding: utf-8 -*-
+
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class DiffComparesCanonicalMetadata(metaclass=CaseMeta):
+    """Files with the same metadata compare equal, the others print the metadata that differs."""
+
+    def setUp(self):
+        os.makedirs(os.path.join(self.left, "sub"))
+        os.makedirs(os.path.join(self.right, "sub"))
+        shutil.copy(self.canon, os.path.join(self.left, "a.jpg"))
+        shutil.copy(self.canon, os.path.join(self.right, "a.jpg"))
+        shutil.copy(self.nikon, os.path.join(self.left, "sub", "b.jpg"))
+        shutil.copy(self.nikon, os.path.join(self.right, "sub", "b.jpg"))
+        shutil.copy(self.sony, os.path.join(self.left, "c.jpg"))
+
+    def tearDown(self):
+        shutil.rmtree(self.left)
+        shutil.rmtree(self.right)
+
+    canon = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    sony = path("$data_path/exiv2-sony-dsc-w7.jpg")
+    left = path("$tmp_path/diff_left")
+    right = path("$tmp_path/diff_right")
+    a1 = path("$tmp_path/diff_left/a.jpg")
+    a2 = path("$tmp_path/diff_right/a.jpg")
+    commands = [
+        "$exiv2 diff $a1 $a2",
+        "$exiv2 -a 1:00 adjust $a2",
+        "$exiv2 diff $a1 $a2",
+        "$exiv2 -v diff $a1 $a2",
+        "$exiv2 -j 2 diff $left $right",
+        "$exiv2 diff $left $a2",
+    ]
+    stdout = [
+        "",
+        "",
+        """--- $a1
++++ $a2
+- Exif.Image.DateTime                          2003:12:14 12:01:44
++ Exif.Image.DateTime                          2003:12:14 13:01:44
+- Exif.Photo.DateTimeDigitized                 2003:12:14 12:01:44
++ Exif.Photo.DateTimeDigitized                 2003:12:14 13:01:44
+- Exif.Photo.DateTimeOriginal                  2003:12:14 12:01:44
++ Exif.Photo.DateTimeOriginal                  2003:12:14 13:01:44
+""",
+        """File 1: $a1
+--- $a1
++++ $a2
+- Exif.Image.DateTime                          2003:12:14 12:01:44
++ Exif.Image.DateTime                          2003:12:14 13:01:44
+- Exif.Photo.DateTimeDigitized                 2003:12:14 12:01:44
++ Exif.Photo.DateTimeDigitized                 2003:12:14 13:01:44
+- Exif.Photo.DateTimeOriginal                  2003:12:14 12:01:44
++ Exif.Photo.DateTimeOriginal                  2003:12:14 13:01:44
+""",
+        """--- $a1
++++ $a2
+- Exif.Image.DateTime                          2003:12:14 12:01:44
++ Exif.Image.DateTime                          2003:12:14 13:01:44
+- Exif.Photo.DateTimeDigitized                 2003:12:14 12:01:44
++ Exif.Photo.DateTimeDigitized                 2003:12:14 13:01:44
+- Exif.Photo.DateTimeOriginal                  2003:12:14 12:01:44
++ Exif.Photo.DateTimeOriginal                  2003:12:14 13:01:44
+Only in $left: c.jpg
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        "",
+        "",
+        "",
+        "",
+        "",
+        """exiv2: Diff action cannot compare a file with a directory
+""",
+    ]
+    retval = [0, 0, 1, 1, 1, 1]
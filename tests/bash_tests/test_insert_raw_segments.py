@@ -0,0 +1,128 @@
+# -*- coding: utf-8 -*-
+
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+def exif_segment(filename):
+    with open(filename, "rb") as f:
+        data = f.read()
+    start = data.index(b"Exif\0\0") - 4
+    assert data[start : start + 2] == b"\xff\xe1"
+    return data[start : start + 2 + int.from_bytes(data[start + 2 : start + 4], "big")]
+
+
+def photoshop_resources(filename):
+    """The ids of the Photoshop resources in the APP13 segments of a JPEG file"""
+    with open(filename, "rb") as f:
+        data = f.read()
+    resources = []
+    pos = 2
+    while data[pos] == 0xFF and data[pos + 1] not in (0xD9, 0xDA):
+        length = int.from_bytes(data[pos + 2 : pos + 4], "big")
+        segment = data[pos + 4 : pos + 2 + length]
+        if data[pos + 1] == 0xED and segment.startswith(b"Photoshop 3.0\0"):
+            irb = 14
+            while segment[irb : irb + 4] == b"8BIM":
+                resources.append(int.from_bytes(segment[irb + 4 : irb + 6], "big"))
+                name = segment[irb + 6] + 1
+                name += name & 1
+                size = int.from_bytes(segment[irb + 6 + name : irb + 10 + name], "big")
+                irb += 10 + name + size + (size & 1)
+        pos += 2 + length
+    return resources
+
+
+class InsertCopiesJpegSegmentsAsTheyAre(metaclass=CaseMeta):
+    """Metadata inserted from a JPEG into a JPEG without metadata is copied byte for byte."""
+
+    def setUp(self):
+        os.makedirs(self.masters)
+        os.makedirs(self.derivatives)
+        shutil.copy(self.nikon, self.master)
+        shutil.copy(self.nikon, self.derivative)
+
+    def tearDown(self):
+        self.assertEqual(exif_segment(self.master), exif_segment(self.derivative))
+        shutil.rmtree(self.masters)
+        shutil.rmtree(self.derivatives)
+
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    masters = path("$tmp_path/raw_segments_masters")
+    derivatives = path("$tmp_path/raw_segments_derivatives")
+    master = path("$tmp_path/raw_segments_masters/image.jpg")
+    derivative = path("$tmp_path/raw_segments_derivatives/image.jpg")
+    commands = [
+        "$exiv2 -M\"set Xmp.dc.title master\" -M\"add Iptc.Application2.Keywords master\" -c comment $master",
+        "$exiv2 -da $derivative",
+        "$exiv2 -v -l $masters -S .jpg insert $derivative",
+        "$exiv2 diff $master $derivative",
+        "$exiv2 -l $masters -S .jpg -ix insert $derivative",
+        "$exiv2 -PXkt $derivative",
+    ]
+    stdout = [
+        "",
+        "",
+        """File 1/1: $derivative
+Writing Exif data from $master to $derivative
+Writing XMP data from $master to $derivative
+Writing IPTC data from $master to $derivative
+Writing JPEG comment from $master to $derivative
+""",
+        "",
+        "",
+        """Xmp.dc.title                                  lang="x-default" master
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
+
+
+class InsertCopiesOnlyTheIptcOfPhotoshopSegments(metaclass=CaseMeta):
+    """Of the Photoshop segments, only the IPTC data is copied, like the metadata classes do."""
+
+    def setUp(self):
+        for directory in [self.masters, self.empty_masters, self.derivatives]:
+            os.makedirs(directory)
+        shutil.copy(self.with_iptc, self.master)
+        shutil.copy(self.without_iptc, self.empty_master)
+        shutil.copy(self.nikon, self.derivative)
+
+    def tearDown(self):
+        self.assertEqual([0x0404], photoshop_resources(self.derivative))
+        for directory in [self.masters, self.empty_masters, self.derivatives]:
+            shutil.rmtree(directory)
+
+    with_iptc = path("$data_path/iptc-psAPP13-wIPTCmid.jpg")
+    without_iptc = path("$data_path/iptc-psAPP13-noIPTC.jpg")
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    masters = path("$tmp_path/iptc_segments_masters")
+    empty_masters = path("$tmp_path/iptc_segments_empty_masters")
+    derivatives = path("$tmp_path/iptc_segments_derivatives")
+    master = path("$tmp_path/iptc_segments_masters/image.jpg")
+    empty_master = path("$tmp_path/iptc_segments_empty_masters/image.jpg")
+    derivative = path("$tmp_path/iptc_segments_derivatives/image.jpg")
+    commands = [
+        "$exiv2 -da $derivative",
+        "$exiv2 -v -l $empty_masters -S .jpg -ii insert $derivative",
+        "$exiv2 -PIkv $derivative",
+        "$exiv2 -v -l $masters -S .jpg -ii insert $derivative",
+        "$exiv2 -PIkv $derivative",
+    ]
+    stdout = [
+        "",
+        """File 1/1: $derivative
+""",
+        "",
+        """File 1/1: $derivative
+Writing IPTC data from $master to $derivative
+""",
+        """Iptc.Application2.RecordVersion               0
+Iptc.Application2.Credit                      This is a credit
+Iptc.Application2.Byline                      This is a by-line
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
@@ -0,0 +1,31 @@
+# -*- coding: utf-8 -*-
+
+from system_tests import CaseMeta, CopyTmpFiles, path
+
+
+@CopyTmpFiles("$data_path/issue_2233_poc1.jxl")
+class TestJXLWriteXmp(metaclass=CaseMeta):
+    """
+    Writing XMP to a JPEG XL container keeps the codestream box intact
+    and replaces the existing metadata boxes.
+    """
+
+    filename = path("$tmp_path/issue_2233_poc1.jxl")
+    commands = [
+        '$exiv2 -M"set Xmp.dc.title bar" $filename',
+        "$exiv2 -pS $filename",
+        "$exiv2 -Pkv -K Xmp.dc.title $filename",
+    ]
+    stdout = [
+        "",
+        """Exiv2::BmffImage::boxHandler: JXL         0->12 
+Exiv2::BmffImage::boxHandler: ftyp       12->20 brand: jxl 
+Exiv2::BmffImage::boxHandler: Exif       32->258 
+Exiv2::BmffImage::boxHandler: xml       290->3899 
+Exiv2::BmffImage::boxHandler: jxlc     4189->15060 
+""",
+        """Xmp.dc.title                                  lang="x-default" bar
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
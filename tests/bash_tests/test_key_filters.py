@@ -0,0 +1,64 @@
+# -*- coding: utf-8 -*-
+
+from system_tests import CaseMeta, path
+
+
+class GrepLiteralsAndRegularExpressions(metaclass=CaseMeta):
+    """Patterns without special characters are matched like the regular expressions they are."""
+
+    filename = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    commands = [
+        "$exiv2 -Pkt -g Model $filename",
+        "$exiv2 -Pkt -g MODELID/i -g Image.Mo.el $filename",
+        "$exiv2 -Pkt -g 'Canon.*Model' -g ^Exif.Image.Make $filename",
+        "$exiv2 -Pkt -g Model+ $filename",
+        "$exiv2 -Pkt -g 'Exif.Image.(Make|Model)' $filename",
+        "$exiv2 -Pkt -g 'Image.Mo[a-z]\\{3\\}$' -g 'Image.\\(Ma\\)ke' $filename",
+    ]
+    stdout = [
+        """Exif.Image.Model                              Canon PowerShot S40
+Exif.Canon.ModelID                            PowerShot S40
+""",
+        """Exif.Image.Model                              Canon PowerShot S40
+Exif.Canon.ModelID                            PowerShot S40
+""",
+        """Exif.Image.Make                               Canon
+Exif.Canon.ModelID                            PowerShot S40
+""",
+        "",
+        "",
+        """Exif.Image.Make                               Canon
+Exif.Image.Model                              Canon PowerShot S40
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0, 0, 0, 1, 1, 0]
+
+
+class KeysOutsideOfMakernotes(metaclass=CaseMeta):
+    """The makernote is only decoded if a -K key can be found in it."""
+
+    filename = path("$data_path/exiv2-bug528.jpg")
+    commands = [
+        "$exiv2 -Pkt -K Exif.Image.Model -K Exif.Photo.ExposureTime $filename",
+        "$exiv2 -Pkt -K Exif.Image.Model -K Exif.MakerNote.ByteOrder $filename",
+        "$exiv2 -Pkt -K Exif.Image.Model -K Exif.Canon.ModelID $filename",
+    ]
+    stdout = [
+        """Exif.Image.Model                              Canon EOS 40D
+Exif.Photo.ExposureTime                       1/250 s
+""",
+        """Exif.Image.Model                              Canon EOS 40D
+Exif.MakerNote.ByteOrder                      MM
+""",
+        """Exif.Image.Model                              Canon EOS 40D
+""",
+    ]
+    stderr = [
+        "",
+        """Warning: Directory Canon, entry 0x0200 has unknown Exif (TIFF) type 768; setting type size 1.
+""",
+        """Warning: Directory Canon, entry 0x0200 has unknown Exif (TIFF) type 768; setting type size 1.
+""",
+    ]
+    retval = [0] * len(commands)
@@ -0,0 +1,34 @@
+# -*- coding: utf-8 -*-
+
+from system_tests import CaseMeta, CopyFiles, path
+
+
+@CopyFiles("$data_path/exiv2-canon-powershot-s40.jpg", "$data_path/exiv2-empty.jpg")
+class ModifyCommandsAppliedToSeveralFiles(metaclass=CaseMeta):
+    """The modification commands are applied to each file as if they were run one after the other."""
+
+    filename_1 = path("$data_path/exiv2-canon-powershot-s40_copy.jpg")
+    filename_2 = path("$data_path/exiv2-empty_copy.jpg")
+    commands = [
+        """$exiv2 -M"add Iptc.Application2.Keywords k1" -M"add Iptc.Application2.Keywords k2" -M"del Iptc.Application2.Keywords" -M"add Iptc.Application2.Keywords k3" -M"set Exif.Image.Artist one" -M"set Exif.Image.Artist two" -M"set Iptc.Application2.DateCreated 2020-13-45" -M"set Xmp.dc.subject s1" -M"set Xmp.dc.subject s2" -M"del Exif.Image.Make" $filename_1 $filename_2""",
+        "$exiv2 -PEIXkt -g Keywords -g Artist -g DateCreated -g dc.subject -g Exif.Image.Make $filename_1 $filename_2",
+    ]
+    stdout = [
+        "",
+        """$filename_1  Exif.Image.Artist                             two
+$filename_1  Iptc.Application2.Keywords                    k3
+$filename_1  Xmp.dc.subject                                s1, s2
+$filename_2  Exif.Image.Artist                             two
+$filename_2  Iptc.Application2.Keywords                    k3
+$filename_2  Xmp.dc.subject                                s1, s2
+""",
+    ]
+    stderr = [
+        """Warning: Unsupported date format
+Warning: Iptc.Application2.DateCreated: Failed to read Date value "2020-13-45"
+Warning: Unsupported date format
+Warning: Iptc.Application2.DateCreated: Failed to read Date value "2020-13-45"
+""",
+        "",
+    ]
+    retval = [1, 0]
@@ -0,0 +1,40 @@
+# -*- coding: utf-8 -*-
+
+from system_tests import CaseMeta, CopyFiles, path
+
+
+@CopyFiles("$data_path/exiv2-canon-powershot-s40.jpg")
+class JsonLinesAndCsvOutput(metaclass=CaseMeta):
+    """-PJ prints one JSON object per file, -PC one CSV row per file with the -K keys as columns."""
+
+    filename = path("$data_path/exiv2-canon-powershot-s40_copy.jpg")
+    empty = path("$data_path/exiv2-empty.jpg")
+    keys = "-K Exif.Image.Model -K Exif.Image.ImageDescription -K Iptc.Application2.Keywords -K Exif.Photo.ExposureTime"
+    commands = [
+        """$exiv2 -M'set Exif.Image.ImageDescription say "hi",	ok' -M'add Iptc.Application2.Keywords k1' -M'add Iptc.Application2.Keywords k,2' $filename""",
+        "$exiv2 -PJ $keys $filename $empty",
+        "$exiv2 -j 2 -PCv $keys $filename $empty",
+        "$exiv2 -PC $filename",
+    ]
+    stdout = [
+        "",
+        """{"file":"$filename","Exif.Image.ImageDescription":"say \\"hi\\",\\tok","Exif.Image.Model":"Canon PowerShot S40","Exif.Photo.ExposureTime":"1/500 s","Iptc.Application2.Keywords":["k1","k,2"]}
+{"file":"$empty"}
+""",
+        """file,Exif.Image.Model,Exif.Image.ImageDescription,Iptc.Application2.Keywords,Exif.Photo.ExposureTime
+$filename,Canon PowerShot S40,"say ""hi"",	ok","k1, k,2",1/500
+$empty,,,,
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        "",
+        "",
+        "",
+        """exiv2: CSV output requires at least one -K option
+""",
+    ]
+    retval = [0, 1, 1, 1]
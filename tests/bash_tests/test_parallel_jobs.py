@@ -0,0 +1,66 @@
+# -*- coding: utf-8 -*-
+
+from system_tests import CaseMeta, CopyFiles, path
+
+
+class ParallelPrintKeepsFileOrder(metaclass=CaseMeta):
+    """The output of files processed in parallel is written file by file, in the order of the files."""
+
+    filename_1 = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    filename_2 = path("$data_path/does-not-exist.jpg")
+    filename_3 = path("$data_path/exiv2-nikon-d70.jpg")
+    filename_4 = path("$data_path/exiv2-sony-dsc-w7.jpg")
+    commands = [
+        "$exiv2 -j 3 -v -PEkyct -K Exif.Image.Model $filename_1 $filename_2 $filename_3 $filename_4",
+        "$exiv2 --jobs 0 -PEkyct -K Exif.Image.Model $filename_4 $filename_3",
+        "$exiv2 -j x $filename_1",
+    ]
+    stdout = [
+        """File 1/4: $filename_1
+$filename_1  Exif.Image.Model                             Ascii      20  Canon PowerShot S40
+File 2/4: $filename_2
+File 3/4: $filename_3
+$filename_3  Exif.Image.Model                             Ascii      10  NIKON D70
+File 4/4: $filename_4
+$filename_4  Exif.Image.Model                             Ascii       7  DSC-W7
+""",
+        """$filename_4  Exif.Image.Model                             Ascii       7  DSC-W7
+$filename_3  Exif.Image.Model                             Ascii      10  NIKON D70
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        """$filename_2: Failed to open the file
+""",
+        "",
+        """exiv2: Option -j: Invalid argument "x"
+""",
+    ]
+    retval = [255, 0, 1]
+
+
+@CopyFiles("$data_path/exiv2-canon-powershot-s40.jpg", "$data_path/exiv2-nikon-d70.jpg", "$data_path/exiv2-empty.jpg")
+class ParallelModify(metaclass=CaseMeta):
+
+    filename_1 = path("$data_path/exiv2-canon-powershot-s40_copy.jpg")
+    filename_2 = path("$data_path/exiv2-nikon-d70_copy.jpg")
+    filename_3 = path("$data_path/exiv2-empty_copy.jpg")
+    commands = [
+        """$exiv2 -j 2 -M"set Exif.Image.Artist exiv2" -M"set Xmp.dc.title parallel" $filename_1 $filename_2 $filename_3""",
+        "$exiv2 -j 2 -PEXkt -K Exif.Image.Artist -K Xmp.dc.title $filename_1 $filename_2 $filename_3",
+    ]
+    stdout = [
+        "",
+        """$filename_1  Exif.Image.Artist                             exiv2
+$filename_1  Xmp.dc.title                                  lang="x-default" parallel
+$filename_2  Exif.Image.Artist                             exiv2
+$filename_2  Xmp.dc.title                                  lang="x-default" parallel
+$filename_3  Exif.Image.Artist                             exiv2
+$filename_3  Xmp.dc.title                                  lang="x-default" parallel
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
@@ -0,0 +1,58 @@
+# -*- coding: utf-8 -*-
+
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class RecursiveWalkWithIncludeAndExclude(metaclass=CaseMeta):
+    """With -R, the files in directories are processed in the order of their names, depth first."""
+
+    def setUp(self):
+        os.makedirs(os.path.join(self.tree, "sub"))
+        os.makedirs(os.path.join(self.tree, "skip"))
+        shutil.copy(self.canon, os.path.join(self.tree, "a.jpg"))
+        shutil.copy(self.nikon, os.path.join(self.tree, "sub", "b.jpg"))
+        shutil.copy(self.sony, os.path.join(self.tree, "sub", "c.JPG"))
+        shutil.copy(self.canon, os.path.join(self.tree, "skip", "d.jpg"))
+        with open(os.path.join(self.tree, "notes.txt"), "w") as notes:
+            notes.write("not an image\n")
+
+    def tearDown(self):
+        shutil.rmtree(self.tree)
+
+    canon = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    sony = path("$data_path/exiv2-sony-dsc-w7.jpg")
+    tree = path("$tmp_path/recursive")
+    a = path("$tmp_path/recursive/a.jpg")
+    b = path("$tmp_path/recursive/sub/b.jpg")
+    c = path("$tmp_path/recursive/sub/c.JPG")
+    commands = [
+        "$exiv2 -R -v -G '*.jpg' -X skip -PEkt -K Exif.Image.Model $tree",
+        "$exiv2 --recursive --jobs 2 --include '*.[jJ][pP][gG]' --exclude 'sk*' -PEkt -K Exif.Image.Model $tree",
+        "$exiv2 -X skip -PEkt -K Exif.Image.Model $a",
+    ]
+    stdout = [
+        """File 1: $a
+$a  Exif.Image.Model                              Canon PowerShot S40
+File 2: $b
+$b  Exif.Image.Model                              NIKON D70
+""",
+        """$a  Exif.Image.Model                              Canon PowerShot S40
+$b  Exif.Image.Model                              NIKON D70
+$c  Exif.Image.Model                              DSC-W7
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        "",
+        "",
+        """exiv2: -G and -X options can only be used with -R
+""",
+    ]
+    retval = [0, 0, 1]
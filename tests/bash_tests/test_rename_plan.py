@@ -0,0 +1,77 @@
+# -*- coding: utf-8 -*-
+
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class RenamePlanResolvesCollisionsInFileOrder(metaclass=CaseMeta):
+    """The new names of the files are planned before any file is renamed, the later files take the suffixes."""
+
+    def setUp(self):
+        os.makedirs(self.dir)
+        shutil.copy(self.canon, self.a)
+        shutil.copy(self.canon, self.b)
+        shutil.copy(self.nikon, self.c)
+        shutil.copy(self.empty, self.e)
+
+    def tearDown(self):
+        self.assertFalse(os.path.exists(self.a))
+        self.assertTrue(os.path.exists(self.e))
+        shutil.rmtree(self.dir)
+
+    canon = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    empty = path("$data_path/exiv2-empty.jpg")
+    dir = path("$tmp_path/rename_plan")
+    a = path("$tmp_path/rename_plan/a.jpg")
+    b = path("$tmp_path/rename_plan/b.jpg")
+    c = path("$tmp_path/rename_plan/c.jpg")
+    e = path("$tmp_path/rename_plan/e.jpg")
+    a_new = path("$tmp_path/rename_plan/20031214_120144.jpg")
+    b_new = path("$tmp_path/rename_plan/20031214_120144_1.jpg")
+    c_new = path("$tmp_path/rename_plan/20040330_104346.jpg")
+    commands = [
+        "$exiv2 --dry-run rename $a $b $c $e",
+        "$exiv2 -N -F rename $a $b $c $e",
+        "$exiv2 -v -F -j 2 rename $a $b $c $e",
+        "$exiv2 -N -f rename $a_new $b_new $c_new",
+        "$exiv2 -N print $a",
+    ]
+    stdout = [
+        """$a -> $a_new
+$c -> $c_new
+""",
+        """$a -> $a_new
+$b -> $b_new
+$c -> $c_new
+""",
+        """File 1/4: $a
+Renaming file to $a_new
+File 2/4: $b
+Renaming file to $b_new
+File 3/4: $c
+Renaming file to $c_new
+File 4/4: $e
+""",
+        """$b_new -> $a_new (overwrites the existing file)
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        """exiv2: File `$a_new' exists, skipped. Use -f to overwrite or -F to rename it
+$e: No Exif data found in the file
+""",
+        """$e: No Exif data found in the file
+""",
+        """$e: No Exif data found in the file
+""",
+        "",
+        """exiv2: -N option can only be used with rename action
+""",
+    ]
+    retval = [253, 253, 253, 0, 1]
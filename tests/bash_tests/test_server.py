@@ -0,0 +1,91 @@
+# -*- coding: utf-8 -*-
+
+import os
+import shutil
+
+from system_tests import CaseMeta, path
+
+
+class ServerRequests(metaclass=CaseMeta):
+    """The responses to the requests read by exiv2 --server are written in the order of the requests."""
+
+    canon = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    nikon = path("$data_path/exiv2-nikon-d70.jpg")
+    commands = [
+        "$exiv2 --server",
+        "$exiv2 --server -j 2",
+        "$exiv2 --server $canon",
+    ]
+    stdin = [
+        """{"id": 1, "options": ["-PEkt", "-K", "Exif.Image.Model"], "path": "$canon"}
+not a request
+
+{"id": "two", "action": "print", "options": ["-PJ", "-K", "Exif.Image.Make"], "path": ["$canon", "$nikon"]}
+{"id": 3, "path": "$canon", "files": []}
+{"id": 4, "options": ["-K"], "path": "$canon"}
+""",
+        """{"id": 1, "options": ["-PEkt", "-K", "Exif.Image.Model"], "path": "$nikon"}
+{"id": 2, "options": ["-PEkt", "-K", "Exif.Image.Model"], "path": "$canon"}
+{"id": 3, "options": ["-PEkt", "-K", "Exif.Image.Model"], "path": "$data_path/does-not-exist.jpg"}
+{"id": 4, "options": ["-e", "X-"], "action": "extract", "path": "$canon"}
+""",
+        "",
+    ]
+    stdout = [
+        """{"id":1,"rc":0,"stdout":"Exif.Image.Model                              Canon PowerShot S40\\n","stderr":""}
+{"rc":1,"stdout":"","stderr":"exiv2: Invalid request, a JSON object is expected\\n"}
+{"id":"two","rc":0,"stdout":"{\\"file\\":\\"$canon\\",\\"Exif.Image.Make\\":\\"Canon\\"}\\n{\\"file\\":\\"$nikon\\",\\"Exif.Image.Make\\":\\"NIKON CORPORATION\\"}\\n","stderr":""}
+{"id":3,"rc":1,"stdout":"","stderr":"exiv2: Invalid request, unknown member \\"files\\"\\n"}
+{"id":4,"rc":1,"stdout":"","stderr":"exiv2: An action must be specified\\nexiv2: At least one file is required\\nexiv2: Invalid options in the request\\n"}
+""",
+        """{"id":1,"rc":0,"stdout":"Exif.Image.Model                              NIKON D70\\n","stderr":""}
+{"id":2,"rc":0,"stdout":"Exif.Image.Model                              Canon PowerShot S40\\n","stderr":""}
+{"id":3,"rc":255,"stdout":"","stderr":"$data_path/does-not-exist.jpg: Failed to open the file\\n"}
+{"id":4,"rc":1,"stdout":"","stderr":"exiv2: stdin and stdout cannot be used by a request\\n"}
+""",
+        """Usage: exiv2 [ option [ arg ] ]+ [ action ] file ...
+
+Image metadata manipulation tool.
+""",
+    ]
+    stderr = [
+        "",
+        "",
+        """exiv2: Files cannot be given with --server, they are given with each request
+""",
+    ]
+    retval = [0, 0, 1]
+
+
+class ServerRequestsRegisteringNamespaces(metaclass=CaseMeta):
+    """The XMP namespaces registered by a request are known to that request only."""
+
+    def setUp(self):
+        shutil.copy(self.canon, self.image)
+
+    def tearDown(self):
+        os.remove(self.image)
+
+    canon = path("$data_path/exiv2-canon-powershot-s40.jpg")
+    image = path("$tmp_path/server_namespaces.jpg")
+    commands = ["$exiv2 --server -j 2"]
+    stdin = [
+        """{"id": 1, "options": ["-PEkt", "-K", "Exif.Image.Model"], "path": "$image"}
+{"id": 2, "options": ["-M", "reg ns1 http://ns1/", "-M", "reg ns3 http://ns3/", "-M", "set Xmp.ns1.a one", "-q"], "action": "modify", "path": "$image"}
+{"id": 3, "options": ["-PXkt"], "path": "$image"}
+{"id": 4, "options": ["-M", "set Xmp.ns3.b two"], "action": "modify", "path": "$image"}
+{"id": 5, "options": ["-M", "reg ns2 http://ns2/", "-M", "set Xmp.ns2.c three"], "action": "modify", "path": "$image"}
+{"id": 6, "options": ["-PXkt"], "path": "$image"}
+"""
+    ]
+    stdout = [
+        """{"id":1,"rc":0,"stdout":"Exif.Image.Model                              Canon PowerShot S40\\n","stderr":""}
+{"id":2,"rc":0,"stdout":"","stderr":""}
+{"id":3,"rc":0,"stdout":"Xmp.ns1.a                                     one\\n","stderr":""}
+{"id":4,"rc":1,"stdout":"","stderr":"-M option 1: Invalid key `Xmp.ns3.b'\\nexiv2: Error parsing -M option arguments\\nexiv2: Invalid options in the request\\n"}
+{"id":5,"rc":0,"stdout":"","stderr":""}
+{"id":6,"rc":0,"stdout":"Xmp.ns1.a                                     one\\nXmp.ns2.c                                     three\\n","stderr":""}
+"""
+    ]
+    stderr = [""]
+    retval = [0]
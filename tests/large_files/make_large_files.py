@@ -0,0 +1,199 @@
+# -*- coding: utf-8 -*-
+"""
+Generators for sparse media files larger than 4 GB.
+
+The bulk of each file is a hole created by seeking past the end of the file,
+so the files take almost no disk space on file systems which support sparse
+files. The metadata is placed so that it is only found if offsets and sizes
+are handled with 64 bits.
+
+Usage: python3 make_large_files.py <output directory>
+"""
+
+import os
+import struct
+import sys
+import uuid
+
+#: Size of the hole in each file: large enough to push everything after it beyond 4 GB.
+GAP = (1 << 32) + (1 << 29)
+
+TITLE = "exiv2 large file"
+
+
+def _hole(f, size):
+    """Skip size bytes, leaving a hole, and make sure the file is extended."""
+    f.seek(size - 1, os.SEEK_CUR)
+    f.write(b"\0")
+
+
+# ----------------------------------------------------------------------------
+# MP4: ftyp, a 64-bit mdat box, and a moov box located after the media data
+def _atom(kind, payload):
+    return struct.pack(">I4s", 8 + len(payload), kind) + payload
+
+
+def make_mp4(filename, gap=GAP):
+    mvhd = struct.pack(">BxxxIIII", 0, 0, 0, 1000, 10000)  # timescale 1000, duration 10 s
+    mvhd += struct.pack(">IH10x", 0x00010000, 0x0100)
+    mvhd += struct.pack(">9I", 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000)
+    mvhd += bytes(24) + struct.pack(">I", 2)
+    # Chunk offset table pointing into the media data beyond 4 GB
+    co64 = struct.pack(">BxxxIQ", 0, 1, 16 + gap // 2)
+    stbl = _atom(b"stbl", _atom(b"co64", co64))
+    trak = _atom(b"trak", _atom(b"mdia", _atom(b"minf", stbl)))
+    moov = _atom(b"moov", _atom(b"mvhd", mvhd) + trak)
+
+    with open(filename, "wb") as f:
+        f.write(_atom(b"ftyp", b"isom" + struct.pack(">I", 0x200) + b"isommp41"))
+        f.write(struct.pack(">I4sQ", 1, b"mdat", 16 + gap))
+        _hole(f, gap)
+        f.write(moov)
+
+
+# ----------------------------------------------------------------------------
+# AVI (OpenDML): a RIFF AVI chunk with an INFO list after 3 GB of movie data,
+# followed by a RIFF AVIX extension chunk which ends beyond 4 GB. Only the
+# OpenDML header counts the frames of the extension.
+def _chunk(kind, payload):
+    pad = b"\0" if len(payload) % 2 else b""
+    return struct.pack("<4sI", kind, len(payload)) + payload + pad
+
+
+def _list(kind, payload):
+    return struct.pack("<4sI4s", b"LIST", 4 + len(payload), kind) + payload
+
+
+def make_avi(filename, gap=GAP):
+    avih = struct.pack("<14I", 40000, 0, 0, 0x10, 250, 0, 1, 0, 640, 480, 0, 0, 0, 0)
+    odml = _list(b"odml", _chunk(b"dmlh", struct.pack("<I", 1000) + bytes(244)))
+    hdrl = _list(b"hdrl", _chunk(b"avih", avih) + odml)
+    info = _list(b"INFO", _chunk(b"INAM", TITLE.encode() + b"\0"))
+    movi1 = 3 << 30
+    movi2 = gap - movi1
+
+    with open(filename, "wb") as f:
+        riff_size = 4 + len(hdrl) + 12 + movi1 + len(info)
+        f.write(struct.pack("<4sI4s", b"RIFF", riff_size, b"AVI "))
+        f.write(hdrl)
+        f.write(struct.pack("<4sI4s", b"LIST", 4 + movi1, b"movi"))
+        _hole(f, movi1)
+        f.write(info)
+        f.write(struct.pack("<4sI4s", b"RIFF", 4 + 12 + movi2, b"AVIX"))
+        f.write(struct.pack("<4sI4s", b"LIST", 4 + movi2, b"movi"))
+        _hole(f, movi2)
+
+
+# ----------------------------------------------------------------------------
+# Matroska: a Void element with an 8 byte size in front of the segment info
+def _ebml_size(size):
+    if size < 0x7F:
+        return bytes([0x80 | size])
+    return b"\x01" + size.to_bytes(7, "big")
+
+
+def _element(eid, payload):
+    return eid + _ebml_size(len(payload)) + payload
+
+
+def make_mkv(filename, gap=GAP):
+    header = _element(b"\x1a\x45\xdf\xa3", _element(b"\x42\x82", b"matroska") + _element(b"\x42\x87", b"\x04"))
+    info = _element(b"\x15\x49\xa9\x66", _element(b"\x2a\xd7\xb1", b"\x0f\x42\x40") + _element(b"\x7b\xa9", TITLE.encode()))
+
+    with open(filename, "wb") as f:
+        f.write(header)
+        f.write(b"\x18\x53\x80\x67" + b"\x01" + b"\xff" * 7)  # Segment of unknown size
+        f.write(b"\xec" + _ebml_size(gap))  # Void
+        _hole(f, gap)
+        f.write(info)
+
+
+# ----------------------------------------------------------------------------
+# ASF: a Header Object with an album title and padding, followed by a Data
+# Object which ends beyond 4 GB
+def _guid(text):
+    return uuid.UUID(text).bytes_le
+
+
+def _asf_object(guid, payload):
+    return _guid(guid) + struct.pack("<Q", 24 + len(payload)) + payload
+
+
+def _asf_string(text):
+    return (text + "\0").encode("utf-16-le")
+
+
+def make_asf(filename, gap=GAP):
+    name = _asf_string("WM/AlbumTitle")
+    value = _asf_string(TITLE)
+    description = struct.pack("<HH", 1, len(name)) + name + struct.pack("<HH", 0, len(value)) + value
+    children = [
+        _asf_object("D2D0A440-E307-11D2-97F0-00A0C95EA850", description),
+        _asf_object("1806D474-CADF-4509-A4BA-9AABCB96AAE8", bytes(256)),
+    ]
+    header = struct.pack("<IBB", len(children), 1, 2) + b"".join(children)
+
+    with open(filename, "wb") as f:
+        f.write(_asf_object("75B22630-668E-11CF-A6D9-00AA0062CE6C", header))
+        f.write(_guid("75B22636-668E-11CF-A6D9-00AA0062CE6C") + struct.pack("<Q", 24 + gap))
+        _hole(f, gap)
+
+
+# ----------------------------------------------------------------------------
+# TIFF: a small strip followed by a large tail of image data
+def make_tif(filename, gap=GAP):
+    artist = b"exiv2-large\0"
+    entries = [
+        (0x0100, 3, 1, 16),  # ImageWidth
+        (0x0101, 3, 1, 16),  # ImageLength
+        (0x0102, 3, 1, 8),  # BitsPerSample
+        (0x0103, 3, 1, 1),  # Compression
+        (0x0106, 3, 1, 1),  # PhotometricInterpretation
+        (0x0111, 4, 1, 0),  # StripOffsets, patched below
+        (0x0116, 3, 1, 16),  # RowsPerStrip
+        (0x0117, 4, 1, 256),  # StripByteCounts
+        (0x013B, 2, len(artist), 0),  # Artist, patched below
+    ]
+    ifd_size = 2 + 12 * len(entries) + 4
+    artist_offset = 8 + ifd_size
+    strip_offset = artist_offset + len(artist)
+
+    ifd = struct.pack("<H", len(entries))
+    for tag, typ, count, value in entries:
+        if tag == 0x0111:
+            value = strip_offset
+        elif tag == 0x013B:
+            value = artist_offset
+        if typ == 3:
+            ifd += struct.pack("<HHIHxx", tag, typ, count, value)
+        else:
+            ifd += struct.pack("<HHII", tag, typ, count, value)
+    ifd += struct.pack("<I", 0)
+
+    with open(filename, "wb") as f:
+        f.write(b"II*\0" + struct.pack("<I", 8))
+        f.write(ifd)
+        f.write(artist)
+        f.write(bytes(range(256)))
+        _hole(f, gap)
+
+
+GENERATORS = {
+    "large.mp4": make_mp4,
+    "large.avi": make_avi,
+    "large.mkv": make_mkv,
+    "large.asf": make_asf,
+    "large.tif": make_tif,
+}
+
+
+def main(directory):
+    os.makedirs(directory, exist_ok=True)
+    for name, generator in GENERATORS.items():
+        generator(os.path.join(directory, name))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    main(sys.argv[1])
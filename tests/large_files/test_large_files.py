@@ -0,0 +1,166 @@
+# -*- coding: utf-8 -*-
+
+import os
+import unittest
+
+import system_tests
+
+from large_files import make_large_files
+
+# The files are sparse, but not every file system supports that: opt in explicitly.
+ENABLED = os.environ.get("EXIV2_LARGE_FILE_TESTS", "") not in ("", "0")
+
+
+class LargeFileCase:
+    """Generate a sparse file beyond 4 GB in the temporary directory before the commands run."""
+
+    def setUp(self):
+        self.generator(self.filename)
+
+    def tearDown(self):
+        os.remove(self.filename)
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeMp4(LargeFileCase, metaclass=system_tests.CaseMeta):
+    generator = staticmethod(make_large_files.make_mp4)
+    filename = system_tests.path("$tmp_path/large.mp4")
+    commands = ["$exiv2 -K Xmp.video.FileSize -K Xmp.video.TimeScale -K Xmp.video.Duration $filename"]
+    stdout = [
+        """Xmp.video.FileSize                           XmpText     4  4608
+Xmp.video.TimeScale                          XmpText     4  1000
+Xmp.video.Duration                           XmpText     5  10000
+"""
+    ]
+    stderr = [""]
+    retval = [0]
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeMp4WriteXmp(LargeFileCase, metaclass=system_tests.CaseMeta):
+    """The XMP box is appended after the media data, which is neither read nor copied."""
+
+    generator = staticmethod(make_large_files.make_mp4)
+    filename = system_tests.path("$tmp_path/large_write.mp4")
+    commands = [
+        '$exiv2 -M"set Xmp.dc.title exiv2 large file" $filename',
+        "$exiv2 -K Xmp.dc.title -K Xmp.video.TimeScale $filename",
+    ]
+    stdout = [
+        "",
+        """Xmp.video.TimeScale                          XmpText     4  1000
+Xmp.dc.title                                 LangAlt     1  lang="x-default" exiv2 large file
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeAvi(LargeFileCase, metaclass=system_tests.CaseMeta):
+    generator = staticmethod(make_large_files.make_avi)
+    filename = system_tests.path("$tmp_path/large.avi")
+    commands = ["$exiv2 -K Xmp.video.FileType -K Xmp.video.FrameCount -K Xmp.video.Duration -K Xmp.video.Title $filename"]
+    stdout = [
+        """Xmp.video.FileType                           XmpText     4  AVI 
+Xmp.video.FrameCount                         XmpText     4  1000
+Xmp.video.Duration                           XmpText     5  40000
+Xmp.video.Title                              XmpText    16  exiv2 large file
+"""
+    ]
+    stderr = [""]
+    retval = [0]
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeAviWriteInfo(LargeFileCase, metaclass=system_tests.CaseMeta):
+    """The longer INFO list is appended to the RIFF AVIX extension, beyond 4 GB."""
+
+    generator = staticmethod(make_large_files.make_avi)
+    filename = system_tests.path("$tmp_path/large_write.avi")
+    commands = [
+        '$exiv2 -M"set Xmp.video.Title exiv2 larger file" -M"set Xmp.xmp.CreatorTool exiv2" $filename',
+        "$exiv2 -K Xmp.video.Title -K Xmp.xmp.CreatorTool $filename",
+    ]
+    stdout = [
+        "",
+        """Xmp.video.Title                              XmpText    17  exiv2 larger file
+Xmp.xmp.CreatorTool                          XmpText     5  exiv2
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeMkv(LargeFileCase, metaclass=system_tests.CaseMeta):
+    generator = staticmethod(make_large_files.make_mkv)
+    filename = system_tests.path("$tmp_path/large.mkv")
+    commands = ["$exiv2 -K Xmp.video.FileSize -K Xmp.video.Title $filename"]
+    stdout = [
+        """Xmp.video.FileSize                           XmpText     4  4608
+Xmp.video.Title                              XmpText    16  exiv2 large file
+"""
+    ]
+    stderr = [""]
+    retval = [0]
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeMkvWriteTags(LargeFileCase, metaclass=system_tests.CaseMeta):
+    """Info and Tags move into the Void element in front of the old Info, which is beyond 4 GB."""
+
+    generator = staticmethod(make_large_files.make_mkv)
+    filename = system_tests.path("$tmp_path/large_write.mkv")
+    commands = [
+        '$exiv2 -M"set Xmp.video.Title exiv2 larger file" -M"set Xmp.video.GPSCoordinates +48.8577+002.2950/" $filename',
+        "$exiv2 -K Xmp.video.Title -K Xmp.video.GPSCoordinates $filename",
+    ]
+    stdout = [
+        "",
+        """Xmp.video.Title                              XmpText    17  exiv2 larger file
+Xmp.video.GPSCoordinates                     XmpText    18  +48.8577+002.2950/
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeAsfWriteAttributes(LargeFileCase, metaclass=system_tests.CaseMeta):
+    """The attributes are rewritten in the Header Object, the Data Object is neither read nor moved."""
+
+    generator = staticmethod(make_large_files.make_asf)
+    filename = system_tests.path("$tmp_path/large_write.asf")
+    commands = [
+        "$exiv2 -K Xmp.video.Album $filename",
+        '$exiv2 -M"set Xmp.video.Album exiv2 larger file" -M"set Xmp.video.Genre Test" $filename',
+        "$exiv2 -K Xmp.video.Album -K Xmp.video.Genre $filename",
+    ]
+    stdout = [
+        "Xmp.video.Album                              XmpText    16  exiv2 large file\n",
+        "",
+        """Xmp.video.Album                              XmpText    17  exiv2 larger file
+Xmp.video.Genre                              XmpText     4  Test
+""",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
+
+
+@unittest.skipUnless(ENABLED, "set EXIV2_LARGE_FILE_TESTS=1 to run")
+class LargeTiff(LargeFileCase, metaclass=system_tests.CaseMeta):
+    generator = staticmethod(make_large_files.make_tif)
+    filename = system_tests.path("$tmp_path/large.tif")
+    commands = [
+        "$exiv2 -K Exif.Image.Artist $filename",
+        '$exiv2 -M"set Exif.Image.Artist exiv2-LARGE" $filename',
+        "$exiv2 -K Exif.Image.Artist $filename",
+    ]
+    stdout = [
+        "Exif.Image.Artist                            Ascii      12  exiv2-large\n",
+        "",
+        "Exif.Image.Artist                            Ascii      12  exiv2-LARGE\n",
+    ]
+    stderr = [""] * len(commands)
+    retval = [0] * len(commands)
@@ -196,7 +196,7 @@ TEST(TheImageFactory, getsExpectedModesForBmpImages) {
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::bmp, mdIptc));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::bmp, mdXmp));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::bmp, mdComment));
-  EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::bmp, mdIccProfile));
+  EXPECT_EQ(amRead, ImageFactory::checkMode(ImageType::bmp, mdIccProfile));
 }
 
 TEST(TheImageFactory, getsExpectedModesForCr2Images) {
@@ -221,7 +221,7 @@ TEST(TheImageFactory, getsExpectedModesForGifImages) {
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdNone));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdExif));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdIptc));
-  EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdXmp));
+  EXPECT_EQ(amReadWrite, ImageFactory::checkMode(ImageType::gif, mdXmp));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdComment));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::gif, mdIccProfile));
 }
@@ -275,8 +275,8 @@ TEST(TheImageFactory, getsExpectedModesForTgaImages) {
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdNone));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdExif));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdIptc));
-  EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdXmp));
-  EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdComment));
+  EXPECT_EQ(amRead, ImageFactory::checkMode(ImageType::tga, mdXmp));
+  EXPECT_EQ(amRead, ImageFactory::checkMode(ImageType::tga, mdComment));
   EXPECT_EQ(amNone, ImageFactory::checkMode(ImageType::tga, mdIccProfile));
 }
 
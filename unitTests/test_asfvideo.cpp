@@ -2,7 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include "test_bytes.hpp"
+
 #include <exiv2/asfvideo.hpp>
+#include <exiv2/basicio.hpp>
+#include <exiv2/types.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace Exiv2;
 
@@ -52,3 +60,135 @@ TEST(AsfVideo, readMetadata) {
   ASSERT_FALSE(data.empty());
   ASSERT_EQ(xmpData["Xmp.video.TotalStream"].count(), 4u);
 }
+
+namespace {
+using GUIDTag = AsfVideo::GUIDTag;
+const GUIDTag headerGuid(0x75B22630, 0x668E, 0x11CF, {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C});
+const GUIDTag dataGuid(0x75B22636, 0x668E, 0x11CF, {0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C});
+const GUIDTag headerExtensionGuid(0x5FBF03B5, 0xA92E, 0x11CF, {0x8E, 0xE3, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65});
+const GUIDTag descriptionGuid(0xD2D0A440, 0xE307, 0x11D2, {0x97, 0xF0, 0x00, 0xA0, 0xC9, 0x5E, 0xA8, 0x50});
+const GUIDTag paddingGuid(0x1806D474, 0xCADF, 0x4509, {0xA4, 0xBA, 0x9A, 0xAB, 0xCB, 0x96, 0xAA, 0xE8});
+
+std::vector<byte> word(uint16_t value) {
+  std::vector<byte> data(2);
+  us2Data(data.data(), value, littleEndian);
+  return data;
+}
+
+std::vector<byte> object(const GUIDTag& guid, const std::vector<byte>& payload) {
+  std::vector<byte> data(24);
+  guid.copyTo(data.data());
+  ull2Data(data.data() + 16, data.size() + payload.size(), littleEndian);
+  return data + payload;
+}
+
+//! ASCII \em text as a null terminated UTF-16LE string
+std::vector<byte> utf16(const std::string& text) {
+  std::vector<byte> data;
+  for (char c : text + '\0')
+    data.insert(data.end(), {static_cast<byte>(c), 0});
+  return data;
+}
+
+std::vector<byte> descriptor(const std::string& name, const std::string& value) {
+  return word(static_cast<uint16_t>(utf16(name).size())) + utf16(name) + word(0) +
+         word(static_cast<uint16_t>(utf16(value).size())) + utf16(value);
+}
+
+//! An ASF file whose Header Object contains the objects \em children, followed by a Data Object
+std::vector<byte> asf(const std::vector<std::vector<byte>>& children) {
+  std::vector<byte> objects;
+  for (auto&& child : children)
+    objects = objects + child;
+  std::vector<byte> fields(6);
+  ul2Data(fields.data(), static_cast<uint32_t>(children.size()), littleEndian);
+  fields[4] = 1;
+  fields[5] = 2;
+  return object(headerGuid, fields + objects) + object(dataGuid, std::vector<byte>(1000, 0xff));
+}
+
+std::vector<byte> description() {
+  return object(descriptionGuid, word(2) + descriptor("WM/EncodingSettings", "x") + descriptor("WM/AlbumTitle", "old"));
+}
+
+std::string property(const std::vector<byte>& data, const std::string& key) {
+  AsfVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  auto it = video.xmpData().findKey(XmpKey(key));
+  return it == video.xmpData().end() ? "" : it->toString();
+}
+}  // namespace
+
+TEST(AsfVideo, writesAttributesIntoPaddingInPlace) {
+  // Padding in the Header Extension Object and in the Header Object
+  const auto extension = object(headerExtensionGuid, std::vector<byte>(18) + std::vector<byte>{48, 0, 0, 0} +
+                                                         object(paddingGuid, std::vector<byte>(24)));
+  const auto data = asf({description(), extension, object(paddingGuid, std::vector<byte>(40))});
+  ASSERT_EQ("old", property(data, "Xmp.video.Album"));
+
+  AsfVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  video.xmpData()["Xmp.video.Album"] = "a longer album title";
+  video.xmpData()["Xmp.video.Genre"] = "Jazz";
+  video.writeMetadata();
+
+  const auto written = contents(video.io());
+  ASSERT_EQ(data.size(), written.size());
+  ASSERT_TRUE(std::equal(data.end() - 1024, data.end(), written.end() - 1024));
+  ASSERT_EQ("a longer album title", property(written, "Xmp.video.Album"));
+  ASSERT_EQ("Jazz", property(written, "Xmp.video.Genre"));
+  ASSERT_NE(std::string::npos, property(written, "Xmp.video.ExtendedContentDescription").find("WM/EncodingSettings: x"));
+
+  // A removed property removes its attribute
+  video.readMetadata();
+  video.xmpData().erase(video.xmpData().findKey(XmpKey("Xmp.video.Album")));
+  video.writeMetadata();
+  const auto rewritten = contents(video.io());
+  ASSERT_EQ(data.size(), rewritten.size());
+  ASSERT_EQ("", property(rewritten, "Xmp.video.Album"));
+  ASSERT_EQ("Jazz", property(rewritten, "Xmp.video.Genre"));
+}
+
+TEST(AsfVideo, failsToWriteAttributesWithoutPadding) {
+  const auto data = asf({description()});
+  AsfVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  // Unchanged attributes need no room
+  ASSERT_NO_THROW(video.writeMetadata());
+
+  video.xmpData()["Xmp.video.Album"] = "a longer album title";
+  ASSERT_THROW(video.writeMetadata(), Error);
+  ASSERT_EQ(data, contents(video.io()));
+}
+
+TEST(AsfVideo, failsToWritePropertiesWithoutAttribute) {
+  const auto data = asf({description(), object(paddingGuid, std::vector<byte>(200))});
+  AsfVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  video.xmpData()["Xmp.video.Genre"] = "Jazz";
+  video.xmpData()["Xmp.dc.title"] = "Hello";
+  try {
+    video.writeMetadata();
+    FAIL();
+  } catch (const Error& e) {
+    ASSERT_EQ(ErrorCode::kerImageWriteFailed, e.code());
+  }
+  ASSERT_EQ(data, contents(video.io()));
+}
+
+TEST(AsfVideo, comparesEditsWithThePropertiesAsRead) {
+  const auto data = asf({description(), object(paddingGuid, std::vector<byte>(200))});
+  AsfVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  const std::string mimeType = video.xmpData()["Xmp.video.MimeType"].toString();
+  video.xmpData()["Xmp.video.MimeType"] = "video/x-other";
+  ASSERT_THROW(video.writeMetadata(), Error);
+  ASSERT_EQ(data, contents(video.io()));
+  // The rejected edit is kept
+  ASSERT_EQ("video/x-other", video.xmpData()["Xmp.video.MimeType"].toString());
+
+  video.xmpData()["Xmp.video.MimeType"] = mimeType;
+  video.xmpData()["Xmp.video.Album"] = "new";
+  ASSERT_NO_THROW(video.writeMetadata());
+  ASSERT_EQ("new", property(contents(video.io()), "Xmp.video.Album"));
+}
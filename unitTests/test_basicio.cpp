@@ -3,7 +3,10 @@
 #include <gtest/gtest.h>
 #include <exiv2/basicio.hpp>
 
+#include "basicio_int.hpp"
+
 #include <array>
+#include <limits>
 
 using namespace Exiv2;
 
@@ -169,3 +172,86 @@ TEST(MemIo, readMoreBytesThanAvailableReturnsAvailableBytes) {
   MemIo io(buf1.data(), buf1.size());
   ASSERT_EQ(10u, io.read(buf2.data(), 15));
 }
+
+TEST(WindowIo, readsOnlyTheBytesOfTheWindow) {
+  const std::array<byte, 8> data{0, 1, 2, 3, 4, 5, 6, 7};
+  MemIo src(data.data(), data.size());
+  Internal::WindowIo io(src, 2, 4);
+  ASSERT_EQ(0, io.open());
+  ASSERT_EQ(4u, io.size());
+
+  std::array<byte, 8> buf{};
+  ASSERT_EQ(4u, io.read(buf.data(), buf.size()));
+  ASSERT_EQ(2, buf[0]);
+  ASSERT_EQ(5, buf[3]);
+  ASSERT_TRUE(io.eof());
+  ASSERT_EQ(EOF, io.getb());
+}
+
+TEST(WindowIo, seekIsRelativeToTheWindow) {
+  const std::array<byte, 8> data{0, 1, 2, 3, 4, 5, 6, 7};
+  MemIo src(data.data(), data.size());
+  Internal::WindowIo io(src, 2, 4);
+  ASSERT_EQ(0, io.seek(-1, BasicIo::end));
+  ASSERT_EQ(3u, io.tell());
+  ASSERT_EQ(5, io.getb());
+  ASSERT_EQ(1, io.seek(5, BasicIo::beg));
+  ASSERT_TRUE(io.eof());
+  ASSERT_EQ(0u, io.write(data.data(), data.size()));
+}
+
+TEST(WindowIo, unmapsWhatItMapped) {
+  //! Counts the mappings which are not released
+  class MappedIo : public MemIo {
+   public:
+    using MemIo::MemIo;
+    byte* mmap(bool isWriteable) override {
+      ++mappings_;
+      return MemIo::mmap(isWriteable);
+    }
+    int munmap() override {
+      --mappings_;
+      return MemIo::munmap();
+    }
+    int mappings_{0};
+  };
+
+  const std::array<byte, 8> data{0, 1, 2, 3, 4, 5, 6, 7};
+  MappedIo src(data.data(), data.size());
+  {
+    Internal::WindowIo io(src, 2, 4);
+    ASSERT_EQ(0, io.munmap());
+    ASSERT_EQ(0, src.mappings_);
+    ASSERT_EQ(2, *io.mmap());
+    ASSERT_EQ(1, src.mappings_);
+    ASSERT_EQ(0, io.munmap());
+    ASSERT_EQ(0, src.mappings_);
+    ASSERT_EQ(0, io.munmap());
+    ASSERT_EQ(0, src.mappings_);
+
+    io.mmap();
+    ASSERT_EQ(0, io.close());
+    ASSERT_EQ(0, src.mappings_);
+    io.mmap();
+  }
+  ASSERT_EQ(0, src.mappings_);
+}
+
+TEST(copyRange, copiesTheRequestedBytes) {
+  const std::array<byte, 8> data{0, 1, 2, 3, 4, 5, 6, 7};
+  MemIo src(data.data(), data.size());
+  MemIo dst;
+  Internal::copyRange(src, 3, 4, dst);
+  ASSERT_EQ(4u, dst.size());
+  ASSERT_EQ(3, dst.mmap()[0]);
+  ASSERT_THROW(Internal::copyRange(src, 6, 4, dst), Exiv2::Error);
+}
+
+TEST(FileOffset, isNarrowedOnlyWhenItFits) {
+  ASSERT_EQ(42u, Internal::toSize(42));
+  ASSERT_EQ(int64_t{1} << 33, Internal::toSeekOffset(Internal::FileOffset{1} << 33));
+  ASSERT_THROW(Internal::toSeekOffset(std::numeric_limits<Internal::FileOffset>::max()), Exiv2::Error);
+  if constexpr (sizeof(size_t) < sizeof(Internal::FileOffset)) {
+    ASSERT_THROW(Internal::toSize(Internal::FileOffset{1} << 33), Exiv2::Error);
+  }
+}
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+#include "test_bytes.hpp"
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/bmffimage.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace {
+Bytes text(const std::string& str) {
+  return {str.begin(), str.end()};
+}
+
+Bytes box(const std::string& type, const Bytes& payload) {
+  Bytes data;
+  appendULong(data, static_cast<uint32_t>(8 + payload.size()), bigEndian);
+  return data + text(type) + payload;
+}
+
+//! The boxes of a JPEG XL container, as type and payload
+std::vector<std::pair<std::string, Bytes>> boxes(const Bytes& data) {
+  std::vector<std::pair<std::string, Bytes>> result;
+  for (size_t offset = 0; offset + 8 <= data.size();) {
+    const size_t size = getULong(data.data() + offset, bigEndian);
+    if (size < 8 || size > data.size() - offset)
+      break;
+    result.emplace_back(std::string(data.begin() + offset + 4, data.begin() + offset + 8),
+                        Bytes(data.begin() + offset + 8, data.begin() + offset + size));
+    offset += size;
+  }
+  return result;
+}
+
+const Bytes codestream{0xff, 0x0a, 0xfa, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x11, 0x22, 0x33, 0x44, 0x55};
+const Bytes signature = box("JXL ", {0x0d, 0x0a, 0x87, 0x0a});
+const Bytes fileType = box("ftyp", text("jxl ") + Bytes(4) + text("jxl "));
+
+std::string title(BmffImage& image) {
+  auto it = image.xmpData().findKey(XmpKey("Xmp.dc.title"));
+  return it == image.xmpData().end() ? "" : it->toString();
+}
+}  // namespace
+
+TEST(BmffImage, wrapsABareCodestreamToWriteMetadata) {
+  BmffImage image(std::make_unique<MemIo>(codestream.data(), codestream.size()), false);
+  image.readMetadata();
+  ASSERT_TRUE(image.xmpData().empty());
+  image.xmpData()["Xmp.dc.title"] = "codestream";
+  image.writeMetadata();
+
+  const auto written = boxes(contents(image.io()));
+  ASSERT_EQ(4u, written.size());
+  ASSERT_EQ(std::make_pair(std::string("JXL "), Bytes{0x0d, 0x0a, 0x87, 0x0a}), written[0]);
+  ASSERT_EQ("ftyp", written[1].first);
+  ASSERT_EQ("xml ", written[2].first);
+  ASSERT_EQ(std::make_pair(std::string("jxlc"), codestream), written[3]);
+
+  image.readMetadata();
+  ASSERT_EQ("lang=\"x-default\" codestream", title(image));
+}
+
+TEST(BmffImage, keepsABareCodestreamWithoutMetadata) {
+  BmffImage image(std::make_unique<MemIo>(codestream.data(), codestream.size()), false);
+  image.readMetadata();
+  image.writeMetadata();
+  ASSERT_EQ(codestream, contents(image.io()));
+}
+
+#ifdef EXV_HAVE_BROTLI
+namespace {
+const std::string packet =
+    "<?xpacket begin=\"\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?><x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<rdf:Description rdf:about=\"\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\">"
+    "<dc:title><rdf:Alt><rdf:li xml:lang=\"x-default\">first</rdf:li></rdf:Alt></dc:title>"
+    "</rdf:Description></rdf:RDF></x:xmpmeta><?xpacket end=\"w\"?>";
+
+//! \em data as a Brotli stream of a single uncompressed meta-block, which needs no encoder
+Bytes brotliStored(const Bytes& data) {
+  // WBITS 16, not last, 4 nibbles of MLEN - 1, uncompressed, padded to the byte
+  const auto header = static_cast<uint32_t>(((data.size() - 1) << 4) | (1 << 20));
+  Bytes stream{static_cast<byte>(header), static_cast<byte>(header >> 8), static_cast<byte>(header >> 16)};
+  // Followed by an empty last meta-block
+  return stream + data + Bytes{0x03};
+}
+
+Bytes brobXmpFile() {
+  return signature + fileType + box("brob", text("xml ") + brotliStored(text(packet))) + box("jxlc", codestream);
+}
+}  // namespace
+
+TEST(BmffImage, readsBrobPayloadAgainWhenItChanges) {
+  const auto data = brobXmpFile();
+  BmffImage image(std::make_unique<MemIo>(data.data(), data.size()), false);
+  image.readMetadata();
+  ASSERT_EQ("lang=\"x-default\" first", title(image));
+  image.readMetadata();
+  ASSERT_EQ("lang=\"x-default\" first", title(image));
+
+  // The box stays at the same address: the cached payload must not be used for its new content
+  const auto pos = std::search(data.begin(), data.end(), packet.begin(), packet.end()) - data.begin() +
+                   static_cast<long>(packet.find(">first<") + 1);
+  image.io().seek(pos, BasicIo::beg);
+  image.io().write(reinterpret_cast<const byte*>("other"), 5);
+  image.readMetadata();
+  ASSERT_EQ("lang=\"x-default\" other", title(image));
+}
+
+#ifdef EXV_HAVE_BROTLIENC
+TEST(BmffImage, writesBrobXmpCompressedAgain) {
+  const auto data = brobXmpFile();
+  BmffImage image(std::make_unique<MemIo>(data.data(), data.size()), false);
+  image.readMetadata();
+  image.xmpData()["Xmp.dc.title"] = "second";
+  image.writeMetadata();
+
+  const auto written = boxes(contents(image.io()));
+  ASSERT_EQ(4u, written.size());
+  ASSERT_EQ("brob", written[2].first);
+  ASSERT_EQ(text("xml "), Bytes(written[2].second.begin(), written[2].second.begin() + 4));
+  ASSERT_EQ(std::make_pair(std::string("jxlc"), codestream), written[3]);
+
+  image.readMetadata();
+  ASSERT_EQ("lang=\"x-default\" second", title(image));
+}
+#endif  // EXV_HAVE_BROTLIENC
+#endif  // EXV_HAVE_BROTLI
@@ -4,6 +4,7 @@
 
 #include <array>
 #include <exiv2/bmpimage.hpp>
+#include <vector>
 
 using namespace Exiv2;
 
@@ -92,6 +93,71 @@ TEST(BmpImage, readMetadataReadsImageDimensionsWhenDataIsAvailable) {
   ASSERT_EQ(800u, bmp.pixelHeight());
 }
 
+namespace {
+using Bytes = std::vector<byte>;
+
+void putLong(Bytes& buf, size_t offset, uint32_t value) {
+  for (size_t i = 0; i < 4; ++i)
+    buf[offset + i] = static_cast<byte>(value >> (8 * i));
+}
+
+//! A 1x1 pixel BMP with a V5 header, followed by a 16 byte ICC profile
+Bytes bmpV5(uint32_t profileOffset, uint32_t profileSize) {
+  Bytes bmp(14 + 124 + 4);
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  putLong(bmp, 10, 14 + 124);        // Bitmap offset
+  putLong(bmp, 14, 124);             // Header size
+  putLong(bmp, 18, 1);               // Width
+  putLong(bmp, 22, 1);               // Height
+  putLong(bmp, 70, 0x4D424544);      // Color space type 'MBED'
+  putLong(bmp, 126, profileOffset);  // Profile offset, from the start of the header
+  putLong(bmp, 130, profileSize);    // Profile size
+  const Bytes profile{0, 0, 0, 16, 'l', 'c', 'm', 's', 2, 0x10, 0, 0, 'm', 'n', 't', 'r'};
+  bmp.insert(bmp.end(), profile.begin(), profile.end());
+  return bmp;
+}
+}  // namespace
+
+TEST(BmpImage, readMetadataReadsEmbeddedIccProfile) {
+  const auto data = bmpV5(124 + 4, 16);
+  BmpImage bmp(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(bmp.readMetadata());
+  ASSERT_EQ(1u, bmp.pixelWidth());
+  ASSERT_TRUE(bmp.iccProfileDefined());
+  ASSERT_EQ(16u, bmp.iccProfile().size());
+  ASSERT_EQ(0, bmp.iccProfile().cmpBytes(0, data.data() + data.size() - 16, 16));
+  ASSERT_EQ(amRead, bmp.checkMode(mdIccProfile));
+}
+
+TEST(BmpImage, readMetadataIgnoresProfileOutOfRange) {
+  for (const auto& [offset, size] : {std::pair<uint32_t, uint32_t>{0xfffffff0, 16}, {124 + 4, 17}, {124 + 8, 16},
+                                     {124 + 4, 0xffffffff}, {124 + 4, 2}}) {
+    const auto data = bmpV5(offset, size);
+    BmpImage bmp(std::make_unique<MemIo>(data.data(), data.size()));
+    ASSERT_NO_THROW(bmp.readMetadata());
+    ASSERT_EQ(1u, bmp.pixelWidth());
+    ASSERT_FALSE(bmp.iccProfileDefined());
+  }
+}
+
+TEST(BmpImage, readMetadataIgnoresProfileWithAnotherSize) {
+  // The size in the profile header does not match the size in the BMP header
+  const auto data = bmpV5(124 + 4, 12);
+  BmpImage bmp(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(bmp.readMetadata());
+  ASSERT_FALSE(bmp.iccProfileDefined());
+}
+
+TEST(BmpImage, readMetadataIgnoresTruncatedV5Header) {
+  auto data = bmpV5(124 + 4, 16);
+  data.resize(100);
+  BmpImage bmp(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(bmp.readMetadata());
+  ASSERT_EQ(1u, bmp.pixelWidth());
+  ASSERT_FALSE(bmp.iccProfileDefined());
+}
+
 TEST(BmpImage, readMetadataThrowsWhenImageIsNotBMP) {
   const std::array<unsigned char, 26> header{
       'B',  'A',               // Signature                                                         off:0   size:2
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Helpers of the unit tests which build files byte by byte
+
+#ifndef TEST_BYTES_HPP_
+#define TEST_BYTES_HPP_
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/types.hpp>
+
+#include <vector>
+
+using Bytes = std::vector<Exiv2::byte>;
+
+inline Bytes operator+(Bytes lhs, const Bytes& rhs) {
+  lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+  return lhs;
+}
+
+//! Append \em value to \em data as 4 bytes in the byte order \em byteOrder
+inline void appendULong(Bytes& data, uint32_t value, Exiv2::ByteOrder byteOrder) {
+  Exiv2::byte buf[4];
+  Exiv2::ul2Data(buf, value, byteOrder);
+  data.insert(data.end(), buf, buf + 4);
+}
+
+//! The whole contents of \em io
+inline Bytes contents(Exiv2::BasicIo& io) {
+  Bytes data(io.size());
+  io.seek(0, Exiv2::BasicIo::beg);
+  io.read(data.data(), data.size());
+  return data;
+}
+
+#endif  // TEST_BYTES_HPP_
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+#include <exiv2/basicio.hpp>
+
+#include "containerwalker_int.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+namespace {
+std::vector<ContainerEntry> walkAll(BasicIo& io, ContainerFormat format, bool descend = true) {
+  std::vector<ContainerEntry> entries;
+  ContainerWalker walker(io, format);
+  walker.walk(0, io.size(), [&](const ContainerEntry& entry) {
+    entries.push_back(entry);
+    return descend && entry.formType != 0 ? WalkAction::descend : WalkAction::next;
+  });
+  return entries;
+}
+}  // namespace
+
+TEST(ContainerWalker, fourccIsBigEndian) {
+  ASSERT_EQ(0x52494646u, fourcc("RIFF"));
+  ASSERT_EQ("LIST", fourccToString(fourcc("LIST")));
+}
+
+TEST(ContainerWalker, riffSkipsPadByteAndDescendsIntoLists) {
+  const byte data[] = {
+      'a', 'b', 'c', 'd', 3, 0, 0, 0, 1, 2, 3, 0,           // odd sized chunk with pad byte
+      'L', 'I', 'S', 'T', 12, 0, 0, 0, 'I', 'N', 'F', 'O',  // list
+      'I', 'N', 'A', 'M', 0, 0, 0, 0,                       // empty child chunk
+      'e', 'f', 'g', 'h', 2, 0, 0, 0, 4, 5,                 // last chunk
+  };
+  MemIo io(data, sizeof(data));
+  auto entries = walkAll(io, ContainerFormat::riff);
+  ASSERT_EQ(4u, entries.size());
+  ASSERT_EQ(fourcc("abcd"), entries[0].id);
+  ASSERT_EQ(3u, entries[0].size);
+  ASSERT_EQ(12u, entries[1].offset);
+  ASSERT_EQ(fourcc("INFO"), entries[1].formType);
+  ASSERT_EQ(24u, entries[1].childOffset);
+  ASSERT_EQ(fourcc("INAM"), entries[2].id);
+  ASSERT_EQ(1u, entries[2].depth);
+  ASSERT_EQ(32u, entries[3].offset);
+  ASSERT_EQ(0u, entries[3].depth);
+}
+
+TEST(ContainerWalker, bmffReadsLargeSizeAndSizeToEnd) {
+  const byte data[] = {
+      0, 0, 0, 1, 'f', 'r', 'e', 'e', 0, 0, 0, 0, 0, 0, 0, 18, 0, 0,  // 64-bit size
+      0, 0, 0, 0, 'm', 'd', 'a', 't', 7, 7, 7,                         // up to the end
+  };
+  MemIo io(data, sizeof(data));
+  auto entries = walkAll(io, ContainerFormat::bmff);
+  ASSERT_EQ(2u, entries.size());
+  ASSERT_EQ(16u, entries[0].dataOffset);
+  ASSERT_EQ(2u, entries[0].size);
+  ASSERT_TRUE(entries[1].unknownSize);
+  ASSERT_EQ(3u, entries[1].size);
+}
+
+TEST(ContainerWalker, ebmlKeepsIdMarkerAndHandlesUnknownSize) {
+  const byte data[] = {
+      0x42, 0x86, 0x81, 0x01,        // EBMLVersion = 1
+      0x18, 0x53, 0x80, 0x67, 0xff,  // Segment of unknown size
+      0xec, 0x82, 0, 0,              // Void
+  };
+  MemIo io(data, sizeof(data));
+  auto entries = walkAll(io, ContainerFormat::ebml, false);
+  ASSERT_EQ(2u, entries.size());
+  ASSERT_EQ(0x4286u, entries[0].id);
+  ASSERT_EQ(1u, entries[0].size);
+  ASSERT_EQ(0x18538067u, entries[1].id);
+  ASSERT_TRUE(entries[1].unknownSize);
+  ASSERT_EQ(4u, entries[1].size);
+}
+
+TEST(ContainerWalker, pngAccountsForCrc) {
+  const byte data[] = {
+      0, 0, 0, 2, 't', 'E', 'X', 't', 'a', 'b', 1, 2, 3, 4,  //
+      0, 0, 0, 0, 'I', 'E', 'N', 'D', 1, 2, 3, 4,            //
+  };
+  MemIo io(data, sizeof(data));
+  ContainerWalker walker(io, ContainerFormat::png);
+  std::string text;
+  ASSERT_FALSE(walker.walk(0, io.size(), [&](const ContainerEntry& entry) {
+    if (entry.id == fourcc("IEND"))
+      return WalkAction::stop;
+    DataBuf payload = walker.readPayload(entry, 100);
+    text.assign(payload.c_str(), payload.size());
+    return WalkAction::next;
+  }));
+  ASSERT_EQ("ab", text);
+}
+
+TEST(ContainerWalker, rejectsEntriesLargerThanTheirParent) {
+  const byte data[] = {'a', 'b', 'c', 'd', 9, 0, 0, 0, 1, 2};
+  MemIo io(data, sizeof(data));
+  ASSERT_THROW(walkAll(io, ContainerFormat::riff), Error);
+
+  ContainerWalker walker(io, ContainerFormat::riff);
+  walker.setTruncatedAllowed(true);
+  ContainerEntry entry;
+  ASSERT_TRUE(walker.readHeader(0, io.size(), 0, entry));
+  ASSERT_TRUE(entry.truncated);
+  ASSERT_EQ(2u, entry.size);
+}
+
+TEST(ContainerWalker, rejectsTooDeepNesting) {
+  // Each list contains the next one
+  std::vector<byte> data;
+  for (uint32_t i = 0; i < 4; ++i) {
+    const uint32_t size = 4 + 12 * (3 - i);
+    const byte list[] = {'L', 'I', 'S', 'T', static_cast<byte>(size), 0, 0, 0, 'a', 'b', 'c', 'd'};
+    data.insert(data.end(), list, list + sizeof(list));
+  }
+  MemIo io(data.data(), data.size());
+  ContainerWalker walker(io, ContainerFormat::riff, 2);
+  ASSERT_THROW(walker.walk(0, io.size(), [](const ContainerEntry&) { return WalkAction::descend; }), Error);
+
+  ContainerWalker deepWalker(io, ContainerFormat::riff, 4);
+  size_t count = 0;
+  ASSERT_TRUE(deepWalker.walk(0, io.size(), [&](const ContainerEntry&) {
+    ++count;
+    return WalkAction::descend;
+  }));
+  ASSERT_EQ(4u, count);
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+
+#include <exiv2/exif.hpp>
+#include <exiv2/iptc.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+using namespace Exiv2;
+
+TEST(digest, emptyMetadataHasTheFnvOffsetBasis) {
+  ASSERT_EQ(0xcbf29ce484222325ULL, digest(CanonicalMetadata()));
+  ASSERT_EQ(digest(CanonicalMetadata()), digest(ExifData()));
+  ASSERT_EQ(digest(CanonicalMetadata()), digest(IptcData()));
+  ASSERT_EQ(digest(CanonicalMetadata()), digest(XmpData()));
+}
+
+TEST(digest, keyAndValueBoundariesAreSignificant) {
+  const CanonicalMetadata one{{"ab", "c"}};
+  const CanonicalMetadata other{{"a", "bc"}};
+  ASSERT_NE(digest(one), digest(other));
+}
+
+TEST(canonicalMetadata, exifIsSortedByKeyIndependentOfInsertionOrder) {
+  ExifData first;
+  first["Exif.Photo.DateTimeOriginal"] = "2003:12:14 12:01:44";
+  first["Exif.Image.Model"] = "Canon PowerShot S40";
+  ExifData second;
+  second["Exif.Image.Model"] = "Canon PowerShot S40";
+  second["Exif.Photo.DateTimeOriginal"] = "2003:12:14 12:01:44";
+
+  const CanonicalMetadata canonical = canonicalMetadata(first);
+  ASSERT_EQ(2u, canonical.size());
+  ASSERT_EQ("Exif.Image.Model", canonical[0].first);
+  ASSERT_EQ("Canon PowerShot S40", canonical[0].second);
+  ASSERT_EQ("Exif.Photo.DateTimeOriginal", canonical[1].first);
+  ASSERT_EQ(canonical, canonicalMetadata(second));
+  ASSERT_EQ(digest(first), digest(second));
+}
+
+TEST(canonicalMetadata, exifSkipsTheLayoutTags) {
+  ExifData exifData;
+  exifData["Exif.Image.Model"] = "NIKON D70";
+  const uint64_t expected = digest(exifData);
+
+  exifData["Exif.Image.ExifTag"] = uint32_t(196);
+  exifData["Exif.Image.StripOffsets"] = uint32_t(1024);
+  exifData["Exif.Photo.MakerNote"] = "1 2 3";
+  ASSERT_EQ(1u, canonicalMetadata(exifData).size());
+  ASSERT_EQ(expected, digest(exifData));
+}
+
+TEST(canonicalMetadata, valueChangesChangeTheDigest) {
+  IptcData iptcData;
+  iptcData["Iptc.Application2.Caption"] = "before";
+  const uint64_t before = digest(iptcData);
+  iptcData["Iptc.Application2.Caption"] = "after";
+  ASSERT_NE(before, digest(iptcData));
+
+  XmpData xmpData;
+  xmpData["Xmp.dc.creator"] = "someone";
+  ASSERT_EQ("Xmp.dc.creator", canonicalMetadata(xmpData).at(0).first);
+  ASSERT_NE(digest(XmpData()), digest(xmpData));
+}
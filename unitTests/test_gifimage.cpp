@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <exiv2/gifimage.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+using namespace Exiv2;
+
+namespace {
+// A 2x1 pixel GIF87a with a global color table and a single image
+const std::array<byte, 35> minimalGif{
+    'G',  'I',  'F',  '8',  '7',  'a',               // Signature
+    0x02, 0x00, 0x01, 0x00, 0x80, 0x00, 0x00,        // Logical screen descriptor
+    0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF,              // Global color table (2 entries)
+    0x2C, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01,  // Image descriptor
+    0x00, 0x00,                                      //
+    0x02, 0x02, 0x44, 0x01, 0x00,                    // LZW minimum code size, image data
+    0x3B,                                            // Trailer
+};
+}  // namespace
+
+TEST(GifImage, mimeTypeIsGif) {
+  auto memIo = std::make_unique<MemIo>();
+  GifImage gif(std::move(memIo));
+
+  ASSERT_EQ("image/gif", gif.mimeType());
+}
+
+TEST(GifImage, readMetadataReadsImageDimensions) {
+  auto memIo = std::make_unique<MemIo>(minimalGif.data(), minimalGif.size());
+  GifImage gif(std::move(memIo));
+  ASSERT_NO_THROW(gif.readMetadata());
+  ASSERT_EQ(2u, gif.pixelWidth());
+  ASSERT_EQ(1u, gif.pixelHeight());
+  ASSERT_TRUE(gif.xmpData().empty());
+}
+
+TEST(GifImage, readMetadataThrowsOnTruncatedImageData) {
+  auto memIo = std::make_unique<MemIo>(minimalGif.data(), minimalGif.size() - 4);
+  GifImage gif(std::move(memIo));
+  try {
+    gif.readMetadata();
+    FAIL();
+  } catch (const Exiv2::Error& e) {
+    ASSERT_EQ(ErrorCode::kerFailedToReadImageData, e.code());
+  }
+}
+
+TEST(GifImage, writeMetadataRoundTripsXmp) {
+  auto memIo = std::make_unique<MemIo>(minimalGif.data(), minimalGif.size());
+  GifImage gif(std::move(memIo));
+  gif.readMetadata();
+  gif.xmpData()["Xmp.dc.format"] = "image/gif";
+  ASSERT_NO_THROW(gif.writeMetadata());
+
+  gif.readMetadata();
+  ASSERT_EQ(2u, gif.pixelWidth());
+  ASSERT_EQ("image/gif", gif.xmpData()["Xmp.dc.format"].toString());
+
+  // Writing again replaces the existing XMP extension
+  const size_t size = gif.io().size();
+  ASSERT_NO_THROW(gif.writeMetadata());
+  ASSERT_EQ(size, gif.io().size());
+
+  gif.clearXmpData();
+  gif.clearXmpPacket();
+  ASSERT_NO_THROW(gif.writeMetadata());
+  gif.readMetadata();
+  ASSERT_TRUE(gif.xmpData().empty());
+  ASSERT_EQ(minimalGif.size(), gif.io().size());
+}
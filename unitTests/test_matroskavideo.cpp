@@ -2,8 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include "test_bytes.hpp"
+
 #include <exiv2/matroskavideo.hpp>
 
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
 using namespace Exiv2;
 
 TEST(MatroskaVideo, canBeOpenedWithEmptyMemIo) {
@@ -52,3 +59,217 @@ TEST(MatroskaVideo, readMetadata) {
   ASSERT_FALSE(data.empty());
   ASSERT_EQ(xmpData["Xmp.video.TotalStream"].count(), 4u);
 }
+
+namespace {
+Bytes element(const Bytes& id, const Bytes& payload) {
+  Bytes size{0x01};  // 8 byte size
+  for (int shift = 48; shift >= 0; shift -= 8)
+    size.push_back(static_cast<byte>(payload.size() >> shift));
+  return id + size + payload;
+}
+
+Bytes text(const std::string& str) {
+  return {str.begin(), str.end()};
+}
+
+const Bytes header = element({0x1a, 0x45, 0xdf, 0xa3}, element({0x42, 0x82}, text("matroska")));
+const Bytes info = element({0x15, 0x49, 0xa9, 0x66}, element({0x7b, 0xa9}, text("title")));
+const Bytes cluster = element({0x1f, 0x43, 0xb6, 0x75}, element({0xa3}, Bytes(5000, 0xff)));
+const Bytes tags = element({0x12, 0x54, 0xc3, 0x67},
+                           element({0x73, 0x73}, element({0x67, 0xc8}, element({0x45, 0xa3}, text("ARTIST")) +
+                                                                           element({0x44, 0x87}, text("someone")))));
+
+Bytes seekHead(const Bytes& id, uint64_t position) {
+  Bytes pos;
+  for (int shift = 56; shift >= 0; shift -= 8)
+    pos.push_back(static_cast<byte>(position >> shift));
+  return element({0x11, 0x4d, 0x9b, 0x74}, element({0x4d, 0xbb}, element({0x53, 0xab}, id) + element({0x53, 0xac}, pos)));
+}
+
+Bytes segment(const Bytes& payload) {
+  return header + element({0x18, 0x53, 0x80, 0x67}, payload);
+}
+
+void assertTagsRead(const Bytes& data) {
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  ASSERT_EQ("title", mkv.xmpData()["Xmp.video.Title"].toString());
+  ASSERT_EQ("ARTIST", mkv.xmpData()["Xmp.video.TagName"].toString());
+  ASSERT_EQ("someone", mkv.xmpData()["Xmp.video.TagString"].toString());
+}
+}  // namespace
+
+TEST(MatroskaVideo, readsTagsAfterClustersThroughSeekHead) {
+  // The SeekHead has a fixed size: its position does not depend on the position it contains
+  const auto position = seekHead({0x12, 0x54, 0xc3, 0x67}, 0).size() + info.size() + cluster.size();
+  assertTagsRead(segment(seekHead({0x12, 0x54, 0xc3, 0x67}, position) + info + cluster + tags));
+}
+
+TEST(MatroskaVideo, followsClustersToTagsWithoutSeekHead) {
+  assertTagsRead(segment(info + cluster + cluster + tags));
+}
+
+TEST(MatroskaVideo, followsALimitedNumberOfClustersWithoutSeekHead) {
+  const auto emptyCluster = element({0x1f, 0x43, 0xb6, 0x75}, {});
+  Bytes clusters;
+  for (int i = 0; i < 16383; ++i)
+    clusters.insert(clusters.end(), emptyCluster.begin(), emptyCluster.end());
+  assertTagsRead(segment(info + clusters + tags));
+
+  const auto data = segment(info + clusters + emptyCluster + tags);
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  ASSERT_EQ("title", mkv.xmpData()["Xmp.video.Title"].toString());
+  ASSERT_EQ(mkv.xmpData().end(), mkv.xmpData().findKey(XmpKey("Xmp.video.TagName")));
+}
+
+TEST(MatroskaVideo, ignoresTagsInMediaDataWithoutSeekHead) {
+  // Tags in the payload of a cluster and in random data after the segment are not elements of the file
+  const auto mediaCluster = element({0x1f, 0x43, 0xb6, 0x75}, element({0xa3}, Bytes(100, 0xff) + tags));
+  std::mt19937 random(84);
+  Bytes tail(64 * 1024);
+  std::generate(tail.begin(), tail.end(), [&] { return static_cast<byte>(random()); });
+  const auto data = segment(info + mediaCluster) + tail + tags + tail;
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  ASSERT_EQ("title", mkv.xmpData()["Xmp.video.Title"].toString());
+  ASSERT_EQ(mkv.xmpData().end(), mkv.xmpData().findKey(XmpKey("Xmp.video.TagName")));
+  ASSERT_EQ(mkv.xmpData().end(), mkv.xmpData().findKey(XmpKey("Xmp.video.TagString")));
+}
+
+TEST(MatroskaVideo, stopsAtTruncatedHeader) {
+  // The last element has a 4 byte id but only 2 bytes are left
+  const auto data = segment(info) + Bytes{0x12, 0x54};
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  ASSERT_EQ("title", mkv.xmpData()["Xmp.video.Title"].toString());
+}
+
+namespace {
+Bytes voidElement(size_t size) {
+  return element({0xec}, Bytes(size));
+}
+
+void setProperties(MatroskaVideo& mkv) {
+  mkv.readMetadata();
+  mkv.xmpData()["Xmp.video.Title"] = "new title";
+  mkv.xmpData()["Xmp.video.DateTimeOriginal"] = "2024-05-01";
+  mkv.xmpData()["Xmp.video.GPSCoordinates"] = "+48.8577+002.2950/";
+  mkv.writeMetadata();
+}
+
+void assertPropertiesRead(const Bytes& data) {
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  ASSERT_EQ("new title", mkv.xmpData()["Xmp.video.Title"].toString());
+  ASSERT_EQ("2024-05-01", mkv.xmpData()["Xmp.video.DateTimeOriginal"].toString());
+  ASSERT_EQ("+48.8577+002.2950/", mkv.xmpData()["Xmp.video.GPSCoordinates"].toString());
+}
+}  // namespace
+
+TEST(MatroskaVideo, writesInfoAndTagsIntoVoidInPlace) {
+  const auto data = segment(info + voidElement(500) + cluster);
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  setProperties(mkv);
+
+  const auto written = contents(mkv.io());
+  ASSERT_EQ(data.size(), written.size());
+  ASSERT_TRUE(std::equal(data.end() - cluster.size(), data.end(), written.end() - cluster.size()));
+  assertPropertiesRead(written);
+}
+
+TEST(MatroskaVideo, appendsTagsAndUpdatesSeekHead) {
+  // Room for a further Seek entry after the SeekHead, but none after Info
+  const auto head = seekHead({0x15, 0x49, 0xa9, 0x66}, 0);
+  const auto position = head.size() + 100 + 9;
+  const auto data = segment(seekHead({0x15, 0x49, 0xa9, 0x66}, position) + voidElement(100) + info + cluster);
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  setProperties(mkv);
+
+  const auto written = contents(mkv.io());
+  ASSERT_GT(written.size(), data.size());
+  ASSERT_TRUE(std::equal(data.end() - cluster.size(), data.end(), written.begin() + (data.size() - cluster.size())));
+  assertPropertiesRead(written);
+
+  // Writing again reuses the elements in place
+  setProperties(mkv);
+  ASSERT_EQ(written, contents(mkv.io()));
+}
+
+TEST(MatroskaVideo, failsToWritePropertiesItCannotStore) {
+  const auto data = segment(info + voidElement(500) + cluster);
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  mkv.xmpData()["Xmp.video.Title"] = "new title";
+  mkv.xmpData()["Xmp.dc.title"] = "Hello";
+  try {
+    mkv.writeMetadata();
+    FAIL();
+  } catch (const Error& e) {
+    ASSERT_EQ(ErrorCode::kerImageWriteFailed, e.code());
+  }
+  ASSERT_EQ(data, contents(mkv.io()));
+
+  // Properties read from the file are not written, but may be kept as they are
+  mkv.readMetadata();
+  mkv.xmpData()["Xmp.video.Title"] = "new title";
+  ASSERT_NO_THROW(mkv.writeMetadata());
+  mkv.xmpData()["Xmp.video.Width"] = 100;
+  ASSERT_THROW(mkv.writeMetadata(), Error);
+}
+
+namespace {
+Bytes simpleTag(const std::string& name, const std::string& value) {
+  return element({0x67, 0xc8}, element({0x45, 0xa3}, text(name)) + element({0x44, 0x87}, text(value)));
+}
+
+std::string property(const Bytes& data, const std::string& key) {
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  auto it = mkv.xmpData().findKey(XmpKey(key));
+  return it == mkv.xmpData().end() ? "" : it->toString();
+}
+}  // namespace
+
+TEST(MatroskaVideo, writesTheTitleOnlyToInfo) {
+  const auto data = segment(info + voidElement(500) + cluster);
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  mkv.xmpData()["Xmp.video.Title"] = "new title";
+  mkv.writeMetadata();
+
+  const auto written = contents(mkv.io());
+  ASSERT_EQ("new title", property(written, "Xmp.video.Title"));
+  const std::string name = "TITLE";
+  ASSERT_EQ(written.end(), std::search(written.begin(), written.end(), name.begin(), name.end()));
+  const Bytes tagsId{0x12, 0x54, 0xc3, 0x67};
+  ASSERT_EQ(written.end(), std::search(written.begin(), written.end(), tagsId.begin(), tagsId.end()));
+}
+
+TEST(MatroskaVideo, removesPropertiesFromAllTags) {
+  // A Tag for the segment and one for a track, which the properties are read from as well
+  const auto trackTargets = element({0x63, 0xc0}, element({0x63, 0xc5}, {0x01}));
+  const auto tagsWithTitle = element(
+      {0x12, 0x54, 0xc3, 0x67},
+      element({0x73, 0x73}, simpleTag("ARTIST", "someone") + simpleTag("DATE_RECORDED", "2024-05-01")) +
+          element({0x73, 0x73}, trackTargets + simpleTag("TITLE", "track title")));
+  const auto data = segment(info + tagsWithTitle + voidElement(500) + cluster);
+  ASSERT_EQ("2024-05-01", property(data, "Xmp.video.DateTimeOriginal"));
+
+  MatroskaVideo mkv(std::make_unique<MemIo>(data.data(), data.size()));
+  mkv.readMetadata();
+  mkv.xmpData()["Xmp.video.Title"] = "new title";
+  mkv.writeMetadata();
+  auto written = contents(mkv.io());
+  ASSERT_EQ(data.size(), written.size());
+  ASSERT_EQ("new title", property(written, "Xmp.video.Title"));
+
+  mkv.readMetadata();
+  mkv.xmpData().erase(mkv.xmpData().findKey(XmpKey("Xmp.video.Title")));
+  mkv.xmpData().erase(mkv.xmpData().findKey(XmpKey("Xmp.video.DateTimeOriginal")));
+  mkv.writeMetadata();
+  written = contents(mkv.io());
+  ASSERT_EQ("", property(written, "Xmp.video.Title"));
+  ASSERT_EQ("", property(written, "Xmp.video.DateTimeOriginal"));
+  ASSERT_EQ("someone", property(written, "Xmp.video.TagString"));
+}
@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+
+#include "test_bytes.hpp"
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/quicktimevideo.hpp>
+#include <exiv2/types.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace {
+std::vector<byte> atom(const std::string& type, const std::vector<byte>& payload) {
+  std::vector<byte> data;
+  appendULong(data, static_cast<uint32_t>(8 + payload.size()), bigEndian);
+  data.insert(data.end(), type.begin(), type.end());
+  data.insert(data.end(), payload.begin(), payload.end());
+  return data;
+}
+
+//! A QuickTime movie with one video track of 60 frames of 5 units at a time scale of 100, or 20 fps, in two
+//! time-to-sample entries of 20 and 40 frames
+std::vector<byte> movie() {
+  std::vector<byte> ftyp{'q', 't', ' ', ' ', 0, 0, 0, 0, 'q', 't', ' ', ' '};
+  std::vector<byte> mvhd(100);
+  mvhd[15] = 100;  // time scale
+  std::vector<byte> hdlr{0, 0, 0, 0, 'm', 'h', 'l', 'r', 'v', 'i', 'd', 'e', 'a', 'p', 'p', 'l', 0, 0, 0, 0, 0, 0, 0, 0};
+  std::vector<byte> stts;
+  for (uint32_t value : {0u, 2u, 20u, 5u, 40u, 5u})
+    appendULong(stts, value, bigEndian);
+  const auto stbl = atom("stbl", atom("stts", stts));
+  const auto trak = atom("trak", atom("mdia", atom("hdlr", hdlr) + atom("minf", stbl)));
+  return atom("ftyp", ftyp) + atom("moov", atom("mvhd", mvhd) + trak);
+}
+}  // namespace
+
+TEST(QuickTimeVideo, computesFrameRateFromTimeToSampleTable) {
+  auto data = movie();
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_TRUE(video.computeFrameRate());
+  video.readMetadata();
+  auto it = video.xmpData().findKey(XmpKey("Xmp.video.FrameRate"));
+  ASSERT_NE(video.xmpData().end(), it);
+  ASSERT_DOUBLE_EQ(20.0, it->toFloat());
+  ASSERT_EQ("Media Handler", video.xmpData()["Xmp.video.HandlerClass"].toString());
+}
+
+TEST(QuickTimeVideo, skipsFrameRateWhenDisabled) {
+  auto data = movie();
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.computeFrameRate(false);
+  video.readMetadata();
+  ASSERT_EQ(video.xmpData().end(), video.xmpData().findKey(XmpKey("Xmp.video.FrameRate")));
+  ASSERT_EQ("Media Handler", video.xmpData()["Xmp.video.HandlerClass"].toString());
+}
+
+TEST(QuickTimeVideo, findsMovieAtomAfterMediaData) {
+  auto data = movie();
+  // Move moov behind a media data atom and add trailing bytes too short for an atom
+  const std::vector<byte> ftyp(data.begin(), data.begin() + 20);
+  const std::vector<byte> moov(data.begin() + 20, data.end());
+  data = ftyp + atom("mdat", std::vector<byte>(1000, 0xff)) + moov + std::vector<byte>{0, 0, 0};
+
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  ASSERT_EQ("100", video.xmpData()["Xmp.video.TimeScale"].toString());
+  ASSERT_DOUBLE_EQ(20.0, video.xmpData()["Xmp.video.FrameRate"].toFloat());
+}
+
+namespace {
+void setTitle(QuickTimeVideo& video, const std::string& title) {
+  video.readMetadata();
+  video.xmpData()["Xmp.dc.title"] = title;
+  video.writeMetadata();
+}
+
+std::string readTitle(const std::vector<byte>& data) {
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  auto it = video.xmpData().findKey(XmpKey("Xmp.dc.title"));
+  return it == video.xmpData().end() ? "" : it->toString();
+}
+}  // namespace
+
+TEST(QuickTimeVideo, writesXmpIntoFreeAtomInPlace) {
+  auto data = movie() + atom("free", std::vector<byte>(4000));
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  setTitle(video, "first");
+
+  const auto written = contents(video.io());
+  ASSERT_EQ(data.size(), written.size());
+  ASSERT_TRUE(std::equal(data.begin(), data.end() - 4008, written.begin()));
+  ASSERT_EQ("lang=\"x-default\" first", readTitle(written));
+  // Properties computed from the streams are not written
+  const std::string fileSize = "FileSize";
+  ASSERT_EQ(written.end(), std::search(written.begin(), written.end(), fileSize.begin(), fileSize.end()));
+}
+
+TEST(QuickTimeVideo, appendsXmpAfterMediaDataWhenThereIsNoRoom) {
+  auto data = movie();
+  const std::vector<byte> ftyp(data.begin(), data.begin() + 20);
+  const std::vector<byte> moov(data.begin() + 20, data.end());
+  data = ftyp + moov + atom("mdat", std::vector<byte>(1000, 0xff));
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  setTitle(video, "first");
+
+  auto written = contents(video.io());
+  ASSERT_GT(written.size(), data.size());
+  ASSERT_TRUE(std::equal(data.begin(), data.end(), written.begin()));
+  ASSERT_EQ("lang=\"x-default\" first", readTitle(written));
+
+  // A larger packet does not fit into the old box, which becomes a free atom
+  setTitle(video, std::string(5000, 'x'));
+  const auto rewritten = contents(video.io());
+  ASSERT_TRUE(std::equal(data.begin(), data.end(), rewritten.begin()));
+  ASSERT_EQ(0, std::memcmp(rewritten.data() + data.size() + 4, "free", 4));
+  ASSERT_EQ("lang=\"x-default\" " + std::string(5000, 'x'), readTitle(rewritten));
+
+  // A smaller one reuses the free space in place
+  setTitle(video, "third");
+  ASSERT_EQ(rewritten.size(), video.io().size());
+  ASSERT_EQ("lang=\"x-default\" third", readTitle(contents(video.io())));
+}
+
+TEST(QuickTimeVideo, appendsXmpAfterTruncatedMediaData) {
+  // The media data claims 1000 bytes but the file ends after 100 of them
+  auto mdat = atom("mdat", std::vector<byte>(1000, 0xff));
+  mdat.resize(108);
+  const auto data = movie() + mdat;
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  setTitle(video, "first");
+
+  const auto written = contents(video.io());
+  ASSERT_GT(written.size(), data.size());
+  ASSERT_EQ(108u, getULong(written.data() + movie().size(), bigEndian));
+  ASSERT_EQ("lang=\"x-default\" first", readTitle(written));
+
+  // Trailing bytes too short for an atom are overwritten by the box
+  const auto trailing = movie() + atom("mdat", std::vector<byte>(100, 0xff)) + std::vector<byte>{0, 0, 0};
+  QuickTimeVideo other(std::make_unique<MemIo>(trailing.data(), trailing.size()));
+  setTitle(other, "first");
+  ASSERT_EQ(written, contents(other.io()));
+}
+
+TEST(QuickTimeVideo, failsToWriteStreamProperties) {
+  const auto data = movie() + atom("free", std::vector<byte>(4000));
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  video.readMetadata();
+  video.xmpData()["Xmp.video.Title"] = "title";
+  try {
+    video.writeMetadata();
+    FAIL();
+  } catch (const Error& e) {
+    ASSERT_EQ(ErrorCode::kerImageWriteFailed, e.code());
+  }
+  ASSERT_EQ(data, contents(video.io()));
+}
+
+namespace {
+//! A movie which claims to be 4 GB larger than its contents, to test the limits of the 32-bit atom sizes
+class HugeIo : public MemIo {
+ public:
+  using MemIo::MemIo;
+  [[nodiscard]] size_t size() const override {
+    return MemIo::size() + 0x100000000;
+  }
+};
+}  // namespace
+
+TEST(QuickTimeVideo, keepsXmpWhenTheBoxCannotBeAppended) {
+  // Media data without a size extends to the end of the file, and cannot get a 32-bit size here
+  const auto mdat = std::vector<byte>{0, 0, 0, 0, 'm', 'd', 'a', 't'} + std::vector<byte>(100, 0xff);
+  auto data = movie() + mdat;
+  QuickTimeVideo small(std::make_unique<MemIo>(data.data(), data.size()));
+  setTitle(small, "first");
+  const auto written = contents(small.io());
+  const std::vector<byte> box(written.begin() + data.size(), written.end());
+  data = movie() + box + mdat;
+
+  auto io = std::make_unique<HugeIo>(data.data(), data.size());
+  auto& memIo = *io;
+  QuickTimeVideo video(std::move(io));
+  try {
+    video.xmpData()["Xmp.dc.title"] = std::string(5000, 'x');
+    video.writeMetadata();
+    FAIL();
+  } catch (const Error& e) {
+    ASSERT_EQ(ErrorCode::kerImageWriteFailed, e.code());
+  }
+  std::vector<byte> unchanged(memIo.MemIo::size());
+  memIo.seek(0, BasicIo::beg);
+  memIo.read(unchanged.data(), unchanged.size());
+  ASSERT_EQ(data, unchanged);
+  ASSERT_EQ("lang=\"x-default\" first", readTitle(unchanged));
+}
+
+namespace {
+void appendULongLong(std::vector<byte>& data, uint64_t value) {
+  byte buf[8];
+  ull2Data(buf, value, bigEndian);
+  data.insert(data.end(), buf, buf + 8);
+}
+
+std::vector<byte> table(const std::vector<uint32_t>& values) {
+  std::vector<byte> data;
+  for (uint32_t value : values)
+    appendULong(data, value, bigEndian);
+  return data;
+}
+
+//! A movie with a GPMF track whose samples are in \em mdat, followed by the video track of movie()
+std::vector<byte> cameraMovie(const std::vector<byte>& mdat, const std::vector<byte>& stbl) {
+  std::vector<byte> tkhd(84);
+  tkhd[15] = 2;  // track ID
+  std::vector<byte> mdhd(24);
+  mdhd[14] = 0x03;  // time scale 1000
+  mdhd[15] = 0xe8;
+  std::vector<byte> hdlr{0, 0, 0, 0, 'm', 'h', 'l', 'r', 'm', 'e', 't', 'a', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  const auto stsd = table({0, 1, 16}) + std::vector<byte>{'g', 'p', 'm', 'd', 0, 0, 0, 0, 0, 0, 0, 1};
+  const auto minf = atom("minf", atom("stbl", atom("stsd", stsd) + stbl));
+  const auto trak = atom("trak", atom("tkhd", tkhd) + atom("mdia", atom("mdhd", mdhd) + atom("hdlr", hdlr) + minf));
+  const auto video = movie();
+  const std::vector<byte> ftyp(video.begin(), video.begin() + 20);
+  const std::vector<byte> moov(video.begin() + 28, video.end());
+  // An empty track and the video track are skipped
+  return ftyp + atom("mdat", mdat) + atom("moov", atom("trak", std::vector<byte>()) + trak + moov);
+}
+
+std::vector<TimedMetadataSample> readSamples(const std::vector<byte>& data, size_t limit = 100) {
+  QuickTimeVideo video(std::make_unique<MemIo>(data.data(), data.size()));
+  std::vector<TimedMetadataSample> samples;
+  video.readTimedMetadata([&](const TimedMetadataSample& sample) {
+    samples.push_back(sample);
+    samples.back().data = nullptr;
+    // Keep the bytes in the format field to check them
+    samples.back().format += std::string(sample.data, sample.data + sample.size);
+    return samples.size() < limit;
+  });
+  return samples;
+}
+}  // namespace
+
+TEST(QuickTimeVideo, readsTimedMetadataSamplesChunkByChunk) {
+  // Samples 0 and 1 in the first chunk, 2 and 3 in the second one, 4 in the third one
+  std::vector<byte> mdat(100, 0xff);
+  const uint32_t sizes[] = {3, 4, 5, 6, 7};
+  const uint32_t offsets[] = {0, 3, 20, 25, 50};
+  for (size_t i = 0; i < 5; ++i)
+    std::fill_n(mdat.begin() + offsets[i], sizes[i], static_cast<byte>('0' + i));
+  const auto stbl = atom("stts", table({0, 1, 5, 1001})) + atom("stsc", table({0, 2, 1, 2, 1, 3, 1, 1})) +
+                    atom("stsz", table({0, 0, 5, 3, 4, 5, 6, 7})) + atom("stco", table({0, 3, 28, 48, 78}));
+  const auto samples = readSamples(cameraMovie(mdat, stbl));
+
+  ASSERT_EQ(5u, samples.size());
+  for (size_t i = 0; i < 5; ++i) {
+    ASSERT_EQ(2u, samples[i].trackId);
+    ASSERT_EQ(1000u, samples[i].timeScale);
+    ASSERT_EQ(i, samples[i].index);
+    ASSERT_EQ(1001 * i, samples[i].time);
+    ASSERT_EQ(28 + offsets[i], samples[i].offset);
+    ASSERT_EQ("gpmd" + std::string(sizes[i], static_cast<char>('0' + i)), samples[i].format);
+  }
+}
+
+TEST(QuickTimeVideo, readsTimedMetadataWithLargeOffsetsAndConstantSize) {
+  // Three samples of 4 bytes per chunk, the second chunk has the last two of the five samples
+  std::vector<byte> mdat(40);
+  for (size_t i = 0; i < mdat.size(); ++i)
+    mdat[i] = static_cast<byte>('a' + i);
+  std::vector<byte> co64 = table({0, 2});
+  appendULongLong(co64, 28);
+  appendULongLong(co64, 48);
+  const auto stbl = atom("stsc", table({0, 1, 1, 3, 1})) + atom("stsz", table({0, 4, 5})) + atom("co64", co64);
+
+  const auto samples = readSamples(cameraMovie(mdat, stbl));
+  ASSERT_EQ(5u, samples.size());
+  ASSERT_EQ("gpmdabcd", samples[0].format);
+  ASSERT_EQ("gpmdijkl", samples[2].format);
+  ASSERT_EQ("gpmduvwx", samples[3].format);
+  ASSERT_EQ(0u, samples[4].time);
+
+  // The callback stops the iteration
+  ASSERT_EQ(2u, readSamples(cameraMovie(mdat, stbl), 2).size());
+}
@@ -2,8 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include "test_bytes.hpp"
+
 #include <exiv2/riffvideo.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
 using namespace Exiv2;
 
 TEST(RiffVideo, canBeOpenedWithEmptyMemIo) {
@@ -52,3 +59,126 @@ TEST(RiffVideo, readMetadata) {
   ASSERT_FALSE(data.empty());
   ASSERT_EQ(xmpData["Xmp.video.TotalStream"].count(), 4u);
 }
+
+namespace {
+Bytes chunk(const std::string& id, const Bytes& payload) {
+  Bytes data(id.begin(), id.end());
+  appendULong(data, static_cast<uint32_t>(payload.size()), littleEndian);
+  data.insert(data.end(), payload.begin(), payload.end());
+  if (payload.size() % 2 != 0)
+    data.push_back(0);
+  return data;
+}
+
+Bytes list(const std::string& id, const std::string& type, const Bytes& children) {
+  Bytes payload(type.begin(), type.end());
+  payload.insert(payload.end(), children.begin(), children.end());
+  return chunk(id, payload);
+}
+}  // namespace
+
+TEST(RiffVideo, readsOpenDmlFrameCountAndSkipsExtensions) {
+  Bytes avih;
+  for (uint32_t value : {40000u, 0u, 0u, 0x10u, 100u, 0u, 1u, 0u, 640u, 480u, 0u, 0u, 0u, 0u})
+    appendULong(avih, value, littleEndian);
+  Bytes dmlh;
+  appendULong(dmlh, 300, littleEndian);
+  const Bytes hdrl = list("LIST", "hdrl", chunk("avih", avih) + list("LIST", "odml", chunk("dmlh", dmlh)));
+  const Bytes movi = list("LIST", "movi", chunk("ix00", Bytes(24)) + chunk("00dc", Bytes(1000, 0xff)));
+  const Bytes info = list("LIST", "INFO", chunk("INAM", {'t', 'i', 't', 'l', 'e', 0}));
+  const Bytes data = list("RIFF", "AVI ", hdrl + movi + chunk("idx1", Bytes(32))) + list("RIFF", "AVIX", movi + info);
+
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  riff.readMetadata();
+  ASSERT_EQ("300", riff.xmpData()["Xmp.video.FrameCount"].toString());
+  ASSERT_EQ("12000", riff.xmpData()["Xmp.video.Duration"].toString());
+  ASSERT_EQ("title", riff.xmpData()["Xmp.video.Title"].toString());
+}
+
+namespace {
+void setProperties(RiffVideo& riff, const std::string& title) {
+  riff.readMetadata();
+  riff.xmpData()["Xmp.video.Title"] = title;
+  riff.xmpData()["Xmp.xmp.CreatorTool"] = "exiv2";
+  riff.writeMetadata();
+}
+
+void assertPropertiesRead(const Bytes& data, const std::string& title) {
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  riff.readMetadata();
+  ASSERT_EQ(title, riff.xmpData()["Xmp.video.Title"].toString());
+  ASSERT_EQ("exiv2", riff.xmpData()["Xmp.xmp.CreatorTool"].toString());
+}
+
+const Bytes fmt = chunk("fmt ", Bytes(16));
+const Bytes waveData = chunk("data", Bytes(1001, 0x7f));  // odd sized, with pad byte
+}  // namespace
+
+TEST(RiffVideo, writesInfoAndXmpIntoJunkInPlace) {
+  const Bytes data = list("RIFF", "WAVE", fmt + chunk("JUNK", Bytes(8000)) + waveData);
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  setProperties(riff, "title");
+
+  const auto written = contents(riff.io());
+  ASSERT_EQ(data.size(), written.size());
+  ASSERT_TRUE(std::equal(data.end() - waveData.size(), data.end(), written.end() - waveData.size()));
+  assertPropertiesRead(written, "title");
+}
+
+TEST(RiffVideo, appendsInfoAndXmpToTheRiffChunk) {
+  const Bytes info = list("LIST", "INFO", chunk("ISFT", {'x', 0}));
+  const Bytes data = list("RIFF", "WAVE", fmt + waveData + info);
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  setProperties(riff, "title");
+
+  auto written = contents(riff.io());
+  ASSERT_GT(written.size(), data.size());
+  ASSERT_EQ(written.size() - 8, getULong(written.data() + 4, littleEndian));
+  ASSERT_TRUE(std::equal(data.begin() + 8, data.end() - info.size(), written.begin() + 8));
+  // The old list is too small and becomes a JUNK chunk, the new one keeps the other chunks
+  ASSERT_EQ(0, std::memcmp(written.data() + data.size() - info.size(), "JUNK", 4));
+  const std::string software = "ISFT";
+  ASSERT_NE(written.end(), std::search(written.begin() + data.size(), written.end(), software.begin(), software.end()));
+  assertPropertiesRead(written, "title");
+
+  // A longer title does not fit: the old list becomes a JUNK chunk, which a shorter one reuses
+  setProperties(riff, std::string(100, 'x'));
+  written = contents(riff.io());
+  assertPropertiesRead(written, std::string(100, 'x'));
+  const auto size = written.size();
+  setProperties(riff, "short");
+  ASSERT_EQ(size, riff.io().size());
+  assertPropertiesRead(contents(riff.io()), "short");
+}
+
+TEST(RiffVideo, keepsTheOrderOfTheInfoChunks) {
+  const Bytes info = list("LIST", "INFO",
+                          chunk("ISFT", {'x', 0}) + chunk("INAM", {'o', 'l', 'd', 0}) + chunk("IART", {'m', 'e', 0}));
+  const Bytes data = list("RIFF", "WAVE", fmt + info + chunk("JUNK", Bytes(100)) + waveData);
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  riff.readMetadata();
+  riff.writeMetadata();
+  ASSERT_EQ(data, contents(riff.io()));
+
+  riff.xmpData()["Xmp.video.Title"] = "new";
+  riff.writeMetadata();
+  const auto written = contents(riff.io());
+  ASSERT_EQ(data.size(), written.size());
+  const Bytes updated = list("LIST", "INFO",
+                             chunk("ISFT", {'x', 0}) + chunk("INAM", {'n', 'e', 'w', 0}) + chunk("IART", {'m', 'e', 0}));
+  ASSERT_TRUE(std::equal(updated.begin(), updated.end(), written.begin() + 12 + fmt.size()));
+}
+
+TEST(RiffVideo, failsToWritePropertiesWithoutInfoChunk) {
+  const Bytes data = list("RIFF", "WAVE", fmt + chunk("JUNK", Bytes(8000)) + waveData);
+  RiffVideo riff(std::make_unique<MemIo>(data.data(), data.size()));
+  riff.readMetadata();
+  riff.xmpData()["Xmp.video.FrameRate"] = "25";
+  try {
+    riff.writeMetadata();
+    FAIL();
+  } catch (const Error& e) {
+    ASSERT_EQ(ErrorCode::kerImageWriteFailed, e.code());
+  }
+  ASSERT_EQ(data, contents(riff.io()));
+}
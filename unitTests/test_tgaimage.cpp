@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <gtest/gtest.h>
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/error.hpp>
+#include <exiv2/tgaimage.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace {
+using Bytes = std::vector<byte>;
+
+// A 2x1 pixel uncompressed true-color TGA
+const Bytes tgaImage{
+    0x00, 0x00, 0x02,              // ID length, color map type, image type
+    0x00, 0x00, 0x00, 0x00, 0x00,  // Color map specification
+    0x00, 0x00, 0x00, 0x00,        // x and y origin
+    0x02, 0x00, 0x01, 0x00,        // Width and height
+    0x18, 0x00,                    // Pixel depth, image descriptor
+    0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+};
+
+void putString(Bytes& buf, size_t offset, const std::string& text) {
+  std::memcpy(buf.data() + offset, text.data(), text.size());
+}
+
+void putShort(Bytes& buf, size_t offset, uint16_t value) {
+  buf[offset] = static_cast<byte>(value);
+  buf[offset + 1] = static_cast<byte>(value >> 8);
+}
+
+Bytes extensionArea() {
+  Bytes ext(495);
+  putShort(ext, 0, 495);
+  putString(ext, 2, "Jane Doe");
+  putString(ext, 43, "First line");
+  putString(ext, 43 + 81, "Second line   ");
+  const uint16_t stamp[] = {5, 1, 2024, 13, 45, 30};
+  for (size_t i = 0; i < 6; ++i)
+    putShort(ext, 367 + (2 * i), stamp[i]);
+  putString(ext, 379, "Job 42");
+  putString(ext, 426, "Painter");
+  putShort(ext, 467, 123);
+  ext[469] = 'b';
+  return ext;
+}
+
+//! The footer, with the extension area at \em offset
+Bytes footer(uint32_t offset) {
+  Bytes buf(26);
+  putShort(buf, 0, static_cast<uint16_t>(offset));
+  putShort(buf, 2, static_cast<uint16_t>(offset >> 16));
+  putString(buf, 8, "TRUEVISION-XFILE.");
+  return buf;
+}
+
+Bytes tga(const Bytes& ext, uint32_t offset) {
+  Bytes data = tgaImage;
+  data.insert(data.end(), ext.begin(), ext.end());
+  const Bytes foot = footer(offset);
+  data.insert(data.end(), foot.begin(), foot.end());
+  return data;
+}
+}  // namespace
+
+TEST(TgaImage, readsExtensionArea) {
+  const auto data = tga(extensionArea(), static_cast<uint32_t>(tgaImage.size()));
+  TgaImage tga(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(tga.readMetadata());
+  ASSERT_EQ(2u, tga.pixelWidth());
+  ASSERT_EQ(1u, tga.pixelHeight());
+  ASSERT_EQ("Jane Doe", tga.xmpData()["Xmp.dc.creator"].toString());
+  ASSERT_EQ("First line\nSecond line", tga.comment());
+  ASSERT_EQ("2024-05-01T13:45:30", tga.xmpData()["Xmp.xmp.CreateDate"].toString());
+  ASSERT_EQ("lang=\"x-default\" Job 42", tga.xmpData()["Xmp.dc.title"].toString());
+  ASSERT_EQ("Painter 1.23b", tga.xmpData()["Xmp.xmp.CreatorTool"].toString());
+}
+
+TEST(TgaImage, ignoresExtensionAreaBeyondTheFooter) {
+  const auto data = tga(extensionArea(), 0x7fffffff);
+  TgaImage tga(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(tga.readMetadata());
+  ASSERT_TRUE(tga.xmpData().empty());
+  ASSERT_TRUE(tga.comment().empty());
+}
+
+TEST(TgaImage, ignoresTruncatedExtensionArea) {
+  // The extension area runs into the footer
+  auto ext = extensionArea();
+  ext.resize(300);
+  const auto data = tga(ext, static_cast<uint32_t>(tgaImage.size()));
+  TgaImage tga(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(tga.readMetadata());
+  ASSERT_TRUE(tga.xmpData().empty());
+  ASSERT_TRUE(tga.comment().empty());
+}
+
+TEST(TgaImage, ignoresExtensionAreaOfAnotherSize) {
+  auto ext = extensionArea();
+  putShort(ext, 0, 494);
+  const auto data = tga(ext, static_cast<uint32_t>(tgaImage.size()));
+  TgaImage tga(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(tga.readMetadata());
+  ASSERT_TRUE(tga.xmpData().empty());
+}
+
+TEST(TgaImage, ignoresMissingExtensionArea) {
+  const auto data = tga(extensionArea(), 0);
+  TgaImage tga(std::make_unique<MemIo>(data.data(), data.size()));
+  ASSERT_NO_THROW(tga.readMetadata());
+  ASSERT_TRUE(tga.xmpData().empty());
+  ASSERT_EQ(2u, tga.pixelWidth());
+}
+
+TEST(isTgaType, recognizesTheFooterSignature) {
+  const auto data = tga(extensionArea(), 0);
+  MemIo io(data.data(), data.size());
+  ASSERT_TRUE(isTgaType(io, false));
+  ASSERT_EQ(0u, io.tell());
+
+  MemIo other(tgaImage.data(), tgaImage.size());
+  ASSERT_FALSE(isTgaType(other, false));
+}